@@ -71,6 +71,8 @@
 #include "backend_commit.h"
 #include "backend_client.h"
 #include "backend_handle.h"
+#include "backend_stats.h"
+#include "backend_trace.h"
 
 /*! Find client by session-id 
  * @param[in] ce_list   List of clients
@@ -88,6 +90,175 @@ ce_find_byid(struct client_entry *ce_list,
     return NULL;
 }
 
+static int ce_output_cb(int s, void *arg);
+
+/*! Free notifications waiting to be written to a client
+ * @param[in]  ce  Client entry
+ */
+int
+backend_client_output_free(struct client_entry *ce)
+{
+    struct client_output *co;
+
+    if (ce->ce_outq && ce->ce_s)
+	clixon_event_unreg_fd(ce->ce_s, ce_output_cb);
+    while ((co = ce->ce_outq) != NULL){
+	DELQ(co, ce->ce_outq, struct client_output *);
+	stream_msg_free(co->co_sm);
+	free(co);
+	clixon_mem_add(CLIXON_MEM_CLIENT, 0, -1);
+    }
+    clixon_mem_add(CLIXON_MEM_CLIENT, -(int64_t)ce->ce_outlen, 0);
+    ce->ce_outlen = 0;
+    return 0;
+}
+
+/*! Write queued notifications to a client when its socket is writable
+ * @param[in]  s    Client socket
+ * @param[in]  arg  Client entry
+ * @see ce_notify_send
+ */
+static int
+ce_output_cb(int   s,
+	     void *arg)
+{
+    struct client_entry  *ce = (struct client_entry *)arg;
+    struct client_output *co;
+    struct clicon_msg    *msg;
+    size_t                len;
+    ssize_t               n;
+
+    while ((co = ce->ce_outq) != NULL){
+	msg = co->co_sm->sm_msg;
+	len = ntohl(msg->op_len);
+	if ((n = send(s, (char*)msg + co->co_off, len - co->co_off, MSG_DONTWAIT)) < 0){
+	    if (errno == EAGAIN || errno == EWOULDBLOCK)
+		break;
+	    /* Client is removed when from_client reads eof */
+	    clicon_log(LOG_WARNING, "client %d reset", ce->ce_nr);
+	    backend_client_output_free(ce);
+	    return 0;
+	}
+	co->co_off += n;
+	ce->ce_outlen -= n;
+	clixon_mem_add(CLIXON_MEM_CLIENT, -(int64_t)n, 0);
+	if (co->co_off < len)
+	    break;
+	DELQ(co, ce->ce_outq, struct client_output *);
+	stream_msg_free(co->co_sm);
+	free(co);
+	clixon_mem_add(CLIXON_MEM_CLIENT, 0, -1);
+    }
+    if (ce->ce_outq == NULL)
+	clixon_event_unreg_fd(s, ce_output_cb);
+    return 0;
+}
+
+/*! Write all queued notifications to a client, blocking
+ * Must be done before a reply is written, so that it is not interleaved with a
+ * partially written notification. On write error the queue is dropped.
+ * @param[in]  ce  Client entry
+ */
+static void
+ce_output_flush(struct client_entry *ce)
+{
+    struct client_output *co;
+    struct clicon_msg    *msg;
+    size_t                len;
+    ssize_t               n;
+
+    clixon_event_unreg_fd(ce->ce_s, ce_output_cb);
+    while ((co = ce->ce_outq) != NULL){
+	msg = co->co_sm->sm_msg;
+	len = ntohl(msg->op_len);
+	while (co->co_off < len){
+	    if ((n = write(ce->ce_s, (char*)msg + co->co_off, len - co->co_off)) < 0){
+		if (errno == EINTR)
+		    continue;
+		clicon_log(LOG_WARNING, "client %d reset", ce->ce_nr);
+		backend_client_output_free(ce); /* already unregistered */
+		return;
+	    }
+	    co->co_off += n;
+	    ce->ce_outlen -= n;
+	    clixon_mem_add(CLIXON_MEM_CLIENT, -(int64_t)n, 0);
+	}
+	DELQ(co, ce->ce_outq, struct client_output *);
+	stream_msg_free(co->co_sm);
+	free(co);
+	clixon_mem_add(CLIXON_MEM_CLIENT, 0, -1);
+    }
+    ce->ce_outlen = 0;
+}
+
+/*! Send notification to a client without blocking
+ *
+ * The notification message is encoded once and shared by all subscribers, see
+ * stream_notify_msg. If the client socket is not writable, or there are already
+ * queued notifications, the message is queued and written by ce_output_cb when
+ * the socket becomes writable. A client whose queue grows beyond 
+ * BACKEND_NOTIFY_QUEUE_MAX is shut down.
+ * @param[in]  ce    Client entry
+ * @param[in]  event Notification as XML
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+ce_notify_send(struct client_entry *ce,
+	       cxobj               *event)
+{
+    int                   retval = -1;
+    struct stream_msg    *sm = NULL;
+    struct client_output *co;
+    size_t                len;
+    ssize_t               n = 0;
+
+    if ((sm = stream_notify_msg(event)) == NULL)
+	goto done;
+    len = ntohl(sm->sm_msg->op_len);
+    if (ce->ce_outq == NULL){ /* Nothing queued, try to write directly */
+	if ((n = send(ce->ce_s, sm->sm_msg, len, MSG_DONTWAIT)) < 0){
+	    if (errno != EAGAIN && errno != EWOULDBLOCK){
+		clicon_err(OE_UNIX, errno, "send");
+		goto done;
+	    }
+	    n = 0;
+	}
+	if (n == len)
+	    goto ok;
+    }
+    if (ce->ce_outlen + len - n > BACKEND_NOTIFY_QUEUE_MAX){
+	/* Client is removed when from_client reads eof */
+	clicon_log(LOG_WARNING, "client %d not reading notifications, closing", ce->ce_nr);
+	backend_client_output_free(ce);
+	shutdown(ce->ce_s, SHUT_RDWR);
+	goto ok;
+    }
+    if ((co = malloc(sizeof(*co))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(co, 0, sizeof(*co));
+    co->co_sm = sm;
+    co->co_off = n;
+    sm = NULL;
+    if (ce->ce_outq == NULL &&
+	clixon_event_reg_fd_write(ce->ce_s, ce_output_cb, ce, "client output") < 0){
+	stream_msg_free(co->co_sm);
+	free(co);
+	goto done;
+    }
+    ADDQ(co, ce->ce_outq);
+    ce->ce_outlen += len - n;
+    clixon_mem_add(CLIXON_MEM_CLIENT, len - n, 1);
+ ok:
+    retval = 0;
+ done:
+    if (sm)
+	stream_msg_free(sm);
+    return retval;
+}
+
 /*! Stream callback for netconf stream notification (RFC 5277)
  * @param[in]  h     Clicon handle
  * @param[in]  op    0:event, 1:rm
@@ -111,7 +282,11 @@ ce_event_cb(clicon_handle h,
 	    backend_client_rm(h, ce);
 	break;
     default:
+#ifdef CLIXON_PROTO_PLAIN
 	if (send_msg_notify_xml(h, ce->ce_s, event) < 0){
+#else
+	if (ce_notify_send(ce, event) < 0){
+#endif
 	    if (errno == ECONNRESET || errno == EPIPE){
 		clicon_log(LOG_WARNING, "client %d reset", ce->ce_nr);
 	    }
@@ -143,6 +318,7 @@ backend_client_rm(clicon_handle        h,
     ce_prev = &c0; /* this points to stack and is not real backpointer */
     for (c = *ce_prev; c; c = c->ce_next){
 	if (c == ce){
+	    backend_client_output_free(ce);
 	    if (ce->ce_s){
 		clixon_event_unreg_fd(ce->ce_s, from_client);
 		close(ce->ce_s);
@@ -368,6 +544,10 @@ client_statedata(clicon_handle h,
 	if ((ret = client_get_capabilities(h, yspec, xpath, xret)) < 0)
 	    goto done;
     }
+    if (clicon_option_bool(h, "CLICON_BACKEND_STATS")){
+	if (backend_stats_get(h, yspec, xret) < 0)
+	    goto done;
+    }
     if (clicon_option_bool(h, "CLICON_MODULE_LIBRARY_RFC7895")){
 	if ((ret = yang_modules_state_get(h, yspec, xpath, nsc, 0, xret)) < 0)
 	    goto done;
@@ -590,6 +770,11 @@ from_client_edit_config(clicon_handle h,
     char               *val = NULL;
     cvec               *nsc = NULL;
     char               *prefix = NULL;
+    char               *memstr;
+    uint64_t            memmax = 0;
+    uint64_t            nr = 0;
+    size_t              sz = 0;
+    struct clixon_mem_stat ms;
 
     username = clicon_username_get(h);
     if ((yspec =  clicon_dbspec_yang(h)) == NULL){
@@ -682,6 +867,28 @@ from_client_edit_config(clicon_handle h,
      */
     if (xml_sort_recurse(xc) < 0)
 	goto done;
+    /* Soft memory limit of target datastore, the edit is estimated by its size */
+    /* uint32 option: parse unsigned, limits >= 2GiB do not fit an int */
+    if ((memstr = clicon_option_str(h, "CLICON_XMLDB_MEMORY_MAX")) != NULL &&
+	parse_uint64(memstr, &memmax, NULL) <= 0){
+	clicon_err(OE_CFG, EINVAL, "CLICON_XMLDB_MEMORY_MAX: %s is not a number", memstr);
+	goto done;
+    }
+    if (memmax > 0 &&
+	operation != OP_DELETE && operation != OP_REMOVE){
+	if (clixon_mem_get(clixon_mem_acct_db(target), &ms) < 0)
+	    goto done;
+	if (xml_stats(xc, &nr, &sz) < 0)
+	    goto done;
+	if (ms.ms_bytes + sz > memmax){
+	    cbuf_reset(cbx);
+	    cprintf(cbx, "Datastore %s memory limit exceeded: %" PRIu64 " + %zu > %" PRIu64 " bytes",
+		    target, ms.ms_bytes, sz, memmax);
+	    if (netconf_resource_denied(cbret, "application", cbuf_get(cbx)) < 0)
+		goto done;
+	    goto ok;
+	}
+    }
     if ((ret = xmldb_put(h, target, operation, xc, username, cbret)) < 0){
 	clicon_debug(1, "%s ERROR PUT", __FUNCTION__);	
 	if (netconf_operation_failed(cbret, "protocol", clicon_err_reason)< 0)
@@ -1494,8 +1701,10 @@ from_client_stats(clicon_handle h,
 		  void         *arg,
 		  void         *regarg)
 {
-    int      retval = -1;
-    uint64_t nr;
+    int                    retval = -1;
+    uint64_t               nr;
+    enum clixon_mem_acct   acct;
+    struct clixon_mem_stat ms;
     
     cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
     nr=0;
@@ -1507,12 +1716,201 @@ from_client_stats(clicon_handle h,
 	goto done;
     if (clixon_stats_get_db(h, "startup", cbret) < 0)
 	goto done;
+    for (acct=0; acct<CLIXON_MEM_NR; acct++){
+	if (clixon_mem_get(acct, &ms) < 0)
+	    goto done;
+	cprintf(cbret, "<memory><name>%s</name>", clixon_mem_acct2str(acct));
+	cprintf(cbret, "<bytes>%" PRIu64 "</bytes><peak-bytes>%" PRIu64 "</peak-bytes>",
+		ms.ms_bytes, ms.ms_peak_bytes);
+	cprintf(cbret, "<objects>%" PRIu64 "</objects><peak-objects>%" PRIu64 "</peak-objects>",
+		ms.ms_objs, ms.ms_peak_objs);
+	cprintf(cbret, "</memory>");
+    }
     cprintf(cbret, "</rpc-reply>");
     retval = 0;
  done:
     return retval;
 }
 
+/*! Get generation counter of a datastore
+ * @param[in]  h       Clicon handle 
+ * @param[in]  xe      Request: <rpc><xn></rpc> 
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register() 
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see xmldb_generation_get
+ */
+static int
+from_client_datastore_generation(clicon_handle h,
+				 cxobj        *xe,
+				 cbuf         *cbret,
+				 void         *arg,
+				 void         *regarg)
+{
+    int       retval = -1;
+    char     *db;
+    uint64_t  gen;
+
+    if ((db = xml_find_body(xe, "datastore")) == NULL){
+	if (netconf_missing_element(cbret, "application", "datastore", NULL) < 0)
+	    goto done;
+	goto ok;
+    }
+    if (xmldb_validate_db(db) < 0){
+	if (netconf_invalid_value(cbret, "application", "No such database") < 0)
+	    goto done;
+	goto ok;
+    }
+    if ((gen = xmldb_generation_get(h, db)) == 0)
+	goto done;
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><generation xmlns=\"%s\">%" PRIu64 "</generation>",
+	    NETCONF_BASE_NAMESPACE, CLIXON_LIB_NS, gen);
+    cprintf(cbret, "<last-modified xmlns=\"%s\">%" PRIu64 "</last-modified></rpc-reply>",
+	    CLIXON_LIB_NS, (uint64_t)xmldb_lastmod_get(h, db));
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get values of data nodes given xpaths, evaluated in the backend
+ *
+ * Only the number of matches and the body of the first match of each xpath are 
+ * returned, instead of the data tree to the client for evaluation.
+ * The datastore is read once for all xpaths.
+ * @param[in]  h       Clicon handle 
+ * @param[in]  xe      Request: <rpc><xn></rpc> 
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register() 
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see clixon_client_get_vals  Client side
+ */
+static int
+from_client_get_values(clicon_handle h,
+		       cxobj        *xe,
+		       cbuf         *cbret,
+		       void         *arg,
+		       void         *regarg)
+{
+    int        retval = -1;
+    char      *db;
+    char      *ns;
+    cvec      *nsc = NULL;
+    cxobj     *xt = NULL;
+    cxobj     *xnacm = NULL;
+    cxobj     *x;
+    cxobj    **xvec = NULL;
+    size_t     xlen;
+    char      *body;
+    uint64_t   gen;
+    
+    if ((db = xml_find_body(xe, "datastore")) == NULL)
+	db = "running";
+    if (xmldb_validate_db(db) < 0){
+	if (netconf_invalid_value(cbret, "application", "No such database") < 0)
+	    goto done;
+	goto ok;
+    }
+    if ((ns = xml_find_body(xe, "namespace")) != NULL &&
+	(nsc = xml_nsctx_init(NULL, ns)) == NULL)
+	goto done;
+    /* Read the datastore once, zero-copy unless it needs to be pruned by NACM */
+    xnacm = clicon_nacm_cache(h);
+    if (xmldb_get0(h, db, YB_MODULE, NULL, "/", xnacm != NULL, &xt, NULL) < 0){
+	if (netconf_operation_failed(cbret, "application", "read registry")< 0)
+	    goto done;
+	goto ok;
+    }
+    if (xnacm != NULL){
+	if ((xvec = malloc(sizeof(cxobj*))) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    goto done;
+	}
+	xvec[0] = xt;
+	if (nacm_datanode_read(h, xt, xvec, 1, clicon_username_get(h), xnacm) < 0) 
+	    goto done;
+	free(xvec);
+	xvec = NULL;
+    }
+    if ((gen = xmldb_generation_get(h, db)) == 0)
+	goto done;
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><generation xmlns=\"%s\">%" PRIu64 "</generation>",
+	    NETCONF_BASE_NAMESPACE, CLIXON_LIB_NS, gen);
+    x = NULL;
+    while ((x = xml_child_each(xe, x, CX_ELMNT)) != NULL){
+	if (strcmp(xml_name(x), "xpath") != 0)
+	    continue;
+	if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, xml_body(x)?xml_body(x):"/") < 0)
+	    goto done;
+	cprintf(cbret, "<value xmlns=\"%s\"><count>%zu</count>", CLIXON_LIB_NS, xlen);
+	if (xlen && (body = xml_body(xvec[0])) != NULL){
+	    cprintf(cbret, "<body>");
+	    if (xml_chardata_cbuf_append(cbret, body) < 0)
+		goto done;
+	    cprintf(cbret, "</body>");
+	}
+	cprintf(cbret, "</value>");
+	if (xvec){
+	    free(xvec);
+	    xvec = NULL;
+	}
+    }
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 0;
+ done:
+    if (xt){
+	if (xnacm != NULL) /* Copy, not freed by xmldb_get0_free in zero-copy mode */
+	    xml_free(xt);
+	else{
+	    xmldb_get0_clear(h, xt);
+	    xmldb_get0_free(h, &xt);
+	}
+    }
+    if (xvec)
+	free(xvec);
+    if (nsc)
+	xml_nsctx_free(nsc);
+    return retval;
+}
+
+/*! Write the commit trace ring buffer to CLICON_BACKEND_TRACE_FILE
+ * @param[in]  h       Clicon handle 
+ * @param[in]  xe      Request: <rpc><xn></rpc> 
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register() 
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see backend_trace_export
+ */
+static int
+from_client_trace_export(clicon_handle h,
+			 cxobj        *xe,
+			 cbuf         *cbret,
+			 void         *arg,
+			 void         *regarg)
+{
+    int      retval = -1;
+    uint32_t nr = 0;
+
+    if (backend_trace_export(h, &nr) < 0){
+	if (netconf_operation_failed(cbret, "application", clicon_err_reason) < 0)
+	    goto done;
+	goto ok;
+    }
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><spans xmlns=\"%s\">%u</spans></rpc-reply>",
+	    NETCONF_BASE_NAMESPACE, CLIXON_LIB_NS, nr);
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Request restart of specific plugins
  * @param[in]  h       Clicon handle 
  * @param[in]  xe      Request: <rpc><xn></rpc> 
@@ -1628,6 +2026,43 @@ from_client_hello(clicon_handle       h,
     return retval;
 }
 
+/* RPCs allowed on read-only sessions, see CLICON_SOCK_READONLY */
+static const struct {
+    const char *ro_ns;
+    const char *ro_name;
+} readonly_rpcs[] = {
+    {NETCONF_BASE_NAMESPACE, "get-config"},
+    {NETCONF_BASE_NAMESPACE, "get"},
+    {NETCONF_BASE_NAMESPACE, "close-session"},
+    {CLIXON_LIB_NS,          "ping"},
+    {CLIXON_LIB_NS,          "stats"},
+    {CLIXON_LIB_NS,          "datastore-generation"},
+    {CLIXON_LIB_NS,          "get-values"},
+    {NULL,                   NULL}
+};
+
+/*! Check if an rpc is allowed on a read-only session
+ * @param[in]  ymod  Yang module of rpc
+ * @param[in]  rpc   Name of rpc
+ * @retval     1     Allowed, the rpc only reads
+ * @retval     0     Not allowed
+ */
+static int
+rpc_readonly(yang_stmt *ymod,
+	     char      *rpc)
+{
+    char *ns;
+    int   i;
+
+    if ((ns = yang_find_mynamespace(ymod)) == NULL)
+	return 0;
+    for (i=0; readonly_rpcs[i].ro_name; i++)
+	if (strcmp(readonly_rpcs[i].ro_name, rpc) == 0 &&
+	    strcmp(readonly_rpcs[i].ro_ns, ns) == 0)
+	    return 1;
+    return 0;
+}
+
 /*! An internal clicon message has arrived from a client. Receive and dispatch.
  * @param[in]   h    Clicon handle
  * @param[in]   s    Socket where message arrived. read from this.
@@ -1660,8 +2095,20 @@ from_client_msg(clicon_handle        h,
     char                *rpcname;
     char                *rpcprefix;
     char                *namespace = NULL;
+    struct timespec      t0;
+    uint64_t             xmlnr0 = 0;
+    uint64_t             xmlnr1 = 0;
+    enum clixon_mem_acct acct0;
+    size_t               msize;
     
     clicon_debug(1, "%s", __FUNCTION__);
+    backend_stats_start(&t0);
+    xml_stats_alloc(&xmlnr0);
+    /* Request, reply and transient XML trees are accounted to the client, datastore
+     * code sets its own accounting class when modifying a datastore */
+    acct0 = clixon_mem_acct_set(CLIXON_MEM_CLIENT);
+    msize = ntohl(msg->op_len);
+    clixon_mem_add(CLIXON_MEM_CLIENT, msize, 1);
     yspec = clicon_dbspec_yang(h); 
     /* Return netconf message. Should be filled in by the dispatch(sub) functions 
      * as wither rpc-error or by positive response.
@@ -1760,6 +2207,12 @@ from_client_msg(clicon_handle        h,
 	}
 	module = yang_argument_get(ymod);
 	clicon_debug(1, "%s module:%s rpc:%s", __FUNCTION__, module, rpc);
+	/* Sessions on the read-only socket may not change anything */
+	if (ce->ce_readonly && !rpc_readonly(ymod, rpc)){
+	    if (netconf_access_denied(cbret, "protocol", "Operation not allowed on read-only session") < 0)
+		goto done;
+	    goto reply;
+	}
 	/* Pre-NACM access step */
 	xnacm = NULL;
 
@@ -1771,6 +2224,7 @@ from_client_msg(clicon_handle        h,
 	if ((ret = nacm_access_pre(h, ce->ce_username, username, &xnacm)) < 0)
 	    goto done;
 	/* Cache XML NACM tree here. Use with caution, only valid on from_client_msg stack 
+	 * The tree itself is owned by the compiled NACM policy, see nacm_access_pre
 	 */
 	if (clicon_nacm_cache_set(h, xnacm) < 0)
 	    goto done;
@@ -1781,7 +2235,7 @@ from_client_msg(clicon_handle        h,
 	    if (ret == 0) /* credentials fail */
 		goto reply;
 	    /* NACM rpc operation exec validation */
-	    if ((ret = nacm_rpc(rpc, module, username, xnacm, cbret)) < 0)
+	    if ((ret = nacm_rpc(h, rpc, module, username, xnacm, cbret)) < 0)
 		goto done;
 	    if (ret == 0) /* Not permitted and cbret set */
 		goto reply;
@@ -1799,7 +2253,6 @@ from_client_msg(clicon_handle        h,
 	    goto reply;
 	}
 	if (xnacm){
-	    xml_free(xnacm);
 	    xnacm = NULL;
 	    if (clicon_nacm_cache_set(h, NULL) < 0)
 		goto done;
@@ -1810,8 +2263,13 @@ from_client_msg(clicon_handle        h,
 	if (netconf_operation_failed(cbret, "application", clicon_errno?clicon_err_reason:"unknown")< 0)
 	    goto done;
     clicon_debug(1, "%s cbret:%s", __FUNCTION__, cbuf_get(cbret));
+    clixon_mem_add(CLIXON_MEM_CLIENT, cbuf_buflen(cbret), 0);
+    msize += cbuf_buflen(cbret);
     /* XXX problem here is that cbret has not been parsed so may contain 
        parse errors */
+    /* Write pending notifications first, a failure is handled as send error below */
+    if (ce->ce_outq)
+	ce_output_flush(ce);
     if (send_msg_reply(ce->ce_s, cbuf_get(cbret), cbuf_len(cbret)+1) < 0){
 	switch (errno){
 	case EPIPE:
@@ -1829,12 +2287,20 @@ from_client_msg(clicon_handle        h,
 	    goto done;
 	}
     }
+    /* No zero-copy datastore references are held between messages */
+    if (xmldb_cache_evict(h) < 0)
+	goto done;
+    if (rpc){
+	xml_stats_alloc(&xmlnr1);
+	if (backend_stats_rpc(rpc, &t0, ntohl(msg->op_len), cbuf_len(cbret)+1, xmlnr1-xmlnr0,
+			      strstr(cbuf_get(cbret), "<rpc-error") != NULL) < 0)
+	    goto done;
+    }
     // ok:
     retval = 0;
   done:  
     clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
     if (xnacm){
-	xml_free(xnacm);
 	if (clicon_nacm_cache_set(h, NULL) < 0)
 	    goto done;
     }
@@ -1844,6 +2310,8 @@ from_client_msg(clicon_handle        h,
 	xml_free(xt);
     if (cbret)
 	cbuf_free(cbret);
+    clixon_mem_add(CLIXON_MEM_CLIENT, -(int64_t)msize, -1);
+    clixon_mem_acct_set(acct0);
     /* Sanity: log if clicon_err() is not called ! */
     if (retval < 0 && clicon_errno < 0) 
 	clicon_log(LOG_NOTICE, "%s: Internal error: No clicon_err call on RPC error (message: %s)",
@@ -1955,6 +2423,15 @@ backend_rpc_init(clicon_handle h)
     if (rpc_callback_register(h, from_client_stats, NULL,
 			      CLIXON_LIB_NS, "stats") < 0)
 	goto done;
+    if (rpc_callback_register(h, from_client_datastore_generation, NULL,
+			      CLIXON_LIB_NS, "datastore-generation") < 0)
+	goto done;
+    if (rpc_callback_register(h, from_client_get_values, NULL,
+			      CLIXON_LIB_NS, "get-values") < 0)
+	goto done;
+    if (rpc_callback_register(h, from_client_trace_export, NULL,
+			      CLIXON_LIB_NS, "trace-export") < 0)
+	goto done;
     if (rpc_callback_register(h, from_client_restart_plugin, NULL,
 			      CLIXON_LIB_NS, "restart-plugin") < 0)
 	goto done;
@@ -40,6 +40,15 @@
 /*
  * Types
  */ 
+/*
+ * Notification not yet (completely) written to a client
+ */
+struct client_output{
+    qelem_t               co_q;       /* queue header */
+    struct stream_msg    *co_sm;      /* Shared notification message */
+    size_t                co_off;     /* Bytes of message already written */
+};
+
 /*
  * Client entry.
  * Keep state about every connected client.
@@ -54,6 +63,9 @@ struct client_entry{
     int                   ce_id;      /* Session id */
     char                 *ce_username;/* Translated from peer user cred */
     clicon_handle         ce_handle;  /* clicon config handle (all clients have same?) */
+    struct client_output *ce_outq;    /* Notifications waiting to be written */
+    size_t                ce_outlen;  /* Bytes waiting in ce_outq */
+    int                   ce_readonly;/* Read-only session, see CLICON_SOCK_READONLY */
 };
 
 
@@ -61,6 +73,7 @@ struct client_entry{
  * Prototypes
  */ 
 int backend_client_rm(clicon_handle h, struct client_entry *ce);
+int backend_client_output_free(struct client_entry *ce);
 int from_client(int fd, void *arg);
 int backend_rpc_init(clicon_handle h);
 
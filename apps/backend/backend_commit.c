@@ -70,6 +70,23 @@
 #include "backend_handle.h"
 #include "backend_commit.h"
 #include "backend_client.h"
+#include "backend_stats.h"
+#include "backend_trace.h"
+#include "backend_snapshot.h"
+
+/*! End of a validate/commit phase: record its statistics and trace span
+ * @param[in]     td    Transaction data
+ * @param[in]     name  Phase name
+ * @param[in,out] t     Start time of phase, set to start of next phase
+ */
+static int
+commit_phase(transaction_data_t *td,
+	     const char         *name,
+	     struct timespec    *t)
+{
+    backend_trace_span(name, NULL, td->td_id, t);
+    return backend_stats_phase(name, t);
+}
 
 /*! Key values are checked for validity independent of user-defined callbacks
  *
@@ -465,7 +482,9 @@ from_validate_common(clicon_handle       h,
     int         i;
     cxobj      *xn;
     int         ret;
+    struct timespec t;
     
+    backend_stats_start(&t);
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
 	clicon_err(OE_FATAL, 0, "No DB_SPEC");
 	goto done;
@@ -484,6 +503,8 @@ from_validate_common(clicon_handle       h,
     /* Clear flags xpath for get */
     xml_apply0(td->td_src, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
 	       (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
+    if (commit_phase(td, "load", &t) < 0)
+	goto done;
     /* 3. Compute differences */
     if (xml_diff(yspec, 
 		 td->td_src,
@@ -519,9 +540,13 @@ from_validate_common(clicon_handle       h,
 	xml_flag_set(xn, XML_FLAG_CHANGE);
 	xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
     }
+    if (commit_phase(td, "diff", &t) < 0)
+	goto done;
     /* 4. Call plugin transaction start callbacks */
     if (plugin_transaction_begin_all(h, td) < 0)
 	goto done;
+    if (commit_phase(td, "plugin-begin", &t) < 0)
+	goto done;
 
     /* 5. Make generic validation on all new or changed data.
        Note this is only call that uses 3-values */
@@ -529,14 +554,20 @@ from_validate_common(clicon_handle       h,
 	goto done;
     if (ret == 0)
 	goto fail;
+    if (commit_phase(td, "validate", &t) < 0)
+	goto done;
 
     /* 6. Call plugin transaction validate callbacks */
     if (plugin_transaction_validate_all(h, td) < 0)
 	goto done;
+    if (commit_phase(td, "plugin-validate", &t) < 0)
+	goto done;
 
     /* 7. Call plugin transaction complete callbacks */
     if (plugin_transaction_complete_all(h, td) < 0)
 	goto done;
+    if (commit_phase(td, "plugin-complete", &t) < 0)
+	goto done;
     retval = 1;
  done:
     return retval;
@@ -565,10 +596,15 @@ candidate_commit(clicon_handle h,
     transaction_data_t *td = NULL;
     int                 ret;
     cxobj              *xret = NULL;
+    struct timespec     t;
+    struct timespec     tc;
 
+    backend_stats_start(&tc);
      /* 1. Start transaction */
     if ((td = transaction_new()) == NULL)
 	goto done;
+    /* Serve read-only sessions from a snapshot of running until commit ends */
+    backend_snapshot_start(h);
 
     /* Common steps (with validate). Load candidate and running and compute diffs
      * Note this is only call that uses 3-values
@@ -580,6 +616,7 @@ candidate_commit(clicon_handle h,
 	    goto done;
 	goto fail;
     }
+    backend_stats_start(&t);
 
      /* 7. Call plugin transaction commit callbacks */
      if (plugin_transaction_commit_all(h, td) < 0)
@@ -587,6 +624,8 @@ candidate_commit(clicon_handle h,
      /* After commit, make a post-commit call (sure that all plugins have committed) */
      if (plugin_transaction_commit_done_all(h, td) < 0)
 	 goto done;
+     if (commit_phase(td, "plugin-commit", &t) < 0)
+	 goto done;
      
      /* Clear cached trees from default values and marking */
      if (xmldb_get0_clear(h, td->td_target) < 0)
@@ -599,6 +638,8 @@ candidate_commit(clicon_handle h,
      if (xmldb_copy(h, candidate, "running") < 0)
 	 goto done;
      xmldb_modified_set(h, candidate, 0); /* reset dirty bit */
+     if (commit_phase(td, "datastore-write", &t) < 0)
+	 goto done;
      /* Here pointers to old (source) tree are obsolete */
      if (td->td_dvec){
 	 td->td_dlen = 0;
@@ -612,6 +653,8 @@ candidate_commit(clicon_handle h,
 
     /* 9. Call plugin transaction end callbacks */
     plugin_transaction_end_all(h, td);
+    if (commit_phase(td, "plugin-end", &t) < 0)
+	goto done;
     
     retval = 1;
  done:
@@ -619,12 +662,14 @@ candidate_commit(clicon_handle h,
      if (td){
 	 if (retval < 1)
 	     plugin_transaction_abort_all(h, td);
+	 backend_trace_commit(h, td->td_id, &tc);
 	 xmldb_get0_free(h, &td->td_target);
 	 xmldb_get0_free(h, &td->td_src);
 	 transaction_free(td);
      }
      if (xret)
 	 xml_free(xret);
+     backend_snapshot_stop(h);
      return retval;
  fail:
     retval = 0;
@@ -73,8 +73,11 @@
 #include "backend_client.h"
 #include "backend_plugin.h"
 #include "backend_commit.h"
+#include "backend_snapshot.h"
 #include "backend_handle.h"
 #include "backend_startup.h"
+#include "backend_stats.h"
+#include "backend_trace.h"
 
 /* Command line options to be passed to getopt(3) */
 #define BACKEND_OPTS "hD:f:E:l:d:p:b:Fza:u:P:1qs:c:U:g:y:o:"
@@ -100,6 +103,7 @@ backend_terminate(clicon_handle h)
     clicon_debug(1, "%s", __FUNCTION__);
     if ((ss = clicon_socket_get(h)) != -1)
 	close(ss);
+    backend_snapshot_exit(h);
     /* Disconnect datastore */
     xmldb_disconnect(h);
     /* Clear module state caches */
@@ -118,11 +122,15 @@ backend_terminate(clicon_handle h)
 	yspec_free(yspec);
     if ((nsctx = clicon_nsctx_global_get(h)) != NULL)
 	cvec_free(nsctx);
+    /* Free compiled NACM policy before the NACM tree it refers to */
+    nacm_policy_exit(h);
     if ((x = clicon_nacm_ext(h)) != NULL)
 	xml_free(x);
     if ((x = clicon_conf_xml(h)) != NULL)
 	xml_free(x);
     stream_publish_exit();
+    backend_stats_exit(h);
+    backend_trace_exit(h);
     clixon_plugin_exit_all(h);
     /* Delete all backend plugin RPC callbacks */
     rpc_callback_delete_all(h);
@@ -910,45 +918,57 @@ main(int    argc,
 			    clicon_option_str(h, "CLICON_BACKEND_REGEXP")) < 0)
 	goto done;
 
-    /* Load Yang modules
-     * 1. Load a yang module as a specific absolute filename */
-    if ((str = clicon_yang_main_file(h)) != NULL)
-	if (yang_spec_parse_file(h, str, yspec) < 0)
+    /* Load pre-resolved yang spec snapshot instead of yang modules if valid */
+    if ((ret = yang_snapshot_load(h, "backend", yspec)) < 0)
+	goto done;
+    if (ret == 0){
+	/* Load Yang modules
+	 * 1. Load a yang module as a specific absolute filename */
+	if ((str = clicon_yang_main_file(h)) != NULL)
+	    if (yang_spec_parse_file(h, str, yspec) < 0)
+		goto done;
+	/* 2. Load a (single) main module */
+	if ((str = clicon_yang_module_main(h)) != NULL)
+	    if (yang_spec_parse_module(h, str, clicon_yang_module_revision(h),
+				       yspec) < 0)
+		goto done;
+	/* 3. Load all modules in a directory (will not overwrite file loaded ^) */
+	if ((str = clicon_yang_main_dir(h)) != NULL)
+	    if (yang_spec_load_dir(h, str, yspec) < 0)
+		goto done;
+	/* Load clixon lib yang module */
+	if (yang_spec_parse_module(h, "clixon-lib", NULL, yspec) < 0)
 	    goto done;
-    /* 2. Load a (single) main module */
-    if ((str = clicon_yang_module_main(h)) != NULL)
-	if (yang_spec_parse_module(h, str, clicon_yang_module_revision(h),
-				   yspec) < 0)
+	/* Load yang module library, RFC7895 */
+	if (yang_modules_init(h) < 0)
 	    goto done;
-    /* 3. Load all modules in a directory (will not overwrite file loaded ^) */
-    if ((str = clicon_yang_main_dir(h)) != NULL)
-	if (yang_spec_load_dir(h, str, yspec) < 0)
+	/* Add generic yang specs, used by netconf client and as internal protocol 
+	 */
+	if (netconf_module_load(h) < 0)
 	    goto done;
-    /* Load clixon lib yang module */
-    if (yang_spec_parse_module(h, "clixon-lib", NULL, yspec) < 0)
-	goto done;
-    /* Load yang module library, RFC7895 */
-    if (yang_modules_init(h) < 0)
-	goto done;
-    /* Add generic yang specs, used by netconf client and as internal protocol 
-     */
-    if (netconf_module_load(h) < 0)
-	goto done;
-    /* Load yang restconf module */
-    if (yang_spec_parse_module(h, "ietf-restconf", NULL, yspec)< 0)
-	goto done;
-    /* Load yang Restconf stream discovery */
-    if (clicon_option_bool(h, "CLICON_STREAM_DISCOVERY_RFC8040") &&
-	yang_spec_parse_module(h, "ietf-restconf-monitoring", NULL, yspec)< 0)
-	goto done;
-    /* Load yang Netconf stream discovery */
-    if (clicon_option_bool(h, "CLICON_STREAM_DISCOVERY_RFC5277") &&
-	yang_spec_parse_module(h, "clixon-rfc5277", NULL, yspec)< 0)
-	goto done;
-    /* Load yang YANG module state */
-    if (clicon_option_bool(h, "CLICON_XMLDB_MODSTATE") &&
-	yang_spec_parse_module(h, "ietf-yang-library", NULL, yspec)< 0)
-	goto done;
+	/* Load yang restconf module */
+	if (yang_spec_parse_module(h, "ietf-restconf", NULL, yspec)< 0)
+	    goto done;
+	/* Load yang Restconf stream discovery */
+	if (clicon_option_bool(h, "CLICON_STREAM_DISCOVERY_RFC8040") &&
+	    yang_spec_parse_module(h, "ietf-restconf-monitoring", NULL, yspec)< 0)
+	    goto done;
+	/* Load yang Netconf stream discovery */
+	if (clicon_option_bool(h, "CLICON_STREAM_DISCOVERY_RFC5277") &&
+	    yang_spec_parse_module(h, "clixon-rfc5277", NULL, yspec)< 0)
+	    goto done;
+	/* Load yang backend statistics */
+	if (clicon_option_bool(h, "CLICON_BACKEND_STATS") &&
+	    yang_spec_parse_module(h, "clixon-stats", NULL, yspec)< 0)
+	    goto done;
+	/* Load yang YANG module state */
+	if (clicon_option_bool(h, "CLICON_XMLDB_MODSTATE") &&
+	    yang_spec_parse_module(h, "ietf-yang-library", NULL, yspec)< 0)
+	    goto done;
+	/* Save loaded yang as snapshot for next startup */
+	if (yang_snapshot_save(h, "backend", yspec) < 0)
+	    goto done;
+    }
     /* Check restconf start/stop from backend */
     if (clicon_option_bool(h, "CLICON_BACKEND_RESTCONF_PROCESS")){
 	if (restconf_pseudo_process_reg(h, yspec) < 0)
@@ -962,6 +982,12 @@ main(int    argc,
     if (clicon_nsctx_global_set(h, nsctx_global) < 0)
 	goto done;
 
+    /* Per-RPC and commit phase statistics, if enabled */
+    if (backend_stats_init(h) < 0)
+	goto done;
+    /* Commit tracing, if enabled */
+    if (backend_trace_init(h) < 0)
+	goto done;
     /* Initialize server socket and save it to handle */
     if (backend_rpc_init(h) < 0)
 	goto done;
@@ -1069,6 +1095,9 @@ main(int    argc,
 	goto done;
     if (xmldb_modified_set(h, "candidate", 0) <0)
 	goto done;
+    /* Release datastores only used at startup, eg tmp and failsafe */
+    if (xmldb_cache_evict(h) < 0)
+	goto done;
     
     /* Set startup status */
     if (clicon_startup_status_set(h, status) < 0)
@@ -1123,6 +1152,9 @@ main(int    argc,
 	goto done;
     if (clicon_socket_set(h, ss) < 0)
 	goto done;
+    /* Initialize read-only socket, if any */
+    if (backend_snapshot_init(h) < 0)
+	goto done;
     if (dbg)
 	clicon_option_dump(h, dbg);
     /* Depending on configure setting, privileges may be dropped here after
@@ -64,6 +64,8 @@
 #include "clixon_backend_transaction.h"
 #include "backend_plugin.h"
 #include "backend_commit.h"
+#include "backend_stats.h"
+#include "backend_trace.h"
 
 /*! Request plugins to reset system state
  * The system 'state' should be the same as the contents of running_db
@@ -436,11 +438,16 @@ plugin_transaction_begin_one(clixon_plugin      *cp,
 			     clicon_handle       h, 
 			     transaction_data_t *td)
 {
-    int         retval = -1;
-    trans_cb_t *fn;
+    int             retval = -1;
+    trans_cb_t     *fn;
+    int             ret;
+    struct timespec t;
     
     if ((fn = cp->cp_api.ca_trans_begin) != NULL){
-	if (fn(h, (transaction_data)td) < 0){
+	backend_stats_start(&t);
+	ret = fn(h, (transaction_data)td);
+	backend_trace_span("begin", cp->cp_name, td->td_id, &t);
+	if (ret < 0){
 	    if (!clicon_errno) /* sanity: log if clicon_err() is not called ! */
 		clicon_log(LOG_NOTICE, "%s: Plugin '%s' callback does not make clicon_err call on error", 
 		       __FUNCTION__, cp->cp_name);
@@ -488,11 +495,16 @@ plugin_transaction_validate_one(clixon_plugin      *cp,
 				clicon_handle       h, 
 				transaction_data_t *td)
 {
-    int         retval = -1;
-    trans_cb_t *fn;
+    int             retval = -1;
+    trans_cb_t     *fn;
+    int             ret;
+    struct timespec t;
     
     if ((fn = cp->cp_api.ca_trans_validate) != NULL){
-	if (fn(h, (transaction_data)td) < 0){
+	backend_stats_start(&t);
+	ret = fn(h, (transaction_data)td);
+	backend_trace_span("validate", cp->cp_name, td->td_id, &t);
+	if (ret < 0){
 	    if (!clicon_errno) /* sanity: log if clicon_err() is not called ! */
 		clicon_log(LOG_NOTICE, "%s: Plugin '%s' callback does not make clicon_err call on error", 
 		       __FUNCTION__, cp->cp_name);
@@ -539,11 +551,16 @@ plugin_transaction_complete_one(clixon_plugin      *cp,
 				clicon_handle       h, 
 				transaction_data_t *td)
 {
-    int         retval = -1;
-    trans_cb_t *fn;
+    int             retval = -1;
+    trans_cb_t     *fn;
+    int             ret;
+    struct timespec t;
     
     if ((fn = cp->cp_api.ca_trans_complete) != NULL){
-	if (fn(h, (transaction_data)td) < 0){
+	backend_stats_start(&t);
+	ret = fn(h, (transaction_data)td);
+	backend_trace_span("complete", cp->cp_name, td->td_id, &t);
+	if (ret < 0){
 	    if (!clicon_errno) /* sanity: log if clicon_err() is not called ! */
 		clicon_log(LOG_NOTICE, "%s: Plugin '%s' callback does not make clicon_err call on error", 
 		       __FUNCTION__, cp->cp_name);
@@ -622,11 +639,16 @@ plugin_transaction_commit_one(clixon_plugin      *cp,
 			      clicon_handle       h, 
 			      transaction_data_t *td)
 {
-    int         retval = -1;
-    trans_cb_t *fn;
+    int             retval = -1;
+    trans_cb_t     *fn;
+    int             ret;
+    struct timespec t;
     
     if ((fn = cp->cp_api.ca_trans_commit) != NULL){
-	if (fn(h, (transaction_data)td) < 0){
+	backend_stats_start(&t);
+	ret = fn(h, (transaction_data)td);
+	backend_trace_span("commit", cp->cp_name, td->td_id, &t);
+	if (ret < 0){
 	    if (!clicon_errno) /* sanity: log if clicon_err() is not called ! */
 		clicon_log(LOG_NOTICE, "%s: Plugin '%s' callback does not make clicon_err call on error", 
 		       __FUNCTION__, cp->cp_name);
@@ -681,11 +703,16 @@ plugin_transaction_commit_done_one(clixon_plugin      *cp,
 				   clicon_handle       h, 
 				   transaction_data_t *td)
 {
-    int         retval = -1;
-    trans_cb_t *fn;
+    int             retval = -1;
+    trans_cb_t     *fn;
+    int             ret;
+    struct timespec t;
     
     if ((fn = cp->cp_api.ca_trans_commit_done) != NULL){
-	if (fn(h, (transaction_data)td) < 0){
+	backend_stats_start(&t);
+	ret = fn(h, (transaction_data)td);
+	backend_trace_span("commit-done", cp->cp_name, td->td_id, &t);
+	if (ret < 0){
 	    if (!clicon_errno) /* sanity: log if clicon_err() is not called ! */
 		clicon_log(LOG_NOTICE, "%s: Plugin '%s' callback does not make clicon_err call on error", 
 		       __FUNCTION__, cp->cp_name);
@@ -732,11 +759,16 @@ plugin_transaction_end_one(clixon_plugin      *cp,
 			   clicon_handle       h, 
 			   transaction_data_t *td)
 {
-    int         retval = -1;
-    trans_cb_t *fn;
+    int             retval = -1;
+    trans_cb_t     *fn;
+    int             ret;
+    struct timespec t;
     
     if ((fn = cp->cp_api.ca_trans_end) != NULL){
-	if (fn(h, (transaction_data)td) < 0){
+	backend_stats_start(&t);
+	ret = fn(h, (transaction_data)td);
+	backend_trace_span("end", cp->cp_name, td->td_id, &t);
+	if (ret < 0){
 	    if (!clicon_errno) /* sanity: log if clicon_err() is not called ! */
 		clicon_log(LOG_NOTICE, "%s: Plugin '%s' callback does not make clicon_err call on error", 
 		       __FUNCTION__, cp->cp_name);
@@ -775,11 +807,16 @@ plugin_transaction_abort_one(clixon_plugin      *cp,
 			     clicon_handle       h, 
 			     transaction_data_t *td)
 {
-    int         retval = -1;
-    trans_cb_t *fn;
+    int             retval = -1;
+    trans_cb_t     *fn;
+    int             ret;
+    struct timespec t;
     
     if ((fn = cp->cp_api.ca_trans_abort) != NULL){
-	if (fn(h, (transaction_data)td) < 0){
+	backend_stats_start(&t);
+	ret = fn(h, (transaction_data)td);
+	backend_trace_span("abort", cp->cp_name, td->td_id, &t);
+	if (ret < 0){
 	    if (!clicon_errno) /* sanity: log if clicon_err() is not called ! */
 		clicon_log(LOG_NOTICE, "%s: Plugin '%s' callback does not make clicon_err call on error", 
 		       __FUNCTION__, cp->cp_name);
@@ -0,0 +1,277 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+  *
+  * Read-only backend socket with commit snapshots, see CLICON_SOCK_READONLY.
+  * Sessions on the read-only socket may only issue read operations (get, get-config,
+  * etc), see from_client_msg. Between commits they are served by the backend as any
+  * other session.
+  * During a commit the backend cannot serve any session. Instead, a snapshot process
+  * is forked when the commit starts. It shares all datastore caches with the backend
+  * copy-on-write, closes all other sockets and serves the read-only socket with the
+  * configuration as it was before the commit. When the commit ends, successfully or
+  * not, the snapshot process is killed and read-only sessions connected to it are
+  * closed. New sessions are then served by the backend and see the committed
+  * configuration.
+  * Only sessions connected during the commit are served by the snapshot. Read-only
+  * sessions connected before the commit stay with the backend and wait for the commit,
+  * since both processes cannot read the same session socket.
+  * The backend is single-threaded, therefore a process and not a thread is used.
+  */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <syslog.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+#include "backend_socket.h"
+#include "backend_client.h"
+#include "backend_handle.h"
+#include "backend_snapshot.h"
+
+/* Read-only server socket, or -1 if not enabled */
+static int   _SNAPSHOT_SS = -1;
+
+/* Pid of running snapshot process, or 0 */
+static pid_t _SNAPSHOT_PID = 0;
+
+/* Pid of killed snapshot process not yet reaped, or 0 */
+static pid_t _SNAPSHOT_REAP = 0;
+
+/*! Terminate snapshot process, checked in clixon_event_loop()
+ */
+static void
+snapshot_sig_term(int arg)
+{
+    clicon_exit_set();
+}
+
+/*! Reap a killed snapshot process
+ * @param[in]  block  Wait for it to exit, otherwise only reap if it has exited
+ */
+static void
+snapshot_reap(int block)
+{
+    pid_t ret;
+
+    if (_SNAPSHOT_REAP == 0)
+	return;
+    while ((ret = waitpid(_SNAPSHOT_REAP, NULL, block?0:WNOHANG)) < 0 && errno == EINTR)
+	;
+    if (ret != 0) /* Reaped, or ECHILD if SIGCHLD is ignored */
+	_SNAPSHOT_REAP = 0;
+}
+
+/*! Timer callback polling a killed snapshot process until it is reaped
+ * So that no zombie is left between commits
+ * @param[in]  fd   Not used
+ * @param[in]  arg  Not used
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+snapshot_reap_timeout(int   fd,
+		      void *arg)
+{
+    struct timeval t;
+    struct timeval t1 = {0, 10000}; /* 10ms */
+
+    snapshot_reap(0);
+    if (_SNAPSHOT_REAP == 0)
+	return 0;
+    gettimeofday(&t, NULL);
+    timeradd(&t, &t1, &t);
+    return clixon_event_reg_timeout(t, snapshot_reap_timeout, NULL,
+				    "snapshot reap timer");
+}
+
+/*! Open read-only backend socket and register callback
+ * @param[in]  h    Clicon handle
+ * @retval     0    OK, or CLICON_SOCK_READONLY not set
+ * @retval    -1    Error
+ */
+int
+backend_snapshot_init(clicon_handle h)
+{
+    char *sock;
+    int   ss;
+
+    if ((sock = clicon_option_str(h, "CLICON_SOCK_READONLY")) == NULL)
+	return 0;
+    if ((ss = backend_socket_init_readonly(h, sock)) < 0)
+	return -1;
+    if (clixon_event_reg_fd(ss, backend_accept_client_readonly, h, "read-only server socket") < 0){
+	close(ss);
+	return -1;
+    }
+    _SNAPSHOT_SS = ss;
+    clicon_debug(1, "%s %s", __FUNCTION__, sock);
+    return 0;
+}
+
+/*! Close read-only backend socket and remove its path
+ * @param[in]  h    Clicon handle
+ */
+int
+backend_snapshot_exit(clicon_handle h)
+{
+    char       *sock;
+    struct stat st;
+
+    backend_snapshot_stop(h);
+    snapshot_reap(1);
+    if (_SNAPSHOT_SS != -1){
+	close(_SNAPSHOT_SS);
+	_SNAPSHOT_SS = -1;
+	if ((sock = clicon_option_str(h, "CLICON_SOCK_READONLY")) != NULL &&
+	    lstat(sock, &st) == 0)
+	    unlink(sock);
+    }
+    return 0;
+}
+
+/*! Serve read-only socket from snapshot, in the child process
+ *
+ * All inherited event registrations and sockets except the read-only socket are
+ * removed, so that the snapshot process cannot interfere with the backend.
+ * @param[in]  h    Clicon handle
+ * @note Never returns
+ */
+static void
+snapshot_serve(clicon_handle h)
+{
+    struct client_entry *ce;
+    int                  ss;
+
+    clixon_event_exit();
+    if ((ss = clicon_socket_get(h)) != -1)
+	close(ss);
+    for (ce = backend_client_list(h); ce; ce = ce->ce_next)
+	if (ce->ce_s != -1)
+	    close(ce->ce_s);
+    if (set_signal(SIGTERM, snapshot_sig_term, NULL) < 0 ||
+	set_signal(SIGINT, snapshot_sig_term, NULL) < 0)
+	_exit(1);
+    if (clixon_event_reg_fd(_SNAPSHOT_SS, backend_accept_client_readonly, h,
+			    "read-only server socket") < 0)
+	_exit(1);
+    clixon_event_loop();
+    _exit(0);
+}
+
+/*! Start snapshot process serving the read-only socket during a commit
+ *
+ * The commit rewrites the running datastore file, so the snapshot must not read it:
+ * unread subtrees of the running cache are read before forking, and no snapshot is
+ * made if running is not cached.
+ * Failure to start a snapshot is not fatal: read-only sessions then wait for the
+ * commit to end as other sessions.
+ * @param[in]  h    Clicon handle
+ * @retval     0    OK, snapshot started or not enabled
+ * @see backend_snapshot_stop  Must be called when commit ends
+ */
+int
+backend_snapshot_start(clicon_handle h)
+{
+    db_elmnt *de;
+    pid_t     pid;
+
+    if (_SNAPSHOT_SS == -1 || _SNAPSHOT_PID != 0)
+	return 0;
+    snapshot_reap(0);
+    if (clicon_datastore_cache(h) == DATASTORE_NOCACHE)
+	return 0;
+    if ((de = clicon_db_elmnt_get(h, "running")) == NULL || de->de_xml == NULL)
+	return 0;
+    if (xmldb_lazy_load(h, "running", NULL) < 0)
+	goto fail;
+    if ((pid = fork()) < 0){
+	clicon_err(OE_UNIX, errno, "fork");
+	goto fail;
+    }
+    if (pid == 0) /* child */
+	snapshot_serve(h);
+    _SNAPSHOT_PID = pid;
+    clicon_debug(1, "%s pid:%d", __FUNCTION__, pid);
+    return 0;
+ fail:
+    clicon_log(LOG_WARNING, "%s: No commit snapshot: %s", __FUNCTION__, clicon_err_reason);
+    clicon_err_reset();
+    return 0;
+}
+
+/*! Kill snapshot process when commit ends
+ *
+ * Read-only sessions connected to the snapshot are closed, new sessions are served
+ * by the backend with the new configuration.
+ * SIGKILL is used so that the snapshot cannot serve any more requests after this
+ * call, without waiting for a request it is serving to complete. It is reaped
+ * without blocking by polling from a timer, or when the next snapshot is started.
+ * @param[in]  h    Clicon handle
+ * @retval     0    OK
+ */
+int
+backend_snapshot_stop(clicon_handle h)
+{
+    pid_t pid;
+
+    if ((pid = _SNAPSHOT_PID) == 0)
+	return 0;
+    _SNAPSHOT_PID = 0;
+    snapshot_reap(1); /* Previous, already killed */
+    if (kill(pid, SIGKILL) < 0 && errno != ESRCH)
+	clicon_log(LOG_WARNING, "%s: kill %d: %s", __FUNCTION__, pid, strerror(errno));
+    _SNAPSHOT_REAP = pid;
+    clicon_debug(1, "%s pid:%d", __FUNCTION__, pid);
+    clixon_event_unreg_timeout(snapshot_reap_timeout, NULL);
+    if (snapshot_reap_timeout(0, NULL) < 0)
+	clicon_err_reset(); /* Reaped when next snapshot is started */
+    return 0;
+}
@@ -217,16 +217,31 @@ backend_socket_init(clicon_handle h)
     return -1;
 }
 
-/*! Accept new socket client
- * @param[in]  fd   Socket (unix or ip)
- * @param[in]  arg  typecast clicon_handle
+/*! Open read-only backend socket, a unix socket
+ * 
+ * @param[in]  h    Clicon handle
+ * @param[in]  sock Unix file-system path, see CLICON_SOCK_READONLY
+ * @retval     s    Socket file descriptor (see socket(2))
+ * @retval    -1    Error
  */
 int
-backend_accept_client(int   fd,
-		      void *arg) 
+backend_socket_init_readonly(clicon_handle h,
+			     char         *sock)
+{
+    return config_socket_init_unix(h, sock);
+}
+
+/*! Accept new socket client, common function
+ * @param[in]  h        Clicon handle
+ * @param[in]  fd       Socket (unix or ip)
+ * @param[in]  readonly Session is read-only
+ */
+static int
+accept_client(clicon_handle h,
+	      int           fd,
+	      int           readonly)
 {
     int                  retval = -1;
-    clicon_handle        h = (clicon_handle)arg;
     int                  s;
     struct sockaddr      from = {0,};
     socklen_t            len;
@@ -249,6 +264,7 @@ backend_accept_client(int   fd,
     if ((ce = backend_client_add(h, &from)) == NULL)
 	goto done;
     ce->ce_handle = h;
+    ce->ce_readonly = readonly;
 
     /* 
      * Get credentials of connected peer - only for unix socket 
@@ -299,3 +315,26 @@ backend_accept_client(int   fd,
 	free(name);
     return retval;
 }
+
+/*! Accept new socket client
+ * @param[in]  fd   Socket (unix or ip)
+ * @param[in]  arg  typecast clicon_handle
+ */
+int
+backend_accept_client(int   fd,
+		      void *arg) 
+{
+    return accept_client((clicon_handle)arg, fd, 0);
+}
+
+/*! Accept new read-only socket client
+ * @param[in]  fd   Read-only unix socket
+ * @param[in]  arg  typecast clicon_handle
+ * @see CLICON_SOCK_READONLY
+ */
+int
+backend_accept_client_readonly(int   fd,
+			       void *arg) 
+{
+    return accept_client((clicon_handle)arg, fd, 1);
+}
@@ -43,6 +43,8 @@
  * Prototypes
  */ 
 int backend_socket_init(clicon_handle h);
+int backend_socket_init_readonly(clicon_handle h, char *sock);
 int backend_accept_client(int fd, void *arg);
+int backend_accept_client_readonly(int fd, void *arg);
 
 #endif  /* _BACKEND_SOCKET_H_ */
@@ -0,0 +1,365 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+  *
+  * Backend statistics: per-RPC and commit phase counters and latencies.
+  * Collected if CLICON_BACKEND_STATS is set and read as state data, see clixon-stats.yang
+  *
+  * Each operation has a counter, sum and max of latencies, and a histogram with
+  * power-of-two buckets in microseconds from which percentiles are estimated.
+  * Entries are kept by value in hash tables keyed by RPC or phase name.
+  */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+#include "backend_stats.h"
+
+/* Number of histogram buckets. Bucket i counts latencies below 2^i microseconds,
+ * the last bucket counts all longer latencies (from about 35 minutes)
+ */
+#define STATS_BUCKETS 32
+
+/*! Statistics of one RPC type or commit phase
+ * Stored by value in a hash table
+ */
+struct backend_stats{
+    uint64_t bs_count;                 /* Number of operations */
+    uint64_t bs_total;                 /* Sum of latencies [us] */
+    uint64_t bs_max;                   /* Max latency [us] */
+    uint64_t bs_hist[STATS_BUCKETS];   /* Latency histogram */
+    uint64_t bs_errors;                /* Replies with rpc-error (rpc only) */
+    uint64_t bs_bytes_in;              /* Sum of request sizes (rpc only) */
+    uint64_t bs_bytes_out;             /* Sum of reply sizes (rpc only) */
+    uint64_t bs_xmlnr;                 /* Sum of created XML nodes (rpc only) */
+};
+
+/* Statistics per RPC name, NULL if not enabled */
+static clicon_hash_t *_STATS_RPC = NULL;
+
+/* Statistics per commit phase name */
+static clicon_hash_t *_STATS_PHASE = NULL;
+
+/*! Get stats entry of a name, create it if not found
+ * @param[in]  hash  Hash table
+ * @param[in]  name  RPC or phase name
+ * @retval     bs    Stats entry
+ * @retval     NULL  Error
+ */
+static struct backend_stats *
+stats_entry(clicon_hash_t *hash,
+	    const char    *name)
+{
+    struct backend_stats *bs;
+    struct backend_stats  bs0 = {0,};
+
+    if ((bs = clicon_hash_value(hash, name, NULL)) == NULL){
+	if (clicon_hash_add(hash, name, &bs0, sizeof(bs0)) == NULL)
+	    return NULL;
+	bs = clicon_hash_value(hash, name, NULL);
+    }
+    return bs;
+}
+
+/*! Add a latency sample since t0 to a stats entry
+ * @param[in]  bs   Stats entry
+ * @param[in]  t0   Start time
+ * @param[in]  t1   End time
+ */
+static void
+stats_sample(struct backend_stats *bs,
+	     struct timespec      *t0,
+	     struct timespec      *t1)
+{
+    uint64_t us;
+    int      i;
+
+    us = backend_timespec_us(t0, t1);
+    bs->bs_count++;
+    bs->bs_total += us;
+    if (us > bs->bs_max)
+	bs->bs_max = us;
+    for (i=0; i<STATS_BUCKETS-1; i++)
+	if (us < (1ULL<<i))
+	    break;
+    bs->bs_hist[i]++;
+}
+
+/*! Estimate a latency percentile from the histogram
+ * @param[in]  bs   Stats entry
+ * @param[in]  pct  Percentile, 0-100
+ * @retval     us   Upper bound of the bucket containing the percentile, capped by max
+ */
+static uint64_t
+stats_percentile(struct backend_stats *bs,
+		 int                   pct)
+{
+    uint64_t n = 0;
+    uint64_t limit;
+    int      i;
+
+    if (bs->bs_count == 0)
+	return 0;
+    limit = (bs->bs_count*pct + 99)/100; /* rank, rounded up */
+    for (i=0; i<STATS_BUCKETS-1; i++){
+	n += bs->bs_hist[i];
+	if (n >= limit)
+	    break;
+    }
+    if (i == STATS_BUCKETS-1 || (1ULL<<i) > bs->bs_max)
+	return bs->bs_max;
+    return 1ULL<<i;
+}
+
+/*! Print timer leafs of a stats entry as XML
+ */
+static void
+stats_timer2cbuf(cbuf                 *cb,
+		 struct backend_stats *bs)
+{
+    cprintf(cb, "<count>%" PRIu64 "</count>", bs->bs_count);
+    cprintf(cb, "<total>%" PRIu64 "</total>", bs->bs_total);
+    cprintf(cb, "<max>%" PRIu64 "</max>", bs->bs_max);
+    cprintf(cb, "<p50>%" PRIu64 "</p50>", stats_percentile(bs, 50));
+    cprintf(cb, "<p99>%" PRIu64 "</p99>", stats_percentile(bs, 99));
+}
+
+/*! Initialize backend statistics if enabled by CLICON_BACKEND_STATS
+ * @param[in]  h     Clicon handle
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see backend_stats_exit
+ */
+int
+backend_stats_init(clicon_handle h)
+{
+    int retval = -1;
+
+    if (!clicon_option_bool(h, "CLICON_BACKEND_STATS"))
+	goto ok;
+    if ((_STATS_RPC = clicon_hash_init()) == NULL)
+	goto done;
+    if ((_STATS_PHASE = clicon_hash_init()) == NULL)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Free backend statistics
+ * @see backend_stats_init
+ */
+int
+backend_stats_exit(clicon_handle h)
+{
+    if (_STATS_RPC){
+	clicon_hash_free(_STATS_RPC);
+	_STATS_RPC = NULL;
+    }
+    if (_STATS_PHASE){
+	clicon_hash_free(_STATS_PHASE);
+	_STATS_PHASE = NULL;
+    }
+    return 0;
+}
+
+/*! Get microseconds between two monotonic timestamps
+ * @param[in]  t0   Start time
+ * @param[in]  t1   End time
+ * @retval     us   Microseconds from t0 to t1
+ */
+uint64_t
+backend_timespec_us(struct timespec *t0,
+		    struct timespec *t1)
+{
+    return (t1->tv_sec - t0->tv_sec)*1000000LL + (t1->tv_nsec - t0->tv_nsec)/1000;
+}
+
+/*! Start a statistics timer
+ * The timer is a monotonic timestamp. It is always set, since it is shared with
+ * tracing, see backend_trace_span
+ * @param[out] t0    Start time
+ * @code
+ *   struct timespec t;
+ *   backend_stats_start(&t);
+ *   ...
+ *   backend_stats_phase("diff", &t);
+ * @endcode
+ */
+void
+backend_stats_start(struct timespec *t0)
+{
+    clock_gettime(CLOCK_MONOTONIC, t0);
+}
+
+/*! Record latency of one RPC
+ * @param[in]  name      RPC name
+ * @param[in]  t0        Time when request was received
+ * @param[in]  bytes_in  Size of request
+ * @param[in]  bytes_out Size of reply
+ * @param[in]  xmlnr     Number of XML nodes created handling the request
+ * @param[in]  error     Reply is an rpc-error
+ * @retval     0         OK (also if statistics is not enabled)
+ * @retval    -1         Error
+ */
+int
+backend_stats_rpc(const char      *name,
+		  struct timespec *t0,
+		  size_t           bytes_in,
+		  size_t           bytes_out,
+		  uint64_t         xmlnr,
+		  int              error)
+{
+    struct backend_stats *bs;
+    struct timespec       t1;
+
+    if (_STATS_RPC == NULL)
+	return 0;
+    if ((bs = stats_entry(_STATS_RPC, name)) == NULL)
+	return -1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    stats_sample(bs, t0, &t1);
+    bs->bs_bytes_in += bytes_in;
+    bs->bs_bytes_out += bytes_out;
+    bs->bs_xmlnr += xmlnr;
+    if (error)
+	bs->bs_errors++;
+    return 0;
+}
+
+/*! Record latency of a commit phase since t0, and restart the timer
+ * Consecutive phases can thus be timed with one timer.
+ * @param[in]     name   Phase name
+ * @param[in,out] t0     Start time of phase, set to end time
+ * @retval        0      OK (also if statistics is not enabled)
+ * @retval       -1      Error
+ */
+int
+backend_stats_phase(const char      *name,
+		    struct timespec *t0)
+{
+    struct backend_stats *bs;
+    struct timespec       t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (_STATS_PHASE == NULL){
+	*t0 = t1;
+	return 0;
+    }
+    if ((bs = stats_entry(_STATS_PHASE, name)) == NULL)
+	return -1;
+    stats_sample(bs, t0, &t1);
+    *t0 = t1;
+    return 0;
+}
+
+/*! Get backend statistics as state data
+ * @param[in]     h      Clicon handle
+ * @param[in]     yspec  Yang spec
+ * @param[in,out] xret   Existing XML tree, merge statistics into this
+ * @retval        0      OK
+ * @retval       -1      Error
+ * @see clixon-stats.yang
+ */
+int
+backend_stats_get(clicon_handle h,
+		  yang_stmt    *yspec,
+		  cxobj       **xret)
+{
+    int                   retval = -1;
+    cbuf                 *cb = NULL;
+    char                **keys = NULL;
+    size_t                klen;
+    struct backend_stats *bs;
+    int                   i;
+
+    if (_STATS_RPC == NULL)
+	goto ok;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "<stats xmlns=\"%s\">", CLIXON_STATS_NS);
+    if (clicon_hash_keys(_STATS_RPC, &keys, &klen) < 0)
+	goto done;
+    for (i=0; i<klen; i++){
+	if ((bs = clicon_hash_value(_STATS_RPC, keys[i], NULL)) == NULL)
+	    continue;
+	cprintf(cb, "<rpc><name>%s</name>", keys[i]);
+	stats_timer2cbuf(cb, bs);
+	cprintf(cb, "<errors>%" PRIu64 "</errors>", bs->bs_errors);
+	cprintf(cb, "<bytes-in>%" PRIu64 "</bytes-in>", bs->bs_bytes_in);
+	cprintf(cb, "<bytes-out>%" PRIu64 "</bytes-out>", bs->bs_bytes_out);
+	cprintf(cb, "<xml-nodes>%" PRIu64 "</xml-nodes>", bs->bs_xmlnr);
+	cprintf(cb, "</rpc>");
+    }
+    if (keys){
+	free(keys);
+	keys = NULL;
+    }
+    if (clicon_hash_keys(_STATS_PHASE, &keys, &klen) < 0)
+	goto done;
+    for (i=0; i<klen; i++){
+	if ((bs = clicon_hash_value(_STATS_PHASE, keys[i], NULL)) == NULL)
+	    continue;
+	cprintf(cb, "<phase><name>%s</name>", keys[i]);
+	stats_timer2cbuf(cb, bs);
+	cprintf(cb, "</phase>");
+    }
+    cprintf(cb, "</stats>");
+    if (clixon_xml_parse_string(cbuf_get(cb), YB_MODULE, yspec, xret, NULL) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    if (keys)
+	free(keys);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
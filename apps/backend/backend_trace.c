@@ -0,0 +1,291 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+  *
+  * Backend tracing of validate/commit transactions.
+  * Spans of commit phases and of each plugin transaction callback are recorded with
+  * monotonic timestamps and the transaction id in a fixed-size ring buffer. The ring
+  * is written as a Chrome trace (JSON "complete" events) that can be loaded in
+  * Perfetto or chrome://tracing, on request (trace-export rpc) or automatically after
+  * a commit slower than CLICON_BACKEND_TRACE_SLOW.
+  * The backend is single-threaded so the ring needs no locking, and recording a span
+  * is a slot overwrite without allocation.
+  */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <syslog.h>
+#include <time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+#include "backend_stats.h"
+#include "backend_trace.h"
+
+/* Max length of plugin name in a span, longer names are truncated */
+#define TRACE_NAMELEN 64
+
+/*! One traced span
+ */
+struct trace_span{
+    const char     *ts_name;                 /* Phase or callback name (static string) */
+    char            ts_plugin[TRACE_NAMELEN];/* Plugin name or empty */
+    uint64_t        ts_tid;                  /* Transaction id */
+    struct timespec ts_begin;                /* Monotonic start time */
+    struct timespec ts_end;                  /* Monotonic end time */
+};
+
+/* Ring buffer of spans, NULL if tracing is not enabled */
+static struct trace_span *_TRACE_RING = NULL;
+
+/* Number of slots in ring buffer */
+static uint32_t           _TRACE_SIZE = 0;
+
+/* Total number of spans recorded, next slot is _TRACE_NR % _TRACE_SIZE */
+static uint64_t           _TRACE_NR = 0;
+
+/*! Initialize tracing if enabled by CLICON_BACKEND_TRACE_SPANS
+ * @param[in]  h     Clicon handle
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see backend_trace_exit
+ */
+int
+backend_trace_init(clicon_handle h)
+{
+    int retval = -1;
+    int size;
+
+    if ((size = clicon_option_int(h, "CLICON_BACKEND_TRACE_SPANS")) <= 0)
+	goto ok;
+    if ((_TRACE_RING = calloc(size, sizeof(struct trace_span))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    _TRACE_SIZE = size;
+    _TRACE_NR = 0;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Free tracing ring buffer
+ * @see backend_trace_init
+ */
+int
+backend_trace_exit(clicon_handle h)
+{
+    if (_TRACE_RING){
+	free(_TRACE_RING);
+	_TRACE_RING = NULL;
+    }
+    _TRACE_SIZE = 0;
+    _TRACE_NR = 0;
+    return 0;
+}
+
+/*! Record a span from t0 until now
+ * @param[in]  name    Phase or callback name, must be a static string
+ * @param[in]  plugin  Plugin filename, or NULL
+ * @param[in]  tid     Transaction id
+ * @param[in]  t0      Monotonic start time, see backend_stats_start
+ * @code
+ *   struct timespec t;
+ *   backend_stats_start(&t);
+ *   fn(h, td);
+ *   backend_trace_span("validate", cp->cp_name, td->td_id, &t);
+ * @endcode
+ */
+void
+backend_trace_span(const char      *name,
+		   const char      *plugin,
+		   uint64_t         tid,
+		   struct timespec *t0)
+{
+    struct trace_span *ts;
+    const char        *p;
+
+    if (_TRACE_RING == NULL)
+	return;
+    ts = &_TRACE_RING[_TRACE_NR++ % _TRACE_SIZE];
+    clock_gettime(CLOCK_MONOTONIC, &ts->ts_end);
+    ts->ts_begin = *t0;
+    ts->ts_name = name;
+    ts->ts_tid = tid;
+    ts->ts_plugin[0] = '\0';
+    if (plugin){
+	if ((p = strrchr(plugin, '/')) != NULL)
+	    plugin = p+1;
+	strncpy(ts->ts_plugin, plugin, TRACE_NAMELEN-1);
+	ts->ts_plugin[TRACE_NAMELEN-1] = '\0';
+    }
+}
+
+/*! Print a string as JSON string contents
+ * Only quote, backslash and control characters need escaping in names
+ */
+static void
+trace_json_str(FILE       *f,
+	       const char *str)
+{
+    const char *s;
+
+    for (s=str; *s; s++){
+	if (*s == '"' || *s == '\\')
+	    fprintf(f, "\\%c", *s);
+	else if ((unsigned char)*s < 0x20)
+	    fprintf(f, "\\u%04x", (unsigned char)*s);
+	else
+	    fputc(*s, f);
+    }
+}
+
+/*! Write all spans in the ring buffer as a Chrome trace JSON file
+ *
+ * Each span is a complete event ("ph":"X") with time in microseconds, pid of the
+ * backend and the transaction id as thread id, so that each transaction is shown
+ * on its own track with plugin callbacks nested in the phases.
+ * @param[in]  h       Clicon handle
+ * @param[out] nr      Number of spans written (if not NULL)
+ * @retval     0       OK
+ * @retval    -1       Error, eg tracing not enabled or file cannot be written
+ * @see CLICON_BACKEND_TRACE_FILE
+ */
+int
+backend_trace_export(clicon_handle h,
+		     uint32_t     *nr)
+{
+    int                retval = -1;
+    char              *file;
+    FILE              *f = NULL;
+    struct trace_span *ts;
+    uint64_t           i;
+    uint64_t           i0;
+    uint64_t           ns;
+    uint64_t           dur;
+    int                first = 1;
+
+    if (_TRACE_RING == NULL){
+	clicon_err(OE_CFG, EINVAL, "Tracing not enabled, see CLICON_BACKEND_TRACE_SPANS");
+	goto done;
+    }
+    if ((file = clicon_option_str(h, "CLICON_BACKEND_TRACE_FILE")) == NULL){
+	clicon_err(OE_CFG, EINVAL, "CLICON_BACKEND_TRACE_FILE not set");
+	goto done;
+    }
+    if ((f = fopen(file, "w")) == NULL){
+	clicon_err(OE_UNIX, errno, "fopen(%s)", file);
+	goto done;
+    }
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    /* Oldest span first */
+    i0 = _TRACE_NR > _TRACE_SIZE ? _TRACE_NR - _TRACE_SIZE : 0;
+    for (i=i0; i<_TRACE_NR; i++){
+	ts = &_TRACE_RING[i % _TRACE_SIZE];
+	ns = ts->ts_begin.tv_sec*1000000000ULL + ts->ts_begin.tv_nsec;
+	dur = (ts->ts_end.tv_sec - ts->ts_begin.tv_sec)*1000000000LL +
+	    (ts->ts_end.tv_nsec - ts->ts_begin.tv_nsec);
+	fprintf(f, "%s\n{\"name\":\"", first?"":",");
+	trace_json_str(f, ts->ts_name);
+	fprintf(f, "\",\"cat\":\"%s\",\"ph\":\"X\"", ts->ts_plugin[0]?"plugin":"commit");
+	fprintf(f, ",\"ts\":%" PRIu64 ".%03u,\"dur\":%" PRIu64 ".%03u",
+		ns/1000, (unsigned)(ns%1000), dur/1000, (unsigned)(dur%1000));
+	fprintf(f, ",\"pid\":%d,\"tid\":%" PRIu64, getpid(), ts->ts_tid);
+	if (ts->ts_plugin[0]){
+	    fprintf(f, ",\"args\":{\"plugin\":\"");
+	    trace_json_str(f, ts->ts_plugin);
+	    fprintf(f, "\"}");
+	}
+	fprintf(f, "}");
+	first = 0;
+    }
+    fprintf(f, "\n]}\n");
+    if (fclose(f) != 0){
+	f = NULL;
+	clicon_err(OE_UNIX, errno, "fclose(%s)", file);
+	goto done;
+    }
+    f = NULL;
+    if (nr)
+	*nr = _TRACE_NR - i0;
+    retval = 0;
+ done:
+    if (f)
+	fclose(f);
+    return retval;
+}
+
+/*! End of a commit: record the commit span and export the trace if it was slow
+ * @param[in]  h       Clicon handle
+ * @param[in]  tid     Transaction id
+ * @param[in]  t0      Monotonic start time of commit
+ * @see CLICON_BACKEND_TRACE_SLOW
+ */
+void
+backend_trace_commit(clicon_handle    h,
+		     uint64_t         tid,
+		     struct timespec *t0)
+{
+    struct timespec t1;
+    uint64_t        ms;
+    int             slow;
+
+    if (_TRACE_RING == NULL)
+	return;
+    backend_trace_span("commit", NULL, tid, t0);
+    if ((slow = clicon_option_int(h, "CLICON_BACKEND_TRACE_SLOW")) <= 0)
+	return;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if ((ms = backend_timespec_us(t0, &t1)/1000) < slow)
+	return;
+    /* Not fatal for the commit */
+    if (backend_trace_export(h, NULL) < 0)
+	clicon_log(LOG_WARNING, "Slow commit %" PRIu64 " (%" PRIu64 "ms): trace export: %s",
+		   tid, ms, clicon_err_reason);
+    else
+	clicon_log(LOG_NOTICE, "Slow commit %" PRIu64 " (%" PRIu64 "ms): trace written to %s",
+		   tid, ms, clicon_option_str(h, "CLICON_BACKEND_TRACE_FILE"));
+}
@@ -114,6 +114,7 @@ backend_handle_exit(clicon_handle h)
 
     /* only delete client structs, not close sockets, etc, see backend_client_rm WHY NOT? */
     while ((ce = backend_client_list(h)) != NULL){
+	backend_client_output_free(ce);
 	if (ce->ce_s){
 	    close(ce->ce_s);
 	    ce->ce_s = 0;
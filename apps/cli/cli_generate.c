@@ -50,7 +50,9 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <unistd.h>
 #include <syslog.h>
+#include <sys/stat.h>
 #include <sys/param.h>
 
 /* cligen */
@@ -58,6 +60,7 @@
 
 /* Clicon */
 #include <clixon/clixon.h>
+#include <clixon/clixon_sha1.h>
 
 #include "clixon_cli_api.h"
 #include "cli_plugin.h"
@@ -991,6 +994,143 @@ yang2cli_stmt(clicon_handle h,
     return retval;
 }
 
+/*! Compute key of generated CLI syntax in the autocli cache
+ *
+ * The key is a SHA1 hash of everything the generated syntax depends on: the clixon version,
+ * the autocli options and the complete (printed) YANG specification.
+ * @param[in]  h         Clixon handle
+ * @param[in]  yn        Yang spec
+ * @param[in]  state     Set to include state syntax
+ * @param[in]  show_tree Is tree for show cli command
+ * @param[out] key       Hex string. Free with free()
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+yang2cli_cache_key(clicon_handle h,
+		   yang_stmt    *yn,
+		   int           state,
+		   int           show_tree,
+		   char        **key)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "%s %d %d %d %d %d\n", CLIXON_VERSION_STRING,
+	    clicon_cli_genmodel_type(h),
+	    clicon_cli_genmodel_completion(h),
+	    clicon_yang_regexp(h),
+	    state, show_tree);
+    if (yang_print_cbuf(cb, yn, 0) < 0)
+	goto done;
+    if ((*key = clicon_sha1hex(cbuf_get(cb))) == NULL)
+	goto done;
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Read generated CLI syntax from autocli cache file
+ * @param[in]  dir  Cache directory
+ * @param[in]  key  Cache key
+ * @param[out] cb   Generated CLI syntax
+ * @retval     1    Found, cb contains syntax
+ * @retval     0    Not found
+ * @retval    -1    Error
+ */
+static int
+yang2cli_cache_read(char *dir,
+		    char *key,
+		    cbuf *cb)
+{
+    int         retval = -1;
+    char        filename[MAXPATHLEN];
+    FILE       *f = NULL;
+    struct stat st;
+    char       *buf = NULL;
+
+    snprintf(filename, MAXPATHLEN-1, "%s/%s.cli", dir, key);
+    if ((f = fopen(filename, "r")) == NULL){
+	retval = 0;
+	goto done;
+    }
+    if (fstat(fileno(f), &st) < 0){
+	clicon_err(OE_UNIX, errno, "fstat(%s)", filename);
+	goto done;
+    }
+    if ((buf = malloc(st.st_size+1)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    if (fread(buf, 1, st.st_size, f) != st.st_size){
+	clicon_err(OE_UNIX, errno, "fread(%s)", filename);
+	goto done;
+    }
+    buf[st.st_size] = '\0';
+    cbuf_append_str(cb, buf);
+    retval = 1;
+ done:
+    if (buf)
+	free(buf);
+    if (f)
+	fclose(f);
+    return retval;
+}
+
+/*! Write generated CLI syntax to autocli cache file
+ * The file is written to a temporary file and then renamed so that concurrently starting
+ * CLI processes never read a partially written file.
+ * @param[in]  dir  Cache directory
+ * @param[in]  key  Cache key
+ * @param[in]  cb   Generated CLI syntax
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+yang2cli_cache_write(char *dir,
+		     char *key,
+		     cbuf *cb)
+{
+    int   retval = -1;
+    char  filename[MAXPATHLEN];
+    char  tmpfile[MAXPATHLEN];
+    FILE *f = NULL;
+
+    snprintf(filename, MAXPATHLEN-1, "%s/%s.cli", dir, key);
+    snprintf(tmpfile, MAXPATHLEN-1, "%s/%s.cli.%d", dir, key, getpid());
+    if ((f = fopen(tmpfile, "w")) == NULL){
+	clicon_err(OE_UNIX, errno, "fopen(%s)", tmpfile);
+	goto done;
+    }
+    if (fwrite(cbuf_get(cb), 1, cbuf_len(cb), f) != cbuf_len(cb)){
+	clicon_err(OE_UNIX, errno, "fwrite(%s)", tmpfile);
+	goto done;
+    }
+    if (fclose(f) < 0){
+	f = NULL;
+	clicon_err(OE_UNIX, errno, "fclose(%s)", tmpfile);
+	goto done;
+    }
+    f = NULL;
+    if (rename(tmpfile, filename) < 0){
+	clicon_err(OE_UNIX, errno, "rename(%s)", filename);
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (f)
+	fclose(f);
+    if (retval < 0)
+	unlink(tmpfile);
+    return retval;
+}
+
 /*! Generate CLI code for Yang specification
  * @param[in]  h         Clixon handle
  * @param[in]  yn        Create parse-tree from this yang node
@@ -1014,6 +1154,9 @@ yang2cli(clicon_handle      h,
     yang_stmt         *yc;
     cvec              *globals;       /* global variables from syntax */
     enum genmodel_type gt;
+    char              *cachedir;
+    char              *key = NULL;
+    int                ret = 0;
 
     if (pt == NULL){
 	clicon_err(OE_YANG, EINVAL, "pt is NULL");
@@ -1024,11 +1167,24 @@ yang2cli(clicon_handle      h,
 	clicon_err(OE_XML, errno, "cbuf_new");
 	goto done;
     }
-    /* Traverse YANG, loop through all modules and generate CLI */
-    yc = NULL;
-    while ((yc = yn_each(yn, yc)) != NULL)
-	if (yang2cli_stmt(h, yc, gt, 0, state, show_tree, cb) < 0)
+    /* Try to get previously generated syntax from autocli cache */
+    if ((cachedir = clicon_option_str(h, "CLICON_CLI_GENMODEL_CACHE_DIR")) != NULL){
+	if (yang2cli_cache_key(h, yn, state, show_tree, &key) < 0)
 	    goto done;
+	if ((ret = yang2cli_cache_read(cachedir, key, cb)) < 0)
+	    goto done;
+	clicon_debug(1, "%s: autocli cache %s: %s", __FUNCTION__, ret?"hit":"miss", key);
+    }
+    if (ret == 0){
+	/* Traverse YANG, loop through all modules and generate CLI */
+	yc = NULL;
+	while ((yc = yn_each(yn, yc)) != NULL)
+	    if (yang2cli_stmt(h, yc, gt, 0, state, show_tree, cb) < 0)
+		goto done;
+	/* Cache failure is not fatal, the syntax is just regenerated next time */
+	if (key && yang2cli_cache_write(cachedir, key, cb) < 0)
+	    clicon_log(LOG_WARNING, "%s: autocli cache: %s", __FUNCTION__, clicon_err_reason);
+    }
     if (printgen)
 	clicon_log(LOG_NOTICE, "%s: Generated CLI spec:\n%s", __FUNCTION__, cbuf_get(cb));
     else
@@ -1050,6 +1206,8 @@ yang2cli(clicon_handle      h,
 
     retval = 0;
   done:
+    if (key)
+	free(key);
     if (cb)
 	cbuf_free(cb);
     return retval;
@@ -87,6 +87,15 @@ struct cli_handle {
 
     cligen_handle   cl_cligen;   /* cligen handle */
     cli_syntax_t   *cl_stx;	 /* CLI syntax structure */
+    clicon_hash_t  *cl_expand;   /* Completion cache of datastore content, see expand_dbvar */
+};
+
+/*! Datastore content cached for CLI completion
+ * @see cli_expand_cache_get
+ */
+struct expand_cache {
+    uint64_t ec_generation; /* Datastore generation when fetched */
+    cxobj   *ec_xml;        /* Datastore content (get-config reply) */
 };
 
 /*! Return a clicon handle for other CLICON API calls
@@ -122,6 +131,9 @@ cli_handle_exit(clicon_handle h)
 
     if (cl->cl_stx)
 	free(cl->cl_stx);
+    cli_expand_cache_flush(h);
+    if (cl->cl_expand)
+	clicon_hash_free(cl->cl_expand);
     clicon_handle_exit(h); /* frees h and options */
     
     cligen_exit(ch);
@@ -154,6 +166,111 @@ cli_syntax_set(clicon_handle h,
     return 0;
 }
 
+/*! Get datastore content cached for CLI completion
+ * @param[in]  h     Clicon handle
+ * @param[in]  key   Cache key, eg "<db>:<xpath>"
+ * @param[in]  gen   Current generation of the datastore
+ * @retval     xt    Cached XML tree, owned by the cache, do not free
+ * @retval     NULL  Not found or stale (generation has changed)
+ * @see xmldb_generation_get  Backend generation counter
+ */
+cxobj *
+cli_expand_cache_get(clicon_handle h,
+		     char         *key,
+		     uint64_t      gen)
+{
+    struct cli_handle   *cl = handle(h);
+    struct expand_cache *ec;
+
+    if (cl->cl_expand == NULL)
+	return NULL;
+    if ((ec = clicon_hash_value(cl->cl_expand, key, NULL)) == NULL)
+	return NULL;
+    if (ec->ec_generation != gen)
+	return NULL;
+    return ec->ec_xml;
+}
+
+/*! Add datastore content to CLI completion cache
+ * @param[in]  h     Clicon handle
+ * @param[in]  key   Cache key, eg "<db>:<xpath>"
+ * @param[in]  gen   Generation of the datastore when xt was fetched
+ * @param[in]  xt    XML tree. Consumed by the cache
+ * @param[in]  max   Max number of entries, if reached the cache is flushed. 0: unlimited
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+cli_expand_cache_set(clicon_handle h,
+		     char         *key,
+		     uint64_t      gen,
+		     cxobj        *xt,
+		     int           max)
+{
+    int                  retval = -1;
+    struct cli_handle   *cl = handle(h);
+    struct expand_cache *ec;
+    struct expand_cache  ec0 = {0,};
+    char               **keys = NULL;
+    size_t               klen;
+
+    if (cl->cl_expand == NULL &&
+	(cl->cl_expand = clicon_hash_init()) == NULL)
+	goto done;
+    if ((ec = clicon_hash_value(cl->cl_expand, key, NULL)) != NULL){
+	if (ec->ec_xml)
+	    xml_free(ec->ec_xml);
+	ec->ec_xml = NULL;
+    }
+    else if (max){
+	if (clicon_hash_keys(cl->cl_expand, &keys, &klen) < 0)
+	    goto done;
+	if (klen >= max && cli_expand_cache_flush(h) < 0)
+	    goto done;
+    }
+    ec0.ec_generation = gen;
+    ec0.ec_xml = xt;
+    if (clicon_hash_add(cl->cl_expand, key, &ec0, sizeof(ec0)) == NULL)
+	goto done;
+    retval = 0;
+ done:
+    if (keys)
+	free(keys);
+    return retval;
+}
+
+/*! Remove all entries of the CLI completion cache
+ * @param[in]  h     Clicon handle
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+cli_expand_cache_flush(clicon_handle h)
+{
+    int                  retval = -1;
+    struct cli_handle   *cl = handle(h);
+    struct expand_cache *ec;
+    char               **keys = NULL;
+    size_t               klen;
+    int                  i;
+
+    if (cl->cl_expand == NULL)
+	goto ok;
+    if (clicon_hash_keys(cl->cl_expand, &keys, &klen) < 0)
+	goto done;
+    for (i = 0; i < klen; i++){
+	if ((ec = clicon_hash_value(cl->cl_expand, keys[i], NULL)) != NULL &&
+	    ec->ec_xml)
+	    xml_free(ec->ec_xml);
+	clicon_hash_del(cl->cl_expand, keys[i]);
+    }
+ ok:
+    retval = 0;
+ done:
+    if (keys)
+	free(keys);
+    return retval;
+}
 
 /*! Return clicon handle */
 cligen_handle
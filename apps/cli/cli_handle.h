@@ -62,4 +62,9 @@ cli_syntax_t *cli_syntax(clicon_handle h);
 
 int cli_syntax_set(clicon_handle h, cli_syntax_t *stx);
 
+/* Completion cache of datastore content */
+cxobj *cli_expand_cache_get(clicon_handle h, char *key, uint64_t gen);
+int cli_expand_cache_set(clicon_handle h, char *key, uint64_t gen, cxobj *xt, int max);
+int cli_expand_cache_flush(clicon_handle h);
+
 #endif  /* _CLI_HANDLE_H_ */
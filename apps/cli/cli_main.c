@@ -413,6 +413,7 @@ main(int    argc,
     size_t         cligen_bufthreshold;
     int            dbg=0;
     int            nr;
+    int            ret;
     
     /* Defaults */
     once = 0;
@@ -636,35 +637,43 @@ main(int    argc,
 	goto done;
     clicon_dbspec_yang_set(h, yspec);	
 
-    /* Load Yang modules
-     * 1. Load a yang module as a specific absolute filename */
-    if ((str = clicon_yang_main_file(h)) != NULL){
-	if (yang_spec_parse_file(h, str, yspec) < 0)
+    /* Load pre-resolved yang spec snapshot instead of yang modules if valid */
+    if ((ret = yang_snapshot_load(h, "cli", yspec)) < 0)
+	goto done;
+    if (ret == 0){
+	/* Load Yang modules
+	 * 1. Load a yang module as a specific absolute filename */
+	if ((str = clicon_yang_main_file(h)) != NULL){
+	    if (yang_spec_parse_file(h, str, yspec) < 0)
+		goto done;
+	}
+	/* 2. Load a (single) main module */
+	if ((str = clicon_yang_module_main(h)) != NULL){
+	    if (yang_spec_parse_module(h, str, clicon_yang_module_revision(h),
+				       yspec) < 0)
+		goto done;
+	}
+	/* 3. Load all modules in a directory */
+	if ((str = clicon_yang_main_dir(h)) != NULL){
+	    if (yang_spec_load_dir(h, str, yspec) < 0)
+		goto done;
+	}
+
+	/* Load clixon lib yang module */
+	if (yang_spec_parse_module(h, "clixon-lib", NULL, yspec) < 0)
 	    goto done;
-    }
-    /* 2. Load a (single) main module */
-    if ((str = clicon_yang_module_main(h)) != NULL){
-	if (yang_spec_parse_module(h, str, clicon_yang_module_revision(h),
-				   yspec) < 0)
+
+	 /* Load yang module library, RFC7895 */
+	if (yang_modules_init(h) < 0)
 	    goto done;
-    }
-    /* 3. Load all modules in a directory */
-    if ((str = clicon_yang_main_dir(h)) != NULL){
-	if (yang_spec_load_dir(h, str, yspec) < 0)
+
+	/* Add netconf yang spec, used as internal protocol */
+	if (netconf_module_load(h) < 0)
+	    goto done;
+	/* Save loaded yang as snapshot for next startup */
+	if (yang_snapshot_save(h, "cli", yspec) < 0)
 	    goto done;
     }
-
-    /* Load clixon lib yang module */
-    if (yang_spec_parse_module(h, "clixon-lib", NULL, yspec) < 0)
-	goto done;
-
-     /* Load yang module library, RFC7895 */
-    if (yang_modules_init(h) < 0)
-	goto done;
-
-    /* Add netconf yang spec, used as internal protocol */
-    if (netconf_module_load(h) < 0)
-	goto done;
     
     /* Here all modules are loaded 
      * Compute and set canonical namespace context
@@ -70,8 +70,74 @@
 
 /* Exported functions in this file are in clixon_cli_api.h */
 #include "clixon_cli_api.h"
+#include "cli_plugin.h"
+#include "cli_handle.h"
 #include "cli_common.h" /* internal functions */
 
+/* Max number of (db, xpath) entries in the completion cache before it is flushed */
+#define EXPAND_CACHE_MAX 64
+
+/*! Get configuration for completion, using the completion cache if enabled
+ *
+ * If CLICON_CLI_EXPAND_CACHE is set, the reply is cached keyed by (db, xpath) and reused
+ * as long as the generation counter of the datastore in the backend is unchanged. 
+ * This replaces a potentially large get-config with a small datastore-generation request.
+ * @param[in]  h       Clicon handle
+ * @param[in]  db      Name of database
+ * @param[in]  xpath   XPath of get-config filter
+ * @param[in]  nsc     Namespace context of xpath
+ * @param[out] xt      XML tree of reply. 
+ * @param[out] cached  If set, xt is owned by the cache and should not be freed or modified
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+expand_get_config(clicon_handle h,
+		  char         *db,
+		  char         *xpath,
+		  cvec         *nsc,
+		  cxobj       **xt,
+		  int          *cached)
+{
+    int       retval = -1;
+    cbuf     *cb = NULL;
+    uint64_t  gen = 0;
+    cxobj    *x;
+
+    *cached = 0;
+    if (!clicon_option_bool(h, "CLICON_CLI_EXPAND_CACHE")){
+	if (clicon_rpc_get_config(h, NULL, db, xpath, nsc, xt) < 0)
+	    goto done;
+	goto ok;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "%s:%s", db, xpath?xpath:"/");
+    if (clicon_rpc_datastore_generation(h, db, &gen, NULL) < 0)
+	goto done;
+    if ((x = cli_expand_cache_get(h, cbuf_get(cb), gen)) != NULL){
+	*xt = x;
+	*cached = 1;
+	goto ok;
+    }
+    if (clicon_rpc_get_config(h, NULL, db, xpath, nsc, xt) < 0)
+	goto done;
+    /* Do not cache errors */
+    if (xpath_first(*xt, NULL, "/rpc-error") != NULL)
+	goto ok;
+    if (cli_expand_cache_set(h, cbuf_get(cb), gen, *xt, EXPAND_CACHE_MAX) < 0)
+	goto done;
+    *cached = 1;
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
 /*! Completion callback intended for automatically generated data model
  *
  * Returns an expand-type list of commands as used by cligen 'expand' 
@@ -122,6 +188,7 @@ expand_dbvar(void   *h,
     cvec            *nsc = NULL;
     int              ret;
     int              cvvi = 0;
+    int              cached = 0;
     
     if (argv == NULL || cvec_len(argv) != 2){
 	clicon_err(OE_PLUGIN, EINVAL, "requires arguments: <db> <xmlkeyfmt>");
@@ -156,8 +223,8 @@ expand_dbvar(void   *h,
     if (api_path2xpath(api_path, yspec, &xpath, &nsc, NULL) < 0)
 	goto done;
 
-    /* Get configuration */
-    if (clicon_rpc_get_config(h, NULL, dbstr, xpath, nsc, &xt) < 0) /* XXX */
+    /* Get configuration, if cached xt is shared and must not be modified */
+    if (expand_get_config(h, dbstr, xpath, nsc, &xt, &cached) < 0)
     	goto done;
     if ((xe = xpath_first(xt, NULL, "/rpc-error")) != NULL){
 	clixon_netconf_error(xe, "Get configuration", NULL);
@@ -200,6 +267,11 @@ expand_dbvar(void   *h,
 		goto done;
 	    }
 	    xpathcur = yang_argument_get(ypath);
+	    if (cached){ /* Merge below modifies xt, make a private copy */
+		if ((xt = xml_dup(xt)) == NULL)
+		    goto done;
+		cached = 0;
+	    }
 	    if (xml_merge(xt, xtop, yspec, &reason) < 0) /* Merge xtop into xt */
 		goto done;
 	    if (reason){
@@ -264,7 +336,7 @@ expand_dbvar(void   *h,
 	free(xvec);
     if (xtop)
 	xml_free(xtop);
-    if (xt)
+    if (xt && !cached)
 	xml_free(xt);
     if (xpath) 
 	free(xpath);
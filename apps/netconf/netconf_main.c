@@ -69,9 +69,10 @@
 #include "clixon_netconf.h"
 #include "netconf_lib.h"
 #include "netconf_rpc.h"
+#include "netconf_server.h"
 
 /* Command line options to be passed to getopt(3) */
-#define NETCONF_OPTS "hD:f:E:l:qa:u:d:p:y:U:t:eo:"
+#define NETCONF_OPTS "hD:f:E:l:qa:u:d:p:y:U:t:eo:SC:"
 
 #define NETCONF_LOGFILE "/tmp/clixon_netconf.log"
 
@@ -527,7 +528,9 @@ usage(clicon_handle h,
 	    "\t-U <user>\tOver-ride unix user with a pseudo user for NACM.\n"
 	    "\t-t <sec>\tTimeout in seconds. Quit after this time.\n"
 	    "\t-e \t\tDont ignore errors on packet input.\n"
-	    "\t-o \"<option>=<value>\"\tGive configuration option overriding config file (see clixon-config.yang)\n",
+	    "\t-o \"<option>=<value>\"\tGive configuration option overriding config file (see clixon-config.yang)\n"
+	    "\t-S \t\tRun as persistent netconf server on CLICON_NETCONF_SOCK\n"
+	    "\t-C <sock>\tConnect stdin/stdout to netconf server socket (eg ssh subsystem)\n",
 	    argv0,
 	    clicon_netconf_dir(h)
 	    );
@@ -554,6 +557,11 @@ main(int    argc,
     size_t           cligen_buflen;
     size_t           cligen_bufthreshold;
     int              dbg = 0;
+    int              ret;
+    int              server = 0;
+    int              worker = 0;
+    int              pseudouser = 0;
+    char            *shimsock = NULL;
     
     /* Create handle */
     if ((h = clicon_handle_init()) == NULL)
@@ -595,6 +603,11 @@ main(int    argc,
 		clicon_log_file(optarg+1) < 0)
 		goto done;
 	     break;
+	case 'C': /* Shim: connect to netconf server socket */
+	    if (!strlen(optarg))
+		usage(h, argv[0]);
+	    shimsock = optarg;
+	    break;
 	}
 
     /* 
@@ -603,6 +616,13 @@ main(int    argc,
     clicon_log_init(__PROGRAM__, dbg?LOG_DEBUG:LOG_INFO, logdst); 
     clicon_debug_init(dbg, NULL); 
 
+    /* Shim does not need config, yang or backend: the netconf server has it */
+    if (shimsock != NULL){
+	retval = netconf_shim(h, shimsock);
+	clicon_handle_exit(h);
+	return retval;
+    }
+
     /* Find, read and parse configfile */
     if (clicon_options_main(h) < 0)
 	goto done;
@@ -617,6 +637,7 @@ main(int    argc,
 	case 'f':  /* config file */
 	case 'E': /* extra config dir */
 	case 'l':  /* log  */
+	case 'C':  /* shim */
 	    break; /* see above */
 	case 'q':  /* quiet: dont write hello */
 	    quiet++;
@@ -648,6 +669,7 @@ main(int    argc,
 		usage(h, argv[0]);
 	    if (clicon_username_set(h, optarg) < 0)
 		goto done;
+	    pseudouser++;
 	    break;
 	case 't': /* timeout in seconds */
 	    tv.tv_sec = atoi(optarg);
@@ -655,6 +677,9 @@ main(int    argc,
 	case 'e': /* dont ignore packet errors */
 	    ignore_packet_errors = 0;
 	    break;
+	case 'S': /* Persistent netconf server */
+	    server++;
+	    break;
 	case 'o':{ /* Configuration option */
 	    char          *val;
 	    if ((val = index(optarg, '=')) == NULL)
@@ -698,32 +723,40 @@ main(int    argc,
 	clixon_plugins_load(h, CLIXON_PLUGIN_INIT, dir, NULL) < 0)
 	goto done;
     
-    /* Load Yang modules
-     * 1. Load a yang module as a specific absolute filename */
-    if ((str = clicon_yang_main_file(h)) != NULL){
-	if (yang_spec_parse_file(h, str, yspec) < 0)
+    /* Load pre-resolved yang spec snapshot instead of yang modules if valid */
+    if ((ret = yang_snapshot_load(h, "netconf", yspec)) < 0)
+	goto done;
+    if (ret == 0){
+	/* Load Yang modules
+	 * 1. Load a yang module as a specific absolute filename */
+	if ((str = clicon_yang_main_file(h)) != NULL){
+	    if (yang_spec_parse_file(h, str, yspec) < 0)
+		goto done;
+	}
+	/* 2. Load a (single) main module */
+	if ((str = clicon_yang_module_main(h)) != NULL){
+	    if (yang_spec_parse_module(h, str, clicon_yang_module_revision(h),
+				       yspec) < 0)
+		goto done;
+	}
+	/* 3. Load all modules in a directory */
+	if ((str = clicon_yang_main_dir(h)) != NULL){
+	    if (yang_spec_load_dir(h, str, yspec) < 0)
+		goto done;
+	}
+	/* Load clixon lib yang module */
+	if (yang_spec_parse_module(h, "clixon-lib", NULL, yspec) < 0)
 	    goto done;
-    }
-    /* 2. Load a (single) main module */
-    if ((str = clicon_yang_module_main(h)) != NULL){
-	if (yang_spec_parse_module(h, str, clicon_yang_module_revision(h),
-				   yspec) < 0)
+	 /* Load yang module library, RFC7895 */
+	if (yang_modules_init(h) < 0)
 	    goto done;
-    }
-    /* 3. Load all modules in a directory */
-    if ((str = clicon_yang_main_dir(h)) != NULL){
-	if (yang_spec_load_dir(h, str, yspec) < 0)
+	/* Add netconf yang spec, used by netconf client and as internal protocol */
+	if (netconf_module_load(h) < 0)
+	    goto done;
+	/* Save loaded yang as snapshot for next startup */
+	if (yang_snapshot_save(h, "netconf", yspec) < 0)
 	    goto done;
     }
-    /* Load clixon lib yang module */
-    if (yang_spec_parse_module(h, "clixon-lib", NULL, yspec) < 0)
-	goto done;
-     /* Load yang module library, RFC7895 */
-    if (yang_modules_init(h) < 0)
-	goto done;
-    /* Add netconf yang spec, used by netconf client and as internal protocol */
-    if (netconf_module_load(h) < 0)
-	goto done;
     /* Here all modules are loaded 
      * Compute and set canonical namespace context
      */
@@ -732,6 +765,16 @@ main(int    argc,
     if (clicon_nsctx_global_set(h, nsctx_global) < 0)
 	goto done;
 
+    /* Persistent server: only returns in session workers, with the session
+     * on stdin/stdout, or when the server terminates */
+    if (server){
+	if (netconf_server(h, !pseudouser, &worker) < 0)
+	    goto done;
+	if (!worker){
+	    retval = 0;
+	    goto done;
+	}
+    }
     /* Call start function is all plugins before we go interactive */
     if (clixon_plugin_start_all(h) < 0)
 	goto done;
@@ -0,0 +1,427 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ * Persistent netconf frontend server
+ * Instead of one clixon_netconf process per SSH session, each loading config, YANG
+ * and plugins, a server process does that once and then serves sessions on the unix
+ * socket CLICON_NETCONF_SOCK:
+ *
+ *   sshd -> clixon_netconf -C <sock>  (shim) --unix socket--> worker <- server (-S)
+ *
+ * The server keeps a pool of CLICON_NETCONF_POOL_SIZE idle pre-forked workers waiting
+ * in accept(). A worker serves exactly one session: after accept it tells the server
+ * (which forks a new idle worker), connects the session socket to stdin/stdout and
+ * returns to the ordinary netconf session code, which then runs as if started by sshd.
+ * The session user is the peer user of the unix socket, ie the SSH user running the shim.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <syslog.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/param.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+#include "netconf_server.h"
+
+/* Server notification pipe: workers write their pid when they accept a session,
+ * signal handlers write 0 to wake up the server */
+static int _server_pipe[2] = {-1, -1};
+
+/*! Server signal handler: wake up server, and exit on SIGTERM/SIGINT
+ */
+static void
+netconf_server_sig(int arg)
+{
+    pid_t pid = 0;
+    int   err = errno;
+
+    if (arg != SIGCHLD)
+	clicon_exit_set();
+    if (write(_server_pipe[1], &pid, sizeof(pid)) < 0)
+	;
+    errno = err;
+}
+
+/*! Open the netconf server UNIX domain socket
+ * The socket has 770 permissions and group according to CLICON_SOCK_GROUP, as the
+ * backend socket.
+ * @param[in]  h    Clicon handle
+ * @param[in]  sock Unix file-system path
+ * @retval     s    Socket file descriptor
+ * @retval    -1    Error
+ */
+static int
+netconf_server_socket(clicon_handle h,
+		      char         *sock)
+{
+    int                s;
+    struct sockaddr_un addr;
+    mode_t             old_mask;
+    char              *group;
+    gid_t              gid;
+    struct stat        st;
+
+    if (lstat(sock, &st) == 0 && unlink(sock) < 0){
+	clicon_err(OE_UNIX, errno, "unlink(%s)", sock);
+	return -1;
+    }
+    if ((group = clicon_sock_group(h)) == NULL){
+	clicon_err(OE_FATAL, 0, "clicon_sock_group option not set");
+	return -1;
+    }
+    if (group_name2gid(group, &gid) < 0)
+	return -1;
+    if ((s = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+	clicon_err(OE_UNIX, errno, "socket");
+	return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sock, sizeof(addr.sun_path)-1);
+    old_mask = umask(S_IRWXO | S_IXGRP | S_IXUSR);
+    if (bind(s, (struct sockaddr *)&addr, SUN_LEN(&addr)) < 0){
+	clicon_err(OE_UNIX, errno, "bind");
+	umask(old_mask); 
+	goto err;
+    }
+    umask(old_mask); 
+    if (lchown(sock, -1, gid) < 0){
+	clicon_err(OE_UNIX, errno, "lchown(%s, %s)", sock, group);
+	goto err;
+    }
+    clicon_debug(1, "Listen on netconf server socket at %s", addr.sun_path);
+    if (listen(s, SOMAXCONN) < 0){
+	clicon_err(OE_UNIX, errno, "listen");
+	goto err;
+    }
+    return s;
+  err:
+    close(s);
+    return -1;
+}
+
+/*! Worker: accept one netconf session and make it the stdin/stdout of this process
+ * @param[in]  h        Clicon handle
+ * @param[in]  ss       Server socket
+ * @param[in]  peeruser Set session user to peer user of unix socket
+ * @retval     0        OK, session on stdin/stdout
+ * @retval    -1        Error
+ */
+static int
+netconf_server_worker(clicon_handle h,
+		      int           ss,
+		      int           peeruser)
+{
+    int             retval = -1;
+    int             s = -1;
+    struct sockaddr from = {0,};
+    socklen_t       len;
+    pid_t           pid;
+    char           *name = NULL;
+#ifdef HAVE_SO_PEERCRED        /* Linux. */
+    socklen_t       clen;
+    struct ucred    cr = {0,};
+#elif defined(HAVE_GETPEEREID) /* FreeBSD */
+    uid_t           euid;
+    uid_t           guid;
+#endif
+
+    close(_server_pipe[0]);
+    if (set_signal(SIGTERM, SIG_DFL, NULL) < 0 ||
+	set_signal(SIGINT, SIG_DFL, NULL) < 0 ||
+	set_signal(SIGCHLD, SIG_DFL, NULL) < 0)
+	goto done;
+    len = sizeof(from);
+    while ((s = accept(ss, &from, &len)) < 0){
+	if (errno == EINTR)
+	    continue;
+	clicon_err(OE_UNIX, errno, "accept");
+	goto done;
+    }
+    /* Tell server this worker is busy */
+    pid = getpid();
+    if (write(_server_pipe[1], &pid, sizeof(pid)) < 0){
+	clicon_err(OE_UNIX, errno, "write");
+	goto done;
+    }
+    close(_server_pipe[1]);
+    close(ss);
+    if (peeruser){
+#if defined(HAVE_SO_PEERCRED)
+	clen =  sizeof(cr);
+	if (getsockopt(s, SOL_SOCKET, SO_PEERCRED, &cr, &clen) < 0){
+	    clicon_err(OE_UNIX, errno, "getsockopt");
+	    goto done;
+	}
+	if (uid2name(cr.uid, &name) < 0)
+	    goto done;
+#elif defined(HAVE_GETPEEREID)
+	if (getpeereid(s, &euid, &guid) < 0){
+	    clicon_err(OE_UNIX, errno, "getpeereid");
+	    goto done;
+	}
+	if (uid2name(euid, &name) < 0)
+	    goto done;
+#else
+#error "Need getsockopt O_PEERCRED or getpeereid for unix socket peer cred"
+#endif
+	if (name && clicon_username_set(h, name) < 0)
+	    goto done;
+    }
+    clicon_debug(1, "%s: session user %s", __FUNCTION__, clicon_username_get(h));
+    if (dup2(s, 0) < 0 || dup2(s, 1) < 0){
+	clicon_err(OE_UNIX, errno, "dup2");
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (s != -1)
+	close(s);
+    if (name)
+	free(name);
+    return retval;
+}
+
+/*! Remove pid from idle worker vector
+ */
+static void
+netconf_server_idle_del(pid_t *idle,
+			int   *nidle,
+			pid_t  pid)
+{
+    int i;
+
+    for (i=0; i<*nidle; i++)
+	if (idle[i] == pid){
+	    idle[i] = idle[--(*nidle)];
+	    break;
+	}
+}
+
+/*! Run persistent netconf server with a pool of pre-forked session workers
+ *
+ * Returns in two ways: in a worker when it has accepted a session, or in the server
+ * when it is terminated (SIGTERM/SIGINT). 
+ * @param[in]  h        Clicon handle, with config, YANG and plugins loaded
+ * @param[in]  peeruser Set session user to peer user of unix socket (not if -U)
+ * @param[out] worker   1: in worker process with session on stdin/stdout, 0: server terminated
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+int
+netconf_server(clicon_handle h,
+	       int           peeruser,
+	       int          *worker)
+{
+    int     retval = -1;
+    char   *sock;
+    int     ss = -1;
+    int     size;
+    pid_t  *idle = NULL;
+    int     nidle = 0;
+    pid_t   pid;
+    ssize_t len;
+    int     status;
+    int     i;
+
+    *worker = 0;
+    if ((sock = clicon_option_str(h, "CLICON_NETCONF_SOCK")) == NULL){
+	clicon_err(OE_FATAL, 0, "CLICON_NETCONF_SOCK option not set");
+	goto done;
+    }
+    if ((size = clicon_option_int(h, "CLICON_NETCONF_POOL_SIZE")) < 1)
+	size = 1;
+    if ((idle = calloc(size, sizeof(pid_t))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    if (pipe(_server_pipe) < 0){
+	clicon_err(OE_UNIX, errno, "pipe");
+	goto done;
+    }
+    if ((ss = netconf_server_socket(h, sock)) < 0)
+	goto done;
+    if (set_signal(SIGTERM, netconf_server_sig, NULL) < 0 ||
+	set_signal(SIGINT, netconf_server_sig, NULL) < 0 ||
+	set_signal(SIGCHLD, netconf_server_sig, NULL) < 0)
+	goto done;
+    clicon_log(LOG_NOTICE, "%s: %u Started netconf server on %s", __FUNCTION__, getpid(), sock);
+    while (clicon_exit_get() == 0){
+	/* Keep pool of idle workers full */
+	while (nidle < size){
+	    if ((pid = fork()) < 0){
+		clicon_err(OE_UNIX, errno, "fork");
+		goto done;
+	    }
+	    if (pid == 0){ /* Worker */
+		*worker = 1;
+		free(idle);
+		idle = NULL;
+		retval = netconf_server_worker(h, ss, peeruser);
+		ss = -1; /* closed in worker, not removed */
+		goto worker;
+	    }
+	    idle[nidle++] = pid;
+	}
+	if ((len = read(_server_pipe[0], &pid, sizeof(pid))) < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "read");
+	    goto done;
+	}
+	if (len != sizeof(pid))
+	    continue;
+	if (pid == 0) /* Signal: reap exited workers */
+	    while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
+		netconf_server_idle_del(idle, &nidle, pid);
+	else          /* Worker accepted a session */
+	    netconf_server_idle_del(idle, &nidle, pid);
+    }
+    /* Terminate idle workers, busy workers finish their sessions */
+    for (i=0; i<nidle; i++)
+	kill(idle[i], SIGTERM);
+    clicon_log(LOG_NOTICE, "%s: %u Terminated netconf server", __FUNCTION__, getpid());
+    retval = 0;
+ done:
+    if (ss != -1){
+	close(ss);
+	unlink(sock);
+    }
+    if (_server_pipe[0] != -1){
+	close(_server_pipe[0]);
+	close(_server_pipe[1]);
+    }
+ worker:
+    if (idle)
+	free(idle);
+    return retval;
+}
+
+/*! Write all of buffer to file descriptor
+ */
+static int
+netconf_shim_write(int   fd,
+		   char *buf,
+		   int   len)
+{
+    ssize_t n;
+
+    while (len > 0){
+	if ((n = write(fd, buf, len)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "write");
+	    return -1;
+	}
+	buf += n;
+	len -= n;
+    }
+    return 0;
+}
+
+/*! SSH subsystem shim: splice stdin/stdout to netconf server socket
+ *
+ * Does not read config or YANG, the server has done that.
+ * Use as ssh subsystem in sshd_config, eg:
+ *   Subsystem netconf /usr/local/bin/clixon_netconf -C /usr/local/var/example/netconf.sock
+ * @param[in]  h        Clicon handle
+ * @param[in]  sockpath Netconf server unix socket, see CLICON_NETCONF_SOCK
+ * @retval     0        OK, session closed
+ * @retval    -1        Error
+ */
+int
+netconf_shim(clicon_handle h,
+	     char         *sockpath)
+{
+    int           retval = -1;
+    int           s = -1;
+    struct pollfd fds[2];
+    char          buf[BUFSIZ];
+    ssize_t       n;
+
+    if ((s = clicon_connect_unix(h, sockpath)) < 0)
+	goto done;
+    fds[0].fd = 0;
+    fds[0].events = POLLIN;
+    fds[1].fd = s;
+    fds[1].events = POLLIN;
+    while (1){
+	if (poll(fds, 2, -1) < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "poll");
+	    goto done;
+	}
+	if (fds[0].revents & (POLLIN|POLLHUP|POLLERR)){
+	    if ((n = read(0, buf, sizeof(buf))) <= 0){
+		/* EOF from client: half-close, the server closes when done */
+		shutdown(s, SHUT_WR);
+		fds[0].fd = -1;
+	    }
+	    else if (netconf_shim_write(s, buf, n) < 0)
+		goto done;
+	}
+	if (fds[1].revents & (POLLIN|POLLHUP|POLLERR)){
+	    if ((n = read(s, buf, sizeof(buf))) <= 0)
+		break; /* Server closed session */
+	    if (netconf_shim_write(1, buf, n) < 0)
+		goto done;
+	}
+    }
+    retval = 0;
+ done:
+    if (s != -1)
+	close(s);
+    return retval;
+}
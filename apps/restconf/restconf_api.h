@@ -47,7 +47,7 @@ int restconf_reply_header(void *req, const char *name, const char *vfmt, ...)  _
 int restconf_reply_header(FCGX_Request *req, const char *name, const char *vfmt, ...);
 #endif
 
-int restconf_reply_send(void *req, int code, cbuf *cb);
+int restconf_reply_send(void *req, int code, cbuf *cb); /* cb is consumed on success */
 
 cbuf *restconf_get_indata(void *req);
 
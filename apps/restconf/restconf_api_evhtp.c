@@ -126,11 +126,33 @@ restconf_reply_header(void       *req0,
     return retval;
 }
 
+/*! Free a reply body cbuf when libevent has written it to the connection
+ * @param[in]  data   Start of referenced data (cbuf_get)
+ * @param[in]  len    Length of referenced data
+ * @param[in]  arg    The cbuf
+ * @see restconf_reply_send
+ */
+static void
+restconf_reply_body_free(const void *data,
+			 size_t      len,
+			 void       *arg)
+{
+    cbuf *cb = (cbuf *)arg;
+
+    if (cb)
+	cbuf_free(cb);
+}
+
 /*! Send HTTP reply with potential message body
  * @param[in]     req         Evhtp http request handle
- * @param[in]     cb          Body as a cbuf, send if 
+ * @param[in]     code        HTTP status code
+ * @param[in]     cb          Body as a cbuf, send if non-NULL and non-empty
+ * @retval        0           OK, cb is consumed
+ * @retval       -1           Error, cb is not consumed
  * 
  * Prerequisites: status code set, headers given, body if wanted set
+ * The body is not copied: the cbuf buffer is added by reference to the connection
+ * output and freed by libevent when it has been written to the socket.
  */
 int
 restconf_reply_send(void  *req0,
@@ -166,24 +188,27 @@ restconf_reply_send(void  *req0,
 	cprintf(cb, "\r\n");
 	if (restconf_reply_header(req, "Content-Length", "%d", cbuf_len(cb)) < 0)
 	    goto done;
-    }
-    /* create evbuffer* : bufferevent_write_buffer/ drain, 
-       ie send everything , except body */
-    evhtp_send_reply_start(req, req->status); 
-    /* Write a body if cbuf is nonzero */
-    if (cb != NULL && cbuf_len(cb)){
-	/* Suboptimal, copy from cbuf to evbuffer */
+	/* Reference the cbuf buffer in an evbuffer, no copy */
 	if ((eb = evbuffer_new()) == NULL){
 	    clicon_err(OE_CFG, errno, "evbuffer_new");
 	    goto done;
 	}
-	if (evbuffer_add(eb, cbuf_get(cb), cbuf_len(cb)) < 0){
-	    clicon_err(OE_CFG, errno, "evbuffer_add");
+	if (evbuffer_add_reference(eb, cbuf_get(cb), cbuf_len(cb),
+				   restconf_reply_body_free, cb) < 0){
+	    clicon_err(OE_CFG, errno, "evbuffer_add_reference");
 	    goto done;
 	}
-	evhtp_send_reply_body(req, eb); /* conn->bev = eb, body is different */
+	cb = NULL; /* Now owned by eb */
     }
+    /* create evbuffer* : bufferevent_write_buffer/ drain, 
+       ie send everything , except body */
+    evhtp_send_reply_start(req, req->status); 
+    /* Write a body if any, moves the referenced chain to the connection */
+    if (eb != NULL)
+	evhtp_send_reply_body(req, eb); /* conn->bev = eb, body is different */
     evhtp_send_reply_end(req);      /* just flag finished */
+    if (cb) /* Empty body */
+	cbuf_free(cb);
     retval = 0;
  done:
     if (eb)
@@ -192,28 +217,49 @@ restconf_reply_send(void  *req0,
 }
 
 /*! get input data
- * @param[in]  req        Fastcgi request handle
- * @note Pulls up an event buffer and then copies it to a cbuf. This is not efficient.
+ * @param[in]  req        Evhtp request handle
+ * @retval     cb         Input data as cbuf, free with cbuf_free
+ * @retval     NULL       Error
+ * @note The evbuffer extents are appended to the cbuf directly, without first
+ * linearizing the evbuffer with evbuffer_pullup, ie the data is copied once.
  */
 cbuf *
 restconf_get_indata(void *req0)
 {
-    evhtp_request_t *req = (evhtp_request_t *)req0;    
-    cbuf            *cb = NULL;
-    size_t           len;
-    unsigned char   *buf;
+    evhtp_request_t   *req = (evhtp_request_t *)req0;    
+    cbuf              *cb = NULL;
+    size_t             len;
+    struct evbuffer_iovec *vec = NULL;
+    int                n;
+    int                i;
 
-    if ((cb = cbuf_new()) == NULL)
-	return NULL;
     len = evbuffer_get_length(req->buffer_in);
+    if ((cb = cbuf_new_alloc(len+1)) == NULL){
+	clicon_err(OE_CFG, errno, "cbuf_new_alloc");
+	return NULL;
+    }
     if (len > 0){
-	if ((buf = evbuffer_pullup(req->buffer_in, len)) == NULL){
-	    clicon_err(OE_CFG, errno, "evbuffer_pullup");
-	    return NULL;
+	if ((n = evbuffer_peek(req->buffer_in, len, NULL, NULL, 0)) < 0){
+	    clicon_err(OE_CFG, errno, "evbuffer_peek");
+	    goto err;
 	}
-	/* Note the pullup may not be null-terminated */
-	cbuf_append_buf(cb, buf, len);
+	if ((vec = calloc(n, sizeof(*vec))) == NULL){
+	    clicon_err(OE_UNIX, errno, "calloc");
+	    goto err;
+	}
+	n = evbuffer_peek(req->buffer_in, len, NULL, vec, n);
+	/* Note the extents are not null-terminated */
+	for (i=0; i<n; i++)
+	    if (cbuf_append_buf(cb, vec[i].iov_base, vec[i].iov_len) < 0){
+		clicon_err(OE_CFG, errno, "cbuf_append_buf");
+		goto err;
+	    }
+	free(vec);
     }
-
     return cb;
+ err:
+    if (vec)
+	free(vec);
+    cbuf_free(cb);
+    return NULL;
 }
@@ -183,6 +183,8 @@ restconf_reply_body_add(void     *req0,
  * @param[in]     req   Fastcgi request handle
  * @param[in]     code  Status code
  * @param[in]     cb    Body as a cbuf if non-NULL
+ * @retval        0     OK, cb is consumed
+ * @retval       -1     Error, cb is not consumed
  * 
  * Prerequisites: status code set, headers given, body if wanted set
  */
@@ -203,10 +205,12 @@ restconf_reply_send(void  *req0,
     FCGX_FPrintF(req->out, "\r\n");
     /* Write a body if cbuf is nonzero */
     if (cb != NULL && cbuf_len(cb)){
-	FCGX_FPrintF(req->out, "%s", cbuf_get(cb));
+	FCGX_PutStr(cbuf_get(cb), cbuf_len(cb), req->out);
 	FCGX_FPrintF(req->out, "\r\n");
     }
     FCGX_FFlush(req->out); /* Is this only for notification ? */
+    if (cb)
+	cbuf_free(cb);
     retval = 0;
  done:
     return retval;
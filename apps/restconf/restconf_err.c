@@ -104,6 +104,7 @@ restconf_badrequest(clicon_handle h,
     cprintf(cb, "The requested URL %s or data is in some way badly formed.\n", path);
     if (restconf_reply_send(req, 400, cb) < 0)
 	goto done;
+    cb = NULL; /* consumed */
     retval = 0;
  done:
     if (cb)
@@ -144,6 +145,7 @@ restconf_unauthorized(clicon_handle h,
     cprintf(cb, "The requested URL %s was unauthorized.\n", path);
     if (restconf_reply_send(req, 400, cb) < 0)
 	goto done;
+    cb = NULL; /* consumed */
     retval = 0;
  done:
     if (cb)
@@ -181,6 +183,7 @@ restconf_forbidden(clicon_handle h,
     cprintf(cb, "The requested URL %s was forbidden.\n", path);
     if (restconf_reply_send(req, 403, cb) < 0)
 	goto done;
+    cb = NULL; /* consumed */
     retval = 0;
  done:
     if (cb)
@@ -219,6 +222,7 @@ restconf_notfound(clicon_handle h,
     cprintf(cb, "The requested URL %s was not found on this server.\n", path);
     if (restconf_reply_send(req, 404, cb) < 0)
 	goto done;
+    cb = NULL; /* consumed */
     retval = 0;
  done:
     if (cb)
@@ -276,6 +280,7 @@ restconf_notacceptable(clicon_handle h,
     cprintf(cb, "The target resource does not have a current representation that would be acceptable to the user agent.\n", path);
     if (restconf_reply_send(req, 406, cb) < 0)
 	goto done;
+    cb = NULL; /* consumed */
     retval = 0;
  done:
     if (cb)
@@ -344,6 +349,7 @@ restconf_internal_server_error(clicon_handle h,
     cprintf(cb, "Internal server error when accessing %s</h1>\n", path);
     if (restconf_reply_send(req, 500, cb) < 0)
 	goto done;
+    cb = NULL; /* consumed */
     retval = 0;
  done:
     if (cb)
@@ -472,6 +478,7 @@ api_return_err(clicon_handle h,
     } /* switch media */
     if (restconf_reply_send(req, code, cb) < 0)
 	goto done;
+    cb = NULL; /* consumed */
     // ok:
     retval = 0;
  done:
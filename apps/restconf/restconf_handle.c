@@ -90,6 +90,15 @@ struct restconf_handle {
     
     /* ------ end of common handle ------ */
     clicon_hash_t           *rh_params;    /* restconf parameters, including http headers */
+    clicon_hash_t           *rh_cache;     /* GET reply cache, see restconf_reply_cache_get */
+};
+
+/*! GET reply body cached by restconf
+ * @see restconf_reply_cache_get
+ */
+struct reply_cache {
+    uint64_t rc_generation; /* Running datastore generation when fetched */
+    char    *rc_body;       /* Reply body */
 };
 
 /*! Creates and returns a clicon config handle for other CLICON API calls
@@ -107,6 +116,11 @@ restconf_handle_init(void)
 int
 restconf_handle_exit(clicon_handle h)
 {
+    struct restconf_handle *rh = handle(h);
+
+    restconf_reply_cache_flush(h);
+    if (rh->rh_cache)
+	clicon_hash_free(rh->rh_cache);
     clicon_handle_exit(h); /* frees h and options (and streams) */
     return 0;
 }
@@ -172,3 +186,114 @@ restconf_param_del_all(clicon_handle h)
  done:
     return retval;
 }
+
+/*! Get GET reply body from restconf reply cache
+ * @param[in]  h     Clicon handle
+ * @param[in]  key   Cache key, see api_data_get_cache_key
+ * @param[in]  gen   Current generation of the running datastore
+ * @retval     body  Cached reply body, owned by the cache, do not free
+ * @retval     NULL  Not found or stale (generation has changed)
+ * @see xmldb_generation_get  Backend generation counter
+ */
+char *
+restconf_reply_cache_get(clicon_handle h,
+			 char         *key,
+			 uint64_t      gen)
+{
+    struct restconf_handle *rh = handle(h);
+    struct reply_cache     *rc;
+
+    if (rh->rh_cache == NULL)
+	return NULL;
+    if ((rc = clicon_hash_value(rh->rh_cache, key, NULL)) == NULL)
+	return NULL;
+    if (rc->rc_generation != gen)
+	return NULL;
+    return rc->rc_body;
+}
+
+/*! Add GET reply body to restconf reply cache
+ * @param[in]  h     Clicon handle
+ * @param[in]  key   Cache key, see api_data_get_cache_key
+ * @param[in]  gen   Generation of the running datastore when the reply was fetched
+ * @param[in]  body  Reply body. Copied
+ * @param[in]  max   Max number of entries, if reached the cache is flushed. 0: unlimited
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+restconf_reply_cache_set(clicon_handle h,
+			 char         *key,
+			 uint64_t      gen,
+			 char         *body,
+			 int           max)
+{
+    int                     retval = -1;
+    struct restconf_handle *rh = handle(h);
+    struct reply_cache     *rc;
+    struct reply_cache      rc0 = {0,};
+    char                  **keys = NULL;
+    size_t                  klen;
+
+    if (rh->rh_cache == NULL &&
+	(rh->rh_cache = clicon_hash_init()) == NULL)
+	goto done;
+    if ((rc = clicon_hash_value(rh->rh_cache, key, NULL)) != NULL){
+	if (rc->rc_body)
+	    free(rc->rc_body);
+	rc->rc_body = NULL;
+    }
+    else if (max){
+	if (clicon_hash_keys(rh->rh_cache, &keys, &klen) < 0)
+	    goto done;
+	if (klen >= max && restconf_reply_cache_flush(h) < 0)
+	    goto done;
+    }
+    rc0.rc_generation = gen;
+    if ((rc0.rc_body = strdup(body)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    if (clicon_hash_add(rh->rh_cache, key, &rc0, sizeof(rc0)) == NULL){
+	free(rc0.rc_body);
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (keys)
+	free(keys);
+    return retval;
+}
+
+/*! Remove all entries of the restconf reply cache
+ * @param[in]  h     Clicon handle
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+restconf_reply_cache_flush(clicon_handle h)
+{
+    int                     retval = -1;
+    struct restconf_handle *rh = handle(h);
+    struct reply_cache     *rc;
+    char                  **keys = NULL;
+    size_t                  klen;
+    int                     i;
+
+    if (rh->rh_cache == NULL)
+	goto ok;
+    if (clicon_hash_keys(rh->rh_cache, &keys, &klen) < 0)
+	goto done;
+    for (i = 0; i < klen; i++){
+	if ((rc = clicon_hash_value(rh->rh_cache, keys[i], NULL)) != NULL &&
+	    rc->rc_body)
+	    free(rc->rc_body);
+	clicon_hash_del(rh->rh_cache, keys[i]);
+    }
+ ok:
+    retval = 0;
+ done:
+    if (keys)
+	free(keys);
+    return retval;
+}
@@ -47,5 +47,8 @@ int           restconf_handle_exit(clicon_handle h);
 char         *restconf_param_get(clicon_handle h, const char *param);
 int           restconf_param_set(clicon_handle h, const char *param, char *val);
 int           restconf_param_del_all(clicon_handle h);
+char         *restconf_reply_cache_get(clicon_handle h, char *key, uint64_t gen);
+int           restconf_reply_cache_set(clicon_handle h, char *key, uint64_t gen, char *body, int max);
+int           restconf_reply_cache_flush(clicon_handle h);
 
 #endif  /* _RESTCONF_HANDLE_H_ */
@@ -43,6 +43,8 @@
  * The choice is set at libevhtp compile time by cmake. Eg:
  *    cmake -DEVHTP_DISABLE_EVTHR=ON # Disable threads.
  * Default in testing is disabled threads.
+ * Independently of libevhtp threads, CLICON_RESTCONF_WORKERS worker processes may be
+ * forked after YANG and plugins are loaded, see restconf_workers_start.
  */
 
 #include <stdlib.h>
@@ -63,6 +65,7 @@
 #include <sys/stat.h> /* chmod */
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h> /* TCP_NODELAY */
 #include <arpa/inet.h>
 
 /* evhtp */
@@ -82,6 +85,7 @@
 #include "restconf_api.h"       /* generic not shared with plugins */
 #include "restconf_err.h"
 #include "restconf_root.h"
+#include "restconf_stream.h"
 
 
 /* Command line options to be passed to getopt(3) */
@@ -106,6 +110,28 @@ static cx_evhtp_handle *_EVHTP_HANDLE = NULL;
 /* Need global variable to for signal handler XXX */
 static clicon_handle _CLICON_HANDLE = NULL;
 
+/* Pids of forked restconf workers, only set in the parent process
+ * @see restconf_workers_start
+ */
+static pid_t *_WORKERS = NULL;
+static int    _NWORKERS = 0;
+
+/*! Terminate forked restconf worker processes, in parent
+ */
+static void
+restconf_workers_stop(void)
+{
+    int i;
+
+    for (i=0; i<_NWORKERS; i++)
+	if (_WORKERS[i] > 0)
+	    kill(_WORKERS[i], SIGTERM);
+    if (_WORKERS)
+	free(_WORKERS);
+    _WORKERS = NULL;
+    _NWORKERS = 0;
+}
+
 static void
 evhtp_terminate(cx_evhtp_handle *eh)
 {
@@ -148,12 +174,13 @@ restconf_sig_term(int arg)
 		   __PROGRAM__, __FUNCTION__, getpid(), arg);
     else
 	exit(-1);
+    if (_CLICON_HANDLE)
+	stream_child_freeall(_CLICON_HANDLE);
     if (_EVHTP_HANDLE) /* global */
 	evhtp_terminate(_EVHTP_HANDLE);
-    if (_CLICON_HANDLE){
-	//	stream_child_freeall(_CLICON_HANDLE);
+    if (_CLICON_HANDLE)
 	restconf_terminate(_CLICON_HANDLE);
-    }
+    restconf_workers_stop();
     clicon_exit_set(); /* XXX should rather signal event_base_loop */
     exit(-1);
 }
@@ -168,6 +195,113 @@ restconf_sig_child(int arg)
     }
 }
 
+/*! Fork one restconf worker process
+ * @param[in]  i   Worker index in _WORKERS
+ * @retval     1   OK, in parent
+ * @retval     0   OK, in worker
+ * @retval    -1   Error
+ */
+static int
+restconf_worker_fork(int i)
+{
+    pid_t pid;
+
+    if ((pid = fork()) < 0){
+	clicon_err(OE_UNIX, errno, "fork");
+	return -1;
+    }
+    if (pid == 0){ /* Worker */
+	free(_WORKERS);
+	_WORKERS = NULL;
+	_NWORKERS = 0;
+	if (set_signal(SIGCHLD, restconf_sig_child, NULL) < 0){
+	    clicon_err(OE_DAEMON, errno, "Setting signal");
+	    return -1;
+	}
+	clicon_debug(1, "%s worker %u started", __FUNCTION__, getpid());
+	return 0;
+    }
+    _WORKERS[i] = pid;
+    return 1;
+}
+
+/*! Fork restconf worker processes and restart them when they exit
+ *
+ * Called after YANG and plugins are loaded, but before the event base, sockets and
+ * backend sessions are created. The parent forks CLICON_RESTCONF_WORKERS workers. The
+ * workers return and continue the same startup as a single restconf process: each
+ * creates its own event base and backend connections and binds its own listening
+ * sockets with SO_REUSEPORT, so that the kernel load-balances accepted connections
+ * between them. The YANG spec, options and plugins are shared read-only
+ * (copy-on-write) between the processes.
+ * The parent does not serve requests. It waits for workers to exit and forks a new
+ * worker in place of each, from the same startup state and with the same privileges
+ * as the first ones. It only returns on error, or is terminated by a signal.
+ * Processes are used instead of threads since the clixon handle, error and log
+ * state is not thread-safe.
+ * @param[in]  h   Clicon handle
+ * @retval     0   OK, in worker or if no workers
+ * @retval    -1   Error
+ */
+static int
+restconf_workers_start(clicon_handle h)
+{
+    int   retval = -1;
+    int   n;
+    int   ret;
+    pid_t pid;
+    int   status;
+    int   i;
+
+    if ((n = clicon_option_int(h, "CLICON_RESTCONF_WORKERS")) <= 1)
+	goto ok;
+#ifdef SO_REUSEPORT
+    if ((_WORKERS = calloc(n, sizeof(pid_t))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    _NWORKERS = n;
+    /* Workers are reaped below, not in the signal handler */
+    if (set_signal(SIGCHLD, SIG_DFL, NULL) < 0){
+	clicon_err(OE_DAEMON, errno, "Setting signal");
+	goto done;
+    }
+    for (i=0; i<n; i++){
+	if ((ret = restconf_worker_fork(i)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto ok;
+    }
+    while (1){
+	if ((pid = waitpid(-1, &status, 0)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "waitpid");
+	    goto done;
+	}
+	for (i=0; i<_NWORKERS; i++)
+	    if (_WORKERS[i] == pid)
+		break;
+	if (i == _NWORKERS)
+	    continue;
+	_WORKERS[i] = 0;
+	clicon_log(LOG_WARNING, "%s: restconf worker %d exited with status %d, restarting",
+		   __PROGRAM__, pid, status);
+	sleep(1); /* Avoid a fork loop if workers fail at startup */
+	if ((ret = restconf_worker_fork(i)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto ok;
+    }
+#else
+    clicon_log(LOG_WARNING, "%s: SO_REUSEPORT not supported, CLICON_RESTCONF_WORKERS ignored", __FUNCTION__);
+#endif
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 static char*
 evhtp_method2str(enum htp_method m)
 {
@@ -406,13 +540,23 @@ cx_pre_accept(evhtp_connection_t *conn,
     return EVHTP_RES_OK;
 }
 
+/*! Called when a client connection has been accepted
+ * Disable Nagle on the connection: replies are written in one piece and
+ * persistent (keep-alive) connections should not wait for delayed ACKs between
+ * requests.
+ */
 static evhtp_res
 cx_post_accept(evhtp_connection_t *conn,
 	       void               *arg)
 {
     //    clicon_handle  h = (clicon_handle)arg;
+    evutil_socket_t sock;
+    int             on = 1;
 
     clicon_debug(1, "%s", __FUNCTION__);    
+    if ((sock = conn->sock) >= 0 &&
+	setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (void *)&on, sizeof(on)) == -1)
+	clicon_debug(1, "%s setsockopt TCP_NODELAY: %s", __FUNCTION__, strerror(errno));
     return EVHTP_RES_OK;
 }
 
@@ -513,6 +657,44 @@ cx_path_restconf(evhtp_request_t *req,
     return; /* void */
 }
 
+/*! /streams callback, event stream notifications
+ * @see cx_path_restconf
+ * @see CLICON_STREAM_PATH
+ */
+static void
+cx_path_stream(evhtp_request_t *req,
+	       void            *arg)
+{
+    clicon_handle h = arg;
+    int           ret;
+    cvec         *qvec = NULL;
+
+    clicon_debug(1, "------------");
+    /* input debug */
+    if (clicon_debug_get())
+	evhtp_headers_for_each(req->headers_in, print_header, h);
+    /* Query vector, ie the ?a=x&b=y stuff */
+    if ((qvec = cvec_new(0)) ==NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto done;
+    }
+    /* set fcgi-like paramaters */
+    if ((ret = evhtp_params_set(h, req, qvec)) < 0)
+	goto done;
+    if (ret == 1){
+	/* call generic function */
+	if (api_stream(h, req, qvec, clicon_option_str(h, "CLICON_STREAM_PATH"), NULL) < 0)
+	    goto done;
+    }
+    /* Clear (fcgi) paramaters from this request */
+    if (restconf_param_del_all(h) < 0)
+	goto done;
+ done:
+    if (qvec)
+	cvec_free(qvec);
+    return; /* void */
+}
+
 /*! Get Server cert ssl info
  * @param[in]     h                Clicon handle
  * @param[in]     server_cert_path Path to server ssl cert file
@@ -679,6 +861,14 @@ restconf_socket_init(clicon_handle h,
 	clicon_err(OE_UNIX, errno, "setsockopt SO_REUSEADDR");
 	goto done;
     }
+#ifdef SO_REUSEPORT
+    /* Each restconf worker binds its own socket, see restconf_workers_start */
+    if (clicon_option_int(h, "CLICON_RESTCONF_WORKERS") > 1 &&
+	setsockopt(s, SOL_SOCKET, SO_REUSEPORT, (void *)&on, sizeof(on)) == -1) {
+	clicon_err(OE_UNIX, errno, "setsockopt SO_REUSEPORT");
+	goto done;
+    }
+#endif
     /* only bind ipv6, otherwise it may bind to ipv4 as well which is strange but seems default */
     if (sa->sa_family == AF_INET6 &&
 	setsockopt(s, IPPROTO_IPV6, IPV6_V6ONLY, &on, sizeof(on)) == -1) {
@@ -872,6 +1062,7 @@ cx_evhtp_socket(clicon_handle    h,
     uint16_t     port = 0;
     int          ss;
     evhtp_t     *htp = NULL;
+    cbuf        *cb = NULL;
 
     /* This is socket create a new evhtp_t instance */
     if ((htp = evhtp_new(eh->eh_evbase, NULL)) == NULL){
@@ -896,6 +1087,16 @@ cx_evhtp_socket(clicon_handle    h,
     	clicon_err(OE_EVENTS, errno, "evhtp_set_cb");
     	goto done;
    }
+    /* Callback to be executed for all /streams event stream calls */
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "/%s", clicon_option_str(h, "CLICON_STREAM_PATH"));
+    if (evhtp_set_cb(htp, cbuf_get(cb), cx_path_stream, h) == NULL){
+    	clicon_err(OE_EVENTS, errno, "evhtp_set_cb");
+    	goto done;
+    }
     /* Generic callback called if no other callbacks are matched */
     evhtp_set_gencb(htp, cx_gencb, h);
 
@@ -933,6 +1134,8 @@ cx_evhtp_socket(clicon_handle    h,
 	goto done;
     retval = 0;
  done:
+    if (cb)
+	cbuf_free(cb);
     return retval;
 }
 
@@ -1097,45 +1300,53 @@ restconf_config(clicon_handle    h,
 	goto done;
     cp->cp_api.ca_extension = restconf_main_extension_cb;
 
-    /* Load Yang modules
-     * 1. Load a yang module as a specific absolute filename */
-    if ((str = clicon_yang_main_file(h)) != NULL){
-	if (yang_spec_parse_file(h, str, yspec) < 0)
-	    goto done;
-    }
-    /* 2. Load a (single) main module */
-    if ((str = clicon_yang_module_main(h)) != NULL){
-	if (yang_spec_parse_module(h, str, clicon_yang_module_revision(h),
-				   yspec) < 0)
+    /* Load pre-resolved yang spec snapshot instead of yang modules if valid */
+    if ((ret = yang_snapshot_load(h, "restconf", yspec)) < 0)
+	goto done;
+    if (ret == 0){
+	/* Load Yang modules
+	 * 1. Load a yang module as a specific absolute filename */
+	if ((str = clicon_yang_main_file(h)) != NULL){
+	    if (yang_spec_parse_file(h, str, yspec) < 0)
+		goto done;
+	}
+	/* 2. Load a (single) main module */
+	if ((str = clicon_yang_module_main(h)) != NULL){
+	    if (yang_spec_parse_module(h, str, clicon_yang_module_revision(h),
+				       yspec) < 0)
+		goto done;
+	}
+	/* 3. Load all modules in a directory */
+	if ((str = clicon_yang_main_dir(h)) != NULL){
+	    if (yang_spec_load_dir(h, str, yspec) < 0)
+		goto done;
+	}
+	/* Load clixon lib yang module */
+	if (yang_spec_parse_module(h, "clixon-lib", NULL, yspec) < 0)
 	    goto done;
-    }
-    /* 3. Load all modules in a directory */
-    if ((str = clicon_yang_main_dir(h)) != NULL){
-	if (yang_spec_load_dir(h, str, yspec) < 0)
+	/* Load yang module library, RFC7895 */
+	if (yang_modules_init(h) < 0)
 	    goto done;
-    }
-    /* Load clixon lib yang module */
-    if (yang_spec_parse_module(h, "clixon-lib", NULL, yspec) < 0)
-	goto done;
-    /* Load yang module library, RFC7895 */
-    if (yang_modules_init(h) < 0)
-	goto done;
 
-    /* Load yang restconf module */
-    if (yang_spec_parse_module(h, "ietf-restconf", NULL, yspec)< 0)
-	goto done;
+	/* Load yang restconf module */
+	if (yang_spec_parse_module(h, "ietf-restconf", NULL, yspec)< 0)
+	    goto done;
     
-    /* Add netconf yang spec, used as internal protocol */
-    if (netconf_module_load(h) < 0)
-	goto done;
+	/* Add netconf yang spec, used as internal protocol */
+	if (netconf_module_load(h) < 0)
+	    goto done;
 
-    /* Add system modules */
-    if (clicon_option_bool(h, "CLICON_STREAM_DISCOVERY_RFC8040") &&
-	yang_spec_parse_module(h, "ietf-restconf-monitoring", NULL, yspec)< 0)
-	goto done;
-    if (clicon_option_bool(h, "CLICON_STREAM_DISCOVERY_RFC5277") &&
-	yang_spec_parse_module(h, "clixon-rfc5277", NULL, yspec)< 0)
-	goto done;
+	/* Add system modules */
+	if (clicon_option_bool(h, "CLICON_STREAM_DISCOVERY_RFC8040") &&
+	    yang_spec_parse_module(h, "ietf-restconf-monitoring", NULL, yspec)< 0)
+	    goto done;
+	if (clicon_option_bool(h, "CLICON_STREAM_DISCOVERY_RFC5277") &&
+	    yang_spec_parse_module(h, "clixon-rfc5277", NULL, yspec)< 0)
+	    goto done;
+	/* Save loaded yang as snapshot for next startup */
+	if (yang_snapshot_save(h, "restconf", yspec) < 0)
+	    goto done;
+    }
 
     /* Here all modules are loaded 
      * Compute and set canonical namespace context
@@ -1145,6 +1356,10 @@ restconf_config(clicon_handle    h,
     if (clicon_nsctx_global_set(h, nsctx_global) < 0)
 	goto done;
 
+    /* Fork workers, the rest is done in each worker, the parent supervises them */
+    if (restconf_workers_start(h) < 0)
+	goto done;
+
     /* Init evhtp, common stuff */
     if ((eh->eh_evbase = event_base_new()) == NULL){
 	clicon_err(OE_UNIX, errno, "event_base_new");
@@ -1359,7 +1574,8 @@ main(int    argc,
     retval = 0;
  done:
     clicon_debug(1, "restconf_main_evhtp done");
-    //    stream_child_freeall(h);
+    restconf_workers_stop();
+    stream_child_freeall(h);
     evhtp_terminate(eh);    
     restconf_terminate(h);    
     return retval;
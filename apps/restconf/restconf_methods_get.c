@@ -48,6 +48,7 @@
 #include <time.h>
 #include <signal.h>
 #include <limits.h>
+#include <inttypes.h>
 #include <sys/time.h>
 #include <sys/wait.h>
 
@@ -63,6 +64,184 @@
 #include "restconf_err.h"
 #include "restconf_methods_get.h"
 
+/*! Check if a yang subtree contains only configuration data nodes
+ * @param[in]  ys   Yang node
+ * @retval     1    No config false data node in subtree
+ * @retval     0    Some data node in subtree is config false
+ */
+static int
+yang_subtree_config(yang_stmt *ys)
+{
+    yang_stmt    *yc = NULL;
+    enum rfc_6020 keyw;
+
+    while ((yc = yn_each(ys, yc)) != NULL) {
+	keyw = yang_keyword_get(yc);
+	if (!yang_datanode(yc) && keyw != Y_CHOICE && keyw != Y_CASE)
+	    continue;
+	if (yang_config(yc) == 0)
+	    return 0;
+	if (yang_subtree_config(yc) == 0)
+	    return 0;
+    }
+    return 1;
+}
+
+/*! Check if a GET reply only depends on the running datastore and can be cached
+ *
+ * This is the case if only config data is requested, or if the requested node and
+ * its yang subtree has no config false nodes, ie no state data can be returned.
+ * @param[in]  cplist   Compiled api-path, NULL for datastore root
+ * @param[in]  content  Content query parameter
+ * @retval     1        Reply is determined by running datastore
+ * @retval     0        Reply may contain state data
+ */
+static int
+api_data_get_cacheable(clixon_path    *cplist,
+		       netconf_content content)
+{
+    yang_stmt *ys;
+
+    if (content == CONTENT_CONFIG)
+	return 1;
+    if (content != CONTENT_ALL || cplist == NULL)
+	return 0;
+    ys = PREVQ(clixon_path *, cplist)->cp_yang;
+    if (ys == NULL || yang_config_ancestor(ys) == 0)
+	return 0;
+    return yang_subtree_config(ys);
+}
+
+/*! Create key of GET reply cache from user, media, api-path and query
+ * @param[in]  h        Clixon handle
+ * @param[in]  api_path API-path
+ * @param[in]  qvec     Query parameters
+ * @param[in]  media    Output media
+ * @retval     cb       Key, free with cbuf_free
+ * @retval     NULL     Error
+ */
+static cbuf *
+api_data_get_cache_key(clicon_handle  h,
+		       char          *api_path,
+		       cvec          *qvec,
+		       restconf_media media)
+{
+    cbuf   *cb;
+    cg_var *cv = NULL;
+    char   *user;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	return NULL;
+    }
+    user = clicon_username_get(h);
+    cprintf(cb, "%s %s %s", user?user:"", restconf_media_int2str(media), api_path?api_path:"/");
+    while ((cv = cvec_each(qvec, cv)) != NULL)
+	cprintf(cb, "&%s=%s", cv_name_get(cv), cv_string_get(cv));
+    return cb;
+}
+
+/*! Strong ETag of a GET reply from running generation and cache key
+ * The key is hashed (FNV-1a) so that different users, media and queries get
+ * different entity-tags.
+ * @param[out] cb   Buffer for ETag, including quotes
+ * @param[in]  gen  Running datastore generation
+ * @param[in]  key  Cache key, see api_data_get_cache_key
+ */
+static void
+api_data_get_etag(cbuf     *cb,
+		  uint64_t  gen,
+		  char     *key)
+{
+    uint32_t hash = 2166136261u;
+
+    for (; *key; key++){
+	hash ^= (uint8_t)*key;
+	hash *= 16777619u;
+    }
+    cprintf(cb, "\"%" PRIx64 "-%08" PRIx32 "\"", gen, hash);
+}
+
+/*! Add ETag, Last-Modified and Cache-Control headers to a cacheable GET reply
+ * @param[in]  req      Generic Www handle
+ * @param[in]  etag     Entity-tag including quotes
+ * @param[in]  lastmod  Time of last change of running datastore, 0 if not known
+ */
+static int
+api_data_get_cache_headers(void  *req,
+			   char  *etag,
+			   time_t lastmod)
+{
+    int       retval = -1;
+    struct tm tm;
+    char      date[64];
+
+    if (restconf_reply_header(req, "ETag", "%s", etag) < 0)
+	goto done;
+    if (lastmod && gmtime_r(&lastmod, &tm) != NULL &&
+	strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", &tm) > 0 &&
+	restconf_reply_header(req, "Last-Modified", "%s", date) < 0)
+	goto done;
+    if (restconf_reply_header(req, "Cache-Control", "no-cache") < 0)
+	goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Send successful GET or HEAD reply of an existing resource
+ *
+ * If cacheable (etag given), ETag and Last-Modified are added, and If-None-Match: * is
+ * answered with 304 since the resource is known to exist.
+ * @param[in]     h         Clixon handle
+ * @param[in]     req       Generic Www handle
+ * @param[in]     media_out Output media
+ * @param[in]     etag      Entity-tag including quotes, or NULL if not cacheable
+ * @param[in]     lastmod   Time of last change of running datastore, 0 if not known
+ * @param[in]     head      If 1 is HEAD, otherwise GET
+ * @param[in,out] cbxp      Reply body, set to NULL if consumed
+ */
+static int
+api_data_get_reply(clicon_handle  h,
+		   void          *req,
+		   restconf_media media_out,
+		   char          *etag,
+		   time_t         lastmod,
+		   int            head,
+		   cbuf         **cbxp)
+{
+    int   retval = -1;
+    char *str;
+
+    if (etag){
+	if (api_data_get_cache_headers(req, etag, lastmod) < 0)
+	    goto done;
+	if ((str = restconf_param_get(h, "HTTP_IF_NONE_MATCH")) != NULL &&
+	    strcmp(str, "*") == 0){
+	    if (restconf_reply_send(req, 304, NULL) < 0)
+		goto done;
+	    goto ok;
+	}
+    }
+    else if (restconf_reply_header(req, "Cache-Control", "no-cache") < 0)
+	goto done;
+    if (restconf_reply_header(req, "Content-Type", "%s", restconf_media_int2str(media_out)) < 0)
+	goto done;
+    if (head){
+	/* Same headers as the GET, but no body */
+	if (restconf_reply_send(req, 200, NULL) < 0)
+	    goto done;
+	goto ok;
+    }
+    if (restconf_reply_send(req, 200, *cbxp) < 0)
+	goto done;
+    *cbxp = NULL; /* consumed */
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Generic GET (both HEAD and GET)
  * According to restconf 
  * @param[in]  h        Clixon handle
@@ -90,6 +269,9 @@
  * encoding is used in the response, then an error response containing a
  * "400 Bad Request" status-line MUST be returned by the server.
  * Netconf: <get-config>, <get>                        
+ * If CLICON_RESTCONF_CACHE is set and the reply only depends on the running datastore,
+ * an ETag and Last-Modified is derived from the datastore generation. A request with a
+ * matching If-None-Match gets 304, and a cached reply is returned without a <get>.
  */
 static int
 api_data_get2(clicon_handle  h,
@@ -110,7 +292,7 @@ api_data_get2(clicon_handle  h,
     cxobj     *xerr = NULL; /* malloced */
     cxobj     *xe = NULL;   /* not malloced */
     cxobj    **xvec = NULL;
-    size_t     xlen;
+    int        xlen = 0;
     int        i;
     cxobj     *x;
     int        ret;
@@ -119,9 +301,14 @@ api_data_get2(clicon_handle  h,
     char      *attr; /* attribute value string */
     netconf_content content = CONTENT_ALL;
     int32_t    depth = -1;  /* Nr of levels to print, -1 is all, 0 is none */
-    cxobj     *xtop = NULL;
-    cxobj     *xbot = NULL;
-    yang_stmt *y = NULL;
+    clixon_path *cplist = NULL; /* compiled api-path */
+    int        cachemax;
+    int        cacheable;
+    cbuf      *cbkey = NULL;    /* reply cache key */
+    cbuf      *cbetag = NULL;
+    uint64_t   gen = 0;
+    time_t     lastmod = 0;
+    char      *str;
     
     clicon_debug(1, "%s", __FUNCTION__);
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
@@ -132,16 +319,10 @@ api_data_get2(clicon_handle  h,
     for (i=0; i<pi; i++)
 	api_path = index(api_path+1, '/');
     if (api_path){
-	if ((xtop = xml_new("top", NULL, CX_ELMNT)) == NULL)
-	    goto done;
-	/* Translate api-path to xml, but to validate the api-path, note: strict=1 
-	 * xtop and xbot unnecessary for this function but needed by function
+	/* Validate and resolve api-path once (strict), giving yang nodes, keys and 
+	 * namespace context (nsc), used both for the xpath and for the reply
 	 */
-	if ((ret = api_path2xml(api_path, yspec, xtop, YC_DATANODE, 1, &xbot, &y, &xerr)) < 0)
-	    goto done;
-	/* Translate api-path to xpath: xpath (cbpath) and namespace context (nsc) */
-	if (ret != 0 &&
-	    (ret = api_path2xpath(api_path, yspec, &xpath, &nsc, &xerr)) < 0)
+	if ((ret = api_path_compile(api_path, yspec, &cplist, &nsc, &xerr)) < 0)
 	    goto done;
 	if (ret == 0){ /* validation failed */
 	    if ((xe = xpath_first(xerr, NULL, "rpc-error")) == NULL){
@@ -152,6 +333,8 @@ api_data_get2(clicon_handle  h,
 		goto done;
 	    goto ok;
 	}
+	if (clixon_path2xpath(cplist, &xpath) < 0)
+	    goto done;
     }
 
     /* Check for content attribute */
@@ -194,6 +377,47 @@ api_data_get2(clicon_handle  h,
 	}
     }
 
+    /* Reply determined by running: ETag, If-None-Match and reply cache */
+    cacheable = (cachemax = clicon_option_int(h, "CLICON_RESTCONF_CACHE")) > 0 &&
+	api_data_get_cacheable(cplist, content) == 1;
+    /* The generation is only used for caching, if it cannot be read (eg denied by
+     * NACM) make an uncached GET */
+    if (cacheable &&
+	clicon_rpc_datastore_generation(h, "running", &gen, &lastmod) < 0){
+	clicon_debug(1, "%s no generation, not cached: %s", __FUNCTION__, clicon_err_reason);
+	clicon_err_reset();
+	cacheable = 0;
+    }
+    if (cacheable){
+	if ((cbkey = api_data_get_cache_key(h, api_path, qvec, media_out)) == NULL)
+	    goto done;
+	if ((cbetag = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	api_data_get_etag(cbetag, gen, cbuf_get(cbkey));
+	/* A matching entity-tag was sent in a reply of an existing resource, and the
+	 * generation has not changed since */
+	if ((str = restconf_param_get(h, "HTTP_IF_NONE_MATCH")) != NULL &&
+	    strstr(str, cbuf_get(cbetag)) != NULL){
+	    if (api_data_get_cache_headers(req, cbuf_get(cbetag), lastmod) < 0)
+		goto done;
+	    if (restconf_reply_send(req, 304, NULL) < 0)
+		goto done;
+	    goto ok;
+	}
+	if ((str = restconf_reply_cache_get(h, cbuf_get(cbkey), gen)) != NULL){
+	    clicon_debug(1, "%s cache hit", __FUNCTION__);
+	    if ((cbx = cbuf_new_alloc(strlen(str)+3)) == NULL){
+		clicon_err(OE_UNIX, errno, "cbuf_new_alloc");
+		goto done;
+	    }
+	    cbuf_append_str(cbx, str);
+	    if (api_data_get_reply(h, req, media_out, cbuf_get(cbetag), lastmod, head, &cbx) < 0)
+		goto done;
+	    goto ok;
+	}
+    }
     clicon_debug(1, "%s path:%s", __FUNCTION__, xpath);
     switch (content){
     case CONTENT_CONFIG:
@@ -233,16 +457,6 @@ api_data_get2(clicon_handle  h,
     /* Normal return, no error */
     if ((cbx = cbuf_new()) == NULL)
 	goto done;
-    if (head){
-	/* Same headers as the GET, but no body */
-	if (restconf_reply_header(req, "Cache-Control", "no-cache") < 0)
-	    goto done;
-	if (restconf_reply_header(req, "Content-Type", "%s", restconf_media_int2str(media_out)) < 0)
-	    goto done;
-	if (restconf_reply_send(req, 200, NULL) < 0)
-	    goto done;
-	goto ok;
-    }
     if (xpath==NULL || strcmp(xpath,"/")==0){ /* Special case: data root */
 	switch (media_out){
 	case YANG_DATA_XML:
@@ -258,7 +472,8 @@ api_data_get2(clicon_handle  h,
 	}
     }
     else{
-	if (xpath_vec(xret, nsc, "%s", &xvec, &xlen, xpath) < 0){
+	/* Search reply using the compiled api-path, no xpath parsing */
+	if (clixon_xml_find_path(xret, cplist, &xvec, &xlen) < 0){
 	    if (netconf_operation_failed_xml(&xerr, "application", clicon_err_reason) < 0)
 		goto done;
 	    if ((xe = xpath_first(xerr, NULL, "rpc-error")) == NULL){
@@ -313,11 +528,11 @@ api_data_get2(clicon_handle  h,
 	}
     }
     clicon_debug(1, "%s cbuf:%s", __FUNCTION__, cbuf_get(cbx));
-    if (restconf_reply_header(req, "Content-Type", "%s", restconf_media_int2str(media_out)) < 0)
+    if (cbkey &&
+	restconf_reply_cache_set(h, cbuf_get(cbkey), gen, cbuf_get(cbx), cachemax) < 0)
 	goto done;
-    if (restconf_reply_header(req, "Cache-Control", "no-cache") < 0)
-	goto done;
-    if (restconf_reply_send(req, 200, cbx) < 0)
+    /* Here the resource exists */
+    if (api_data_get_reply(h, req, media_out, cbetag?cbuf_get(cbetag):NULL, lastmod, head, &cbx) < 0)
 	goto done;
  ok:
     retval = 0;
@@ -327,8 +542,12 @@ api_data_get2(clicon_handle  h,
 	free(xpath);
     if (nsc)
 	xml_nsctx_free(nsc);
-    if (xtop)
-        xml_free(xtop);
+    if (cplist)
+	clixon_path_free(cplist);
+    if (cbkey)
+	cbuf_free(cbkey);
+    if (cbetag)
+	cbuf_free(cbetag);
     if (cbx)
         cbuf_free(cbx);
     if (xret)
@@ -518,6 +737,7 @@ api_operations_get(clicon_handle h,
 	goto done;
     if (restconf_reply_send(req, 200, cbx) < 0)
 	goto done;
+    cbx = NULL; /* consumed */
     // ok:
     retval = 0;
  done:
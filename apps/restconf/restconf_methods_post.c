@@ -962,7 +962,8 @@ api_operations_post(clicon_handle h,
 	break;
     }
     if (restconf_reply_send(req, 200, cbret) < 0)
-	goto done;	
+	goto done;
+    cbret = NULL; /* consumed */
  ok:
     retval = 0;
  done:
@@ -110,6 +110,7 @@ api_well_known(clicon_handle h,
 
     if (restconf_reply_send(req, 200, cb) < 0)
 	goto done;
+    cb = NULL; /* consumed */
  ok:
     retval = 0;
  done:
@@ -178,6 +179,7 @@ api_root_restconf_exact(clicon_handle  h,
     }
     if (restconf_reply_send(req, 200, cb) < 0)
 	goto done;
+    cb = NULL; /* consumed */
  ok:
     retval = 0;
  done:
@@ -249,6 +251,7 @@ api_yang_library_version(clicon_handle h,
     }
     if (restconf_reply_send(req, 200, cb) < 0)
 	goto done;
+    cb = NULL; /* consumed */
     retval = 0;
  done:
     if (cb)
@@ -0,0 +1,512 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+  *
+  * Restconf event stream implementation for native (evhtp) restconf.
+  * See RFC 8040 Sections 3.8, 6, 9.3
+  *
+  * Unlike the fcgi variant, no process is forked per subscriber. Clients are served
+  * on the event loop of the restconf daemon as server-sent events in a chunked reply.
+  * Clients requesting the same stream as the same user share one backend subscription:
+  * each notification is read and serialized once, and then written to all its clients.
+  * Requests with start-time or stop-time (replay) get a subscription of their own.
+  * Clients that do not read their stream are disconnected when more than
+  * RESTCONF_STREAM_BUFMAX bytes are queued on their connection.
+  * A backend subscription is closed when its last client disconnects.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <syslog.h>
+#include <fcntl.h>
+#include <time.h>
+#include <limits.h>
+#include <sys/time.h>
+
+/* evhtp */
+#include <evhtp/evhtp.h>
+#include <evhtp/sslutils.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+#include "restconf_lib.h"
+#include "restconf_handle.h"
+#include "restconf_api.h"
+#include "restconf_err.h"
+#include "restconf_stream.h"
+
+struct stream_client;
+
+/* Backend notification subscription, shared by clients of same stream and user
+ */
+struct stream_sub{
+    qelem_t               ss_q;       /* queue header */
+    char                 *ss_key;     /* <user>:<stream>, NULL if not shared (replay) */
+    int                   ss_s;       /* Backend socket */
+    struct event         *ss_ev;      /* Read event of backend socket */
+    struct stream_client *ss_clients; /* SSE clients */
+    int                   ss_busy;    /* Sending to clients, do not free */
+};
+
+/* SSE client of a stream subscription
+ */
+struct stream_client{
+    qelem_t               sc_q;       /* queue header */
+    struct stream_sub    *sc_sub;     /* Subscription */
+    evhtp_request_t      *sc_req;     /* Chunked reply of client */
+};
+
+/* List of backend subscriptions
+ * @note could hang on clicon handle instead.
+ */
+static struct stream_sub *STREAM_SUBS = NULL; 
+
+/*! Close backend subscription and free it, it must not have clients
+ * @param[in]  ss   Subscription
+ */
+static void
+stream_sub_free(struct stream_sub *ss)
+{
+    clicon_debug(1, "%s %s", __FUNCTION__, ss->ss_key?ss->ss_key:"");
+    DELQ(ss, STREAM_SUBS, struct stream_sub *);
+    if (ss->ss_ev)
+	event_free(ss->ss_ev);
+    if (ss->ss_s != -1)
+	close(ss->ss_s);
+    if (ss->ss_key)
+	free(ss->ss_key);
+    free(ss);
+}
+
+/*! Remove client from its subscription, free subscription if it was the last
+ * @param[in]  sc   Stream client
+ */
+static void
+stream_client_rm(struct stream_client *sc)
+{
+    struct stream_sub *ss = sc->sc_sub;
+
+    DELQ(sc, ss->ss_clients, struct stream_client *);
+    free(sc);
+    if (ss->ss_clients == NULL && !ss->ss_busy)
+	stream_sub_free(ss);
+}
+
+/*! Request of client freed, eg client closed connection
+ * @param[in]  req   Evhtp request
+ * @param[in]  arg   Stream client
+ */
+static evhtp_res
+stream_client_fini(evhtp_request_t *req,
+		   void            *arg)
+{
+    struct stream_client *sc = (struct stream_client *)arg;
+
+    clicon_debug(1, "%s", __FUNCTION__);
+    stream_client_rm(sc);
+    return EVHTP_RES_OK;
+}
+
+/*! End stream of client and remove it, eg when backend closes subscription
+ * @param[in]  sc   Stream client
+ */
+static void
+stream_client_end(struct stream_client *sc)
+{
+    evhtp_request_t *req = sc->sc_req;
+
+    evhtp_unset_hook(&req->hooks, evhtp_hook_on_request_fini);
+    stream_client_rm(sc);
+    evhtp_send_reply_chunk_end(req);
+}
+
+/*! Callback when stream notifications arrive from backend
+ *
+ * The notification is serialized once and sent as an event to all clients of the
+ * subscription. Clients with more than RESTCONF_STREAM_BUFMAX bytes unsent are closed.
+ * @param[in]  s     Backend socket
+ * @param[in]  what  Libevent event flags
+ * @param[in]  arg   Subscription
+ */
+static void
+stream_backend_cb(evutil_socket_t s,
+		  short           what,
+		  void           *arg)
+{
+    struct stream_sub     *ss = (struct stream_sub *)arg;
+    struct stream_client  *sc;
+    struct stream_client **scvec = NULL;
+    int                    sclen = 0;
+    evhtp_connection_t    *conn;
+    struct evbuffer       *eb = NULL;
+    struct clicon_msg     *reply = NULL;
+    cxobj                 *xtop = NULL; /* top xml */
+    cxobj                 *xn;          /* notification xml */
+    cbuf                  *cb = NULL;
+    int                    eof;
+    int                    ret;
+    int                    i;
+    
+    clicon_debug(1, "%s", __FUNCTION__);
+    ss->ss_busy++;
+    /* get msg (this is the reason this function is called) */
+    if (clicon_msg_rcv(s, &reply, &eof) < 0){
+	clicon_debug(1, "%s msg_rcv error", __FUNCTION__);
+	eof = 1;
+    }
+    /* Collect clients, closing a slow client removes it from the list */
+    if ((sc = ss->ss_clients) != NULL)
+	do {
+	    sclen++;
+	    sc = NEXTQ(struct stream_client *, sc);
+	} while (sc && sc != ss->ss_clients);
+    if (sclen && (scvec = calloc(sclen, sizeof(*scvec))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    for (i=0, sc=ss->ss_clients; i<sclen; i++, sc = NEXTQ(struct stream_client *, sc))
+	scvec[i] = sc;
+    /* Handle close from backend: end all streams */
+    if (eof){
+	clicon_debug(1, "%s eof", __FUNCTION__);
+	for (i=0; i<sclen; i++)
+	    stream_client_end(scvec[i]);
+	goto done;
+    }
+    if ((ret = clicon_msg_decode(reply, NULL, NULL, &xtop, NULL)) < 0)  /* XXX pass yang_spec */
+	goto done;
+    if (ret == 0){
+	clicon_err(OE_XML, EFAULT, "Invalid notification");
+	goto done;
+    }
+    if ((xn = xpath_first(xtop, NULL, "notification")) == NULL)
+	goto done;
+    /* Serialize event once for all clients */
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "data: ");
+    if (clicon_xml2cbuf(cb, xn, 0, 0, -1) < 0)
+	goto done;
+    cprintf(cb, "\r\n\r\n");
+    if ((eb = evbuffer_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "evbuffer_new");
+	goto done;
+    }
+    for (i=0; i<sclen; i++){
+	sc = scvec[i];
+	conn = evhtp_request_get_connection(sc->sc_req);
+	if (evbuffer_get_length(bufferevent_get_output(evhtp_connection_get_bev(conn)))
+	    > RESTCONF_STREAM_BUFMAX){
+	    clicon_log(LOG_NOTICE, "%s: stream client not reading, closing", __FUNCTION__);
+	    evhtp_connection_free(conn); /* calls stream_client_fini */
+	    continue;
+	}
+	if (evbuffer_add(eb, cbuf_get(cb), cbuf_len(cb)) < 0){
+	    clicon_err(OE_UNIX, errno, "evbuffer_add");
+	    goto done;
+	}
+	evhtp_send_reply_chunk(sc->sc_req, eb); /* drains eb */
+    }
+ done:
+    ss->ss_busy--;
+    if (eof || ss->ss_clients == NULL)
+	stream_sub_free(ss);
+    if (scvec)
+	free(scvec);
+    if (eb)
+	evbuffer_free(eb);
+    if (cb)
+	cbuf_free(cb);
+    if (xtop != NULL)
+	xml_free(xtop);
+    if (reply)
+	free(reply);
+}
+
+/*! Find or create backend subscription
+ * @param[in]  h      Clicon handle
+ * @param[in]  req    Evhtp request
+ * @param[in]  name   Stream name
+ * @param[in]  qvec   Query parameters, start-time and stop-time are used
+ * @param[in]  pretty Pretty-print of error replies
+ * @param[in]  media_out Media of error replies
+ * @param[out] ssp    Subscription, NULL if error reply has been sent
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+restconf_stream(clicon_handle       h,
+		evhtp_request_t    *req,
+		char               *name,
+		cvec               *qvec, 
+		int                 pretty,
+		restconf_media      media_out,
+		struct stream_sub **ssp)
+{
+    int                retval = -1;
+    struct stream_sub *ss = NULL;
+    cxobj             *xret = NULL;
+    cxobj             *xe;
+    cbuf              *cb = NULL;
+    cbuf              *cbkey = NULL;
+    int                s = -1; /* socket */
+    int                replay = 0;
+    int                i;
+    cg_var            *cv;
+    char              *vname;
+    char              *user;
+
+    clicon_debug(1, "%s", __FUNCTION__);
+    *ssp = NULL;
+    if ((cb = cbuf_new()) == NULL || (cbkey = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "<rpc xmlns=\"%s\"><create-subscription xmlns=\"%s\"><stream>%s</stream>",
+	    NETCONF_BASE_NAMESPACE, EVENT_RFC5277_NAMESPACE, name);
+    /* Print all fields */
+    for (i=0; i<cvec_len(qvec); i++){
+        cv = cvec_i(qvec, i);
+	vname = cv_name_get(cv);
+	if (strcmp(vname, "start-time") == 0){
+	    cprintf(cb, "<startTime>");
+	    cv2cbuf(cv, cb);
+	    cprintf(cb, "</startTime>");
+	    replay++;
+	}
+	else if (strcmp(vname, "stop-time") == 0){
+	    cprintf(cb, "<stopTime>");
+	    cv2cbuf(cv, cb);
+	    cprintf(cb, "</stopTime>");
+	    replay++;
+	}
+    }
+    cprintf(cb, "</create-subscription></rpc>]]>]]>");
+    user = clicon_username_get(h);
+    cprintf(cbkey, "%s:%s", user?user:"", name);
+    /* Share existing subscription */
+    if (!replay && (ss = STREAM_SUBS) != NULL){
+	do {
+	    if (ss->ss_key && strcmp(ss->ss_key, cbuf_get(cbkey)) == 0){
+		*ssp = ss;
+		goto ok;
+	    }
+	    ss = NEXTQ(struct stream_sub *, ss);
+	} while (ss && ss != STREAM_SUBS);
+    }
+    if (clicon_rpc_netconf(h, cbuf_get(cb), &xret, &s) < 0)
+	goto done;
+    if ((xe = xpath_first(xret, NULL, "rpc-reply/rpc-error")) != NULL){
+	if (api_return_err(h, req, xe, pretty, media_out, 0) < 0)
+	    goto done;
+	goto ok;
+    }
+    if ((ss = malloc(sizeof(*ss))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(ss, 0, sizeof(*ss));
+    ss->ss_s = s;
+    s = -1;
+    ADDQ(ss, STREAM_SUBS);
+    if (!replay && (ss->ss_key = strdup(cbuf_get(cbkey))) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto err;
+    }
+    if ((ss->ss_ev = event_new(evhtp_request_get_connection(req)->evbase, ss->ss_s,
+			       EV_READ|EV_PERSIST, stream_backend_cb, ss)) == NULL){
+	clicon_err(OE_EVENTS, errno, "event_new");
+	goto err;
+    }
+    if (event_add(ss->ss_ev, NULL) < 0){
+	clicon_err(OE_EVENTS, errno, "event_add");
+	goto err;
+    }
+    *ssp = ss;
+ ok:
+    retval = 0;
+ done:
+    clicon_debug(1, "%s retval: %d", __FUNCTION__, retval);
+    if (s != -1)
+	close(s);
+    if (xret)
+	xml_free(xret);
+    if (cb)
+	cbuf_free(cb);
+    if (cbkey)
+	cbuf_free(cbkey);
+    return retval;
+ err:
+    stream_sub_free(ss);
+    goto done;
+}
+
+/*! Process a stream request
+ * @param[in]  h          Clicon handle
+ * @param[in]  req        Generic Www handle (can be part of clixon handle)
+ * @param[in]  qvec       Query parameters, ie the ?<id>=<val>&<id>=<val> stuff
+ * @param[in]  streampath URI path for streams, eg /streams, see CLICON_STREAM_PATH
+ * @param[out] finish 	  Set to zero, if request should not be finnished by upper layer
+ *                        (or NULL)
+ */
+int
+api_stream(clicon_handle h,
+	   void         *req0,
+	   cvec         *qvec,
+	   char         *streampath,
+	   int          *finish)
+{
+    int                   retval = -1;
+    evhtp_request_t      *req = (evhtp_request_t *)req0;
+    char                 *path;
+    char                **pvec = NULL;
+    int                   pn;
+    int                   authenticated = 0;
+    int                   pretty;
+    restconf_media        media_out = YANG_DATA_XML; /* XXX default */
+    cxobj                *xret = NULL;
+    cxobj                *xerr;
+    struct stream_sub    *ss = NULL;
+    struct stream_client *sc = NULL;
+
+    clicon_debug(1, "%s", __FUNCTION__);
+    path = restconf_uripath(h);
+    pretty = clicon_option_bool(h, "CLICON_RESTCONF_PRETTY");
+    if ((pvec = clicon_strsep(path, "/", &pn)) == NULL)
+	goto done;
+    /* Sanity check of path. Should be /stream/<name> */
+    if (pn != 3 ||
+	strlen(pvec[0]) != 0 ||
+	strcmp(pvec[1], streampath) ||
+	pvec[2] == NULL){
+	if (restconf_notfound(h, req) < 0)
+	    goto done;
+	goto ok;
+    }
+    clicon_debug(1, "%s: stream=%s", __FUNCTION__, pvec[2]);
+    /* If present, check credentials. See "plugin_credentials" in plugin  
+     * See RFC 8040 section 2.5
+     */
+    if ((authenticated = clixon_plugin_auth_all(h, req)) < 0)
+	goto done;
+    clicon_debug(1, "%s auth:%d %s", __FUNCTION__, authenticated, clicon_username_get(h));
+    /* If set but no user, we set a dummy user */
+    if (authenticated){
+	if (clicon_username_get(h) == NULL)
+	    clicon_username_set(h, "none");
+    }
+    else{
+	if (netconf_access_denied_xml(&xret, "protocol", "The requested URL was unauthorized") < 0)
+	    goto done;
+	if ((xerr = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+	    if (api_return_err(h, req, xerr, pretty, media_out, 0) < 0)
+		goto done;
+	}
+	goto ok;
+    }
+    if (restconf_stream(h, req, pvec[2], qvec, pretty, media_out, &ss) < 0){
+	/* Eg backend subscription failed, reply with error */
+	if (netconf_operation_failed_xml(&xret, "application", clicon_err_reason) < 0)
+	    goto done;
+	if ((xerr = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+	    if (api_return_err(h, req, xerr, pretty, media_out, 0) < 0)
+		goto done;
+	}
+	goto ok;
+    }
+    if (ss == NULL) /* error reply sent */
+	goto ok;
+    if ((sc = malloc(sizeof(*sc))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	if (ss->ss_clients == NULL)
+	    stream_sub_free(ss);
+	goto done;
+    }
+    memset(sc, 0, sizeof(*sc));
+    sc->sc_sub = ss;
+    sc->sc_req = req;
+    ADDQ(sc, ss->ss_clients);
+    evhtp_request_set_hook(req, evhtp_hook_on_request_fini, (evhtp_hook)stream_client_fini, sc);
+    /* Setting up stream */
+    if (restconf_reply_header(req, "Content-Type", "text/event-stream") < 0)
+	goto done;
+    if (restconf_reply_header(req, "Cache-Control", "no-cache") < 0)
+	goto done;
+    if (restconf_reply_header(req, "X-Accel-Buffering", "no") < 0)
+	goto done;
+    evhtp_send_reply_chunk_start(req, EVHTP_RES_OK);
+    if (finish)
+	*finish = 0;
+ ok:
+    retval = 0;
+ done:
+    clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
+    if (pvec)
+	free(pvec);
+    if (xret)
+	xml_free(xret);
+    return retval;
+}
+
+/*! Close all stream subscriptions and clients, eg on termination
+ * @param[in]  h   Clicon handle
+ */
+int
+stream_child_freeall(clicon_handle h)
+{
+    struct stream_sub    *ss;
+    struct stream_client *sc;
+
+    while ((ss = STREAM_SUBS) != NULL){
+	ss->ss_busy++; /* Freed below */
+	while ((sc = ss->ss_clients) != NULL){
+	    evhtp_unset_hook(&sc->sc_req->hooks, evhtp_hook_on_request_fini);
+	    stream_client_rm(sc);
+	}
+	stream_sub_free(ss);
+    }
+    return 0;
+}
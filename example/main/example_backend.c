@@ -43,6 +43,7 @@
   *  -U  general-purpose upgrade
   *  -t  enable transaction logging (cal syslog for every transaction)
   *  -v <xpath> Failing validate and commit if <xpath> is present (synthetic error)
+  *  -w <s>  Sleep <s> seconds in commit callback (slow commit)
  */
 #include <stdio.h>
 #include <stdlib.h>
@@ -66,7 +67,7 @@
 #include <clixon/clixon_backend.h> 
 
 /* Command line options to be passed to getopt(3) */
-#define BACKEND_EXAMPLE_OPTS "rsS:iuUt:v:n:"
+#define BACKEND_EXAMPLE_OPTS "rsS:iuUt:v:n:w:"
 
 /*! Variable to control if reset code is run.
  * The reset code inserts "extra XML" which assumes ietf-interfaces is
@@ -124,6 +125,11 @@ static int   _validate_fail_toggle = 0; /* fail at validate and commit */
 */
 static char *_proc_netns = NULL;
 
+/*! Variable to control slow commits, eg for testing reads during a commit
+ * Start backend with -- -w <seconds>
+ */
+static int _commit_sleep = 0;
+
 /* forward */
 static int example_stream_timer_setup(clicon_handle h);
 
@@ -187,6 +193,9 @@ main_commit(clicon_handle    h,
 	}
     }
 
+    if (_commit_sleep)
+	sleep(_commit_sleep);
+
     /* Create namespace context for xpath */
     if ((nsc = xml_nsctx_init(NULL, "urn:ietf:params:xml:ns:yang:ietf-interfaces")) == NULL)
 	goto done;
@@ -1090,6 +1099,9 @@ clixon_plugin_init(clicon_handle h)
 	case 'n': /* process restconf namespace*/
 	    _proc_netns = optarg;
 	    break;
+	case 'w': /* slow commit */
+	    _commit_sleep = atoi(optarg);
+	    break;
 	}
 
     /* Example stream initialization:
@@ -82,6 +82,36 @@
  */
 #define XMLDB_CONFIG_HACK
 
+/*! Bulk merge of edit-config/copy-config into a datastore
+ * If at least this many new children are added to a node in one edit, eg list entries,
+ * they are appended and sorted once with xml_sort_merge() instead of one sorted insert
+ * each, and NACM create access is checked for all of them at once.
+ * Undefine to disable
+ */
+#define XMLDB_BULK_MERGE 16
+
+/*! Max unsent notification data in bytes of one restconf event stream client
+ * If a client does not read its stream and more than this is queued on its connection,
+ * the client is disconnected, instead of buffering without bound.
+ * Only native (evhtp) restconf, see restconf_stream_evhtp.c
+ */
+#define RESTCONF_STREAM_BUFMAX (1024*1024)
+
+/*! Max queued notification data in bytes of one backend client
+ * Notifications are written to clients without blocking the backend, and what cannot
+ * be written is queued. If a client does not read and its queue grows beyond this,
+ * the client is disconnected.
+ * See ce_event_cb in backend_client.c
+ */
+#define BACKEND_NOTIFY_QUEUE_MAX (1024*1024)
+
+/*! Max number of values cached by the client API
+ * Values read with clixon_client_get_vals are cached until the running datastore changes.
+ * If the cache grows beyond this, it is flushed.
+ * See clixon_client.c
+ */
+#define CLIXON_CLIENT_CACHE_MAX 1024
+
 /*! Let state data be ordered-by system
  * RFC 7950 is cryptic about this
  * It says in 7.7.7:
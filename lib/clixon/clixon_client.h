@@ -52,6 +52,8 @@ int clixon_client_subscribe(int sock, int priority, int nspace,
                          int *spoint, const char *fmt, ...);
 int clixon_client_subscribe_done(int sock);
 int clixon_client_read_subscription_socket(int sock, int sub_points[], int *resultlen);
+int clixon_client_get_vals(int sock, const char *xnamespace, const char **xpaths, int n,
+			   char **vals, uint32_t *counts);
 int clixon_client_num_instances(int sock, const char *xnamespace, const char *xpath);
 int clixon_client_get_bool(int sock, int *rval, const char *xnamespace, const char *xpath);
 int clixon_client_get_str(int sock, char *rval, int n, const char *xnamespace, const char *xpath);
@@ -56,6 +56,10 @@ typedef struct {
     cxobj    *de_xml;      /* cache */
     int       de_modified; /* Dirty since loaded/copied/committed/etc XXX:nocache? */
     int       de_empty;    /* Empty on read from file, xmldb_readfile and xmldb_put sets it */
+    uint64_t  de_generation; /* Incremented on every content change, see xmldb_generation_get */
+    time_t    de_lastmod;    /* Time of last content change, see xmldb_lastmod_get */
+    uint64_t  de_lastuse;    /* LRU stamp of last cache access, see xmldb_cache_evict */
+    struct xmldb_lazy *de_lazy; /* Unread top-level subtrees of cache, see xmldb_lazy_load */
 } db_elmnt;
 
 /*
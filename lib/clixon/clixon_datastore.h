@@ -56,6 +56,7 @@ int xmldb_get0(clicon_handle h, const char *db, yang_bind yb,
 	       int copy, cxobj **xtop, modstate_diff_t *msd); 
 int xmldb_get0_clear(clicon_handle h, cxobj *x);
 int xmldb_get0_free(clicon_handle h, cxobj **xp);
+int xmldb_lazy_load(clicon_handle h, const char *db, const char *xpath);
 int xmldb_put(clicon_handle h, const char *db, enum operation_type op, cxobj *xt, char *username, cbuf *cbret); /* in clixon_datastore_write.[ch] */
 int xmldb_copy(clicon_handle h, const char *from, const char *to);
 int xmldb_lock(clicon_handle h, const char *db, uint32_t id);
@@ -70,10 +71,15 @@ int xmldb_create(clicon_handle h, const char *db);
 int xmldb_db_reset(clicon_handle h, const char *db);
 
 cxobj *xmldb_cache_get(clicon_handle h, const char *db);
+int    xmldb_cache_touch(clicon_handle h, const char *db);
+int    xmldb_cache_evict(clicon_handle h);
 
 int xmldb_modified_get(clicon_handle h, const char *db);
 int xmldb_modified_set(clicon_handle h, const char *db, int value);
 int xmldb_empty_get(clicon_handle h, const char *db);
+uint64_t xmldb_generation_get(clicon_handle h, const char *db);
+int xmldb_generation_incr(clicon_handle h, const char *db);
+time_t xmldb_lastmod_get(clicon_handle h, const char *db);
 int xmldb_dump(clicon_handle h, FILE *f, cxobj *xt);
 
 #endif /* _CLIXON_DATASTORE_H */
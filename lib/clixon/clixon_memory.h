@@ -0,0 +1,83 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+
+ * Memory accounting per subsystem
+ * Allocations of long-lived objects (XML, YANG, NACM policies, stream replay,
+ * client queues) are tagged with an accounting class and maintained
+ * incrementally as current and peak bytes and object counts.
+ */
+
+#ifndef _CLIXON_MEMORY_H_
+#define _CLIXON_MEMORY_H_
+
+/*
+ * Types
+ */
+/*! Memory accounting classes
+ * XML objects are tagged with the class that is current when they are created,
+ * @see clixon_mem_acct_set
+ */
+enum clixon_mem_acct{
+    CLIXON_MEM_OTHER = 0, /* Not tagged, eg transient trees */
+    CLIXON_MEM_YANG,      /* YANG specs */
+    CLIXON_MEM_RUNNING,   /* Running datastore cache */
+    CLIXON_MEM_CANDIDATE, /* Candidate datastore cache */
+    CLIXON_MEM_STARTUP,   /* Startup datastore cache */
+    CLIXON_MEM_DATASTORE, /* Other datastore caches, eg tmp and failsafe */
+    CLIXON_MEM_NACM,      /* Compiled NACM policies */
+    CLIXON_MEM_STREAM,    /* Stream replay buffers */
+    CLIXON_MEM_CLIENT,    /* Client requests and notification queues */
+    CLIXON_MEM_NR         /* Nr of classes, not a class */
+};
+
+/*! Memory statistics of one accounting class */
+struct clixon_mem_stat{
+    uint64_t ms_bytes;      /* Current bytes */
+    uint64_t ms_peak_bytes; /* High-water mark of bytes */
+    uint64_t ms_objs;       /* Current nr of objects */
+    uint64_t ms_peak_objs;  /* High-water mark of objects */
+};
+
+/*
+ * Prototypes
+ */
+int   clixon_mem_add(enum clixon_mem_acct acct, int64_t bytes, int64_t objs);
+int   clixon_mem_get(enum clixon_mem_acct acct, struct clixon_mem_stat *ms);
+enum clixon_mem_acct clixon_mem_acct_set(enum clixon_mem_acct acct);
+enum clixon_mem_acct clixon_mem_acct_get(void);
+enum clixon_mem_acct clixon_mem_acct_db(const char *db);
+const char *clixon_mem_acct2str(enum clixon_mem_acct acct);
+
+#endif  /* _CLIXON_MEMORY_H_ */
@@ -75,6 +75,7 @@ typedef struct {
 /*
  * Prototypes
  */
+int clixon_path_free(clixon_path *cplist);
 int xml_yang_root(cxobj *x, cxobj **xr);
 int yang2api_path_fmt(yang_stmt *ys, int inclkey, char **api_path_fmt);
 int api_path_fmt2api_path(const char *api_path_fmt, cvec *cvv, char **api_path, int *cvvi);
@@ -83,6 +84,10 @@ int api_path2xpath(char *api_path, yang_stmt *yspec, char **xpath, cvec **nsc, c
 int api_path2xml(char *api_path, yang_stmt *yspec, cxobj *xtop, 
 		 yang_class nodeclass, int strict,
 		 cxobj **xpathp, yang_stmt **ypathp, cxobj **xerr);
+int api_path_compile(char *api_path, yang_stmt *yspec, clixon_path **cplistp,
+		     cvec **nscp, cxobj **xerr);
+int clixon_path2xpath(clixon_path *cplist, char **xpathp);
+int clixon_xml_find_path(cxobj *xt, clixon_path *cplist, cxobj ***xvec, int *xlen);
 int xml2api_path_1(cxobj *x, cbuf *cb);
 #if defined(__GNUC__) && __GNUC__ >= 3
 int clixon_xml_find_api_path(cxobj *xt, yang_stmt *yt, cxobj ***xvec, int *xlen, const char *format,
@@ -63,6 +63,7 @@ int clicon_rpc_discard_changes(clicon_handle h);
 int clicon_rpc_create_subscription(clicon_handle h, char *stream, char *filter, 
 				   int *s);
 int clicon_rpc_debug(clicon_handle h, int level);
+int clicon_rpc_datastore_generation(clicon_handle h, char *db, uint64_t *gen, time_t *lastmod);
 int clicon_hello_req(clicon_handle h, uint32_t *id);
 
 #endif  /* _CLIXON_PROTO_CLIENT_H_ */
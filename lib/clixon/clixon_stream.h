@@ -70,21 +70,43 @@
  */
 typedef	int (*stream_fn_t)(clicon_handle h, int op, cxobj *event, void *arg);
 
+/* Subscription filter, parsed once and shared by all subscriptions of a stream
+ * with the same xpath. Evaluated at most once per notification.
+ */
+struct stream_filter{
+    qelem_t                     sf_q;      /* queue header */
+    char                       *sf_xpath;  /* Filter selector as xpath */
+    struct xpath_tree          *sf_tree;   /* Parsed xpath, NULL on parse error */
+    int                         sf_refcnt; /* Nr of subscriptions using filter */
+    uint64_t                    sf_notify; /* Notification nr of last evaluation */
+    int                         sf_match;  /* Result of last evaluation */
+};
+
+/* Notification encoded once as clicon message and shared by all subscribers
+ * @see stream_notify_msg
+ */
+struct stream_msg{
+    int                         sm_refcnt; /* Reference count */
+    struct clicon_msg          *sm_msg;    /* Encoded NOTIFY message */
+};
+
 struct stream_subscription{
     qelem_t                     ss_q;   /* queue header */
     char                       *ss_stream; /* Name of associated stream */
     char                       *ss_xpath;  /* Filter selector as xpath */
+    struct stream_filter       *ss_filter; /* Shared parsed filter, or NULL */
     struct timeval              ss_starttime; /* Replay starttime */
     struct timeval              ss_stoptime; /* Replay stoptime */
     stream_fn_t                 ss_fn;     /* Callback when event occurs */
     void                       *ss_arg;    /* Callback argument */
 };
 
-/* Replay time-series */
+/* Replay time-series entry, in a ring buffer ordered by time
+ * The event is stored encoded, not as an XML tree
+ */
 struct stream_replay{
-    qelem_t        r_q;   /* queue header */
-    struct timeval r_tv;  /* time index */
-    cxobj         *r_xml; /* event in xml form */
+    struct timeval     r_tv;  /* time index */
+    struct stream_msg *r_sm;  /* event encoded as NOTIFY message */
 };
 
 /* See RFC8040 9.3, stream list, no replay support for now
@@ -96,7 +118,15 @@ struct event_stream{
     struct stream_subscription *es_subscription;
     int                  es_replay_enabled; /* set if replay is enables */
     struct timeval       es_retention; /* replay retention - how much to save */
-    struct stream_replay *es_replay;
+    struct stream_replay *es_replay;    /* replay ring buffer, ordered by time */
+    size_t               es_replay_size;   /* Allocated entries in ring buffer */
+    size_t               es_replay_head;   /* Index of oldest entry */
+    size_t               es_replay_len;    /* Nr of entries */
+    size_t               es_replay_bytes;  /* Size of encoded entries */
+    size_t               es_replay_max;    /* Max nr of entries, 0 is no limit */
+    size_t               es_replay_maxbytes; /* Max size of entries, 0 is no limit */
+    struct stream_filter *es_filters; /* Parsed filters of subscriptions */
+    uint64_t             es_notify;   /* Notification counter, for filter evaluation */
 
 };
 typedef struct event_stream event_stream_t;
@@ -118,6 +148,8 @@ struct stream_subscription *stream_ss_find(event_stream_t *es,
 					   stream_fn_t fn, void *arg);
 int stream_ss_delete_all(clicon_handle h, stream_fn_t fn, void *arg);
 int stream_ss_delete(clicon_handle h, char *name, stream_fn_t fn, void *arg);
+struct stream_msg *stream_notify_msg(cxobj *xevent);
+int stream_msg_free(struct stream_msg *sm);
 
 int stream_notify_xml(clicon_handle h, char *stream, cxobj *xml);
 #if defined(__GNUC__) && __GNUC__ >= 3
@@ -57,6 +57,9 @@
 #define YANG_FLAG_INDEX 0x04  /* This yang node under list is (extra) index. --> you can access
 			       * list elements using this index with binary search */
 #endif
+#define YANG_FLAG_NACM_DONE   0x08 /* (Cache) YANG_FLAG_NACM_MODULE is computed */
+#define YANG_FLAG_NACM_MODULE 0x10 /* (Cache) All data nodes of subtree are in same module,
+				    * see nacm_datanode_read */
 
 /*
  * Types
@@ -54,6 +54,8 @@
  */
 yang_stmt *yang_parse_file(FILE *fp, const char *name, yang_stmt *ysp);
 yang_stmt *yang_parse_filename(const char *filename, yang_stmt  *ysp);
+int        yang_parse_find_match(clicon_handle h, const char *module, const char *revision,
+				 uint32_t *revactual, cbuf *fbuf);
 int        yang_spec_parse_module(clicon_handle h, const char *module,
 				  const char *revision, yang_stmt *yspec);
 int        yang_spec_parse_file(clicon_handle h, char *filename, yang_stmt *yspec);
@@ -37,6 +37,7 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <syslog.h>
 #include <string.h>
@@ -64,6 +65,9 @@
 #include "clixon_proto_client.h"
 #include "clixon_client.h"
 
+/* Forward */
+static int client_cache_flush(void);
+
 /*! Initialize Clixon client API
  * @param[in]  name        Name of client (NYI)
  * @param[in]  estream     Error/debug file (NULL: syslog)
@@ -130,6 +134,7 @@ int
 clixon_client_close(int s)
 {
     clicon_debug(1, "%s", __FUNCTION__);
+    client_cache_flush(); /* Socket number may be reused */
     close(s);
     return 0;
 }
@@ -161,104 +166,365 @@ clixon_client_read_subscription_socket(int sock,
     return 0;
 }
 
-/*! Internal function to construct a get-config and query a value from the backend
- *
+/*
+ * Client value cache
+ * Values read with get-values are cached, keyed by socket, namespace and xpath, together
+ * with the generation of the running datastore they were read from.
+ * A cached value is valid as long as the running generation has not changed, which is
+ * checked with a small datastore-generation request instead of reading the values again.
+ */
+
+/*! Cached result of one xpath
+ * Stored by value in the hash, with the body following the struct
+ */
+struct client_cache_entry{
+    uint64_t cc_gen;    /* Generation of running when read */
+    uint32_t cc_count;  /* Number of matching nodes */
+    int      cc_nobody; /* No match, or first match has no body */
+    char     cc_body[]; /* Body of first match, null-terminated */
+};
+
+static clicon_hash_t *_CLIENT_CACHE = NULL;
+static int            _CLIENT_CACHE_NR = 0;
+
+/*! Flush the client value cache
+ */
+static int
+client_cache_flush(void)
+{
+    if (_CLIENT_CACHE){
+	clicon_hash_free(_CLIENT_CACHE);
+	_CLIENT_CACHE = NULL;
+    }
+    _CLIENT_CACHE_NR = 0;
+    return 0;
+}
+
+/*! Get cache key of an xpath
+ * @param[in]  cb        Buffer where key is written
  * @param[in]  sock      Stream socket
+ * @param[in]  namespace Default namespace
  * @param[in]  xpath     XPath
- * @param[in]  namespace Default namespace used for non-prefixed entries in xpath. (Alt use nsc)
- * @param[out] val       String value
+ */
+static char *
+client_cache_key(cbuf       *cb,
+		 int         sock,
+		 const char *namespace,
+		 const char *xpath)
+{
+    cbuf_reset(cb);
+    cprintf(cb, "%d\n%s\n%s", sock, namespace?namespace:"", xpath);
+    return cbuf_get(cb);
+}
+
+/*! Add a value to the client cache, flush the cache if full
+ * @param[in]  key    Cache key
+ * @param[in]  gen    Generation of running datastore
+ * @param[in]  count  Number of matching nodes
+ * @param[in]  body   Body of first matching node, or NULL
+ * @see CLIXON_CLIENT_CACHE_MAX
+ */
+static int
+client_cache_add(char     *key,
+		 uint64_t  gen,
+		 uint32_t  count,
+		 char     *body)
+{
+    int                        retval = -1;
+    struct client_cache_entry *cc = NULL;
+    size_t                     len;
+
+    if (_CLIENT_CACHE_NR >= CLIXON_CLIENT_CACHE_MAX)
+	client_cache_flush();
+    if (_CLIENT_CACHE == NULL &&
+	(_CLIENT_CACHE = clicon_hash_init()) == NULL)
+	goto done;
+    len = sizeof(*cc) + (body?strlen(body):0) + 1;
+    if ((cc = malloc(len)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(cc, 0, len);
+    cc->cc_gen = gen;
+    cc->cc_count = count;
+    cc->cc_nobody = (body == NULL);
+    if (body)
+	strcpy(cc->cc_body, body);
+    if (clicon_hash_lookup(_CLIENT_CACHE, key) == NULL)
+	_CLIENT_CACHE_NR++;
+    if (clicon_hash_add(_CLIENT_CACHE, key, cc, len) == NULL)
+	goto done;
+    retval = 0;
+ done:
+    if (cc)
+	free(cc);
+    return retval;
+}
+
+/*! Send an internal rpc to the backend and parse the reply
+ * @param[in]  sock   Stream socket
+ * @param[in]  cb     Rpc as xml string
+ * @param[in]  op     Name of operation, for error reporting
+ * @param[out] xret   Reply, free with xml_free
+ * @retval     0      OK
+ * @retval    -1      Error, including rpc-error in reply
  */
 static int
-clixon_client_get_xdata(int         sock,
-			const char *namespace,
-			const char *xpath,
-			cxobj     **xdata)
+clixon_client_rpc(int         sock,
+		  cbuf       *cb,
+		  const char *op,
+		  cxobj     **xret)
 {
     int                retval = -1;
+    struct clicon_msg *msg = NULL;
     char              *retdata = NULL;
-    cxobj             *xret = NULL;
+    cxobj             *xr = NULL;
     cxobj             *xd;
-    cbuf              *cb = NULL;
-    struct clicon_msg *msg = NULL;
-    const char        *db = "running";
-    cvec              *nsc = NULL; 
-    
-    if ((cb = cbuf_new()) == NULL)
-	goto done;
-    cprintf(cb, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
-    cprintf(cb, " xmlns:%s=\"%s\"",
-	    NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE);
-    cprintf(cb, "><get-config><source><%s/></source>", db);
-    if (xpath && strlen(xpath)){
-	cprintf(cb, "<%s:filter %s:type=\"xpath\" xmlns=\"%s\" %s:select=\"%s\"",
-		NETCONF_BASE_PREFIX,
-		NETCONF_BASE_PREFIX,
-		namespace,
-		NETCONF_BASE_PREFIX,
-		xpath);
-	if (xml_nsctx_cbuf(cb, nsc) < 0)
-	    goto done;
-	cprintf(cb, "/>");
-    }
-    cprintf(cb, "</get-config></rpc>");
+
     clicon_debug(1, "%s xml:%s", __FUNCTION__, cbuf_get(cb));
     if ((msg = clicon_msg_encode(0, "%s", cbuf_get(cb))) == NULL)
 	goto done;
     if (clicon_rpc(sock, msg, &retdata) < 0)
 	goto done;
-    if (clixon_xml_parse_string(retdata, YB_NONE, NULL, &xret, NULL) < 0)
+    if (clixon_xml_parse_string(retdata, YB_NONE, NULL, &xr, NULL) < 0)
 	goto done;
-    if ((xd = xpath_first(xret, NULL, "/rpc-reply/rpc-error")) != NULL){
+    if ((xd = xpath_first(xr, NULL, "/rpc-reply/rpc-error")) != NULL){
 	xd = xml_parent(xd); /* point to rpc-reply */
-	clixon_netconf_error(xd, "Get config", NULL);
-	goto done; /* Not fatal */
+	clixon_netconf_error(xd, op, NULL);
+	goto done;
+    }
+    *xret = xr;
+    xr = NULL;
+    retval = 0;
+ done:
+    if (xr)
+	xml_free(xr);
+    if (retdata)
+	free(retdata);
+    if (msg)
+	free(msg);
+    return retval;
+}
+
+/*! Get generation of the running datastore
+ * @param[in]  sock   Stream socket
+ * @param[out] gen    Generation counter
+ * @see clicon_rpc_datastore_generation  Same using a clicon handle
+ */
+static int
+clixon_client_generation(int       sock,
+			 uint64_t *gen)
+{
+    int    retval = -1;
+    cbuf  *cb = NULL;
+    cxobj *xret = NULL;
+    cxobj *x;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "<rpc xmlns=\"%s\"><datastore-generation xmlns=\"%s\"><datastore>running</datastore></datastore-generation></rpc>",
+	    NETCONF_BASE_NAMESPACE, CLIXON_LIB_NS);
+    if (clixon_client_rpc(sock, cb, "Datastore generation", &xret) < 0)
+	goto done;
+    if ((x = xpath_first(xret, NULL, "/rpc-reply/generation")) == NULL ||
+	parse_uint64(xml_body(x), gen, NULL) <= 0){
+	clicon_err(OE_XML, EINVAL, "rpc error: no generation in reply");
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (xret)
+	xml_free(xret);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Read values of many xpaths from the running datastore in one request
+ *
+ * The xpaths are evaluated in the backend (see the get-values rpc) and only the number
+ * of matches and the body of the first match are returned. Results are cached and reused
+ * as long as the running datastore is unchanged, which costs one small request.
+ * @param[in]  sock      Stream socket
+ * @param[in]  namespace Default namespace used for non-prefixed entries in xpath
+ * @param[in]  xpaths    Vector of xpaths
+ * @param[in]  n         Length of xpaths, vals and counts
+ * @param[out] vals      Body of first match of each xpath or NULL, free with free(). (or NULL)
+ * @param[out] counts    Number of matches of each xpath (or NULL)
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @code
+ *   const char *xpaths[] = {"/c/a", "/c/b"};
+ *   char       *vals[2];
+ *   if (clixon_client_get_vals(s, "urn:example:clixon", xpaths, 2, vals, NULL) < 0)
+ *      err;
+ * @endcode
+ */
+int
+clixon_client_get_vals(int          sock,
+		       const char  *namespace,
+		       const char **xpaths,
+		       int          n,
+		       char       **vals,
+		       uint32_t    *counts)
+{
+    int                        retval = -1;
+    cbuf                      *cb = NULL;
+    cbuf                      *cbkey = NULL;
+    cxobj                     *xret = NULL;
+    cxobj                     *x;
+    cxobj                     *xv;
+    struct client_cache_entry *cc;
+    uint64_t                   gen = 0;
+    uint32_t                   count;
+    char                      *body;
+    int                        i;
+    int                        hit = 1;
+
+    if (vals)
+	for (i=0; i<n; i++)
+	    vals[i] = NULL;
+    if ((cbkey = cbuf_new()) == NULL ||
+	(cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    /* If all xpaths are cached from the same generation, check it is still current */
+    for (i=0; i<n && hit; i++){
+	if (_CLIENT_CACHE == NULL ||
+	    (cc = clicon_hash_value(_CLIENT_CACHE,
+				    client_cache_key(cbkey, sock, namespace, xpaths[i]),
+				    NULL)) == NULL ||
+	    (i > 0 && cc->cc_gen != gen))
+	    hit = 0;
+	else
+	    gen = cc->cc_gen;
+    }
+    if (hit && n > 0){
+	if (clixon_client_generation(sock, &gen) < 0)
+	    goto done;
+	for (i=0; i<n; i++){
+	    cc = clicon_hash_value(_CLIENT_CACHE,
+				   client_cache_key(cbkey, sock, namespace, xpaths[i]),
+				   NULL);
+	    if (cc->cc_gen != gen){
+		hit = 0;
+		break;
+	    }
+	    if (vals && !cc->cc_nobody &&
+		(vals[i] = strdup(cc->cc_body)) == NULL){
+		clicon_err(OE_UNIX, errno, "strdup");
+		goto done;
+	    }
+	    if (counts)
+		counts[i] = cc->cc_count;
+	}
+	if (hit)
+	    goto ok;
+	if (vals)
+	    for (i=0; i<n; i++)
+		if (vals[i]){
+		    free(vals[i]);
+		    vals[i] = NULL;
+		}
     }
-    else if ((xd = xpath_first(xret, NULL, "/rpc-reply/data")) == NULL){
-	if ((xd = xml_new("data", NULL, CX_ELMNT)) == NULL)
+    /* Read all values in one request */
+    cprintf(cb, "<rpc xmlns=\"%s\"><get-values xmlns=\"%s\">",
+	    NETCONF_BASE_NAMESPACE, CLIXON_LIB_NS);
+    if (namespace){
+	cprintf(cb, "<namespace>");
+	if (xml_chardata_cbuf_append(cb, (char*)namespace) < 0)
 	    goto done;
+	cprintf(cb, "</namespace>");
     }
-    else{
-	if (xml_rm(xd) < 0)
+    for (i=0; i<n; i++){
+	cprintf(cb, "<xpath>");
+	if (xml_chardata_cbuf_append(cb, (char*)xpaths[i]) < 0)
 	    goto done;
+	cprintf(cb, "</xpath>");
+    }
+    cprintf(cb, "</get-values></rpc>");
+    if (clixon_client_rpc(sock, cb, "Get values", &xret) < 0)
+	goto done;
+    if ((x = xpath_first(xret, NULL, "/rpc-reply/generation")) == NULL ||
+	parse_uint64(xml_body(x), &gen, NULL) <= 0){
+	clicon_err(OE_XML, EINVAL, "rpc error: no generation in reply");
+	goto done;
     }
-    *xdata = xd;
+    x = xpath_first(xret, NULL, "/rpc-reply");
+    xv = NULL;
+    for (i=0; i<n; i++){
+	while ((xv = xml_child_each(x, xv, CX_ELMNT)) != NULL)
+	    if (strcmp(xml_name(xv), "value") == 0)
+		break;
+	if (xv == NULL){
+	    clicon_err(OE_XML, EINVAL, "rpc error: %d values expected in reply", n);
+	    goto done;
+	}
+	if (parse_uint32(xml_find_body(xv, "count"), &count, NULL) <= 0){
+	    clicon_err(OE_XML, EINVAL, "rpc error: no count in reply");
+	    goto done;
+	}
+	body = xml_find_body(xv, "body");
+	if (body == NULL && xml_find_type(xv, NULL, "body", CX_ELMNT) != NULL)
+	    body = ""; /* Empty body */
+	if (client_cache_add(client_cache_key(cbkey, sock, namespace, xpaths[i]),
+			     gen, count, body) < 0)
+	    goto done;
+	if (vals && body && (vals[i] = strdup(body)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    goto done;
+	}
+	if (counts)
+	    counts[i] = count;
+    }
+ ok:
     retval = 0;
  done:
+    if (retval < 0 && vals)
+	for (i=0; i<n; i++)
+	    if (vals[i]){
+		free(vals[i]);
+		vals[i] = NULL;
+	    }
     if (xret)
 	xml_free(xret);
     if (cb)
 	cbuf_free(cb);
-    if (msg)
-	free(msg);
+    if (cbkey)
+	cbuf_free(cbkey);
     return retval;
 }
 
+/*! Internal function to read the value of one xpath from the backend
+ *
+ * @param[in]  sock      Stream socket
+ * @param[in]  namespace Default namespace used for non-prefixed entries in xpath.
+ * @param[in]  xpath     XPath
+ * @param[out] val       String value, free with free()
+ * @see clixon_client_get_vals
+ */
 static int
 clixon_client_get_val(int         sock,
 		      const char *namespace,
 		      const char *xpath,
 		      char      **val)
 {
-    int    retval = -1;
-    cxobj *xdata = NULL;
-    cxobj *xobj;
+    int      retval = -1;
+    uint32_t count = 0;
     
     if (val == NULL){
 	clicon_err(OE_XML, EINVAL, "Expected val");
 	goto done;
     }
-#if 1 /* XXX: Problem is xpath with indexes used in original need to change to [0] in the 2nd access */
-    if (clixon_client_get_xdata(sock, namespace, "/", &xdata) < 0)
+    if (clixon_client_get_vals(sock, namespace, &xpath, 1, val, &count) < 0)
 	goto done;
-#else
-    if (clixon_client_get_xdata(sock, namespace, xpath, &xdata) < 0)
-	goto done;
-#endif
-    if ((xobj = xpath_first(xdata, NULL, "%s", xpath)) == NULL){
-	clicon_err(OE_XML, ENOENT, "Expected local xpath result");
+    if (count == 0 || *val == NULL){
+	clicon_err(OE_XML, ENOENT, "Expected xpath result: %s", xpath);
 	goto done;
     }
-    *val = xml_body(xobj);
     retval = 0;
  done:
     return retval;
@@ -266,33 +532,19 @@ clixon_client_get_val(int         sock,
 
 /*! Get number of list entries
  * @param[in]  sock      Stream socket
- * @note there is no way using netconf to get this number: instead the whole list is retrieved.
+ * @note Only the number is returned from the backend, not the list itself
  */
 int
 clixon_client_num_instances(int         sock,
 			    const char *namespace,
 			    const char *xpath)
 {
-    int     retval = -1;
-    cxobj  *xdata = NULL;
-    cxobj **vec = NULL;
-    size_t  veclen;
+    uint32_t count = 0;
     
     clicon_debug(1, "%s", __FUNCTION__);
-#if 1 /* XXX: Problem is xpath with indexes used in original need to change to [0] in the 2nd access */
-    if (clixon_client_get_xdata(sock, namespace, "/", &xdata) < 0)
-	goto done;
-#else
-    if (clixon_client_get_xdata(sock, namespace, xpath, &xdata) < 0)
-	goto done;
-#endif
-    if (xpath_vec(xdata, NULL, "%s", &vec, &veclen, xpath) < 0) 
-	goto done;
-    retval = veclen;
- done:
-    if (vec)
-	free(vec);
-    return retval;
+    if (clixon_client_get_vals(sock, namespace, &xpath, 1, NULL, &count) < 0)
+	return -1;
+    return count;
 }
 
 int
@@ -321,6 +573,8 @@ clixon_client_get_bool(int           sock,
     *rval = (int)val0;
     retval = 0;
  done:
+    if (val)
+	free(val);
     if (reason)
 	free(reason);
     return retval;
@@ -350,6 +604,8 @@ clixon_client_get_str(int         sock,
     rval[n-1]= '\0';
     retval = 0;
  done:
+    if (val)
+	free(val);
     return retval;
 }
 
@@ -377,6 +633,8 @@ clixon_client_get_u_int8(int         sock,
     }
     retval = 0;
  done:
+    if (val)
+	free(val);
     if (reason)
 	free(reason);
     return retval;
@@ -406,6 +664,8 @@ clixon_client_get_u_int16(int sock,
     }
     retval = 0;
  done:
+    if (val)
+	free(val);
     if (reason)
 	free(reason);
     return retval;
@@ -435,6 +695,8 @@ clixon_client_get_u_int32(int sock,
     }
     retval = 0;
  done:
+    if (val)
+	free(val);
     if (reason)
 	free(reason);
     return retval;
@@ -464,6 +726,8 @@ clixon_client_get_u_int64(int sock,
     }
     retval = 0;
  done:
+    if (val)
+	free(val);
     if (reason)
 	free(reason);
     return retval;
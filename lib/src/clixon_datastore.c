@@ -42,6 +42,8 @@
 #endif
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
@@ -70,6 +72,7 @@
 #include "clixon_string.h"
 #include "clixon_file.h"
 #include "clixon_yang.h"
+#include "clixon_memory.h"
 #include "clixon_xml.h"
 #include "clixon_yang_module.h"
 #include "clixon_plugin.h"
@@ -79,6 +82,8 @@
 #include "clixon_datastore_write.h"
 #include "clixon_datastore_read.h"
 
+/* Clock of datastore cache accesses, see xmldb_cache_touch */
+static uint64_t _xmldb_cache_clock = 0;
 
 /*! Translate from symbolic database name to actual filename in file-system
  * @param[in]   th       text handle handle
@@ -170,6 +175,10 @@ xmldb_disconnect(clicon_handle h)
 		xml_free(de->de_xml);
 		de->de_xml = NULL;
 	    }
+	    if (de->de_lazy){
+		xmldb_lazy_free(de->de_lazy);
+		de->de_lazy = NULL;
+	    }
 	}
     retval = 0;
  done:
@@ -198,7 +207,10 @@ xmldb_copy(clicon_handle h,
     db_elmnt            de0 = {0,};
     cxobj              *x1 = NULL;  /* from */
     cxobj              *x2 = NULL;  /* to */
+    enum clixon_mem_acct acct0;
 
+    /* The copy is accounted to the destination datastore */
+    acct0 = clixon_mem_acct_set(clixon_mem_acct_db(to));
     /* XXX lock */
     if (clicon_datastore_cache(h) != DATASTORE_NOCACHE){
 	/* Copy in-memory cache */
@@ -230,11 +242,21 @@ xmldb_copy(clicon_handle h,
 	/* always set cache although not strictly necessary in case 1
 	 * above, but logic gets complicated due to differences with
 	 * de and de->de_xml */
-	if (de2)
+	if (de2){
 	    de0 = *de2;
+	    if (de2->de_lazy)
+		xmldb_lazy_free(de2->de_lazy);
+	}
 	de0.de_xml = x2; /* The new tree */
+	/* Unread subtrees of x1 refer to the file, which is copied below */
+	de0.de_lazy = NULL;
+	if (x1 && de1->de_lazy &&
+	    (de0.de_lazy = xmldb_lazy_dup(de1->de_lazy)) == NULL)
+	    goto done;
     }
     clicon_db_elmnt_set(h, to, &de0);
+    xmldb_cache_touch(h, from);
+    xmldb_cache_touch(h, to);
 
     /* Copy the files themselves (above only in-memory cache) */
     if (xmldb_db2file(h, from, &fromfile) < 0)
@@ -243,8 +265,11 @@ xmldb_copy(clicon_handle h,
 	goto done;
     if (clicon_file_copy(fromfile, tofile) < 0)
 	goto done;
+    if (xmldb_generation_incr(h, to) < 0)
+	goto done;
     retval = 0;
  done:
+    clixon_mem_acct_set(acct0);
     if (fromfile)
 	free(fromfile);
     if (tofile)
@@ -390,6 +415,10 @@ xmldb_clear(clicon_handle h,
 	    xml_free(xt);
 	    de->de_xml = NULL;
 	}
+	if (de->de_lazy){
+	    xmldb_lazy_free(de->de_lazy);
+	    de->de_lazy = NULL;
+	}
     }
     return 0;
 }
@@ -417,6 +446,8 @@ xmldb_delete(clicon_handle h,
 	    clicon_err(OE_DB, errno, "truncate %s", filename);
 	    goto done;
 	}
+    if (xmldb_generation_incr(h, db) < 0)
+	goto done;
     retval = 0;
  done:
     if (filename)
@@ -445,6 +476,10 @@ xmldb_create(clicon_handle h,
 	    xml_free(xt);
 	    de->de_xml = NULL;
 	}
+	if (de->de_lazy){
+	    xmldb_lazy_free(de->de_lazy);
+	    de->de_lazy = NULL;
+	}
     }
     if (xmldb_db2file(h, db, &filename) < 0)
 	goto done;
@@ -452,7 +487,9 @@ xmldb_create(clicon_handle h,
 	clicon_err(OE_UNIX, errno, "open(%s)", filename);
 	goto done;
     }
-   retval = 0;
+    if (xmldb_generation_incr(h, db) < 0)
+	goto done;
+    retval = 0;
  done:
     if (filename)
 	free(filename);
@@ -495,6 +532,110 @@ xmldb_cache_get(clicon_handle h,
     return de->de_xml;
 }
 
+/*! Mark datastore cache as recently used
+ * Each access stamps the datastore with a clock, used to find the least recently
+ * used datastore to evict.
+ * @param[in]  h    Clicon handle
+ * @param[in]  db   Database name
+ * @retval     0    OK
+ * @see xmldb_cache_evict
+ */
+int
+xmldb_cache_touch(clicon_handle h,
+		  const char   *db)
+{
+    db_elmnt *de;
+    
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+	de->de_lastuse = ++_xmldb_cache_clock;
+    return 0;
+}
+
+/*! Evict least recently used datastore caches until within CLICON_XMLDB_CACHE_MAX
+ *
+ * The memory of the datastore caches is taken from memory accounting. The caches
+ * of running and candidate are always kept. An evicted datastore is reloaded from
+ * its file on next access, the file is always in sync with the cache since every
+ * change is written to file.
+ * Only datastores stamped by xmldb_cache_touch are evicted, not other caches in
+ * the same hash, such as global defaults.
+ * @param[in]  h    Clicon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @note Must not be called while zero-copy references to a cache may be held, eg
+ *       within a transaction. The backend calls it between client messages.
+ */
+int
+xmldb_cache_evict(clicon_handle h)
+{
+    int                    retval = -1;
+    char                  *maxstr;
+    uint64_t               max = 0;
+    uint64_t               total;
+    struct clixon_mem_stat ms;
+    enum clixon_mem_acct   acct;
+    char                 **keys = NULL;
+    size_t                 klen;
+    size_t                 i;
+    db_elmnt              *de;
+    db_elmnt              *delru;
+    char                  *lru;
+
+    /* uint32 option: parse unsigned, budgets >= 2GiB do not fit an int */
+    if ((maxstr = clicon_option_str(h, "CLICON_XMLDB_CACHE_MAX")) != NULL &&
+	parse_uint64(maxstr, &max, NULL) <= 0){
+	clicon_err(OE_CFG, EINVAL, "CLICON_XMLDB_CACHE_MAX: %s is not a number", maxstr);
+	goto done;
+    }
+    if (max == 0 ||
+	clicon_datastore_cache(h) == DATASTORE_NOCACHE)
+	goto ok;
+    while (1){
+	total = 0;
+	for (acct = CLIXON_MEM_RUNNING; acct <= CLIXON_MEM_DATASTORE; acct++){
+	    if (clixon_mem_get(acct, &ms) < 0)
+		goto done;
+	    total += ms.ms_bytes;
+	}
+	if (total <= max)
+	    break;
+	if (keys){
+	    free(keys);
+	    keys = NULL;
+	}
+	if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
+	    goto done;
+	delru = NULL;
+	lru = NULL;
+	for (i = 0; i < klen; i++){
+	    if (strcmp(keys[i], "running") == 0 || strcmp(keys[i], "candidate") == 0)
+		continue;
+	    if ((de = clicon_hash_value(clicon_db_elmnt(h), keys[i], NULL)) == NULL ||
+		de->de_xml == NULL || de->de_lastuse == 0)
+		continue;
+	    if (delru == NULL || de->de_lastuse < delru->de_lastuse){
+		delru = de;
+		lru = keys[i];
+	    }
+	}
+	if (delru == NULL) /* Only running and candidate left */
+	    break;
+	clicon_debug(1, "%s evict %s: %" PRIu64 " > %" PRIu64 " bytes", __FUNCTION__, lru, total, max);
+	xml_free(delru->de_xml);
+	delru->de_xml = NULL;
+	if (delru->de_lazy){
+	    xmldb_lazy_free(delru->de_lazy);
+	    delru->de_lazy = NULL;
+	}
+    }
+ ok:
+    retval = 0;
+ done:
+    if (keys)
+	free(keys);
+    return retval;
+}
+
 /*! Get modified flag from datastore
  * @param[in]  h     Clicon handle
  * @param[in]  db    Database name
@@ -560,3 +701,92 @@ xmldb_modified_set(clicon_handle h,
     de->de_modified = value;
     return 0;
 }
+
+/*! Initial value of a datastore generation counter
+ * Seeded from wall-clock time (in microseconds) so that a restarted backend does not
+ * reuse generation values that clients may have cached from an earlier run.
+ */
+static uint64_t
+xmldb_generation_seed(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec*1000000 + tv.tv_usec;
+}
+
+/*! Get generation counter of datastore
+ *
+ * The generation is a monotonically increasing number that changes whenever the
+ * content of the datastore changes (put, copy, delete, create). Clients can use it to
+ * invalidate cached datastore content without fetching it.
+ * @param[in]  h     Clicon handle
+ * @param[in]  db    Database name
+ * @retval     gen   Generation counter, 0 on error
+ * @see xmldb_generation_incr
+ */
+uint64_t
+xmldb_generation_get(clicon_handle h,
+		     const char   *db)
+{
+    db_elmnt *de;
+    db_elmnt  de0 = {0,};
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL ||
+	de->de_generation == 0){
+	if (de != NULL)
+	    de0 = *de;
+	de0.de_generation = xmldb_generation_seed();
+	de0.de_lastmod = time(NULL);
+	if (clicon_db_elmnt_set(h, db, &de0) < 0)
+	    return 0;
+	return de0.de_generation;
+    }
+    return de->de_generation;
+}
+
+/*! Increment generation counter of datastore, ie mark that its content has changed
+ * @param[in]  h     Clicon handle
+ * @param[in]  db    Database name
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xmldb_generation_get
+ */
+int
+xmldb_generation_incr(clicon_handle h,
+		      const char   *db)
+{
+    db_elmnt *de;
+
+    if (xmldb_generation_get(h, db) == 0)
+	return -1;
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL){
+	clicon_err(OE_CFG, EFAULT, "datastore %s does not exist", db);
+	return -1;
+    }
+    de->de_generation++;
+    de->de_lastmod = time(NULL);
+    return 0;
+}
+
+/*! Get time of last content change of datastore
+ * Changes before the datastore was first accessed in this process are not known,
+ * then the time of first access is returned.
+ * @param[in]  h     Clicon handle
+ * @param[in]  db    Database name
+ * @retval     t     Time of last change (seconds since epoch), 0 on error
+ * @see xmldb_generation_get  Changes at the same time
+ */
+time_t
+xmldb_lastmod_get(clicon_handle h,
+		  const char   *db)
+{
+    db_elmnt *de;
+
+    if (xmldb_generation_get(h, db) == 0)
+	return 0;
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL)
+	return 0;
+    return de->de_lastmod;
+}
+
@@ -42,6 +42,7 @@
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <ctype.h>
 #include <limits.h>
 #include <stdint.h>
 #include <sys/types.h>
@@ -64,6 +65,7 @@
 #include "clixon_log.h"
 #include "clixon_file.h"
 #include "clixon_yang.h"
+#include "clixon_memory.h"
 #include "clixon_xml.h"
 #include "clixon_xml_sort.h"
 #include "clixon_xml_bind.h"
@@ -71,6 +73,7 @@
 #include "clixon_data.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
+#include "clixon_xpath_function.h"
 #include "clixon_json.h"
 #include "clixon_nacm.h"
 #include "clixon_path.h"
@@ -85,6 +88,28 @@
 
 #define handle(xh) (assert(text_handle_check(xh)==0),(struct text_handle *)(xh))
 
+/*
+ * Types
+ */
+/* Unread top-level subtree of a datastore file, see xmldb_lazy_scan */
+struct xmldb_lazy_elmnt{
+    char   *le_name;  /* Local name of top-level element, NULL if read */
+    long    le_off;   /* Offset of start tag in datastore file */
+    size_t  le_len;   /* Length of element in datastore file */
+};
+
+/* Index of unread top-level subtrees of a datastore cache, see xmldb_lazy_load
+ * The offsets are valid as long as the datastore file is not written: xmldb_put reads
+ * all subtrees before writing the file, and xmldb_copy copies both file and index.
+ */
+struct xmldb_lazy{
+    char                    *xl_head; /* Start tag of config incl namespace declarations */
+    yang_bind                xl_yb;   /* How to bind yang to subtrees when read */
+    int                      xl_len;  /* Length of xl_vec */
+    int                      xl_nr;   /* Number of unread subtrees in xl_vec */
+    struct xmldb_lazy_elmnt *xl_vec;
+};
+
 /*! Ensure that xt only has a single sub-element and that is "config" 
  * @retval    -1     Top element not "config" or "config" element not unique or
  *                   other error, check specific clicon_errno, clicon_suberrno
@@ -510,6 +535,625 @@ xmldb_readfile(clicon_handle    h,
 #endif
 }
 
+/*! Free index of unread top-level subtrees
+ * @param[in]  xl   Lazy index, see xmldb_lazy_scan
+ * @retval     0    OK
+ */
+int
+xmldb_lazy_free(struct xmldb_lazy *xl)
+{
+    int i;
+
+    if (xl == NULL)
+	return 0;
+    if (xl->xl_vec){
+	for (i=0; i<xl->xl_len; i++)
+	    if (xl->xl_vec[i].le_name)
+		free(xl->xl_vec[i].le_name);
+	free(xl->xl_vec);
+    }
+    if (xl->xl_head)
+	free(xl->xl_head);
+    free(xl);
+    return 0;
+}
+
+/*! Copy index of unread top-level subtrees, only unread elements are copied
+ * @param[in]  xl   Lazy index, see xmldb_lazy_scan
+ * @retval     xl1  New index, free with xmldb_lazy_free
+ * @retval     NULL Error
+ * @note The copy refers to the same file offsets, ie the datastore file must be copied too
+ */
+struct xmldb_lazy *
+xmldb_lazy_dup(struct xmldb_lazy *xl)
+{
+    struct xmldb_lazy       *xl1 = NULL;
+    struct xmldb_lazy_elmnt *le;
+    int                      i;
+
+    if ((xl1 = malloc(sizeof(*xl1))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto err;
+    }
+    memset(xl1, 0, sizeof(*xl1));
+    xl1->xl_yb = xl->xl_yb;
+    if ((xl1->xl_head = strdup(xl->xl_head)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto err;
+    }
+    if ((xl1->xl_vec = calloc(xl->xl_nr+1, sizeof(*xl1->xl_vec))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto err;
+    }
+    for (i=0; i<xl->xl_len; i++){
+	if (xl->xl_vec[i].le_name == NULL)
+	    continue;
+	le = &xl1->xl_vec[xl1->xl_len++];
+	*le = xl->xl_vec[i];
+	if ((le->le_name = strdup(xl->xl_vec[i].le_name)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    goto err;
+	}
+	xl1->xl_nr++;
+    }
+    return xl1;
+ err:
+    xmldb_lazy_free(xl1);
+    return NULL;
+}
+
+/*! Skip characters in file until and including end string
+ * @param[in]     fp   File
+ * @param[in,out] pos  File offset, updated
+ * @param[in]     end  End string, at most three characters, eg "-->"
+ * @retval        1    End string found
+ * @retval        0    End of file
+ */
+static int
+xmldb_lazy_skip(FILE       *fp,
+		long       *pos,
+		const char *end)
+{
+    int  len = strlen(end);
+    char buf[3] = {0,};
+    int  c;
+
+    while ((c = getc(fp)) != EOF){
+	(*pos)++;
+	memmove(buf, buf+1, len-1);
+	buf[len-1] = c;
+	if (memcmp(buf, end, len) == 0)
+	    return 1;
+    }
+    return 0;
+}
+
+/*! Scan an XML datastore file and index the top-level elements under config
+ *
+ * Only tags are tokenized: comments, processing instructions, CDATA and quoted
+ * attribute values are skipped. Nothing is parsed or bound to YANG.
+ * @param[in]  fp   Datastore file, positioned at start
+ * @param[in]  xl   Lazy index, head and vector are set
+ * @retval     1    OK, config element is indexed
+ * @retval     0    Not indexable, eg empty, no config top or not well-formed. Read whole file.
+ * @retval    -1    Error
+ */
+static int
+xmldb_lazy_scan(FILE              *fp,
+		struct xmldb_lazy *xl)
+{
+    int                      retval = -1;
+    cbuf                    *cb = NULL; /* Current tag */
+    int                      c;
+    int                      q = 0;     /* Quote character if in attribute value */
+    int                      prev;
+    long                     pos = 0;   /* Offset of next character */
+    long                     start;     /* Offset of current tag */
+    long                     off = 0;   /* Offset of current top-level element */
+    char                    *name = NULL; /* Local name of current top-level element */
+    char                    *p;
+    int                      depth = 0; /* Number of open elements */
+    int                      empty;     /* Empty element tag, ie <x/> */
+    struct xmldb_lazy_elmnt *vec;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    while ((c = getc(fp)) != EOF){
+	pos++;
+	if (c != '<')
+	    continue;
+	start = pos - 1;
+	if ((c = getc(fp)) == EOF)
+	    goto fail;
+	pos++;
+	switch (c){
+	case '?': /* Processing instruction */
+	    if (xmldb_lazy_skip(fp, &pos, "?>") == 0)
+		goto fail;
+	    continue;
+	case '!': /* Comment, CDATA or DOCTYPE */
+	    if ((c = getc(fp)) == EOF)
+		goto fail;
+	    pos++;
+	    if (c == '-'){
+		if (xmldb_lazy_skip(fp, &pos, "-->") == 0)
+		    goto fail;
+	    }
+	    else if (c == '['){
+		if (xmldb_lazy_skip(fp, &pos, "]]>") == 0)
+		    goto fail;
+	    }
+	    else if (xmldb_lazy_skip(fp, &pos, ">") == 0)
+		goto fail;
+	    continue;
+	case '/': /* End tag */
+	    if (depth == 0)
+		goto fail;
+	    if (xmldb_lazy_skip(fp, &pos, ">") == 0)
+		goto fail;
+	    if (--depth == 0) /* </config> */
+		goto ok;
+	    if (depth == 1){
+		if (name == NULL)
+		    goto fail;
+		break; /* Top-level element complete */
+	    }
+	    continue;
+	default: /* Start tag */
+	    cbuf_reset(cb);
+	    cprintf(cb, "<%c", c);
+	    prev = c;
+	    while ((c = getc(fp)) != EOF){
+		pos++;
+		cprintf(cb, "%c", c);
+		if (q){
+		    if (c == q)
+			q = 0;
+		}
+		else if (c == '"' || c == '\'')
+		    q = c;
+		else if (c == '>')
+		    break;
+		prev = c;
+	    }
+	    if (c == EOF)
+		goto fail;
+	    empty = (prev == '/');
+	    if (depth == 0){
+		/* Top-level must be a non-empty <config> */
+		if (empty ||
+		    strncmp(cbuf_get(cb), "<config", strlen("<config")) != 0 ||
+		    (cbuf_get(cb)[strlen("<config")] != '>' &&
+		     !isspace(cbuf_get(cb)[strlen("<config")])))
+		    goto fail;
+		if ((xl->xl_head = strdup(cbuf_get(cb))) == NULL){
+		    clicon_err(OE_UNIX, errno, "strdup");
+		    goto done;
+		}
+		depth++;
+		continue;
+	    }
+	    if (depth == 1){
+		/* Local name of top-level element: skip "<" and prefix */
+		p = cbuf_get(cb) + 1;
+		p[strcspn(p, " \t\r\n/>")] = '\0';
+		if (strchr(p, ':'))
+		    p = strchr(p, ':') + 1;
+		if ((name = strdup(p)) == NULL){
+		    clicon_err(OE_UNIX, errno, "strdup");
+		    goto done;
+		}
+		off = start;
+	    }
+	    if (!empty){
+		depth++;
+		continue;
+	    }
+	    if (depth > 1)
+		continue;
+	    break; /* Empty top-level element */
+	}
+	/* Add top-level element from off to pos */
+	if ((vec = realloc(xl->xl_vec, (xl->xl_len+1)*sizeof(*vec))) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    goto done;
+	}
+	xl->xl_vec = vec;
+	vec[xl->xl_len].le_name = name;
+	vec[xl->xl_len].le_off = off;
+	vec[xl->xl_len].le_len = pos - off;
+	name = NULL;
+	xl->xl_len++;
+	xl->xl_nr++;
+    }
+    goto fail; /* No </config> */
+ ok:
+    retval = 1;
+ done:
+    if (name)
+	free(name);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Read unread top-level subtrees of a datastore file into its cache
+ *
+ * All subtrees are parsed in one go, using the start tag of config to get the same
+ * namespace context as when the whole file is parsed
+ * @param[in]  h     Clicon handle
+ * @param[in]  db    Datastore name, eg "running"
+ * @param[in]  yspec Top-level yang spec
+ * @param[in]  xl    Lazy index, read elements are removed on success
+ * @param[in]  xt    Cached XML tree (config), read subtrees are added
+ * @param[in]  names Local names of top-level elements to read, or NULL for all
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xmldb_lazy_read(clicon_handle      h,
+		const char        *db,
+		yang_stmt         *yspec,
+		struct xmldb_lazy *xl,
+		cxobj             *xt,
+		cvec              *names)
+{
+    int                      retval = -1;
+    char                    *dbfile = NULL;
+    FILE                    *fp = NULL;
+    cbuf                    *cb = NULL;
+    char                    *buf = NULL;
+    cxobj                   *x1 = NULL;
+    cxobj                   *xc;
+    struct xmldb_lazy_elmnt *le;
+    int                      nr = 0;
+    int                      i;
+    enum clixon_mem_acct     acct0;
+
+    acct0 = clixon_mem_acct_set(clixon_mem_acct_db(db));
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "%s", xl->xl_head);
+    for (i=0; i<xl->xl_len; i++){
+	le = &xl->xl_vec[i];
+	if (le->le_name == NULL)
+	    continue;
+	if (names && cvec_find(names, le->le_name) == NULL)
+	    continue;
+	if (fp == NULL){
+	    if (xmldb_db2file(h, db, &dbfile) < 0)
+		goto done;
+	    if ((fp = fopen(dbfile, "r")) == NULL) {
+		clicon_err(OE_UNIX, errno, "open(%s)", dbfile);
+		goto done;
+	    }
+	}
+	if ((buf = realloc(buf, le->le_len + 1)) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    goto done;
+	}
+	if (fseek(fp, le->le_off, SEEK_SET) < 0 ||
+	    fread(buf, 1, le->le_len, fp) != le->le_len){
+	    clicon_err(OE_UNIX, errno, "read %s at %ld", dbfile, le->le_off);
+	    goto done;
+	}
+	buf[le->le_len] = '\0';
+	cprintf(cb, "%s", buf);
+	nr++;
+    }
+    if (nr == 0)
+	goto ok;
+    clicon_debug(1, "%s %s: %d subtrees", __FUNCTION__, db, nr);
+    cprintf(cb, "</config>");
+    /* Parse errors are treated as in xmldb_readfile */
+    if (clixon_xml_parse_string(cbuf_get(cb), xl->xl_yb, yspec, &x1, NULL) < 0)
+	goto done;
+    if (singleconfigroot(x1, &x1) < 0)
+	goto done;
+    while ((xc = xml_child_i_type(x1, 0, CX_ELMNT)) != NULL)
+	if (xml_addsub(xt, xc) < 0)
+	    goto done;
+    /* Remove from index only when read, so that they are not lost on error */
+    for (i=0; i<xl->xl_len; i++){
+	le = &xl->xl_vec[i];
+	if (le->le_name == NULL)
+	    continue;
+	if (names && cvec_find(names, le->le_name) == NULL)
+	    continue;
+	free(le->le_name);
+	le->le_name = NULL;
+	xl->xl_nr--;
+    }
+    if (xl->xl_yb != YB_NONE)
+	if (xml_sort(xt) < 0)
+	    goto done;
+ ok:
+    retval = 0;
+ done:
+    clixon_mem_acct_set(acct0);
+    if (x1)
+	xml_free(x1);
+    if (buf)
+	free(buf);
+    if (cb)
+	cbuf_free(cb);
+    if (fp)
+	fclose(fp);
+    if (dbfile)
+	free(dbfile);
+    return retval;
+}
+
+/*! Read an XML tree from file, leaving top-level subtrees unread if CLICON_XMLDB_LAZY
+ *
+ * Same as xmldb_readfile, but if lazy loading applies, the file is only indexed and an
+ * empty config is returned, except modules-state which is read directly.
+ * The index is returned in de->de_lazy, use xmldb_lazy_load to read subtrees.
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Symbolic database name, eg "candidate", "running"
+ * @param[in]  yb     How to bind yang to XML top-level when parsing
+ * @param[in]  yspec  Top-level yang spec
+ * @param[out] xp     XML tree read from file
+ * @param[out] de     Db-element status (empty flag and lazy index)
+ * @param[out] msdiff If set, return modules-state differences
+ * @retval     -1     General error, check specific clicon_errno, clicon_suberrno
+ * @retval     1      OK
+ * @see xmldb_readfile
+ */
+static int
+xmldb_readfile_lazy(clicon_handle    h,
+		    const char      *db,
+		    yang_bind        yb,
+		    yang_stmt       *yspec,
+		    cxobj          **xp,
+		    db_elmnt        *de,
+		    modstate_diff_t *msdiff)
+{
+    int                retval = -1;
+    struct xmldb_lazy *xl = NULL;
+    char              *dbfile = NULL;
+    FILE              *fp = NULL;
+    char              *format;
+    cxobj             *x0 = NULL;
+    cvec              *names = NULL;
+    int                ret;
+
+    format = clicon_option_str(h, "CLICON_XMLDB_FORMAT");
+    if (!clicon_option_bool(h, "CLICON_XMLDB_LAZY") ||
+	format == NULL || strcmp(format, "json") == 0)
+	return xmldb_readfile(h, db, yb, yspec, xp, de, msdiff);
+    if (xmldb_db2file(h, db, &dbfile) < 0)
+	goto done;
+    if (dbfile==NULL){
+	clicon_err(OE_XML, 0, "dbfile NULL");
+	goto done;
+    }
+    if ((fp = fopen(dbfile, "r")) == NULL) {
+	clicon_err(OE_UNIX, errno, "open(%s)", dbfile);
+	goto done;
+    }
+    if ((xl = malloc(sizeof(*xl))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(xl, 0, sizeof(*xl));
+    xl->xl_yb = yb;
+    if ((ret = xmldb_lazy_scan(fp, xl)) < 0)
+	goto done;
+    if (ret == 0 || xl->xl_nr == 0){ /* Nothing to gain */
+	retval = xmldb_readfile(h, db, yb, yspec, xp, de, msdiff);
+	goto done;
+    }
+    /* Empty config with the same attributes as in the file */
+    if (clixon_xml_parse_va(yb, yspec, &x0, NULL, "%s</config>", xl->xl_head) < 0)
+	goto done;
+    if (singleconfigroot(x0, &x0) < 0)
+	goto done;
+    /* Modules-state is read directly to check it */
+    if ((names = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto done;
+    }
+    if (cvec_add_string(names, "modules-state", "modules-state") == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_add_string");
+	goto done;
+    }
+    if (xmldb_lazy_read(h, db, yspec, xl, x0, names) < 0)
+	goto done;
+    if (text_read_modstate(h, yspec, x0, msdiff) < 0)
+	goto done;
+    clicon_debug(1, "%s %s: %d subtrees unread", __FUNCTION__, db, xl->xl_nr);
+    if (xl->xl_nr == 0 && xml_child_nr(x0) == 0)
+	de->de_empty = 1;
+    if (xl->xl_nr){
+	de->de_lazy = xl;
+	xl = NULL;
+    }
+    *xp = x0;
+    x0 = NULL;
+    retval = 1;
+ done:
+    if (names)
+	cvec_free(names);
+    if (x0)
+	xml_free(x0);
+    if (xl)
+	xmldb_lazy_free(xl);
+    if (fp)
+	fclose(fp);
+    if (dbfile)
+	free(dbfile);
+    return retval;
+}
+
+/*! Check that an xpath only refers to nodes within the subtree of its context node
+ * @param[in]  xs   XPath parse tree, or NULL
+ * @retval     1    Local
+ * @retval     0    Not local, or unknown, eg absolute path, parent axis, current() or deref()
+ */
+static int
+xmldb_lazy_xpath_local(xpath_tree *xs)
+{
+    if (xs == NULL)
+	return 1;
+    switch (xs->xs_type){
+    case XP_ABSPATH:
+	return 0;
+    case XP_STEP:
+	switch (xs->xs_int){
+	case A_CHILD:
+	case A_SELF:
+	case A_ATTRIBUTE:
+	case A_DESCENDANT:
+	case A_DESCENDANT_OR_SELF:
+	    break;
+	default:
+	    return 0;
+	}
+	break;
+    case XP_PRIME_FN:
+	if (xs->xs_int == XPATHFN_CURRENT || xs->xs_int == XPATHFN_DEREF)
+	    return 0;
+	break;
+    default:
+	break;
+    }
+    return xmldb_lazy_xpath_local(xs->xs_c0) && xmldb_lazy_xpath_local(xs->xs_c1);
+}
+
+/*! Get local names of the top-level elements an xpath may select nodes in
+ *
+ * Location paths (and unions of them) whose first step is a named child are resolved,
+ * provided that predicates and later steps stay within that subtree.
+ * @param[in]  xs     XPath parse tree, evaluated with the datastore top (config) as context
+ * @param[in]  names  Names are added to this vector
+ * @retval     1      All selected nodes are in subtrees with a name in names
+ * @retval     0      Unknown, any subtree may be selected
+ * @retval    -1      Error
+ */
+static int
+xmldb_lazy_xpath_names(xpath_tree *xs,
+		       cvec       *names)
+{
+    int         ret;
+    xpath_tree *xn;
+
+    if (xs == NULL)
+	return 0;
+    switch (xs->xs_type){
+    case XP_EXP:
+    case XP_AND:
+    case XP_RELEX:
+    case XP_ADD:
+    case XP_PATHEXPR:
+    case XP_LOCPATH:
+	if (xs->xs_c1 != NULL) /* Operator or filter expression */
+	    return 0;
+	return xmldb_lazy_xpath_names(xs->xs_c0, names);
+    case XP_UNION:
+	if ((ret = xmldb_lazy_xpath_names(xs->xs_c0, names)) != 1)
+	    return ret;
+	if (xs->xs_c1 == NULL)
+	    return 1;
+	return xmldb_lazy_xpath_names(xs->xs_c1, names);
+    case XP_ABSPATH:
+	if (xs->xs_int != A_ROOT) /* eg //x */
+	    return 0;
+	return xmldb_lazy_xpath_names(xs->xs_c0, names);
+    case XP_RELLOCPATH:
+	/* c0 is the path up to the last step c1, or the only step if no c1 */
+	if (!xmldb_lazy_xpath_local(xs->xs_c1))
+	    return 0;
+	return xmldb_lazy_xpath_names(xs->xs_c0, names);
+    case XP_STEP:
+	xn = xs->xs_c0;
+	if (xs->xs_int != A_CHILD || xn == NULL ||
+	    xn->xs_type != XP_NODE || xn->xs_s1 == NULL)
+	    return 0;
+	if (!xmldb_lazy_xpath_local(xs->xs_c1)) /* predicates */
+	    return 0;
+	if (cvec_find(names, xn->xs_s1) == NULL &&
+	    cvec_add_string(names, xn->xs_s1, xn->xs_s1) == NULL){
+	    clicon_err(OE_UNIX, errno, "cvec_add_string");
+	    return -1;
+	}
+	return 1;
+    default:
+	return 0;
+    }
+}
+
+/*! Read unread top-level subtrees of a datastore cache that an xpath may select
+ *
+ * If CLICON_XMLDB_LAZY is set, a datastore read into the cache only consists of the
+ * top-level elements accessed so far, see xmldb_readfile_lazy.
+ * This function reads the subtrees needed to evaluate an xpath, or all of them.
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Datastore name, eg "running"
+ * @param[in]  xpath  XPath evaluated on the cache, or NULL for all subtrees
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @code
+ *   if (xmldb_lazy_load(h, "running", "/ex:interfaces") < 0)
+ *      err;
+ * @endcode
+ */
+int
+xmldb_lazy_load(clicon_handle h,
+		const char   *db,
+		const char   *xpath)
+{
+    int         retval = -1;
+    db_elmnt   *de;
+    yang_stmt  *yspec;
+    xpath_tree *xptree = NULL;
+    cvec       *names = NULL;
+    int         ret;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL ||
+	de->de_lazy == NULL || de->de_xml == NULL)
+	goto ok;
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+	clicon_err(OE_YANG, ENOENT, "No yang spec");
+	goto done;
+    }
+    if (xpath != NULL && strcmp(xpath, "/") != 0){
+	if ((names = cvec_new(0)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cvec_new");
+	    goto done;
+	}
+	if (xpath_parse(xpath, &xptree) < 0)
+	    goto done;
+	if ((ret = xmldb_lazy_xpath_names(xptree, names)) < 0)
+	    goto done;
+	if (ret == 0){ /* Read all */
+	    cvec_free(names);
+	    names = NULL;
+	}
+    }
+    if (xmldb_lazy_read(h, db, yspec, de->de_lazy, de->de_xml, names) < 0)
+	goto done;
+    if (de->de_lazy->xl_nr == 0){
+	xmldb_lazy_free(de->de_lazy);
+	de->de_lazy = NULL;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (xptree)
+	xpath_tree_free(xptree);
+    if (names)
+	cvec_free(names);
+    return retval;
+}
+
 /*! Get content of database using xpath. return a set of matching sub-trees
  * The function returns a minimal tree that includes all sub-trees that match
  * xpath.
@@ -655,6 +1299,7 @@ xmldb_get_cache(clicon_handle    h,
     cxobj          *x1t = NULL;
     db_elmnt        de0 = {0,};
     int             ret;
+    enum clixon_mem_acct acct0;
 
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
 	clicon_err(OE_YANG, ENOENT, "No yang spec");
@@ -662,8 +1307,16 @@ xmldb_get_cache(clicon_handle    h,
     }
     de = clicon_db_elmnt_get(h, db);
     if (de == NULL || de->de_xml == NULL){ /* Cache miss, read XML from file */
+	/* Keep lock, generation, etc if the cache was cleared or evicted */
+	if (de != NULL){
+	    de0 = *de;
+	    de0.de_empty = 0;
+	}
 	/* If there is no xml x0 tree (in cache), then read it from file */
-	if ((ret = xmldb_readfile(h, db, yb, yspec, &x0t, &de0, msdiff)) < 0)
+	acct0 = clixon_mem_acct_set(clixon_mem_acct_db(db));
+	ret = xmldb_readfile_lazy(h, db, yb, yspec, &x0t, &de0, msdiff);
+	clixon_mem_acct_set(acct0);
+	if (ret < 0)
 	    goto done;
 	if (ret == 0)
 	    goto fail;
@@ -675,6 +1328,10 @@ xmldb_get_cache(clicon_handle    h,
     } /* x0t == NULL */
     else
 	x0t = de->de_xml;
+    xmldb_cache_touch(h, db);
+    /* Read the subtrees the xpath may select, if not read already */
+    if (xmldb_lazy_load(h, db, xpath) < 0)
+	goto done;
 
     if (yb == YB_MODULE && !xml_spec(x0t))
 	if (xml_bind_yang(x0t, YB_MODULE, yspec, NULL) < 0)
@@ -798,15 +1455,23 @@ xmldb_get_zerocopy(clicon_handle    h,
     db_elmnt       *de = NULL;
     db_elmnt        de0 = {0,};
     int             ret;
+    enum clixon_mem_acct acct0;
 
+    /* The cache is read and defaults are added to it */
+    acct0 = clixon_mem_acct_set(clixon_mem_acct_db(db));
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
 	clicon_err(OE_YANG, ENOENT, "No yang spec");
 	goto done;
     }
     de = clicon_db_elmnt_get(h, db);
     if (de == NULL || de->de_xml == NULL){ /* Cache miss, read XML from file */
+	/* Keep lock, generation, etc if the cache was cleared or evicted */
+	if (de != NULL){
+	    de0 = *de;
+	    de0.de_empty = 0;
+	}
 	/* If there is no xml x0 tree (in cache), then read it from file */
-	if ((ret = xmldb_readfile(h, db, yb, yspec, &x0t, &de0, msdiff)) < 0)
+	if ((ret = xmldb_readfile_lazy(h, db, yb, yspec, &x0t, &de0, msdiff)) < 0)
 	    goto done;
 	if (ret == 0)
 	    goto fail;
@@ -818,6 +1483,10 @@ xmldb_get_zerocopy(clicon_handle    h,
     } /* x0t == NULL */
     else
 	x0t = de->de_xml;
+    xmldb_cache_touch(h, db);
+    /* Read the subtrees the xpath may select, if not read already */
+    if (xmldb_lazy_load(h, db, xpath) < 0)
+	goto done;
 
     /* Here xt looks like: <config>...</config> */
     if (xpath_vec(x0t, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
@@ -849,6 +1518,7 @@ xmldb_get_zerocopy(clicon_handle    h,
     *xtop = x0t;
     retval = 1;
  done:
+    clixon_mem_acct_set(acct0);
     clicon_debug(2, "%s retval:%d", __FUNCTION__, retval);
     if (xvec)
 	free(xvec);
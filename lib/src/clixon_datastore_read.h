@@ -43,5 +43,7 @@
  */
 int xmldb_readfile(clicon_handle h, const char *db, yang_bind yb, yang_stmt *yspec,
 		   cxobj **xp, db_elmnt *de, modstate_diff_t *msd);
+int xmldb_lazy_free(struct xmldb_lazy *xl);
+struct xmldb_lazy *xmldb_lazy_dup(struct xmldb_lazy *xl);
 
 #endif /* _CLIXON_DATASTORE_READ_H */
@@ -64,6 +64,7 @@
 #include "clixon_log.h"
 #include "clixon_file.h"
 #include "clixon_yang.h"
+#include "clixon_memory.h"
 #include "clixon_xml.h"
 #include "clixon_xml_sort.h"
 #include "clixon_options.h"
@@ -203,6 +204,152 @@ check_body_namespace(cxobj     *x0,
     return retval;
 }
 
+#ifdef XMLDB_BULK_MERGE
+/*! Check if nodes of a yang spec are sorted by system, ie can be merged in bulk
+ * @param[in]  y   Yang spec of xml node
+ * @retval     1   Ordered-by system
+ * @retval     0   Ordered-by user (or state data)
+ * @see xml_insert for the same criteria
+ */
+static int
+bulk_ordered_by_system(yang_stmt *y)
+{
+#ifndef STATE_ORDERED_BY_SYSTEM
+    if (yang_config_ancestor(y)==0)
+	return 0;
+#endif
+    if ((yang_keyword_get(y) == Y_LIST || yang_keyword_get(y) == Y_LEAF_LIST) &&
+	yang_find(y, Y_ORDERED_BY, "user") != NULL)
+	return 0;
+    return 1;
+}
+
+/*! Check if xml node has only namespace declaration attributes
+ * Other attributes, eg operation, may change NACM access of the node
+ */
+static int
+bulk_attr_xmlns_only(cxobj *x)
+{
+    cxobj *xa = NULL;
+    char  *prefix;
+
+    while ((xa = xml_child_each(x, xa, CX_ATTR)) != NULL){
+	prefix = xml_prefix(xa);
+	if (prefix == NULL && strcmp(xml_name(xa), "xmlns") == 0)
+	    continue;
+	if (prefix && strcmp(prefix, "xmlns") == 0)
+	    continue;
+	return 0;
+    }
+    return 1;
+}
+
+/*! Check if the children of a modification tree can be merged in bulk into base tree
+ *
+ * Bulk merge is made if all children of x1 are ordered-by system and at least 
+ * XMLDB_BULK_MERGE are new. Then new children are appended to x0 and x0 is sorted
+ * once after all are added.
+ * Also, NACM create access of new children is checked for all of them at once, 
+ * instead of once per child. Children with other attributes than xmlns are skipped
+ * here, and checked individually since they may have own operations.
+ * @param[in]  h         Clicon handle
+ * @param[in]  x1        XML tree which modifies base
+ * @param[in]  x1t       Request root node (nacm needs this)
+ * @param[in]  x0vec     Matching base children of x1 children, NULL if new
+ * @param[in]  op        OP_MERGE, OP_REPLACE, OP_REMOVE, etc 
+ * @param[in]  username  User name of requestor for nacm
+ * @param[in]  xnacm     NACM XML tree (only if !permit)
+ * @param[in]  permit    If set, no NACM tests using xnacm required
+ * @param[out] bulk      Set if children should be merged in bulk
+ * @param[out] permitvec If bulk NACM check made: vector of children already permitted, free after use
+ * @param[out] cbret     Initialized cligen buffer. Contains return XML if retval is 0.
+ * @retval    -1         Error
+ * @retval     0         Failed (cbret set)
+ * @retval     1         OK
+ */
+static int
+text_modify_bulk(clicon_handle       h,
+		 cxobj              *x1,
+		 cxobj              *x1t,
+		 cxobj             **x0vec,
+		 enum operation_type op,
+		 char               *username,
+		 cxobj              *xnacm,
+		 int                 permit,
+		 int                *bulk,
+		 char              **permitvec,
+		 cbuf               *cbret)
+{
+    int         retval = -1;
+    cxobj      *x1c;
+    yang_stmt  *yc;
+    yang_stmt  *yprev = NULL;
+    int         i;
+    int         nnew = 0;
+    cxobj     **xcreate = NULL;
+    size_t      ncreate = 0;
+    char       *pvec = NULL;
+    int         ret;
+
+    *bulk = 0;
+    x1c = NULL;
+    i = 0;
+    while ((x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL) {
+	if ((yc = xml_spec(x1c)) != yprev){
+	    if (bulk_ordered_by_system(yc) == 0)
+		goto ok;
+	    yprev = yc;
+	}
+	if (x0vec[i++] == NULL)
+	    nnew++;
+    }
+    if (nnew < XMLDB_BULK_MERGE)
+	goto ok;
+    *bulk = 1;
+    if (permit || xnacm == NULL ||
+	(op != OP_MERGE && op != OP_REPLACE && op != OP_CREATE))
+	goto ok;
+    /* NACM create access of all new children in one check */
+    if ((xcreate = calloc(nnew, sizeof(cxobj *))) == NULL ||
+	(pvec = calloc(xml_child_nr(x1), sizeof(char))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    x1c = NULL;
+    i = 0;
+    while ((x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL) {
+	if (x0vec[i] == NULL &&
+	    yang_keyword_get(xml_spec(x1c)) != Y_ANYXML &&
+	    yang_keyword_get(xml_spec(x1c)) != Y_ANYDATA &&
+	    bulk_attr_xmlns_only(x1c)){
+	    xcreate[ncreate++] = x1c;
+	    pvec[i] = 1;
+	}
+	i++;
+    }
+    if (ncreate){
+	if ((ret = nacm_datanode_write_vec(h, xcreate, ncreate, x1t, NACM_CREATE,
+					   username, xnacm, cbret)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+    }
+    *permitvec = pvec;
+    pvec = NULL;
+ ok:
+    retval = 1;
+ done:
+    if (xcreate)
+	free(xcreate);
+    if (pvec)
+	free(pvec);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+#endif /* XMLDB_BULK_MERGE */
+
 /*! Modify a base tree x0 with x1 with yang spec y according to operation op
  * @param[in]  h        Clicon handle
  * @param[in]  x0       Base xml tree (can be NULL in add scenarios)
@@ -214,6 +361,7 @@ check_body_namespace(cxobj     *x0,
  * @param[in]  username User name of requestor for nacm
  * @param[in]  xnacm    NACM XML tree (only if !permit)
  * @param[in]  permit   If set, no NACM tests using xnacm required
+ * @param[in]  append   If set, a new x0 is appended to x0p which is sorted by caller
  * @param[out] cbret    Initialized cligen buffer. Contains return XML if retval is 0.
  * @retval    -1        Error
  * @retval     0        Failed (cbret set)
@@ -237,6 +385,7 @@ text_modify(clicon_handle       h,
 	    char               *username,
 	    cxobj              *xnacm,
 	    int                 permit,
+	    int                 append,
 	    cbuf               *cbret)
 {
     int        retval = -1;
@@ -259,6 +408,8 @@ text_modify(clicon_handle       h,
     int        changed = 0; /* Only if x0p's children have changed-> sort necessary */
     cvec      *nscx1 = NULL;
     char      *createstr = NULL;	
+    int        bulk = 0;         /* x0:s new children are appended and merged */
+    char      *permitvec = NULL; /* x1 children with NACM checked in bulk */
     
     if (x1 == NULL){
 	clicon_err(OE_XML, EINVAL, "x1 is missing");
@@ -447,7 +598,11 @@ text_modify(clicon_handle       h,
 		}
 	    }
 	    if (changed){ 
-		if (xml_insert(x0p, x0, insert, valstr, NULL) < 0) 
+		if (append){
+		    if (xml_addsub(x0p, x0) < 0)
+			goto done;
+		}
+		else if (xml_insert(x0p, x0, insert, valstr, NULL) < 0) 
 		    goto done;
 	    }
 	    break;
@@ -653,6 +808,15 @@ text_modify(clicon_handle       h,
 		}
 		x0vec[i++] = x0c; /* != NULL if x0c is matching x1c */
 	    }
+#ifdef XMLDB_BULK_MERGE
+	    /* Many new children: append them and sort x0 once */
+	    if ((ret = text_modify_bulk(h, x1, x1t, x0vec, op,
+					username, xnacm, permit,
+					&bulk, &permitvec, cbret)) < 0)
+		goto done;
+	    if (ret == 0)
+		goto fail;
+#endif
 	    /* Second pass: Loop through children of the x1 modification tree again
 	     * Now potentially modify x0:s children 
 	     * Here x0vec contains one-to-one matching nodes of x1:s children.
@@ -661,18 +825,30 @@ text_modify(clicon_handle       h,
 	    i = 0;
 	    while ((x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL) {
 		x1cname = xml_name(x1c);
-		x0c = x0vec[i++];
+		x0c = x0vec[i];
 		yc = yang_find_datanode(y0, x1cname);
 		if ((ret = text_modify(h, x0c, x0, x0t, x1c, x1t,
 				       yc, op,
-				       username, xnacm, permit, cbret)) < 0)
+				       username, xnacm,
+				       permit || (permitvec && permitvec[i]),
+				       bulk, cbret)) < 0)
 		    goto done;
 		/* If xml return - ie netconf error xml tree, then stop and return OK */
 		if (ret == 0)
 		    goto fail;
+		i++;
+	    }
+	    if (bulk){
+		bulk = 0;
+		if (xml_sort_merge(x0) < 0)
+		    goto done;
 	    }
 	    if (changed){
-		if (xml_insert(x0p, x0, insert, keystr, nscx1) < 0)
+		if (append){
+		    if (xml_addsub(x0p, x0) < 0)
+			goto done;
+		}
+		else if (xml_insert(x0p, x0, insert, keystr, nscx1) < 0)
 		    goto done;
 	    }
 	    break;
@@ -702,11 +878,16 @@ text_modify(clicon_handle       h,
  done:
     if (nscx1)
 	xml_nsctx_free(nscx1);
+    /* Keep x0 sorted also if a bulk merge is interrupted */
+    if (bulk && xml_sort_merge(x0) < 0)
+	retval = -1;
     /* Remove dangling added objects */
     if (changed && x0 && xml_parent(x0)==NULL)
 	xml_purge(x0);
     if (x0vec)
 	free(x0vec);
+    if (permitvec)
+	free(permitvec);
     return retval;
  fail: /* cbret set */
     retval = 0;
@@ -863,7 +1044,7 @@ text_modify_top(clicon_handle       h,
 	}
 	if ((ret = text_modify(h, x0c, x0, x0t, x1c, x1t,
 			       yc, op,
-			       username, xnacm, permit, cbret)) < 0)
+			       username, xnacm, permit, 0, cbret)) < 0)
 	    goto done;
 	/* If xml return - ie netconf error xml tree, then stop and return OK */
 	if (ret == 0)
@@ -926,7 +1107,10 @@ xmldb_put(clicon_handle       h,
     cvec               *nsc = NULL; /* nacm namespace context */
     int                 firsttime = 0;
     int                 pretty;
+    enum clixon_mem_acct acct0;
 
+    /* Objects added to the datastore tree are accounted to it */
+    acct0 = clixon_mem_acct_set(clixon_mem_acct_db(db));
     if (cbret == NULL){
 	clicon_err(OE_XML, EINVAL, "cbret is NULL");
 	goto done;
@@ -944,6 +1128,9 @@ xmldb_put(clicon_handle       h,
 	if (clicon_datastore_cache(h) != DATASTORE_NOCACHE)
 	    x0 = de->de_xml; 
     }
+    /* The whole tree is written to file, read all subtrees if not already read */
+    if (x0 && xmldb_lazy_load(h, db, NULL) < 0)
+	goto done;
     /* If there is no xml x0 tree (in cache), then read it from file */
     if (x0 == NULL){
 	firsttime++; /* to avoid leakage on error, see fail from text_modify */
@@ -1011,6 +1198,7 @@ xmldb_put(clicon_handle       h,
 	    de0.de_xml = x0;
 	de0.de_empty = (xml_child_nr(de0.de_xml) == 0);
 	clicon_db_elmnt_set(h, db, &de0);
+	xmldb_cache_touch(h, db);
     }
     if (xmldb_db2file(h, db, &dbfile) < 0)
 	goto done;
@@ -1046,6 +1234,8 @@ xmldb_put(clicon_handle       h,
      */
     if (xmodst && xml_purge(xmodst) < 0)
 	goto done;
+    if (xmldb_generation_incr(h, db) < 0)
+	goto done;
     retval = 1;
  done:
     if (f != NULL)
@@ -1058,6 +1248,7 @@ xmldb_put(clicon_handle       h,
 	cbuf_free(cb);
     if (x0 && clicon_datastore_cache(h) == DATASTORE_NOCACHE)
 	xml_free(x0);
+    clixon_mem_acct_set(acct0);
     return retval;
  fail:
     retval = 0;
@@ -68,7 +68,7 @@
 struct event_data{
     struct event_data *e_next;     /* next in list */
     int (*e_fn)(int, void*);            /* function */
-    enum {EVENT_FD, EVENT_TIME} e_type;        /* type of event */
+    enum {EVENT_FD, EVENT_FD_WRITE, EVENT_TIME} e_type; /* type of event */
     int e_fd;                      /* File descriptor */
     struct timeval e_time;         /* Timeout */
     void *e_arg;                   /* function argument */
@@ -152,11 +152,34 @@ clixon_event_reg_fd(int   fd,
     return 0;
 }
 
+/*! Register a callback function to be called when a file descriptor is writable
+ *
+ * Used for non-blocking output: register when a write would block, and deregister
+ * with clixon_event_unreg_fd when all pending output has been written.
+ * @param[in]  fd  File descriptor
+ * @param[in]  fn  Function to call when fd is writable
+ * @param[in]  arg Argument to function fn
+ * @param[in]  str Describing string for logging
+ * @see clixon_event_reg_fd  for input
+ */
+int
+clixon_event_reg_fd_write(int   fd, 
+			  int (*fn)(int, void*), 
+			  void *arg, 
+			  char *str)
+{
+    if (clixon_event_reg_fd(fd, fn, arg, str) < 0)
+	return -1;
+    ee->e_type = EVENT_FD_WRITE;
+    return 0;
+}
+
 /*! Deregister a file descriptor callback
  * @param[in]  s   File descriptor
  * @param[in]  fn  Function to call when input available on fd
  * Note: deregister when exactly function and socket match, not argument
  * @see clixon_event_reg_fd
+ * @see clixon_event_reg_fd_write
  * @see clixon_event_unreg_timeout
  */
 int
@@ -299,23 +322,27 @@ clixon_event_loop(void)
     struct timeval     t0;
     struct timeval     tnull = {0,};
     fd_set             fdset;
+    fd_set             wfdset;
     int                retval = -1;
 
     while (!clicon_exit_get()){
 	FD_ZERO(&fdset);
+	FD_ZERO(&wfdset);
 	for (e=ee; e; e=e->e_next)
 	    if (e->e_type == EVENT_FD)
 		FD_SET(e->e_fd, &fdset);
+	    else if (e->e_type == EVENT_FD_WRITE)
+		FD_SET(e->e_fd, &wfdset);
 	if (ee_timers != NULL){
 	    gettimeofday(&t0, NULL);
 	    timersub(&ee_timers->e_time, &t0, &t); 
 	    if (t.tv_sec < 0)
-		n = select(FD_SETSIZE, &fdset, NULL, NULL, &tnull); 
+		n = select(FD_SETSIZE, &fdset, &wfdset, NULL, &tnull); 
 	    else
-		n = select(FD_SETSIZE, &fdset, NULL, NULL, &t); 
+		n = select(FD_SETSIZE, &fdset, &wfdset, NULL, &t); 
 	}
 	else
-	    n = select(FD_SETSIZE, &fdset, NULL, NULL, NULL); 
+	    n = select(FD_SETSIZE, &fdset, &wfdset, NULL, NULL); 
 	if (clicon_exit_get())
 	    break;
 	if (n == -1) {
@@ -343,7 +370,8 @@ clixon_event_loop(void)
 	    if (clicon_exit_get())
 		break;
 	    e_next = e->e_next;
-	    if(e->e_type == EVENT_FD && FD_ISSET(e->e_fd, &fdset)){
+	    if ((e->e_type == EVENT_FD && FD_ISSET(e->e_fd, &fdset)) ||
+		(e->e_type == EVENT_FD_WRITE && FD_ISSET(e->e_fd, &wfdset))){
 		clicon_debug(2, "%s: FD_ISSET: %s", __FUNCTION__, e->e_string);
 		if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
 		    clicon_debug(1, "%s Error in: %s", __FUNCTION__, e->e_string);
@@ -231,6 +231,7 @@ array_eval(cxobj *xprev,
 }
 
 /*! Escape a json string as well as decode xml cdata
+ * Runs of characters not needing escaping are copied in one go.
  * @param[out] cb   cbuf   (encoded)
  * @param[in]  str  string (unencoded)
  */
@@ -238,45 +239,55 @@ static int
 json_str_escape_cdata(cbuf *cb,
 		      char *str)
 {
-    int   retval = -1;
-    int   i;
-    int   esc = 0; /* cdata escape */
+    int    retval = -1;
+    char  *s = str;
+    size_t n;
+    int    esc = 0; /* cdata escape */
 
-    for (i=0;i<strlen(str);i++)
-	switch (str[i]){
+    while (*s != '\0'){
+	/* Inside cdata "<" is plain, outside "]" is plain */
+	if ((n = strcspn(s, esc?"\n\"\\]":"\n\"\\<")) > 0){
+	    if (cbuf_append_buf(cb, s, n) < 0){
+		clicon_err(OE_UNIX, errno, "cbuf_append_buf");
+		goto done;
+	    }
+	    s += n;
+	}
+	switch (*s){
 	case '\n':
-	    cprintf(cb, "\\n");
+	    cbuf_append_str(cb, "\\n");
+	    s++;
 	    break;
 	case '\"':
-	    cprintf(cb, "\\\"");
+	    cbuf_append_str(cb, "\\\"");
+	    s++;
 	    break;
 	case '\\':
-	    cprintf(cb, "\\\\");
+	    cbuf_append_str(cb, "\\\\");
+	    s++;
 	    break;
 	case '<':
-	    if (!esc &&
-		strncmp(&str[i], "<![CDATA[", strlen("<![CDATA[")) == 0){
-		esc=1;
-		i += strlen("<![CDATA[")-1;
+	    if (strncmp(s, "<![CDATA[", strlen("<![CDATA[")) == 0){
+		esc = 1;
+		s += strlen("<![CDATA[");
 	    }
 	    else
-		cprintf(cb, "%c", str[i]);
+		cbuf_append(cb, *s++);
 	    break;
 	case ']':
-	    if (esc &&
-		strncmp(&str[i], "]]>", strlen("]]>")) == 0){
-		esc=0;
-		i += strlen("]]>")-1;
+	    if (strncmp(s, "]]>", strlen("]]>")) == 0){
+		esc = 0;
+		s += strlen("]]>");
 	    }
 	    else
-		cprintf(cb, "%c", str[i]);
+		cbuf_append(cb, *s++);
 	    break;
-	default: /* fall thru */
-	    cprintf(cb, "%c", str[i]);
+	default: /* '\0' */
 	    break;
 	}
+    }
     retval = 0;
-    // done:
+ done:
     return retval;
 }
 
@@ -514,6 +525,7 @@ xml2json_encode_identityref(cxobj     *xb,
 }
 
 /*! Encode leaf/leaf_list types from XML to JSON
+ * The value is written directly to cb0, only identityrefs need a temporary buffer.
  * @param[in]     x   XML body
  * @param[in]     ys  Yang spec of parent
  * @param[out]    cb0  Encoded string
@@ -532,15 +544,12 @@ xml2json_encode_leafs(cxobj     *xb,
     char         *body;
     enum cv_type  cvtype;
     int           quote = 1; /* Quote value w string: "val" */
-    cbuf         *cb = NULL; /* the variable itself */
+    char         *str = NULL; /* the variable itself */
+    cbuf         *cb = NULL; /* identityref encoding */
 
-    if ((cb = cbuf_new()) ==NULL){
-	clicon_err(OE_XML, errno, "cbuf_new");
-	goto done;
-    }
     body = xb?xml_value(xb):NULL;
     if (yp == NULL){
-	cprintf(cb, "%s", body?body:"null"); 
+	str = body?body:"null";
 	goto ok; /* unknown */
     }
     keyword = yang_keyword_get(yp);
@@ -556,16 +565,17 @@ xml2json_encode_leafs(cxobj     *xb,
 	case CGV_REST:
 	    if (body==NULL)
 		; /* empty: "" */
-	    else if (ytype){
-		if (strcmp(restype, "identityref")==0){
-		    if (xml2json_encode_identityref(xb, body, yp, cb) < 0)
-			goto done;
+	    else if (ytype && strcmp(restype, "identityref")==0){
+		if ((cb = cbuf_new()) == NULL){
+		    clicon_err(OE_XML, errno, "cbuf_new");
+		    goto done;
 		}
-		else
-		    cprintf(cb, "%s", body);
+		if (xml2json_encode_identityref(xb, body, yp, cb) < 0)
+		    goto done;
+		str = cbuf_get(cb);
 	    }
 	    else
-		cprintf(cb, "%s", body);
+		str = body;
 	    break;
 	case CGV_INT8:
 	case CGV_INT16:
@@ -577,25 +587,25 @@ xml2json_encode_leafs(cxobj     *xb,
 	case CGV_UINT64:
 	case CGV_DEC64:
 	case CGV_BOOL:
-	    cprintf(cb, "%s", body);
+	    str = body;
 	    quote = 0;
 	    break;
 	case CGV_VOID:
 	    /* special case YANG empty type */
 	    if (body == NULL && strcmp(restype, "empty")==0){
 		quote = 0;
-		cprintf(cb, "[null]");
+		str = "[null]";
 	    }
 	    break;
 	default:
 	    if (body)
-		cprintf(cb, "%s", body);
+		str = body;
 	    else
-		cprintf(cb, "{}"); /* dont know */
+		str = "{}"; /* dont know */
 	}
 	break;
     default:
-	cprintf(cb, "%s", body);
+	str = body;
 	break;
     }
  ok:
@@ -603,13 +613,13 @@ xml2json_encode_leafs(cxobj     *xb,
      * includign quoting and encoding 
      */
     if (quote){
-	cprintf(cb0, "\"");
-	json_str_escape_cdata(cb0, cbuf_get(cb));
+	cbuf_append(cb0, '"');
+	if (str && json_str_escape_cdata(cb0, str) < 0)
+	    goto done;
+	cbuf_append(cb0, '"');
     }
-    else
-	cprintf(cb0, "%s", cbuf_get(cb));
-    if (quote)
-	cprintf(cb0, "\"");
+    else if (str)
+	cbuf_append_str(cb0, str);
     retval = 0;
  done:
     if (cb)
@@ -662,6 +672,53 @@ nullchild(cbuf      *cb,
     return retval;
 }
 
+/*! Append an indented JSON object name: "module:name":
+ * @param[in]  cb       Cligen buffer
+ * @param[in]  name     Object name
+ * @param[in]  modname  Module name or NULL
+ * @param[in]  level    Indentation level
+ * @param[in]  pretty   Pretty-print output
+ */
+static int
+json_name_cbuf(cbuf *cb,
+	       char *name,
+	       char *modname,
+	       int   level,
+	       int   pretty)
+{
+    if (pretty && clixon_cbuf_indent(cb, level*JSON_INDENT) < 0)
+	return -1;
+    cbuf_append(cb, '"');
+    if (modname){
+	cbuf_append_str(cb, modname);
+	cbuf_append(cb, ':');
+    }
+    cbuf_append_str(cb, name);
+    cbuf_append_str(cb, pretty?"\": ":"\":");
+    return 0;
+}
+
+/*! Append a closing bracket on a new indented line if pretty-printed
+ * @param[in]  cb       Cligen buffer
+ * @param[in]  c        Closing bracket
+ * @param[in]  level    Indentation level
+ * @param[in]  pretty   Pretty-print output
+ */
+static int
+json_close_cbuf(cbuf *cb,
+		int   c,
+		int   level,
+		int   pretty)
+{
+    if (pretty){
+	cbuf_append(cb, '\n');
+	if (clixon_cbuf_indent(cb, level*JSON_INDENT) < 0)
+	    return -1;
+    }
+    cbuf_append(cb, c);
+    return 0;
+}
+
 /*! Do the actual work of translating XML to JSON 
  * @param[out]   cb        Cligen text buffer containing json on exit
  * @param[in]    x         XML tree structure containing XML to translate
@@ -742,10 +799,8 @@ xml2json1_cbuf(cbuf                   *cb,
 	break;
     case NO_ARRAY:
 	if (!flat){
-	    cprintf(cb, "%*s\"", pretty?(level*JSON_INDENT):0, "");
-	    if (modname) 
-		cprintf(cb, "%s:", modname);
-	    cprintf(cb, "%s\":%s", xml_name(x), pretty?" ":"");
+	    if (json_name_cbuf(cb, xml_name(x), modname, level, pretty) < 0)
+		goto done;
 	}
 	switch (childt){
 	case NULL_CHILD:
@@ -755,7 +810,7 @@ xml2json1_cbuf(cbuf                   *cb,
 	case BODY_CHILD:
 	    break;
 	case ANY_CHILD:
-	    cprintf(cb, "{%s", pretty?"\n":"");
+	    cbuf_append_str(cb, pretty?"{\n":"{");
 	    break;
 	default:
 	    break;
@@ -763,14 +818,12 @@ xml2json1_cbuf(cbuf                   *cb,
 	break;
     case FIRST_ARRAY:
     case SINGLE_ARRAY:
-	cprintf(cb, "%*s\"", pretty?(level*JSON_INDENT):0, "");
-	if (modname)
-	    cprintf(cb, "%s:", modname);
-	cprintf(cb, "%s\":%s", xml_name(x), pretty?" ":"");
+	if (json_name_cbuf(cb, xml_name(x), modname, level, pretty) < 0)
+	    goto done;
 	level++;
-	cprintf(cb, "[%s%*s", 
-		pretty?"\n":"",
-		pretty?(level*JSON_INDENT):0, "");
+	cbuf_append_str(cb, pretty?"[\n":"[");
+	if (pretty && clixon_cbuf_indent(cb, level*JSON_INDENT) < 0)
+	    goto done;
 	switch (childt){
 	case NULL_CHILD:
 	    if (nullchild(cb, x, ys) < 0)
@@ -779,7 +832,7 @@ xml2json1_cbuf(cbuf                   *cb,
 	case BODY_CHILD:
 	    break;
 	case ANY_CHILD:
-	    cprintf(cb, "{%s", pretty?"\n":"");
+	    cbuf_append_str(cb, pretty?"{\n":"{");
 	    break;
 	default:
 	    break;
@@ -788,8 +841,8 @@ xml2json1_cbuf(cbuf                   *cb,
     case MIDDLE_ARRAY:
     case LAST_ARRAY:
 	level++;
-	cprintf(cb, "%*s", 
-		pretty?(level*JSON_INDENT):0, "");
+	if (pretty && clixon_cbuf_indent(cb, level*JSON_INDENT) < 0)
+	    goto done;
 	switch (childt){
 	case NULL_CHILD:
 	    if (nullchild(cb, x, ys) < 0)
@@ -798,7 +851,7 @@ xml2json1_cbuf(cbuf                   *cb,
 	case BODY_CHILD:
 	    break;
 	case ANY_CHILD:
-	    cprintf(cb, "{%s", pretty?"\n":"");
+	    cbuf_append_str(cb, pretty?"{\n":"{");
 	    break;
 	default:
 	    break;
@@ -826,7 +879,7 @@ xml2json1_cbuf(cbuf                   *cb,
 			   level+1, pretty, 0, modname0) < 0)
 	    goto done;
 	if (commas > 0) {
-	    cprintf(cb, ",%s", pretty?"\n":"");
+	    cbuf_append_str(cb, pretty?",\n":",");
 	    --commas;
 	}
     }
@@ -839,9 +892,8 @@ xml2json1_cbuf(cbuf                   *cb,
 	case BODY_CHILD:
 	    break;
 	case ANY_CHILD:
-	    cprintf(cb, "%s%*s}", 
-		    pretty?"\n":"",
-		    pretty?(level*JSON_INDENT):0, "");
+	    if (json_close_cbuf(cb, '}', level, pretty) < 0)
+		goto done;
 	    break;
 	default:
 	    break;
@@ -855,9 +907,8 @@ xml2json1_cbuf(cbuf                   *cb,
 	case BODY_CHILD:
 	    break;
 	case ANY_CHILD:
-	    cprintf(cb, "%s%*s}", 
-		    pretty?"\n":"",
-		    pretty?(level*JSON_INDENT):0, "");
+	    if (json_close_cbuf(cb, '}', level, pretty) < 0)
+		goto done;
 	    level--;
 	    break;
 	default:
@@ -869,20 +920,22 @@ xml2json1_cbuf(cbuf                   *cb,
 	switch (childt){
 	case NULL_CHILD:
 	case BODY_CHILD:
-	    cprintf(cb, "%s",pretty?"\n":"");
+	    if (pretty)
+		cbuf_append_str(cb, "\n");
 	    break;
 	case ANY_CHILD:
-	    cprintf(cb, "%s%*s}", 
-		    pretty?"\n":"",
-		    pretty?(level*JSON_INDENT):0, "");
-	    cprintf(cb, "%s",pretty?"\n":"");
+	    if (json_close_cbuf(cb, '}', level, pretty) < 0)
+		goto done;
+	    if (pretty)
+		cbuf_append_str(cb, "\n");
 	    level--;
 	    break;
 	default:
 	    break;
 	}
-	cprintf(cb, "%*s]",
-		pretty?(level*JSON_INDENT):0,"");
+	if (pretty && clixon_cbuf_indent(cb, level*JSON_INDENT) < 0)
+	    goto done;
+	cbuf_append(cb, ']');
 	break;
     default:
 	break;
@@ -0,0 +1,202 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+
+ * Memory accounting per subsystem
+ *
+ * Each long-lived allocation is tagged with an accounting class, and the class
+ * counters are updated incrementally when objects are created, resized and freed,
+ * so statistics never require walking the trees.
+ * XML objects take the class that is current when they are created (see
+ * clixon_mem_acct_set), and keep it when moved between trees. Datastore code sets
+ * the class of the datastore around reading and modifying its cache.
+ * Byte counts are estimates of the structures and strings owned by the objects,
+ * not including allocator overhead. Counters are process-global.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_string.h"
+#include "clixon_log.h"
+#include "clixon_memory.h"
+
+/* Accounting class names, used in stats
+ * @see clixon_mem_acct2str
+ */
+static const map_str2int mem_acct_map[] = {
+    {"other",     CLIXON_MEM_OTHER},
+    {"yang",      CLIXON_MEM_YANG},
+    {"running",   CLIXON_MEM_RUNNING},
+    {"candidate", CLIXON_MEM_CANDIDATE},
+    {"startup",   CLIXON_MEM_STARTUP},
+    {"datastore", CLIXON_MEM_DATASTORE},
+    {"nacm",      CLIXON_MEM_NACM},
+    {"stream",    CLIXON_MEM_STREAM},
+    {"client",    CLIXON_MEM_CLIENT},
+    {NULL,        -1}
+};
+
+/* Counters of each accounting class */
+static struct clixon_mem_stat _MEM_STATS[CLIXON_MEM_NR] = {{0,},};
+
+/* Current accounting class of new XML objects */
+static enum clixon_mem_acct _MEM_ACCT = CLIXON_MEM_OTHER;
+
+/*! Add (or subtract) bytes and objects to an accounting class
+ *
+ * High-water marks are updated. Subtracting more than was added is an accounting
+ * error: it is logged on debug and the counter is clamped at zero.
+ * @param[in]  acct   Accounting class
+ * @param[in]  bytes  Bytes to add, negative to subtract
+ * @param[in]  objs   Objects to add, negative to subtract
+ * @retval     0      OK
+ * @retval    -1      Invalid accounting class, ignored
+ */
+int
+clixon_mem_add(enum clixon_mem_acct acct,
+	       int64_t              bytes,
+	       int64_t              objs)
+{
+    struct clixon_mem_stat *ms;
+
+    if (acct >= CLIXON_MEM_NR)
+	return -1;
+    ms = &_MEM_STATS[acct];
+    if (bytes < 0 && (uint64_t)-bytes > ms->ms_bytes){
+	clicon_debug(1, "%s %s: bytes underflow %" PRIu64 " - %" PRId64, __FUNCTION__,
+		     clixon_mem_acct2str(acct), ms->ms_bytes, -bytes);
+	ms->ms_bytes = 0;
+    }
+    else
+	ms->ms_bytes += bytes;
+    if (objs < 0 && (uint64_t)-objs > ms->ms_objs){
+	clicon_debug(1, "%s %s: objects underflow %" PRIu64 " - %" PRId64, __FUNCTION__,
+		     clixon_mem_acct2str(acct), ms->ms_objs, -objs);
+	ms->ms_objs = 0;
+    }
+    else
+	ms->ms_objs += objs;
+    if (ms->ms_bytes > ms->ms_peak_bytes)
+	ms->ms_peak_bytes = ms->ms_bytes;
+    if (ms->ms_objs > ms->ms_peak_objs)
+	ms->ms_peak_objs = ms->ms_objs;
+    return 0;
+}
+
+/*! Get memory statistics of an accounting class
+ *
+ * @param[in]  acct   Accounting class
+ * @param[out] ms     Statistics (copy)
+ * @retval     0      OK
+ * @retval    -1      Invalid accounting class
+ */
+int
+clixon_mem_get(enum clixon_mem_acct    acct,
+	       struct clixon_mem_stat *ms)
+{
+    if (acct >= CLIXON_MEM_NR)
+	return -1;
+    *ms = _MEM_STATS[acct];
+    return 0;
+}
+
+/*! Set accounting class of XML objects created from now on
+ *
+ * @param[in]  acct   Accounting class
+ * @retval     acct0  Previous accounting class, to be restored by the caller
+ * @code
+ *    acct0 = clixon_mem_acct_set(CLIXON_MEM_NACM);
+ *    ... create xml tree ...
+ *    clixon_mem_acct_set(acct0);
+ * @endcode
+ */
+enum clixon_mem_acct
+clixon_mem_acct_set(enum clixon_mem_acct acct)
+{
+    enum clixon_mem_acct acct0 = _MEM_ACCT;
+
+    if (acct < CLIXON_MEM_NR)
+	_MEM_ACCT = acct;
+    return acct0;
+}
+
+/*! Get current accounting class of new XML objects
+ */
+enum clixon_mem_acct
+clixon_mem_acct_get(void)
+{
+    return _MEM_ACCT;
+}
+
+/*! Get accounting class of a datastore cache
+ *
+ * @param[in]  db     Name of datastore, eg "running"
+ * @retval     acct   Accounting class
+ */
+enum clixon_mem_acct
+clixon_mem_acct_db(const char *db)
+{
+    if (db == NULL)
+	return CLIXON_MEM_DATASTORE;
+    if (strcmp(db, "running") == 0)
+	return CLIXON_MEM_RUNNING;
+    if (strcmp(db, "candidate") == 0)
+	return CLIXON_MEM_CANDIDATE;
+    if (strcmp(db, "startup") == 0)
+	return CLIXON_MEM_STARTUP;
+    return CLIXON_MEM_DATASTORE;
+}
+
+/*! Get name of accounting class
+ *
+ * @param[in]  acct   Accounting class
+ * @retval     name   Name, eg "running", or NULL if invalid class
+ */
+const char *
+clixon_mem_acct2str(enum clixon_mem_acct acct)
+{
+    return clicon_int2str(mem_acct_map, acct);
+}
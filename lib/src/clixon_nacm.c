@@ -60,6 +60,7 @@
 #include "clixon_string.h"
 #include "clixon_handle.h"
 #include "clixon_yang.h"
+#include "clixon_memory.h"
 #include "clixon_xml.h"
 #include "clixon_options.h"
 #include "clixon_data.h"
@@ -77,43 +78,515 @@
 /* NACM namespace for use with xml namespace contexts and xpath */
 #define NACM_NS "urn:ietf:params:xml:ns:yang:ietf-netconf-acm"
 
-/*! Match nacm access operations according to RFC8341 3.4.4.  
- * Incoming RPC Message Validation Step 7 (c)
- *  The rule's "access-operations" leaf has the "exec" bit set or
- *  has the special value "*".
- * @param[in] mode  Primary mode, eg read, create, update, delete, exec
- * @param[in] mode2 Secondary mode, eg "write"
- * @retval 0  No match
- * @retval 1  Match
- * @note access_operations is bit-fields
+/* Access operation bit of a compiled NACM rule, see enum nacm_access */
+#define NACM_ACCESS_BIT(a) (1 << (a))
+
+/* All access operations, ie "*" */
+#define NACM_ACCESS_ALL (NACM_ACCESS_BIT(NACM_CREATE) | NACM_ACCESS_BIT(NACM_READ) | \
+			 NACM_ACCESS_BIT(NACM_UPDATE) | NACM_ACCESS_BIT(NACM_DELETE) | \
+			 NACM_ACCESS_BIT(NACM_EXEC))
+
+/* Compiled NACM rule. Strings point into the NACM XML tree, except the path */
+struct nacm_rule{
+    char  *nr_module;      /* module-name, or NULL */
+    char  *nr_rpc;         /* rpc-name, or NULL */
+    char  *nr_notif;       /* notification-name, or NULL */
+    char  *nr_path;        /* path trimmed from whitespace (malloced), or NULL */
+    char  *nr_action;      /* action: permit or deny, or NULL */
+    int    nr_access;      /* Bitmask of access-operations, see NACM_ACCESS_BIT */
+};
+typedef struct nacm_rule nacm_rule;
+
+/* Compiled NACM rule-list: a range of rules in nacm_policy np_rules */
+struct nacm_rlist{
+    cxobj *nl_xrlist;      /* Rule-list in NACM XML tree */
+    int    nl_start;       /* Index of first rule in np_rules */
+    int    nl_len;         /* Number of rules */
+};
+
+/* Compiled per-user NACM rules: rules of all rule-lists matching the user's groups */
+struct nacm_user{
+    int         nu_ngroups; /* Number of groups user is member of */
+    nacm_rule **nu_rules;   /* Rules in rule-list order */
+    int         nu_len;     /* Length of nu_rules */
+};
+typedef struct nacm_user nacm_user;
+
+/* Compiled NACM policy, cached in the handle and reused for all messages until the
+ * NACM configuration changes. In internal mode it is keyed on the generation of the
+ * running datastore, in external mode on the external NACM tree.
+ */
+struct nacm_policy{
+    cxobj             *np_xtop;       /* Top of NACM XML tree owned by policy, or NULL */
+    cxobj             *np_xnacm;      /* NACM XML tree ("nacm" node), NULL if none */
+    cxobj             *np_xext;       /* External NACM tree (external mode only) */
+    uint64_t           np_generation; /* Running datastore generation (internal mode) */
+    char              *np_read_default;
+    char              *np_write_default;
+    char              *np_exec_default;
+    nacm_rule         *np_rules;      /* All rules, in order */
+    int                np_len;        /* Length of np_rules */
+    struct nacm_rlist *np_rlists;     /* All rule-lists, in order */
+    int                np_rlen;       /* Length of np_rlists */
+    clicon_hash_t     *np_users;      /* Compiled per-user rules, built on demand */
+    size_t             np_msize;      /* Accounted memory of policy, see nacm_policy_mem */
+};
+typedef struct nacm_policy nacm_policy;
+
+/*! Account memory allocated by a compiled NACM policy
+ * The NACM XML tree itself is accounted as XML objects
+ * @param[in]  np  Compiled NACM policy
+ * @param[in]  sz  Bytes allocated
+ */
+static void
+nacm_policy_mem(nacm_policy *np,
+		size_t       sz)
+{
+    np->np_msize += sz;
+    clixon_mem_add(CLIXON_MEM_NACM, sz, 0);
+}
+
+/*! Translate nacm access-operations to a bitmask
+ * @param[in] access_operations  Value of access-operations leaf, eg "read create" or "*"
+ * @retval    bits               Bitmask of NACM_ACCESS_BIT, 0 if none
+ * @note access_operations is bit-fields, where "write" is short-hand for
+ *       create+update+delete
  */
 static int
-match_access(char *access_operations,
-	     char *mode,
-	     char *mode2)
+nacm_access_bits(char *access_operations)
 {
-    if (access_operations==NULL)
+    int bits = 0;
+
+    if (access_operations == NULL)
 	return 0;
-    if (strcmp(access_operations,"*")==0)
-	return 1;
-    if (strstr(access_operations, mode)!=NULL)
-	return 1;
-    if (mode2 && strstr(access_operations, mode2)!=NULL)
-	return 1;
+    if (strcmp(access_operations, "*") == 0)
+	return NACM_ACCESS_ALL;
+    if (strstr(access_operations, "create") != NULL)
+	bits |= NACM_ACCESS_BIT(NACM_CREATE);
+    if (strstr(access_operations, "read") != NULL)
+	bits |= NACM_ACCESS_BIT(NACM_READ);
+    if (strstr(access_operations, "update") != NULL)
+	bits |= NACM_ACCESS_BIT(NACM_UPDATE);
+    if (strstr(access_operations, "delete") != NULL)
+	bits |= NACM_ACCESS_BIT(NACM_DELETE);
+    if (strstr(access_operations, "exec") != NULL)
+	bits |= NACM_ACCESS_BIT(NACM_EXEC);
+    if (strstr(access_operations, "write") != NULL)
+	bits |= NACM_ACCESS_BIT(NACM_CREATE) | NACM_ACCESS_BIT(NACM_UPDATE) |
+	    NACM_ACCESS_BIT(NACM_DELETE);
+    return bits;
+}
+
+/*! Free compiled NACM policy including the NACM tree if owned by the policy
+ * @param[in]  np  Compiled NACM policy
+ */
+static int
+nacm_policy_free(nacm_policy *np)
+{
+    char      **keys = NULL;
+    size_t      klen = 0;
+    size_t      k;
+    nacm_user **nup;
+    int         i;
+
+    if (np->np_users){
+	if (clicon_hash_keys(np->np_users, &keys, &klen) == 0)
+	    for (k=0; k<klen; k++){
+		if ((nup = clicon_hash_value(np->np_users, keys[k], NULL)) == NULL)
+		    continue;
+		if ((*nup)->nu_rules)
+		    free((*nup)->nu_rules);
+		free(*nup);
+	    }
+	if (keys)
+	    free(keys);
+	clicon_hash_free(np->np_users);
+    }
+    for (i=0; i<np->np_len; i++)
+	if (np->np_rules[i].nr_path)
+	    free(np->np_rules[i].nr_path);
+    if (np->np_rules)
+	free(np->np_rules);
+    if (np->np_rlists)
+	free(np->np_rlists);
+    if (np->np_xtop)
+	xml_free(np->np_xtop);
+    clixon_mem_add(CLIXON_MEM_NACM, -(int64_t)np->np_msize, -1);
+    free(np);
+    return 0;
+}
+
+/*! Compile a NACM XML tree into a NACM policy
+ * Resolves rule-lists and rules once, so that per-message processing does not need
+ * to evaluate xpaths on the NACM tree. Users are compiled on demand.
+ * @param[in]  xnacm  NACM XML tree ("nacm" node), or NULL if no NACM config
+ * @retval     np     Compiled NACM policy, free with nacm_policy_free
+ * @retval     NULL   Error
+ * @note np refers to strings in xnacm, which must remain as long as np
+ */
+static nacm_policy *
+nacm_policy_compile(cxobj *xnacm)
+{
+    nacm_policy       *np = NULL;
+    cxobj             *xrlist;
+    cxobj             *xrule;
+    cxobj             *xpath;
+    nacm_rule         *nr;
+    struct nacm_rlist *nl;
+    char              *path;
+    int                nrules = 0;
+    int                nrlists = 0;
+
+    if ((np = malloc(sizeof(*np))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto err;
+    }
+    memset(np, 0, sizeof(*np));
+    clixon_mem_add(CLIXON_MEM_NACM, 0, 1);
+    nacm_policy_mem(np, sizeof(*np));
+    if ((np->np_users = clicon_hash_init()) == NULL)
+	goto err;
+    if ((np->np_xnacm = xnacm) == NULL)
+	return np;
+    np->np_read_default = xml_find_body(xnacm, "read-default");
+    np->np_write_default = xml_find_body(xnacm, "write-default");
+    np->np_exec_default = xml_find_body(xnacm, "exec-default");
+    /* Count rule-lists and rules to allocate vectors once */
+    xrlist = NULL;
+    while ((xrlist = xml_child_each(xnacm, xrlist, CX_ELMNT)) != NULL) {
+	if (strcmp(xml_name(xrlist), "rule-list") != 0)
+	    continue;
+	nrlists++;
+	xrule = NULL;
+	while ((xrule = xml_child_each(xrlist, xrule, CX_ELMNT)) != NULL)
+	    if (strcmp(xml_name(xrule), "rule") == 0)
+		nrules++;
+    }
+    if (nrlists &&
+	(np->np_rlists = calloc(nrlists, sizeof(*np->np_rlists))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto err;
+    }
+    if (nrules &&
+	(np->np_rules = calloc(nrules, sizeof(*np->np_rules))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto err;
+    }
+    nacm_policy_mem(np, nrlists*sizeof(*np->np_rlists) + nrules*sizeof(*np->np_rules));
+    xrlist = NULL;
+    while ((xrlist = xml_child_each(xnacm, xrlist, CX_ELMNT)) != NULL) {
+	if (strcmp(xml_name(xrlist), "rule-list") != 0)
+	    continue;
+	nl = &np->np_rlists[np->np_rlen++];
+	nl->nl_xrlist = xrlist;
+	nl->nl_start = np->np_len;
+	xrule = NULL;
+	while ((xrule = xml_child_each(xrlist, xrule, CX_ELMNT)) != NULL) {
+	    if (strcmp(xml_name(xrule), "rule") != 0)
+		continue;
+	    nr = &np->np_rules[np->np_len++];
+	    nl->nl_len++;
+	    nr->nr_module = xml_find_body(xrule, "module-name");
+	    nr->nr_rpc = xml_find_body(xrule, "rpc-name");
+	    nr->nr_notif = xml_find_body(xrule, "notification-name");
+	    nr->nr_action = xml_find_body(xrule, "action");
+	    nr->nr_access = nacm_access_bits(xml_find_body(xrule, "access-operations"));
+	    if ((xpath = xml_find_type(xrule, NULL, "path", CX_ELMNT)) != NULL){
+		if ((path = xml_body(xpath)) == NULL)
+		    path = "";
+		/* Trim a copy, the NACM tree is compared with later versions */
+		if ((nr->nr_path = strdup(path)) == NULL){
+		    clicon_err(OE_UNIX, errno, "strdup");
+		    goto err;
+		}
+		nacm_policy_mem(np, strlen(nr->nr_path)+1);
+		path = clixon_trim2(nr->nr_path, " \t\n");
+		memmove(nr->nr_path, path, strlen(path)+1);
+	    }
+	}
+    }
+    return np;
+ err:
+    if (np)
+	nacm_policy_free(np);
+    return NULL;
+}
+
+/*! Get compiled rules of a user, compile and cache them if not already done
+ * RFC8341 3.4.4 and 3.4.5: Check all the "group" entries to see if any of them
+ * contain a "user-name" entry that equals the username for the session making the
+ * request. Then collect all rule-list entries, in order, whose "group" leaf-list
+ * matches any of the user's groups.
+ * @param[in]  np        Compiled NACM policy
+ * @param[in]  username  User name of requestor
+ * @retval     nu        Compiled user rules
+ * @retval     NULL      Error
+ */
+static nacm_user *
+nacm_policy_user(nacm_policy *np,
+		 char        *username)
+{
+    nacm_user        **nup;
+    nacm_user         *nu = NULL;
+    cxobj             *xgroups;
+    cxobj             *xg;
+    cxobj             *x;
+    cvec              *groups = NULL; /* Names of user's groups */
+    struct nacm_rlist *nl;
+    char              *b;
+    int                i;
+    int                j;
+
+    if ((nup = clicon_hash_value(np->np_users, username, NULL)) != NULL)
+	return *nup;
+    if ((nu = malloc(sizeof(*nu))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto err;
+    }
+    memset(nu, 0, sizeof(*nu));
+    if ((groups = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto err;
+    }
+    /* User's groups */
+    if (np->np_xnacm &&
+	(xgroups = xml_find_type(np->np_xnacm, NULL, "groups", CX_ELMNT)) != NULL){
+	xg = NULL;
+	while ((xg = xml_child_each(xgroups, xg, CX_ELMNT)) != NULL) {
+	    if (strcmp(xml_name(xg), "group") != 0)
+		continue;
+	    x = NULL;
+	    while ((x = xml_child_each(xg, x, CX_ELMNT)) != NULL)
+		if (strcmp(xml_name(x), "user-name") == 0 &&
+		    (b = xml_body(x)) != NULL && strcmp(b, username) == 0)
+		    break;
+	    if (x == NULL)
+		continue;
+	    if ((b = xml_find_body(xg, "name")) == NULL)
+		continue;
+	    if (cvec_add_string(groups, b, b) == NULL){
+		clicon_err(OE_UNIX, errno, "cvec_add_string");
+		goto err;
+	    }
+	}
+    }
+    nu->nu_ngroups = cvec_len(groups);
+    /* Rules of rule-lists whose group matches any of the user's groups */
+    if (nu->nu_ngroups && np->np_len &&
+	(nu->nu_rules = calloc(np->np_len, sizeof(*nu->nu_rules))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto err;
+    }
+    for (i=0; i<np->np_rlen && nu->nu_ngroups; i++){
+	nl = &np->np_rlists[i];
+	x = NULL;
+	while ((x = xml_child_each(nl->nl_xrlist, x, CX_ELMNT)) != NULL) {
+	    if (strcmp(xml_name(x), "group") != 0 || (b = xml_body(x)) == NULL)
+		continue;
+	    if (cvec_find(groups, b) != NULL)
+		break;
+	}
+	if (x == NULL) /* not found */
+	    continue;
+	for (j=0; j<nl->nl_len; j++)
+	    nu->nu_rules[nu->nu_len++] = &np->np_rules[nl->nl_start+j];
+    }
+    /* It is the pointer to nu that should be copied by hash */
+    if (clicon_hash_add(np->np_users, username, &nu, sizeof(nu)) == NULL)
+	goto err;
+    nacm_policy_mem(np, sizeof(*nu) + (nu->nu_rules?np->np_len*sizeof(*nu->nu_rules):0));
+    cvec_free(groups);
+    return nu;
+ err:
+    if (groups)
+	cvec_free(groups);
+    if (nu){
+	if (nu->nu_rules)
+	    free(nu->nu_rules);
+	free(nu);
+    }
+    return NULL;
+}
+
+/*! Get cached compiled NACM policy from handle
+ * @param[in]  h   Clicon handle
+ * @retval     np  Compiled NACM policy, or NULL
+ */
+static nacm_policy *
+nacm_policy_cache(clicon_handle h)
+{
+    clicon_hash_t *cdat = clicon_data(h);
+    void          *p;
+
+    if ((p = clicon_hash_value(cdat, "nacm_policy", NULL)) != NULL)
+	return *(nacm_policy **)p;
+    return NULL;
+}
+
+/*! Set cached compiled NACM policy in handle, free existing policy
+ * @param[in]  h   Clicon handle
+ * @param[in]  np  Compiled NACM policy, or NULL
+ */
+static int
+nacm_policy_cache_set(clicon_handle h,
+		      nacm_policy  *np)
+{
+    clicon_hash_t *cdat = clicon_data(h);
+    nacm_policy   *np0;
+
+    np0 = nacm_policy_cache(h);
+    /* It is the pointer to np that should be copied by hash */
+    if (clicon_hash_add(cdat, "nacm_policy", &np, sizeof(np)) == NULL)
+	return -1;
+    if (np0 && np0 != np)
+	nacm_policy_free(np0);
+    return 0;
+}
+
+/*! Get compiled NACM policy of a NACM XML tree
+ * Use the cached policy if xnacm is the tree it was compiled from, otherwise compile
+ * a temporary policy, eg if xnacm is not obtained by nacm_access_pre.
+ * @param[in]  h      Clicon handle
+ * @param[in]  xnacm  NACM XML tree, root should be "nacm"
+ * @param[out] npp    Compiled NACM policy
+ * @param[out] nptmp  Temporary policy, if set free with nacm_policy_free after use
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+nacm_policy_get(clicon_handle h,
+		cxobj        *xnacm,
+		nacm_policy **npp,
+		nacm_policy **nptmp)
+{
+    nacm_policy *np;
+
+    if ((np = nacm_policy_cache(h)) != NULL && np->np_xnacm == xnacm){
+	*npp = np;
+	return 0;
+    }
+    if ((np = nacm_policy_compile(xnacm)) == NULL)
+	return -1;
+    *npp = *nptmp = np;
     return 0;
 }
 
+/*! Check if two NACM XML trees are equal, including order
+ * @param[in]  x1  XML tree or NULL
+ * @param[in]  x2  XML tree or NULL
+ * @retval     1   Equal
+ * @retval     0   Not equal
+ */
+static int
+nacm_tree_equal(cxobj *x1,
+		cxobj *x2)
+{
+    cxobj *y1 = NULL;
+    cxobj *y2 = NULL;
+
+    if (x1 == NULL || x2 == NULL)
+	return x1 == x2;
+    if (xml_type(x1) != xml_type(x2) ||
+	xml_child_nr(x1) != xml_child_nr(x2) ||
+	clicon_strcmp(xml_name(x1), xml_name(x2)) != 0 ||
+	clicon_strcmp(xml_value(x1), xml_value(x2)) != 0)
+	return 0;
+    while ((y1 = xml_child_each(x1, y1, -1)) != NULL){
+	y2 = xml_child_each(x2, y2, -1);
+	if (!nacm_tree_equal(y1, y2))
+	    return 0;
+    }
+    return 1;
+}
+
+/*! Get compiled NACM policy of internal NACM config in running datastore
+ * The NACM tree is only read from the running datastore if running has changed
+ * since the policy was compiled, and the policy is only recompiled if the NACM
+ * tree has changed.
+ * @param[in]  h    Clicon handle
+ * @param[out] npp  Compiled NACM policy, cached in handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+nacm_policy_internal(clicon_handle h,
+		     nacm_policy **npp)
+{
+    int          retval = -1;
+    nacm_policy *np0;
+    nacm_policy *np = NULL;
+    uint64_t     gen;
+    cxobj       *xt = NULL;
+    cxobj       *xnacm = NULL;
+    cvec        *nsc = NULL;
+    int          ret;
+    enum clixon_mem_acct acct0;
+
+    gen = xmldb_generation_get(h, "running");
+    np0 = nacm_policy_cache(h);
+    if (np0 && np0->np_xext == NULL && np0->np_generation == gen){
+	*npp = np0;
+	goto ok;
+    }
+    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
+	goto done;
+    /* The copy of the NACM tree is owned by the policy */
+    acct0 = clixon_mem_acct_set(CLIXON_MEM_NACM);
+    ret = xmldb_get0(h, "running", YB_MODULE, NULL, "nacm", 1, &xt, NULL);
+    clixon_mem_acct_set(acct0);
+    if (ret < 0)
+	goto done;
+    if (xt)
+	xnacm = xpath_first(xt, nsc, "nacm");
+    /* Running has changed but not NACM config */
+    if (np0 && np0->np_xext == NULL && nacm_tree_equal(np0->np_xnacm, xnacm)){
+	clicon_debug(1, "%s nacm unchanged", __FUNCTION__);
+	np0->np_generation = gen;
+	*npp = np0;
+	goto ok;
+    }
+    clicon_debug(1, "%s compile nacm", __FUNCTION__);
+    if ((np = nacm_policy_compile(xnacm)) == NULL)
+	goto done;
+    np->np_xtop = xt;
+    xt = NULL;
+    np->np_generation = gen;
+    if (nacm_policy_cache_set(h, np) < 0)
+	goto done;
+    *npp = np;
+    np = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (np)
+	nacm_policy_free(np);
+    if (nsc)
+	xml_nsctx_free(nsc);
+    if (xt)
+	xml_free(xt);
+    return retval;
+}
+
+/*! Free compiled NACM policy cached in handle
+ * @param[in]  h   Clicon handle
+ * @see nacm_access_pre  where the policy is created
+ */
+int
+nacm_policy_exit(clicon_handle h)
+{
+    if (nacm_policy_cache(h) == NULL)
+	return 0;
+    return nacm_policy_cache_set(h, NULL);
+}
+
 /*! Match nacm single rule. Either match with access or deny. Or not match.
  * @param[in]  rpc    rpc name
  * @param[in]  module Yang module name
- * @param[in]  xrule  NACM rule XML tree
- * @param[out] cbret  Cligen buffer result. Set to an error msg if retval=0.
- * @retval -1  Error
- * @retval  0  Matching rule AND Not access and cbret set
- * @retval  1  Matching rule AND Access
- * @retval  2  No matching rule Goto step 10
+ * @param[in]  nr     Compiled NACM rule
+ * @retval  0  No matching rule
+ * @retval  1  Matching rule
  * @see RFC8341 3.4.4.  Incoming RPC Message Validation
- 7.(cont) A rule matches if all of the following criteria are met: 
+ 7.(cont) A rule matches if all of the following criteria are met:
         *  The rule's "module-name" leaf is "*" or equals the name of
            the YANG module where the protocol operation is defined.
 
@@ -126,45 +599,35 @@ match_access(char *access_operations,
            has the special value "*".
  */
 static int
-nacm_rule_rpc(char         *rpc,
-	      char         *module,
-	      cxobj        *xrule)
+nacm_rule_rpc(char      *rpc,
+	      char      *module,
+	      nacm_rule *nr)
 {
-    int    retval = -1;
-    char  *module_rule; /* rule module name */
-    char  *rpc_rule;
-    char  *access_operations;
-    
     /*  7a) The rule's "module-name" leaf is "*" or equals the name of
 	the YANG module where the protocol operation is defined. */
-    if ((module_rule = xml_find_body(xrule, "module-name")) == NULL)
-	goto nomatch;
-    if (strcmp(module_rule,"*") && strcmp(module_rule,module))
-	goto nomatch;
+    if (nr->nr_module == NULL)
+	return 0;
+    if (strcmp(nr->nr_module, "*") && strcmp(nr->nr_module, module))
+	return 0;
     /*  7b) Either (1) the rule does not have a "rule-type" defined or
 	(2) the "rule-type" is "protocol-operation" and the
 	"rpc-name" is "*" or equals the name of the requested
 	protocol operation. */
-    if ((rpc_rule = xml_find_body(xrule, "rpc-name")) == NULL){
-	if (xml_find_body(xrule, "path") || xml_find_body(xrule, "notification-name"))
-	    goto nomatch;
+    if (nr->nr_rpc == NULL){
+	if ((nr->nr_path && strlen(nr->nr_path)) || nr->nr_notif)
+	    return 0;
     }
-    if (rpc_rule && (strcmp(rpc_rule, "*") && strcmp(rpc_rule, rpc)))
-	goto nomatch;
+    else if (strcmp(nr->nr_rpc, "*") && strcmp(nr->nr_rpc, rpc))
+	return 0;
     /* 7c) The rule's "access-operations" leaf has the "exec" bit set or
 	has the special value "*". */
-    access_operations = xml_find_body(xrule, "access-operations");
-    if (!match_access(access_operations, "exec", NULL))
-	goto nomatch;
-    retval = 1;
- done:
-    return retval;
- nomatch:
-    retval = 0;
-    goto done;
+    if ((nr->nr_access & NACM_ACCESS_BIT(NACM_EXEC)) == 0)
+	return 0;
+    return 1;
 }
 
 /*! Process nacm incoming RPC message validation steps
+ * @param[in]  h        Clicon handle
  * @param[in]  module   Yang module name
  * @param[in]  rpc      rpc name
  * @param[in]  username User name of requestor
@@ -178,36 +641,27 @@ nacm_rule_rpc(char         *rpc,
  * @see nacm_datanode_read
  */
 int
-nacm_rpc(char         *rpc,
+nacm_rpc(clicon_handle h,
+	 char         *rpc,
 	 char         *module,
 	 char         *username,
 	 cxobj        *xnacm,
 	 cbuf         *cbret)
 {
-    int     retval = -1;
-    cxobj  *xrule;
-    cxobj **gvec = NULL; /* groups */
-    size_t  glen;
-    cxobj  *rlist;
-    cxobj **rlistvec = NULL; /* rule-list */
-    size_t  rlistlen;
-    cxobj **rvec = NULL; /* rules */
-    size_t  rlen;
-    int     i, j;
-    char   *exec_default = NULL;
-    char   *gname;
-    char   *action;
-    int     match= 0;
-    cvec   *nsc = NULL;
-    
-    /* Create namespace context for with nacm namespace as default */
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
-	goto done;
+    int          retval = -1;
+    nacm_policy *np = NULL;
+    nacm_policy *nptmp = NULL;
+    nacm_user   *nu;
+    nacm_rule   *nr = NULL;
+    int          i;
+
     /* 3.   If the requested operation is the NETCONF <close-session>
        protocol operation, then the protocol operation is permitted.
     */
     if (strcmp(rpc, "close-session") == 0)
 	goto permit;
+    if (nacm_policy_get(h, xnacm, &np, &nptmp) < 0)
+	goto done;
     /* 4.   Check all the "group" entries to see if any of them contain a
        "user-name" entry that equals the username for the session
        making the request.  (If the "enable-external-groups" leaf is
@@ -215,60 +669,35 @@ nacm_rpc(char         *rpc,
        transport layer.)	       */
     if (username == NULL)
 	goto step10;
-
-    /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
+    /* User's groups and rules, compiled */
+    if ((nu = nacm_policy_user(np, username)) == NULL)
 	goto done;
     /* 5. If no groups are found, continue with step 10. */
-    if (glen == 0)
+    if (nu->nu_ngroups == 0)
 	goto step10;
     /* 6. Process all rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
-        entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
-	goto done;
-    for (i=0; i<rlistlen; i++){
-	rlist = rlistvec[i];
-	/* Loop through user's group to find match in this rule-list */
-	for (j=0; j<glen; j++){
-	    gname = xml_find_body(gvec[j], "name");
-	    if (xpath_first(rlist, nsc, ".[group='%s']", gname)!=NULL)
-		break; /* found */
-	}
-	if (j==glen) /* not found */
-	    continue;
-	/* 7. For each rule-list entry found, process all rules, in order,
-	   until a rule that matches the requested access operation is
-	   found. 
-	*/
-	if (xpath_vec(rlist, nsc, "rule", &rvec, &rlen) < 0)
-	    goto done;
-	for (j=0; j<rlen; j++){
-	    xrule = rvec[j];
-	    if ((match = nacm_rule_rpc(rpc, module, xrule)) < 0)
-		goto done;
-	    if (match)
-		break;
-	}
-	if (match)
+        entry.
+       7. For each rule-list entry found, process all rules, in order,
+	until a rule that matches the requested access operation is
+	found.
+    */
+    for (i=0; i<nu->nu_len; i++){
+	nr = nu->nu_rules[i];
+	if (nacm_rule_rpc(rpc, module, nr))
 	    break;
-	if (rvec){
-	    free(rvec);
-	    rvec=NULL;
-	}
     }
-    if (match){
-	if ((action = xml_find_body(xrule, "action")) == NULL)
+    if (i < nu->nu_len){
+	if (nr->nr_action == NULL)
 	    goto step10;
-	if (strcmp(action, "deny")==0){
+	if (strcmp(nr->nr_action, "deny")==0){
 	    if (netconf_access_denied(cbret, "application", "access denied") < 0)
 		goto done;
 	    goto deny;
 	}
-	else if (strcmp(action, "permit")==0)
+	else if (strcmp(nr->nr_action, "permit")==0)
 	    goto permit;
-
     }
  step10:
     /*   10.  If the requested protocol operation is defined in a YANG module
@@ -285,8 +714,7 @@ nacm_rpc(char         *rpc,
     }
     /*   12.  If the "exec-default" leaf is set to "permit", then permit the
 	 protocol operation; otherwise, deny the request. */
-    exec_default = xml_find_body(xnacm, "exec-default");
-    if (exec_default ==NULL || strcmp(exec_default, "permit")==0)
+    if (np->np_exec_default == NULL || strcmp(np->np_exec_default, "permit")==0)
 	goto permit;
     if (netconf_access_denied(cbret, "application", "default deny") < 0)
 	goto done;
@@ -295,14 +723,8 @@ nacm_rpc(char         *rpc,
     retval = 1;
  done:
     clicon_debug(1, "%s retval:%d (0:deny 1:permit)", __FUNCTION__, retval);
-    if (nsc)
-	xml_nsctx_free(nsc);
-    if (gvec)
-	free(gvec);
-    if (rlistvec)
-	free(rlistvec);
-    if (rvec)
-	free(rvec);
+    if (nptmp)
+	nacm_policy_free(nptmp);
     return retval;
  deny: /* Here, cbret must contain a netconf error msg */
     assert(cbuf_len(cbret));
@@ -313,7 +735,7 @@ nacm_rpc(char         *rpc,
 /* Local struct for keeping preparation/compiled data in NACM data path code */
 struct prepvec{
     qelem_t       pv_q;
-    cxobj        *pv_xrule;
+    nacm_rule    *pv_rule;
     clixon_xvec  *pv_xpathvec;
 };
 typedef struct prepvec prepvec;
@@ -336,7 +758,7 @@ prepvec_free(prepvec *pv_list)
 
 prepvec *
 prepvec_add(prepvec  **pv_listp,
-	    cxobj     *xrule)
+	    nacm_rule *nr)
 {
     prepvec *pv;
 
@@ -346,7 +768,7 @@ prepvec_add(prepvec  **pv_listp,
     }
     memset(pv, 0, sizeof(*pv));
     ADDQ(pv, *pv_listp);
-    pv->pv_xrule = xrule;
+    pv->pv_rule = nr;
     if ((pv->pv_xpathvec = clixon_xvec_new()) == NULL)
 	return NULL;
     return pv;
@@ -355,159 +777,92 @@ prepvec_add(prepvec  **pv_listp,
 /*! Prepare datastructures before running through XML tree
  * Save rules in a "cache"
  * These rules match:
- *  - user/group
+ *  - user/group (precompiled in nu)
  *  - have read access-op, etc
  * Also make instance-id lookups on top object for each rule. Assume at most one result
+ * @param[in]  h        Clicon handle
+ * @param[in]  xt       XML root tree
+ * @param[in]  access   NACM access operation
+ * @param[in]  nu       Compiled rules of user
+ * @param[out] pv_listp Prepared rules, free with prepvec_free
  */
 static int
 nacm_datanode_prepare(clicon_handle     h,
 		      cxobj            *xt,
 		      enum nacm_access  access,
-		      cxobj           **gvec,
-		      size_t            glen,
-		      cxobj           **rlistvec,
-		      size_t            rlistlen,
-		      cvec             *nsc,
+		      nacm_user        *nu,
 		      prepvec         **pv_listp)
 {
     int        retval = -1;
-    cxobj     *rlist;
     int        i;
-    int        j;
     int        k;
-    char      *gname;
-    cxobj    **rvec = NULL; /* rules */
-    size_t     rlen;	
-    cxobj     *xrule;
-    cxobj     *pathobj;
-    char      *access_operations;
-    char      *path0;         /* Non-canonical path */
-    char      *path=NULL;     /* Canonical path */
-    cvec      *nsc0 = NULL;   /* Non-canonical namespace context */
+    nacm_rule *nr;
     yang_stmt *yspec;
-    cxobj   **xvec = NULL;
-    int       xlen = 0;
-    int       ret;
-    prepvec *pv;
+    cxobj    **xvec = NULL;
+    int        xlen = 0;
+    int        ret;
+    prepvec   *pv;
 
     yspec = clicon_dbspec_yang(h);
-    for (i=0; i<rlistlen; i++){ 	/* Loop through rule list */
-	rlist = rlistvec[i];
-	/* Loop through user's group to find match in this rule-list */
-	for (j=0; j<glen; j++){
-	    gname = xml_find_body(gvec[j], "name");
-	    if (xpath_first(rlist, nsc, ".[group='%s']", gname)!=NULL)
-		break; /* found */
-	}
-	if (j==glen) /* not found */
+    switch (access){
+    case NACM_READ:
+    case NACM_CREATE:
+    case NACM_DELETE:
+    case NACM_UPDATE:
+	break;
+    default:
+	clicon_err(OE_XML, EINVAL, "Access %d unupported (shouldnt happen)", access);
+	goto done;
+	break;
+    }
+    /* 6. For each rule-list entry found, process all rules, in order,
+       until a rule that matches the requested access operation is
+       found. (see 6 sub rules in nacm_rule_datanode
+    */
+    for (i=0; i<nu->nu_len; i++){ /* Loop through rules of user's rule-lists */
+	nr = nu->nu_rules[i];
+	/* 6c) For a "read" access operation, the rule's "access-operations"
+	   leaf has the "read" bit set or has the special value "*"
+	   6d-f) Same for "create", "delete" and "update" where "write" is
+	   short-hand for all three */
+	if ((nr->nr_access & NACM_ACCESS_BIT(access)) == 0)
 	    continue;
-	/* 6. For each rule-list entry found, process all rules, in order,
-	   until a rule that matches the requested access operation is
-	   found. (see 6 sub rules in nacm_rule_datanode
-	*/
-	if (xpath_vec(rlist, nsc, "rule", &rvec, &rlen) < 0)
-	    goto done;
-	for (j=0; j<rlen; j++){ /* Loop through rules */
-	    xrule = rvec[j];
-	    /* 6c) For a "read" access operation, the rule's "access-operations"
-	       leaf has the "read" bit set or has the special value "*" */
-	    access_operations = xml_find_body(xrule, "access-operations");
-	    switch (access){
-	    case NACM_READ: 
-		/* 6c) For a "read" access operation, the rule's "access-operations"
-		   leaf has the "read" bit set or has the special value "*" */
-		if (!match_access(access_operations, "read", NULL))
-		    continue;
-		break;
-	    case NACM_CREATE:
-		/* 6d) For a "create" access operation, the rule's "access-operations" 
-		   leaf has the "create" bit set or has the special value "*". */
-		if (!match_access(access_operations, "create", "write"))
-		    continue;
-		break;
-	    case NACM_DELETE:
-		/* 6e) For a "delete" access operation, the rule's "access-operations" 
-		   leaf has the "delete" bit set or has the  special value "*". */
-		if (!match_access(access_operations, "delete", "write"))
-		    continue;
-		break;
-	    case NACM_UPDATE:
-		/* 6f) For an "update" access operation, the rule's "access-operations"
-		   leaf has the "update" bit set or has the special value "*". */ 
-		if (!match_access(access_operations, "update", "write"))
-		    continue;
-		break;
-	    default:
-		clicon_err(OE_XML, EINVAL, "Access %d unupported (shouldnt happen)", access);
+	/*  6b) Either (1) the rule does not have a "rule-type" defined or
+	    (2) the "rule-type" is "data-node" and the "path" matches the
+	    requested data node, action node, or notification node. */    
+	if (nr->nr_path == NULL){
+	    if (nr->nr_rpc || nr->nr_notif)
+		continue;
+	    /* Here a new rule is found, add it */
+	    if (prepvec_add(pv_listp, nr) == NULL)
 		goto done;
-		break;
-	    }
-	    /*  6b) Either (1) the rule does not have a "rule-type" defined or
-		(2) the "rule-type" is "data-node" and the "path" matches the
-		requested data node, action node, or notification node. */    
-	    if ((pathobj = xml_find_type(xrule, NULL, "path", CX_ELMNT)) == NULL){
-		if (xml_find_body(xrule, "rpc-name") || xml_find_body(xrule, "notification-name"))
-		    continue;
-		/* Here a new xrule is found, add it */
-		if (prepvec_add(pv_listp, xrule) == NULL)
+	}
+	else{
+	    /* See https://github.com/clicon/clixon/issues/129:
+	     * Paths are not canonicalized, since that brings back the problem of
+	     * JSON encodings
+	     */
+	    if ((ret = clixon_xml_find_instance_id(xt, yspec, &xvec, &xlen, "%s", nr->nr_path)) < 0)
+		goto done;
+	    if (ret == 0)
+		continue;
+	    /* Here a new rule is found, add it */
+	    if ((pv = prepvec_add(pv_listp, nr)) == NULL)
+		goto done;
+	    for (k=0; k<xlen; k++){
+		if (clixon_xvec_append(pv->pv_xpathvec, xvec[k]) < 0)
 		    goto done;
 	    }
-	    else{
-		path0 = clixon_trim2(xml_body(pathobj), " \t\n");
-		/* Get canonical namespace context for nacm paths */
-		if ((path = strdup(path0)) == NULL){
-		    clicon_err(OE_UNIX, errno, "strdup");
-		    goto done;
-		}
-#if 0
-		/* See https://github.com/clicon/clixon/issues/129:
-		 * If this is enabled, you are back to the problem of JSON encodings
-		 */
-		/* Create namespace context for with nacm namespace as default */
-		if (xml_nsctx_node(pathobj, &nsc0) < 0)
-		    goto done;
-		/* instance-id requires canonical paths */
-		if (xpath2canonical(path0, nsc0, yspec, &path, NULL) < 0)
-		    goto done;
-#endif
-		if ((ret = clixon_xml_find_instance_id(xt, yspec, &xvec, &xlen, "%s", path)) < 0)
-		    goto done;
-		if (ret == 0)
-		    continue;
-		/* Here a new xrule is found, add it */
-		if ((pv = prepvec_add(pv_listp, xrule)) == NULL)
-		    goto done;
-		for (k=0; k<xlen; k++){
-		    if (clixon_xvec_append(pv->pv_xpathvec, xvec[k]) < 0)
-			goto done;
-		}
-		if (xvec){
-		    free(xvec);
-		    xvec = NULL;
-		}
-		if (nsc0){
-		    cvec_free(nsc0);
-		    nsc0 = NULL;
-		}
-		if (path){
-		    free(path);
-		    path = NULL;
-		}
+	    if (xvec){
+		free(xvec);
+		xvec = NULL;
 	    }
 	}
-	if (rvec){
-	    free(rvec);
-	    rvec=NULL;
-	}	
     }
     retval = 0;
  done:
     if (xvec)
 	free(xvec);
-    if (path)
-	free(path);
-    if (nsc0)
-	cvec_free(nsc0);
     return retval;
 }
 
@@ -517,7 +872,7 @@ nacm_datanode_prepare(clicon_handle     h,
 
 /*! Match specific rule to specific requested node
  * @param[in]  xn       XML node (requested node)
- * @param[in]  xrule    NACM rule
+ * @param[in]  nr       Compiled NACM rule
  * @param[in]  xp       Xpath match
  * @param[in]  yspec    YANG spec
  * @retval -1  Error
@@ -527,7 +882,7 @@ nacm_datanode_prepare(clicon_handle     h,
  */
 static int
 nacm_data_write_xrule_xml(cxobj       *xn,
-			  cxobj       *xrule,
+			  nacm_rule   *nr,
 			  clixon_xvec *xpathvec,
 			  yang_stmt   *yspec)
 {
@@ -538,7 +893,7 @@ nacm_data_write_xrule_xml(cxobj       *xn,
     cxobj     *xp;
     int        i;
 
-    if ((module_pattern = xml_find_body(xrule, "module-name")) == NULL)
+    if ((module_pattern = nr->nr_module) == NULL)
 	goto nomatch;
     /* 6a) The rule's "module-name" leaf is "*" or equals the name of
      * the YANG module where the requested data node is defined. 
@@ -550,11 +905,11 @@ nacm_data_write_xrule_xml(cxobj       *xn,
 	if (ymod && strcmp(yang_argument_get(ymod), module_pattern) != 0)
 	    goto nomatch;
     }
-    action = xml_find_body(xrule, "action"); /* mandatory */
+    action = nr->nr_action; /* mandatory */
     /*  6b) Either (1) the rule does not have a "rule-type" defined or
 	(2) the "rule-type" is "data-node" and the "path" matches the
 	Requested data node, action node, or notification node. */    
-    if (xml_find_type(xrule, NULL, "path", CX_ELMNT) == NULL){
+    if (nr->nr_path == NULL){
 	if (strcmp(action, "deny")==0)
 	    goto deny;
 	goto permit;
@@ -615,7 +970,7 @@ nacm_datanode_write_recurse(clicon_handle h,
 	do {
 	    /* return values: -1:Error /0:no match /1: deny /2: permit
 	     */
-	    if ((ret = nacm_data_write_xrule_xml(xn, pv->pv_xrule, pv->pv_xpathvec, yspec)) < 0) 
+	    if ((ret = nacm_data_write_xrule_xml(xn, pv->pv_rule, pv->pv_xpathvec, yspec)) < 0) 
 		goto done;
 	    switch(ret){
 	    case 0: /* No match, continue with next rule */
@@ -656,50 +1011,47 @@ nacm_datanode_write_recurse(clicon_handle h,
     goto done;
 }
 
-/*! Make nacm datanode and module rule write access validation
- * The operations of NACM are: create, read, update, delete, exec
- *  where write is short-hand for create+delete+update
+/*! Make nacm datanode and module rule write access validation of a vector of nodes
+ * Same as nacm_datanode_write but the rules are prepared once for all nodes, which
+ * is used in bulk edits where many sibling nodes, eg list entries, are created.
  * @param[in]  h        Clixon handle
- * @param[in]  xreq     XML requestor node (part of xt) for delete it is existing, for others it is new
+ * @param[in]  xvec     Vector of XML requestor nodes (part of xt)
+ * @param[in]  xlen     Length of xvec
  * @param[in]  xt       XML request root tree with "config" label at top.
- * @param[in]  op       NACM access of xreq
+ * @param[in]  access   NACM access of all nodes in xvec
  * @param[in]  username User making access
  * @param[in]  xnacm    NACM xml tree
- * @param[out] cbret Cligen buffer result. Set to an error msg if retval=0.
+ * @param[out] cbret    Cligen buffer result. Set to an error msg if retval=0.
  * @retval -1  Error
- * @retval  0  Not access and cbret set
- * @retval  1  Access
- * @see RFC8341 3.4.5.  Data Node Access Validation
- * @see nacm_datanode_read
- * @see nacm_rpc
+ * @retval  0  Not access to at least one node and cbret set
+ * @retval  1  Access to all nodes
+ * @see nacm_datanode_write
  */
 int
-nacm_datanode_write(clicon_handle    h,
-		    cxobj           *xreq,
-		    cxobj           *xt,
-		    enum nacm_access access,
-		    char            *username,
-		    cxobj           *xnacm,
-		    cbuf            *cbret)
+nacm_datanode_write_vec(clicon_handle    h,
+			cxobj          **xvec,
+			size_t           xlen,
+			cxobj           *xt,
+			enum nacm_access access,
+			char            *username,
+			cxobj           *xnacm,
+			cbuf            *cbret)
 {
     int             retval = -1;
-    cxobj         **gvec = NULL; /* groups */
-    size_t          glen;
-    cxobj         **rlistvec = NULL; /* rule-list */
-    size_t          rlistlen;
-    cxobj         **rvec = NULL; /* rules */
+    nacm_policy    *np = NULL;
+    nacm_policy    *nptmp = NULL;
+    nacm_user      *nu;
     char           *write_default = NULL;
-    cvec           *nsc = NULL;
     int             ret;
     prepvec        *pv_list = NULL;
+    size_t          i;
 
-    /* Create namespace context for with nacm namespace as default */
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
-	goto done;
     if (xnacm == NULL)
 	goto permit;
+    if (nacm_policy_get(h, xnacm, &np, &nptmp) < 0)
+	goto done;
     /* write-default (create, update, or delete) has default deny so should never be NULL */
-    if ((write_default = xml_find_body(xnacm, "write-default")) == NULL){
+    if ((write_default = np->np_write_default) == NULL){
 	clicon_err(OE_XML, EINVAL, "No nacm write-default rule");
 	goto done;
     }
@@ -710,30 +1062,30 @@ nacm_datanode_write(clicon_handle    h,
        transport layer.)	       */
     if (username == NULL)
 	goto step9;
-    /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
+    /* User's groups and rules, compiled */
+    if ((nu = nacm_policy_user(np, username)) == NULL)
 	goto done;
     /* 4. If no groups are found, continue with step 9. */
-    if (glen == 0)
+    if (nu->nu_ngroups == 0)
 	goto step9;
     /* 5. Process all rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
-        entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
-	goto done;
-    /* First run through rules and cache rules as well as lookup objects in xt. 
+        entry. (The rules of matching rule-lists are in nu)
+       First run through rules and cache rules as well as lookup objects in xt. 
      */
-    if (nacm_datanode_prepare(h, xt, access, gvec, glen, rlistvec, rlistlen, nsc, &pv_list) < 0)
+    if (nacm_datanode_prepare(h, xt, access, nu, &pv_list) < 0)
 	goto done;
     /* Then recursivelyy traverse all requested nodes */
-    if ((ret = nacm_datanode_write_recurse(h, xreq, pv_list,
-					   strcmp(write_default, "deny"),
-					   clicon_dbspec_yang(h),
-					   cbret)) < 0)
-	goto done;
-    if (ret == 0) /* deny */
-	goto deny;
+    for (i=0; i<xlen; i++){
+	if ((ret = nacm_datanode_write_recurse(h, xvec[i], pv_list,
+					       strcmp(write_default, "deny"),
+					       clicon_dbspec_yang(h),
+					       cbret)) < 0)
+	    goto done;
+	if (ret == 0) /* deny */
+	    goto deny;
+    }
     goto permit;
     /*  8.   At this point, no matching rule was found in any rule-list
 	entry. */
@@ -761,14 +1113,8 @@ nacm_datanode_write(clicon_handle    h,
     clicon_debug(1, "%s retval:%d (0:deny 1:permit)", __FUNCTION__, retval);
     if (pv_list)
 	prepvec_free(pv_list);
-    if (nsc)
-	xml_nsctx_free(nsc);
-    if (gvec)
-	free(gvec);
-    if (rlistvec)
-	free(rlistvec);
-    if (rvec)
-	free(rvec);
+    if (nptmp)
+	nacm_policy_free(nptmp);
     return retval;
  deny: /* Here, cbret must contain a netconf error msg */
     assert(cbuf_len(cbret));
@@ -776,155 +1122,254 @@ nacm_datanode_write(clicon_handle    h,
     goto done;
 }
 
+/*! Make nacm datanode and module rule write access validation
+ * The operations of NACM are: create, read, update, delete, exec
+ *  where write is short-hand for create+delete+update
+ * @param[in]  h        Clixon handle
+ * @param[in]  xreq     XML requestor node (part of xt) for delete it is existing, for others it is new
+ * @param[in]  xt       XML request root tree with "config" label at top.
+ * @param[in]  op       NACM access of xreq
+ * @param[in]  username User making access
+ * @param[in]  xnacm    NACM xml tree
+ * @param[out] cbret Cligen buffer result. Set to an error msg if retval=0.
+ * @retval -1  Error
+ * @retval  0  Not access and cbret set
+ * @retval  1  Access
+ * @see RFC8341 3.4.5.  Data Node Access Validation
+ * @see nacm_datanode_read
+ * @see nacm_rpc
+ */
+int
+nacm_datanode_write(clicon_handle    h,
+		    cxobj           *xreq,
+		    cxobj           *xt,
+		    enum nacm_access access,
+		    char            *username,
+		    cxobj           *xnacm,
+		    cbuf            *cbret)
+{
+    return nacm_datanode_write_vec(h, &xreq, 1, xt, access, username, xnacm, cbret);
+}
+
 /*---------------------------------------------------------------
  * Datanode read
  */
 
-/*! Perform NACM action: mark if permit, del if deny
- * @param[in] xrule    NACM rule
- * @param[in] xn       XML node (requested node)
- * @retval    -1       Error
- * @retval    0        OK
+/* Result of NACM read access validation of a node and its subtree */
+enum nacm_read_result{
+    NACM_READ_DENY,   /* Node matches deny rule: remove subtree */
+    NACM_READ_NONE,   /* No permitted content and default deny: remove unless list key */
+    NACM_READ_KEEP,   /* Keep node */
+};
+
+/*! Check if all data nodes of a YANG subtree belong to the same module as the node
+ * Nodes of other modules are added by augment. The result is cached in YANG flags
+ * since it only depends on the YANG spec.
+ * @param[in]  ys    YANG node
+ * @param[in]  ymod  Real module of ys
+ * @retval     1     All data nodes of subtree are in ymod
+ * @retval     0     Some data node is in another module
+ * @retval    -1     Error
  */
 static int
-nacm_data_read_action(cxobj *xrule,
-		      cxobj *xn)
+nacm_yang_module_uniform(yang_stmt *ys,
+			 yang_stmt *ymod)
 {
-    int   retval = -1;
-    char *action;
+    int           retval = -1;
+    yang_stmt    *yc;
+    yang_stmt    *ym;
+    enum rfc_6020 keyw;
+    int           ret;
 
-    if ((action = xml_find_body(xrule, "action")) != NULL){
-	if (strcmp(action, "deny")==0)
-	    xml_flag_set(xn, XML_FLAG_DEL);
-	else if (strcmp(action, "permit")==0)
-	    xml_flag_set(xn, XML_FLAG_MARK);
+    if (yang_flag_get(ys, YANG_FLAG_NACM_DONE))
+	return yang_flag_get(ys, YANG_FLAG_NACM_MODULE) ? 1 : 0;
+    yc = NULL;
+    while ((yc = yn_each(ys, yc)) != NULL) {
+	keyw = yang_keyword_get(yc);
+	if (!yang_datanode(yc) && keyw != Y_CHOICE && keyw != Y_CASE)
+	    continue;
+	if (ys_real_module(yc, &ym) < 0)
+	    goto done;
+	if (ym != ymod)
+	    goto fail;
+	if ((ret = nacm_yang_module_uniform(yc, ymod)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
     }
-    retval = 0;
-    //done:
+    yang_flag_set(ys, YANG_FLAG_NACM_MODULE);
+    retval = 1;
+ done:
+    if (retval >= 0)
+	yang_flag_set(ys, YANG_FLAG_NACM_DONE);
     return retval;
+ fail:
+    retval = 0;
+    goto done;
 }
 
-/*! Match specific rule to specific requested node
- * @param[in]  xn       XML node (requested node)
- * @param[in]  xrule    NACM rule
- * @param[in]  yspec    YANG spec
- * @retval -1  Error
- * @retval  0  OK and rule does not match
- * @retval  1  OK and rule matches
- * Two distinct cases:
- * (1) read_default is permit
- *     mark all deny rules and remove them
- * (2) read_default is deny:
- *     mark all permit rules and ancestors, remove everything else
+/*! Check if a prepared NACM rule matches a requested node
+ * @param[in]  xn     XML node (requested node)
+ * @param[in]  ymod   Real YANG module of xn
+ * @param[in]  pv     Prepared NACM rule
+ * @retval     1      Rule matches
+ * @retval     0      Rule does not match
  */
 static int
-nacm_data_read_xrule_xml(cxobj        *xn,
-			 cxobj        *xrule,
-			 clixon_xvec  *xpathvec,
-			 yang_stmt    *yspec)
+nacm_data_read_match(cxobj     *xn,
+		     yang_stmt *ymod,
+		     prepvec   *pv)
 {
-    int        retval = -1;
-    yang_stmt *ymod;
-    char      *module_pattern; /* rule module name */
+    nacm_rule *nr = pv->pv_rule;
     cxobj     *xp;
     int        i;
-    
-    if ((module_pattern = xml_find_body(xrule, "module-name")) == NULL)
-	goto nomatch;
+
     /* 6a) The rule's "module-name" leaf is "*" or equals the name of
-     * the YANG module where the requested data node is defined. 
+     * the YANG module where the requested data node is defined.
      */
-    if (strcmp(module_pattern, "*") != 0){
-	if (ys_module_by_xml(yspec, xn, &ymod) < 0)
-	    goto done;
-	if (strcmp(yang_argument_get(ymod), module_pattern) != 0)
-	    goto nomatch;
-    }
+    if (nr->nr_module == NULL)
+	return 0;
+    if (strcmp(nr->nr_module, "*") != 0 &&
+	(ymod == NULL || strcmp(yang_argument_get(ymod), nr->nr_module) != 0))
+	return 0;
     /*  6b) Either (1) the rule does not have a "rule-type" defined or
 	(2) the "rule-type" is "data-node" and the "path" matches the
-	requested data node, action node, or notification node. */    
-    if (xml_find_type(xrule, NULL, "path", CX_ELMNT) == NULL){
-	if (nacm_data_read_action(xrule, xn) < 0)
-	    goto done;
-	goto match;
-    }
-    for (i=0; i<clixon_xvec_len(xpathvec); i++){
-	xp = clixon_xvec_i(xpathvec, i);
-	/* Check if ancestor is xp (for every xpathvec?) */
-	if (xn == xp || xml_isancestor(xn, xp)){
-	    if (nacm_data_read_action(xrule, xn) < 0)
-		goto done;
-	    goto match;
-	}
+	requested data node, action node, or notification node. */
+    if (nr->nr_path == NULL)
+	return 1;
+    for (i=0; i<clixon_xvec_len(pv->pv_xpathvec); i++){
+	xp = clixon_xvec_i(pv->pv_xpathvec, i);
+	if (xn == xp || xml_isancestor(xn, xp))
+	    return 1;
     }
- nomatch:
-    retval = 0;
- done:
-    return retval;
- match:
-    retval = 1; /* match */
-    goto done;
+    return 0;
 }
 
-/*! Recursive check for NACM read rules among all XML nodes
- * @param[in]  h        Clicon handle
- * @param[in]  xn       XML node (requested node)
- * @param[in]  rulevec  Precomputed rules that apply to this user group
- * @param[in]  xpathvec Precomputed xpath results that apply to this XML tree
- * @param[in]  yspec    YANG spec
- * @retval  0  OK
- * @retval -1  Error
+/*! Check if node is the path target of a prepared NACM rule
+ * @param[in]  xn     XML node (requested node)
+ * @param[in]  pv     Prepared NACM rule
  */
 static int
-nacm_datanode_read_recurse(clicon_handle h,
-			   cxobj        *xn,
-			   prepvec      *pv_list,
-			   yang_stmt    *yspec)
+nacm_data_read_target(cxobj   *xn,
+		      prepvec *pv)
 {
-    int      retval = -1;
-    cxobj   *x;
-    cxobj   *xprev;
-    int      ret;
-    prepvec *pv;
-    
-    if (xml_spec(xn)){ /* Check this node */
-	pv = pv_list;
-	if (pv){
-	    do {
-		if ((ret = nacm_data_read_xrule_xml(xn,
-						    pv->pv_xrule,
-						    pv->pv_xpathvec,
-						    yspec)) < 0) 
-		    goto done;	    
-		if (ret == 1)
-		    break; /* stop at first match */		    
-		pv = NEXTQ(prepvec *, pv);
-	    } while (pv && pv != pv_list);
-	}
+    int i;
 
-#if 0 /* 6(A) in algorithm 
-       * If N did not match any rule R, and default rule is deny, remove that subtree */
-	if (strcmp(read_default, "deny") == 0)
-	    if (xml_tree_prune_flagged_sub(xt, XML_FLAG_MARK, 1, NULL) < 0)
-		goto done;
-#endif
-    }
+    if (pv->pv_rule->nr_path == NULL)
+	return 0;
+    for (i=0; i<clixon_xvec_len(pv->pv_xpathvec); i++)
+	if (clixon_xvec_i(pv->pv_xpathvec, i) == xn)
+	    return 1;
+    return 0;
+}
 
-    /* If node should be purged, dont recurse and defer removal to caller */
-    if (xml_flag(xn, XML_FLAG_DEL) == 0){
-	x = NULL; 	/* Recursively check XML */
-	xprev = NULL;
-	while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
-	    if (nacm_datanode_read_recurse(h, x, pv_list, yspec) < 0)
+/*! Recursive check for NACM read rules, remove nodes that are not permitted
+ *
+ * The first matching rule of a node is inherited from its parent: if the node is in
+ * the same module as its parent, all rules matching the parent also match the node,
+ * and an earlier rule can only match if the node is itself a path target of that rule.
+ * Path targets and their ancestors are marked with XML_FLAG_MARK before traversal.
+ * If a node has no marked descendants and its YANG subtree is all in one module, the
+ * whole subtree has the same result, and is kept or removed without visiting it.
+ * @param[in]  xn        XML node (requested node)
+ * @param[in]  pvec      Prepared rules, in order
+ * @param[in]  plen      Length of pvec
+ * @param[in]  pidx      First matching rule of parent, plen if none, -1 if not known
+ * @param[in]  ympar     Real YANG module of parent, or NULL
+ * @param[in]  defpermit Default result of non-matching nodes is keep
+ * @param[out] result    Result of node, see enum nacm_read_result
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @note XML_FLAG_MARK is reset on all nodes that are visited and not removed
+ */
+static int
+nacm_datanode_read_recurse(cxobj                 *xn,
+			   prepvec              **pvec,
+			   int                    plen,
+			   int                    pidx,
+			   yang_stmt             *ympar,
+			   int                    defpermit,
+			   enum nacm_read_result *result)
+{
+    int                   retval = -1;
+    yang_stmt            *ys;
+    yang_stmt            *ymod = NULL;
+    cxobj                *x;
+    cxobj                *xprev;
+    int                   idx = -1;  /* First matching rule, plen if none, -1 if no spec */
+    int                   marked;
+    int                   keep = 0;  /* Any child kept */
+    int                   iskey;
+    int                   ret;
+    int                   i;
+    enum nacm_read_result res;
+
+    marked = xml_flag(xn, XML_FLAG_MARK);
+    if (marked)
+	xml_flag_reset(xn, XML_FLAG_MARK);
+    if ((ys = xml_spec(xn)) != NULL){ /* Check this node */
+	if (ys_real_module(ys, &ymod) < 0)
+	    goto done;
+	if (pidx >= 0 && ymod == ympar){
+	    /* Inherit from parent, unless node is path target of an earlier rule */
+	    idx = pidx;
+	    if (marked)
+		for (i=0; i<pidx; i++)
+		    if (nacm_data_read_target(xn, pvec[i])){
+			idx = i;
+			break;
+		    }
+	}
+	else{
+	    for (idx=0; idx<plen; idx++)
+		if (nacm_data_read_match(xn, ymod, pvec[idx]))
+		    break;
+	}
+	if (idx < plen){
+	    if (pvec[idx]->pv_rule->nr_action &&
+		strcmp(pvec[idx]->pv_rule->nr_action, "deny") == 0){
+		*result = NACM_READ_DENY;
+		goto ok;
+	    }
+	    if (pvec[idx]->pv_rule->nr_action &&
+		strcmp(pvec[idx]->pv_rule->nr_action, "permit") == 0)
+		defpermit = 1; /* Keep all of subtree not denied */
+	}
+	/* Uniform subtree: no rule targets inside, all nodes in same module */
+	if (!marked){
+	    if ((ret = nacm_yang_module_uniform(ys, ymod)) < 0)
 		goto done;
-	    /* check for delayed remove */
-	    if (xml_flag(x, XML_FLAG_DEL)){
-		if (xml_purge(x) < 0)
+	    if (ret == 1){
+		*result = defpermit ? NACM_READ_KEEP : NACM_READ_NONE;
+		goto ok;
+	    }
+	}
+    }
+    x = NULL;
+    xprev = NULL;
+    while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
+	if (nacm_datanode_read_recurse(x, pvec, plen, idx, ymod, defpermit, &res) < 0)
+	    goto done;
+	if (res == NACM_READ_KEEP)
+	    keep++;
+	else {
+	    /* Keys are kept if any other child is kept */
+	    if (res == NACM_READ_NONE && ys && yang_keyword_get(ys) == Y_LIST){
+		if ((iskey = yang_key_match(ys, xml_name(x))) < 0)
 		    goto done;
-	    x = xprev;
+		if (iskey){
+		    xprev = x;
+		    continue;
+		}
 	    }
+	    if (xml_purge(x) < 0)
+		goto done;
+	    x = xprev;
 	}
+	xprev = x;
     }
+    *result = (defpermit || keep) ? NACM_READ_KEEP : NACM_READ_NONE;
+ ok:
     retval = 0;
  done:
     return retval;
@@ -963,16 +1408,19 @@ nacm_datanode_read_recurse(clicon_handle h,
  * 2. Any node descendants of a deny is denied (except default)
  * 3. First rule matching a node is the active rule
  * 
- * Algorithm:  Select either (A) or (B)
+ * Algorithm:
  *
  * 1. Select next node N in the requested node tree:
  *   2. Select next R rule in the set of applicable rules:
  *     3. If N does not match R, and remaining rules, goto 2.
  *     4. If N matches R as deny, remove that subtree
- *     5. If N matches R as accept, mark that node
- * 6(A). If N did not match any rule R, and default rule is deny, remove that subtree
+ *     5. If N matches R as accept, keep that subtree except denied descendants
+ * 6. If N did not match any rule R, and default rule is deny, remove N unless it has
+ *    kept descendants
  * 7. If remaining nodes, goto 1
- * 8(B) If default rule is deny, recursively remove all subtrees that are not marked
+ * This is made in one pass, where the matching rule is inherited from the parent and
+ * subtrees without path targets in one YANG module are not visited,
+ * see nacm_datanode_read_recurse
  *
  * @see RFC8341 3.4.5.  Data Node Access Validation
  * @see nacm_datanode_write
@@ -987,17 +1435,20 @@ nacm_datanode_read(clicon_handle h,
 		   cxobj        *xnacm)
 {
     int             retval = -1;
-    cxobj         **gvec = NULL; /* groups */
-    size_t          glen;
-    cxobj         **rlistvec = NULL; /* rule-list */
-    size_t          rlistlen;
+    nacm_policy    *np = NULL;
+    nacm_policy    *nptmp = NULL;
+    nacm_user      *nu;
     int             i;
+    int             k;
     char           *read_default = NULL;
-    cvec           *nsc = NULL;
     prepvec        *pv_list = NULL;
+    prepvec        *pv;
+    prepvec       **pvec = NULL;
+    int             plen = 0;
+    cxobj          *x;
+    enum nacm_read_result res;
     
-    /* Create namespace context for with nacm namespace as default */
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
+    if (nacm_policy_get(h, xnacm, &np, &nptmp) < 0)
 	goto done;
     /* 3.   Check all the "group" entries to see if any of them contain a
        "user-name" entry that equals the username for the session
@@ -1006,42 +1457,53 @@ nacm_datanode_read(clicon_handle h,
        transport layer.)	       */
     if (username == NULL)
 	goto step9;
-    /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
+    /* User's groups and rules, compiled */
+    if ((nu = nacm_policy_user(np, username)) == NULL)
 	goto done;
-    /* 4. If no groups are found (glen=0), continue and check read-default 
+    /* 4. If no groups are found (no rules in nu), continue and check read-default 
           in step 11. */
     /* 5. Process all rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
-        entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
-	goto done;
+        entry. (The rules of matching rule-lists are in nu) */
     /* read-default has default permit so should never be NULL */
-    if ((read_default = xml_find_body(xnacm, "read-default")) == NULL){
+    if ((read_default = np->np_read_default) == NULL){
 	clicon_err(OE_XML, EINVAL, "No nacm read-default rule");
 	goto done;
     }
     /* First run through rules and cache rules as well as lookup objects in xt. 
      * DANGER: objects could be stale if they are removed?
      */
-    if (nacm_datanode_prepare(h, xt, NACM_READ, gvec, glen, rlistvec, rlistlen, nsc, &pv_list) < 0)
+    if (nacm_datanode_prepare(h, xt, NACM_READ, nu, &pv_list) < 0)
 	goto done;
-    /* Then recursivelyy traverse all nodes */
-    if (nacm_datanode_read_recurse(h, xt, pv_list, clicon_dbspec_yang(h)) < 0)
+    /* Vector of rules in order, and mark path targets and their ancestors */
+    if ((pv = pv_list) != NULL)
+	do {
+	    plen++;
+	    pv = NEXTQ(prepvec *, pv);
+	} while (pv && pv != pv_list);
+    if (plen && (pvec = calloc(plen, sizeof(*pvec))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
 	goto done;
-#if 1
-    /* Step 8(B) above:
-     * If default rule is deny, recursively remove all subtrees that are not marked
-     */
-    if (strcmp(read_default, "deny") == 0)
-	if (xml_tree_prune_flagged_sub(xt, XML_FLAG_MARK, 1, NULL) < 0)
-	    goto done;
-#endif
-    /* reset flag */
-    if (xml_apply(xt, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_MARK) < 0)
+    }
+    i = 0;
+    if ((pv = pv_list) != NULL)
+	do {
+	    pvec[i++] = pv;
+	    for (k=0; k<clixon_xvec_len(pv->pv_xpathvec); k++)
+		for (x = clixon_xvec_i(pv->pv_xpathvec, k); x; x = xml_parent(x)){
+		    if (xml_flag(x, XML_FLAG_MARK))
+			break;
+		    xml_flag_set(x, XML_FLAG_MARK);
+		    if (x == xt)
+			break;
+		}
+	    pv = NEXTQ(prepvec *, pv);
+	} while (pv && pv != pv_list);
+    /* Then recursively traverse nodes, which also resets marks */
+    if (nacm_datanode_read_recurse(xt, pvec, plen, -1, NULL,
+				   strcmp(read_default, "deny") != 0, &res) < 0)
 	goto done;
-
     goto ok;
     /* 8.   At this point, no matching rule was found in any rule-list
        entry. */
@@ -1059,14 +1521,12 @@ nacm_datanode_read(clicon_handle h,
     retval = 0;
  done:
     clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
+    if (pvec)
+	free(pvec);
     if (pv_list)
 	prepvec_free(pv_list);
-    if (nsc)
-	xml_nsctx_free(nsc);
-    if (gvec)
-	free(gvec);
-    if (rlistvec)
-	free(rlistvec);
+    if (nptmp)
+	nacm_policy_free(nptmp);
     return retval;
 }
 
@@ -1090,7 +1550,6 @@ nacm_datanode_read(clicon_handle h,
  *     err;
  *   if (ret == 0){
  *      // Next step NACM processing
- *      xml_free(xnacm);
  *   }
  * @endcode
  * @see RFC8341 3.4 Access Control Enforcement Procedures
@@ -1170,9 +1629,13 @@ nacm_access_check(clicon_handle h,
  * Initial NACM steps and common to all NACM access validation.
  * If retval=0 continue with next NACM step, eg rpc, module, 
  * etc. If retval = 1 access is OK and skip next NACM step.
+ * The NACM config is compiled into a policy which is cached in the handle and reused
+ * until the NACM config changes, ie a commit changing the nacm tree of running in
+ * internal mode.
  * @param[in]  h        Clicon handle
  * @param[in]  username User name of requestor
- * @param[out] xncam    NACM XML tree, set if retval=0. Free after use
+ * @param[out] xncam    NACM XML tree, set if retval=0. Owned by the NACM policy cache:
+ *                      do not free, valid until next call.
  * @retval -1  Error
  * @retval  0  OK but not validated. Need to do NACM step using xnacm
  * @retval  1  OK permitted. You do not need to do next NACM step.
@@ -1182,7 +1645,6 @@ nacm_access_check(clicon_handle h,
  *     err;
  *   if (ret == 0){
  *      // Next step NACM processing
- *      xml_free(xnacm);
  *   }
  * @endcode
  * @see RFC8341 3.4 Access Control Enforcement Procedures
@@ -1193,12 +1655,12 @@ nacm_access_pre(clicon_handle  h,
 		char          *username,
 		cxobj        **xnacmp)
 {
-    int    retval = -1;
-    char  *mode;
-    cxobj *x;
-    cxobj *xnacm0 = NULL;
-    cxobj *xnacm = NULL;
-    cvec  *nsc = NULL;
+    int          retval = -1;
+    char        *mode;
+    cxobj       *x;
+    cxobj       *xnacm;
+    nacm_policy *np = NULL;
+    cvec        *nsc = NULL;
     
     /* Check clixon option: disabled, external tree or internal */
     mode = clicon_option_str(h, "CLICON_NACM_MODE");
@@ -1207,44 +1669,40 @@ nacm_access_pre(clicon_handle  h,
     else if (strcmp(mode, "disabled")==0)
 	goto permit;
     else if (strcmp(mode, "external")==0){
-	if ((x = clicon_nacm_ext(h)))
-	    if ((xnacm0 = xml_dup(x)) == NULL)
+	if ((x = clicon_nacm_ext(h)) == NULL)
+	    goto permit;
+	/* Compile external tree once */
+	if ((np = nacm_policy_cache(h)) == NULL || np->np_xext != x){
+	    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
 		goto done;
+	    if ((np = nacm_policy_compile(xpath_first(x, nsc, "nacm"))) == NULL)
+		goto done;
+	    np->np_xext = x;
+	    if (nacm_policy_cache_set(h, np) < 0){
+		nacm_policy_free(np);
+		goto done;
+	    }
+	}
     }
     else if (strcmp(mode, "internal")==0){
-	if (xmldb_get0(h, "running", YB_MODULE, nsc, "nacm", 1, &xnacm0, NULL) < 0)
+	if (nacm_policy_internal(h, &np) < 0)
 	    goto done;
     }
     else{
 	clicon_err(OE_XML, 0, "Invalid NACM mode: %s", mode);
 	goto done;
     }
-    
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
-	goto done;
-    /* If config does not exist then the operation is permitted(?) */
-    if (xnacm0 == NULL)
-	goto permit;
     /* If config does not exist then the operation is permitted(?) */
-    if ((xnacm = xpath_first(xnacm0, nsc, "nacm")) == NULL)
+    if ((xnacm = np->np_xnacm) == NULL)
 	goto permit;
-    if (xml_rootchild_node(xnacm0, xnacm) < 0)
-	goto done;
-    xnacm0 = NULL;
     /* Initial NACM steps and common to all NACM access validation. */
     if ((retval = nacm_access_check(h, xnacm, peername, username)) < 0)
 	goto done;
-    if (retval == 0){ /* if retval == 0 then return an xml nacm tree */
+    if (retval == 0) /* if retval == 0 then return an xml nacm tree */
 	*xnacmp = xnacm;
-	xnacm = NULL;
-    }
  done:
     if (nsc)
 	xml_nsctx_free(nsc);
-    if (xnacm0)
-	xml_free(xnacm0);
-    else if (xnacm)
-	xml_free(xnacm);
     return retval;
  permit:
     retval = 1;
@@ -196,7 +196,10 @@ instance_id_parse(char         *path,
     return retval;
 }
 
-static int
+/*! Free a clixon-path list
+ * @param[in]  cplist   List of clixon-path
+ */
+int
 clixon_path_free(clixon_path *cplist)
 {
     clixon_path *cp;
@@ -1177,6 +1180,308 @@ api_path2xml(char       *api_path,
     goto done;
 }
 
+/*! Compile a RESTCONF api-path into a resolved clixon-path in one pass
+ *
+ * The api-path is split, URI-decoded and validated against YANG once. Each step of
+ * the result has its YANG node, xml prefix and named key values, so that it can be
+ * translated to xpath with clixon_path2xpath() and used to search XML trees with
+ * clixon_xml_find_path() without parsing the api-path again.
+ * Validation and error messages are the same as api_path2xml() with data nodes and
+ * strict set, xml prefixes and namespace context are the same as api_path2xpath().
+ * @param[in]  api_path  URI-encoded path expression (RFC8040 3.5.3)
+ * @param[in]  yspec     Yang spec
+ * @param[out] cplistp   Compiled clixon-path (free with clixon_path_free), NULL if root
+ * @param[out] nscp      Namespace context of xml prefixes (free with xml_nsctx_free)
+ * @param[out] xerr      Netconf error message (if retval=0)
+ * @retval     1         OK
+ * @retval     0         Invalid api_path or associated XML, netconf error xml set
+ * @retval    -1         Fatal error, clicon_err called
+ * @code
+ *   clixon_path *cplist = NULL;
+ *   cvec        *nsc = NULL;
+ *   char        *xpath = NULL;
+ *   if ((ret = api_path_compile("/module:a/b=c", yspec, &cplist, &nsc, &xerr)) < 0)
+ *      err;
+ *   if (ret == 1 && clixon_path2xpath(cplist, &xpath) < 0)
+ *      err;
+ *   clixon_path_free(cplist);
+ *   xml_nsctx_free(nsc);
+ * @endcode
+ * @see api_path2xml
+ * @see api_path2xpath
+ */
+int
+api_path_compile(char         *api_path,
+		 yang_stmt    *yspec,
+		 clixon_path **cplistp,
+		 cvec        **nscp,
+		 cxobj       **xerr)
+{
+    int          retval = -1;
+    char       **vec = NULL;
+    int          nvec;
+    int          i;
+    char        *nodeid;
+    char        *restval_enc;
+    char        *restval = NULL;
+    char        *prefix = NULL;
+    char        *name = NULL;
+    char       **valvec = NULL;
+    int          nvalvec;
+    int          vi;
+    yang_stmt   *y0 = yspec;
+    yang_stmt   *y;
+    yang_stmt   *ymod;
+    cvec        *cvk;
+    cg_var      *cvi;
+    char        *keyname;
+    char        *namespace = NULL;
+    char        *xprefix;
+    clixon_path *cplist = NULL;
+    clixon_path *cp;
+    cvec        *nsc = NULL;
+    cbuf        *cberr = NULL;
+
+    if (api_path == NULL){
+	clicon_err(OE_XML, EINVAL, "api_path is NULL");
+	goto done;
+    }
+    if ((cberr = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if (*api_path != '/'){
+	cprintf(cberr, "Invalid api-path: %s (must start with '/')", api_path);
+	if (xerr && netconf_invalid_value_xml(xerr, "application", cbuf_get(cberr)) < 0)
+	    goto done;
+	goto fail;
+    }
+    if ((nsc = xml_nsctx_init(NULL, NULL)) == NULL)
+	goto done;
+    if ((vec = clicon_strsep(api_path, "/", &nvec)) == NULL)
+	goto done;
+    /* vec[0] is empty string before first '/', stop at first empty element */
+    for (i=1; i<nvec && strlen(vec[i]); i++){
+	nodeid = vec[i];
+	/* E.g "x=1,2" -> nodeid:x restval=1,2, restval is RFC 3896 encoded */
+	if ((restval_enc = index(nodeid, '=')) != NULL){
+	    *restval_enc = '\0';
+	    restval_enc++;
+	    if (uri_percent_decode(restval_enc, &restval) < 0)
+		goto done;
+	}
+	if (nodeid_split(nodeid, &prefix, &name) < 0)
+	    goto done;
+	if (yang_keyword_get(y0) == Y_SPEC){ /* top-node */
+	    if (prefix == NULL){
+		cprintf(cberr, "api-path element '%s', expected prefix:name", nodeid);
+		if (xerr &&
+		    netconf_invalid_value_xml(xerr, "application", cbuf_get(cberr)) < 0)
+		    goto done;
+		goto fail;
+	    }
+	    if ((ymod = yang_find_module_by_name(y0, prefix)) == NULL){
+		cprintf(cberr, "No such yang module prefix");
+		if (xerr &&
+		    netconf_unknown_element_xml(xerr, "application", prefix, cbuf_get(cberr)) < 0)
+		    goto done;
+		goto fail;
+	    }
+	    namespace = yang_find_mynamespace(ymod);
+	    y0 = ymod;
+	}
+	else if (prefix){ /* change namespace */
+	    if ((ymod = yang_find_module_by_name(yspec, prefix)) == NULL){
+		cprintf(cberr, "api-path element prefix: '%s', no such yang module", prefix);
+		if (xerr &&
+		    netconf_invalid_value_xml(xerr, "application", cbuf_get(cberr)) < 0)
+		    goto done;
+		goto fail;
+	    }
+	    namespace = yang_find_mynamespace(ymod);
+	}
+	if ((y = yang_find_datanode(y0, name)) == NULL){
+	    if (xerr &&
+		netconf_unknown_element_xml(xerr, "application", name, "Unknown element") < 0)
+		goto done;
+	    goto fail;
+	}
+	/* Get XML/xpath prefix given namespace, note different from api-path prefix */
+	if (xml_nsctx_get_prefix(nsc, namespace, &xprefix) == 0){
+	    xprefix = yang_find_myprefix(y);
+	    if (xml_nsctx_add(nsc, xprefix, namespace) < 0)
+		goto done;
+	}
+	if ((cp = malloc(sizeof(*cp))) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    goto done;
+	}
+	memset(cp, 0, sizeof(*cp));
+	ADDQ(cp, cplist);
+	cp->cp_yang = y;
+	cp->cp_id = name;
+	name = NULL;
+	if (xprefix && (cp->cp_prefix = strdup(xprefix)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    goto done;
+	}
+	switch (yang_keyword_get(y)){
+	case Y_LIST:
+	    cvk = yang_cvec_get(y); /* Use Y_LIST cache, see ys_populate_list() */
+	    if (restval == NULL){
+		cprintf(cberr, "malformed key =%s, expected '=restval'", nodeid);
+		if (xerr &&
+		    netconf_malformed_message_xml(xerr, cbuf_get(cberr)) < 0)
+		    goto done;
+		goto fail;
+	    }
+	    /* Transform restval "a,b,c" to "a" "b" "c" (nvalvec=3) */
+	    if ((valvec = clicon_strsep(restval, ",", &nvalvec)) == NULL)
+		goto done;
+	    if (nvalvec != cvec_len(cvk)){
+		cprintf(cberr, "List key %s length mismatch", cp->cp_id);
+		if (xerr &&
+		    netconf_malformed_message_xml(xerr, cbuf_get(cberr)) < 0)
+		    goto done;
+		goto fail;
+	    }
+	    /* Empty value selects all entries, as api_path2xpath */
+	    if (strlen(restval) && (cp->cp_cvk = cvec_new(0)) == NULL){
+		clicon_err(OE_UNIX, errno, "cvec_new");
+		goto done;
+	    }
+	    vi = 0;
+	    cvi = NULL;
+	    while ((cvi = cvec_each(cvk, cvi)) != NULL){
+		keyname = cv_string_get(cvi);
+		if (yang_find(y, Y_LEAF, keyname) == NULL){
+		    cprintf(cberr, "List statement \"%s\" has no key leaf \"%s\"",
+			    yang_argument_get(y), keyname);
+		    if (xerr &&
+			netconf_invalid_value_xml(xerr, "application", cbuf_get(cberr)) < 0)
+			goto done;
+		    goto fail;
+		}
+		if (cp->cp_cvk &&
+		    cvec_add_string(cp->cp_cvk, keyname, valvec[vi]) == NULL){
+		    clicon_err(OE_UNIX, errno, "cvec_add_string");
+		    goto done;
+		}
+		vi++;
+	    }
+	    free(valvec);
+	    valvec = NULL;
+	    break;
+	case Y_LEAF_LIST:
+	    if (restval && strlen(restval)){
+		if ((cp->cp_cvk = cvec_new(0)) == NULL){
+		    clicon_err(OE_UNIX, errno, "cvec_new");
+		    goto done;
+		}
+		if (cvec_add_string(cp->cp_cvk, ".", restval) == NULL){
+		    clicon_err(OE_UNIX, errno, "cvec_add_string");
+		    goto done;
+		}
+	    }
+	    break;
+	default: /* eg Y_CONTAINER, Y_LEAF */
+	    break;
+	}
+	if (prefix){
+	    free(prefix);
+	    prefix = NULL;
+	}
+	if (restval){
+	    free(restval);
+	    restval = NULL;
+	}
+	y0 = y;
+    }
+    if (cplistp){
+	*cplistp = cplist;
+	cplist = NULL;
+    }
+    if (nscp){
+	*nscp = nsc;
+	nsc = NULL;
+    }
+    retval = 1;
+ done:
+    clicon_debug(2, "%s retval:%d", __FUNCTION__, retval);
+    if (cberr)
+	cbuf_free(cberr);
+    if (cplist)
+	clixon_path_free(cplist);
+    if (nsc)
+	xml_nsctx_free(nsc);
+    if (vec)
+	free(vec);
+    if (valvec)
+	free(valvec);
+    if (prefix)
+	free(prefix);
+    if (name)
+	free(name);
+    if (restval)
+	free(restval);
+    return retval;
+ fail:
+    retval = 0; /* invalid api-path or XML */
+    goto done;
+}
+
+/*! Translate a compiled clixon-path to xpath
+ * Uses the xml prefixes of the namespace context given by api_path_compile()
+ * @param[in]  cplist   Compiled clixon-path, NULL is root
+ * @param[out] xpathp   xpath (use free() to deallocate)
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see api_path_compile
+ */
+int
+clixon_path2xpath(clixon_path *cplist,
+		  char       **xpathp)
+{
+    int          retval = -1;
+    cbuf        *cb = NULL;
+    clixon_path *cp;
+    cg_var      *cv;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if ((cp = cplist) == NULL)
+	cbuf_append_str(cb, "/");
+    else do {
+	    cbuf_append_str(cb, "/");
+	    if (cp->cp_prefix)
+		cprintf(cb, "%s:", cp->cp_prefix);
+	    cbuf_append_str(cb, cp->cp_id);
+	    cv = NULL;
+	    while (cp->cp_cvk && (cv = cvec_each(cp->cp_cvk, cv)) != NULL){
+		if (strcmp(cv_name_get(cv), ".") == 0)
+		    cprintf(cb, "[.='%s']", cv_string_get(cv));
+		else{
+		    cbuf_append_str(cb, "[");
+		    if (cp->cp_prefix)
+			cprintf(cb, "%s:", cp->cp_prefix);
+		    cprintf(cb, "%s='%s']", cv_name_get(cv), cv_string_get(cv));
+		}
+	    }
+	    cp = NEXTQ(clixon_path *, cp);
+	} while (cp && cp != cplist);
+    if ((*xpathp = strdup(cbuf_get(cb))) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
 /*! Construct an api_path from an XML node (single level not recursive)
  * @param[in]  x     XML node (need to be yang populated)
  * @param[out] cb    api_path, must be initialized
@@ -1617,6 +1922,48 @@ clixon_xml_find_api_path(cxobj        *xt,
     goto done;
 }
 
+/*! Given a compiled clixon-path and an XML tree, return matching xml node vector
+ *
+ * Same as clixon_xml_find_api_path() but without parsing and resolving the path
+ * @param[in]  xt       Top xml-tree where to search
+ * @param[in]  cplist   Compiled clixon-path, see api_path_compile
+ * @param[out] xvec     Vector of xml-trees. Vector must be free():d after use
+ * @param[out] xlen     Returns length of vector in return value
+ * @retval    -1        Error
+ * @retval     0        Non-fatal failure, eg no namespace of yang
+ * @retval     1        OK with found xml nodes in xvec (if any)
+ * @see api_path_compile
+ */
+int
+clixon_xml_find_path(cxobj        *xt,
+		     clixon_path  *cplist,
+		     cxobj      ***xvec,
+		     int          *xlen)
+{
+    int          retval = -1;
+    int          ret;
+    clixon_xvec *xv = NULL;
+
+    if ((ret = clixon_path_search(xt, NULL, cplist, &xv)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+    if (xv == NULL){ /* empty path */
+	*xvec = NULL;
+	*xlen = 0;
+    }
+    else if (clixon_xvec_extract(xv, xvec, xlen) < 0)
+	goto done;
+    retval = 1;
+ done:
+    if (xv)
+	clixon_xvec_free(xv);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Given (instance-id) path and XML tree, return matching xml node vector using stdarg
  *
  * Instance-identifier is a subset of XML XPaths and defined in Yang, used in NACM for 
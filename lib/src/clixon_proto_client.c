@@ -1076,6 +1076,77 @@ clicon_rpc_debug(clicon_handle h,
     return retval;
 }
 
+/*! Get generation counter of a datastore from backend server
+ *
+ * The generation changes whenever the content of the datastore changes, and can be used
+ * to check if cached datastore content is still valid without fetching the content.
+ * @param[in]  h        CLICON handle
+ * @param[in]  db       Name of database
+ * @param[out] gen      Generation counter
+ * @param[out] lastmod  Time of last change (seconds since epoch), if not NULL
+ * @retval     0        OK
+ * @retval    -1        Error and logged to syslog
+ * @see xmldb_generation_get
+ */
+int
+clicon_rpc_datastore_generation(clicon_handle h,
+				char         *db,
+				uint64_t     *gen,
+				time_t       *lastmod)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    cxobj             *xret = NULL;
+    cxobj             *xerr;
+    cxobj             *x;
+    char              *username;
+    uint32_t           session_id;
+    uint64_t           t;
+    int                ret;
+
+    if (session_id_check(h, &session_id) < 0)
+	goto done;
+    username = clicon_username_get(h);
+    if ((msg = clicon_msg_encode(session_id,
+				 "<rpc xmlns=\"%s\" username=\"%s\"><datastore-generation xmlns=\"%s\"><datastore>%s</datastore></datastore-generation></rpc>",
+				 NETCONF_BASE_NAMESPACE,
+				 username?username:"",
+				 CLIXON_LIB_NS,
+				 db)) == NULL)
+	goto done;
+    if (clicon_rpc_msg(h, msg, &xret, NULL) < 0)
+	goto done;
+    if ((xerr = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+	clixon_netconf_error(xerr, "Datastore generation", NULL);
+	goto done;
+    }
+    if ((x = xpath_first(xret, NULL, "rpc-reply/generation")) == NULL){
+	clicon_err(OE_XML, 0, "rpc error: no generation in reply");
+	goto done;
+    }
+    if ((ret = parse_uint64(xml_body(x), gen, NULL)) <= 0){
+	clicon_err(OE_XML, errno, "parse_uint64"); 
+	goto done;
+    }
+    if (lastmod){
+	*lastmod = 0;
+	if ((x = xpath_first(xret, NULL, "rpc-reply/last-modified")) != NULL){
+	    if ((ret = parse_uint64(xml_body(x), &t, NULL)) <= 0){
+		clicon_err(OE_XML, errno, "parse_uint64"); 
+		goto done;
+	    }
+	    *lastmod = (time_t)t;
+	}
+    }
+    retval = 0;
+ done:
+    if (msg)
+	free(msg);
+    if (xret)
+	xml_free(xret);
+    return retval;
+}
+
 /*! Send a hello request to the backend server
  * @param[in] h        CLICON handle
  * @param[in] level    Debug level
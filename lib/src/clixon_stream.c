@@ -65,6 +65,7 @@
 #include <inttypes.h>
 #include <syslog.h>
 #include <sys/time.h>
+#include <netinet/in.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -78,17 +79,25 @@
 #include "clixon_hash.h"
 #include "clixon_handle.h"
 #include "clixon_yang.h"
+#include "clixon_memory.h"
 #include "clixon_xml.h"
 #include "clixon_xml_io.h"
 #include "clixon_options.h"
 #include "clixon_data.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
+#include "clixon_proto.h"
 #include "clixon_stream.h"
 
 /* Go through and timeout subscription timers [s] */
 #define STREAM_TIMER_TIMEOUT_S 5
 
+/* Notification being distributed by stream_notify1 or stream_replay_notify, and its
+ * encoded message shared by all subscribers, see stream_notify_msg
+ */
+static cxobj             *_NOTIFY_XEV = NULL;
+static struct stream_msg *_NOTIFY_MSG = NULL;
+
 /*! Find an event notification stream given name
  * @param[in]  h    Clicon handle
  * @param[in]  name Name of stream
@@ -118,6 +127,8 @@ stream_find(clicon_handle h,
  * @param[in]  description    Description of stream
  * @param[in]  replay_enabled Set if replay possible in stream
  * @param[in]  retention      For replay buffer how much relative to save
+ * The size of the replay buffer is also limited by options CLICON_STREAM_REPLAY_MAX
+ * and CLICON_STREAM_REPLAY_MEMORY
  */
 int
 stream_add(clicon_handle   h,
@@ -147,6 +158,10 @@ stream_add(clicon_handle   h,
     es->es_replay_enabled = replay_enabled;
     if (retention)
 	es->es_retention = *retention;
+    if (clicon_option_exists(h, "CLICON_STREAM_REPLAY_MAX"))
+	es->es_replay_max = clicon_option_int(h, "CLICON_STREAM_REPLAY_MAX");
+    if (clicon_option_exists(h, "CLICON_STREAM_REPLAY_MEMORY"))
+	es->es_replay_maxbytes = clicon_option_int(h, "CLICON_STREAM_REPLAY_MEMORY");
     clicon_stream_append(h, es);
  ok:
     retval = 0;
@@ -154,6 +169,157 @@ stream_add(clicon_handle   h,
     return retval;
 }
 
+/*! Get replay entry given its position in time order
+ * @param[in]  es   Event stream
+ * @param[in]  i    Position, 0 is the oldest entry, must be less than es_replay_len
+ */
+static struct stream_replay *
+stream_replay_i(event_stream_t *es,
+		size_t          i)
+{
+    return &es->es_replay[(es->es_replay_head + i) % es->es_replay_size];
+}
+
+/*! Remove the oldest replay entry
+ * @param[in]  es   Event stream, must have at least one entry
+ */
+static void
+stream_replay_pop(event_stream_t *es)
+{
+    struct stream_replay *r;
+
+    r = stream_replay_i(es, 0);
+    es->es_replay_bytes -= ntohl(r->r_sm->sm_msg->op_len);
+    clixon_mem_add(CLIXON_MEM_STREAM, -(int64_t)ntohl(r->r_sm->sm_msg->op_len), -1);
+    stream_msg_free(r->r_sm);
+    r->r_sm = NULL;
+    es->es_replay_head = (es->es_replay_head + 1) % es->es_replay_size;
+    es->es_replay_len--;
+}
+
+/*! Find position of the oldest replay entry not older than a timestamp
+ * Binary search, entries are ordered by time
+ * @param[in]  es   Event stream
+ * @param[in]  tv   Timestamp
+ * @retval     i    Position, es_replay_len if all entries are older
+ */
+static size_t
+stream_replay_seek(event_stream_t *es,
+		   struct timeval *tv)
+{
+    size_t lo = 0;
+    size_t hi = es->es_replay_len;
+    size_t mid;
+
+    while (lo < hi){
+	mid = lo + (hi - lo)/2;
+	if (timercmp(&stream_replay_i(es, mid)->r_tv, tv, <))
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    return lo;
+}
+
+/*! Free a subscription filter
+ * @param[in]  sf   Stream filter
+ */
+static void
+stream_filter_free(struct stream_filter *sf)
+{
+    if (sf->sf_xpath)
+	free(sf->sf_xpath);
+    if (sf->sf_tree)
+	xpath_tree_free(sf->sf_tree);
+    free(sf);
+}
+
+/*! Find or create a parsed subscription filter of a stream given xpath
+ * Subscriptions with the same xpath share the filter, which is parsed only once.
+ * @param[in]  es    Event stream
+ * @param[in]  xpath Filter selector as xpath
+ * @retval     sf    Stream filter with reference added
+ * @retval     NULL  Error
+ * @see stream_filter_rm
+ */
+static struct stream_filter *
+stream_filter_add(event_stream_t *es,
+		  char           *xpath)
+{
+    struct stream_filter *sf;
+
+    if ((sf = es->es_filters) != NULL)
+	do {
+	    if (strcmp(sf->sf_xpath, xpath) == 0){
+		sf->sf_refcnt++;
+		return sf;
+	    }
+	    sf = NEXTQ(struct stream_filter *, sf);
+	} while (sf && sf != es->es_filters);
+    if ((sf = malloc(sizeof(*sf))) == NULL){
+	clicon_err(OE_CFG, errno, "malloc");
+	return NULL;
+    }
+    memset(sf, 0, sizeof(*sf));
+    if ((sf->sf_xpath = strdup(xpath)) == NULL){
+	clicon_err(OE_CFG, errno, "strdup");
+	free(sf);
+	return NULL;
+    }
+    /* A filter that does not parse never matches, as with xpath_first() */
+    if (xpath_parse(xpath, &sf->sf_tree) < 0)
+	clicon_log(LOG_WARNING, "%s: Invalid filter: %s", __FUNCTION__, xpath);
+    sf->sf_refcnt = 1;
+    ADDQ(sf, es->es_filters);
+    return sf;
+}
+
+/*! Remove reference to a subscription filter, free it if it was the last
+ * @param[in]  es    Event stream
+ * @param[in]  sf    Stream filter
+ */
+static void
+stream_filter_rm(event_stream_t       *es,
+		 struct stream_filter *sf)
+{
+    if (--sf->sf_refcnt > 0)
+	return;
+    DELQ(sf, es->es_filters, struct stream_filter *);
+    stream_filter_free(sf);
+}
+
+/*! Check if notification matches a subscription filter
+ * The filter is evaluated once per notification, and the result is reused by all
+ * subscriptions sharing the filter.
+ * @param[in]  es     Event stream
+ * @param[in]  sf     Stream filter
+ * @param[in]  xevent Notification as xml tree
+ * @retval     1      Match
+ * @retval     0      No match
+ * @retval    -1      Error
+ */
+static int
+stream_filter_match(event_stream_t       *es,
+		    struct stream_filter *sf,
+		    cxobj                *xevent)
+{
+    xp_ctx *xr = NULL;
+
+    if (sf->sf_notify != es->es_notify){
+	sf->sf_notify = es->es_notify;
+	sf->sf_match = 0;
+	if (sf->sf_tree == NULL)
+	    ;
+	else if (xpath_vec_ctx_tree(xevent, NULL, sf->sf_tree, 0, &xr) < 0)
+	    return -1;
+	else if (xr && xr->xc_type == XT_NODESET && xr->xc_size)
+	    sf->sf_match = 1;
+	if (xr)
+	    ctx_free(xr);
+    }
+    return sf->sf_match;
+}
+
 /*! Delete complete notification event stream list (not just single stream)
  * @param[in] h     Clicon handle
  * @param[in] force Force deletion of 
@@ -162,8 +328,8 @@ int
 stream_delete_all(clicon_handle h,
 		  int           force)
 {
-    struct stream_replay *r;
     struct stream_subscription *ss;
+    struct stream_filter *sf;
     event_stream_t       *es;
     event_stream_t       *head = clicon_stream(h);
     
@@ -176,11 +342,15 @@ stream_delete_all(clicon_handle h,
 	    free(es->es_description);
 	while ((ss = es->es_subscription) != NULL)
 	    stream_ss_rm(h, es, ss, force); /* XXX in some cases leaks memory due to DONT clause in stream_ss_rm() */
-	while ((r = es->es_replay) != NULL){
-	    DELQ(r, es->es_replay, struct stream_replay *);
-	    if (r->r_xml)
-		xml_free(r->r_xml);
-	    free(r);
+	while (es->es_replay_len)
+	    stream_replay_pop(es);
+	if (es->es_replay){
+	    clixon_mem_add(CLIXON_MEM_STREAM, -(int64_t)(es->es_replay_size*sizeof(*es->es_replay)), 0);
+	    free(es->es_replay);
+	}
+	while ((sf = es->es_filters) != NULL){
+	    DELQ(sf, es->es_filters, struct stream_filter *);
+	    stream_filter_free(sf);
 	}
 	free(es);
     }
@@ -247,8 +417,6 @@ stream_timer_setup(int   fd,
     event_stream_t              *es;
     struct stream_subscription  *ss;
     struct stream_subscription  *ss1;
-    struct stream_replay        *r;
-    struct stream_replay        *r1;
     
     clicon_debug(2, "%s", __FUNCTION__);
     /* Go thru callbacks and see if any have timed out, if so remove them 
@@ -276,21 +444,11 @@ stream_timer_setup(int   fd,
 			ss = NEXTQ(struct stream_subscription *, ss);
 		} while (ss && ss != es->es_subscription);
   /* 2) Go throughreplay buffer and remove entries with passed retention time */
-	    if (timerisset(&es->es_retention) &&
-		(r = es->es_replay) != NULL){
+	    if (timerisset(&es->es_retention)){
 		timersub(&now, &es->es_retention, &tret);
-		do {
-		    if (timercmp(&r->r_tv, &tret, <)){
-			r1 = NEXTQ(struct stream_replay *, r);
-			DELQ(r, es->es_replay, struct stream_replay *);
-			if (r->r_xml)
-			    xml_free(r->r_xml);
-			free(r);
-			r = r1;
-		    }
-		    else
-			r = NEXTQ(struct stream_replay *, r);
-		} while (r && r!=es->es_replay);
+		while (es->es_replay_len &&
+		       timercmp(&stream_replay_i(es, 0)->r_tv, &tret, <))
+		    stream_replay_pop(es);
 	    }
 	    es = NEXTQ(struct event_stream *, es);
 	} while (es && es != clicon_stream(h));
@@ -363,13 +521,21 @@ stream_ss_add(clicon_handle     h,
 	clicon_err(OE_CFG, errno, "strdup");
 	goto done;
     }
+    if (xpath && strlen(xpath) &&
+	(ss->ss_filter = stream_filter_add(es, xpath)) == NULL)
+	goto done;
     ss->ss_fn     = fn;
     ss->ss_arg    = arg;
     ADDQ(ss, es->es_subscription);
     return ss;
   done:
-    if (ss)
+    if (ss){
+	if (ss->ss_stream)
+	    free(ss->ss_stream);
+	if (ss->ss_xpath)
+	    free(ss->ss_xpath);
 	free(ss);
+    }
     return NULL;
 }
 
@@ -389,6 +555,10 @@ stream_ss_rm(clicon_handle                h,
 {
     clicon_debug(1, "%s", __FUNCTION__);
     DELQ(ss, es->es_subscription, struct stream_subscription *);
+    if (ss->ss_filter){
+	stream_filter_rm(es, ss->ss_filter);
+	ss->ss_filter = NULL;
+    }
     /* Remove from upper layers - close socket etc. */
     (*ss->ss_fn)(h, 1, NULL, ss->ss_arg);
     if (force){
@@ -482,6 +652,88 @@ stream_ss_delete(clicon_handle     h,
     return retval;
 }
 
+/*! Get notification encoded as clicon NOTIFY message, shared by all subscribers
+ *
+ * Called by subscription callbacks (see stream_fn_t). While a notification is
+ * distributed to subscribers, it is encoded only once, on the first call, and the
+ * same message is returned to all callers with its reference count increased.
+ * Outside of distribution the notification is encoded in a message of its own.
+ * @param[in]  xevent  Notification as xml tree, as given to the callback
+ * @retval     sm      Shared message, release with stream_msg_free
+ * @retval     NULL    Error
+ * @code
+ *   struct stream_msg *sm;
+ *   if ((sm = stream_notify_msg(event)) == NULL)
+ *      err;
+ *   clicon_msg_send(s, sm->sm_msg);
+ *   stream_msg_free(sm);
+ * @endcode
+ */
+struct stream_msg *
+stream_notify_msg(cxobj *xevent)
+{
+    struct stream_msg *sm = NULL;
+    cbuf              *cb = NULL;
+
+    if (xevent == _NOTIFY_XEV && _NOTIFY_MSG != NULL){
+	sm = _NOTIFY_MSG;
+	sm->sm_refcnt++;
+	goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if (clicon_xml2cbuf(cb, xevent, 0, 0, -1) < 0)
+	goto done;
+    if ((sm = malloc(sizeof(*sm))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(sm, 0, sizeof(*sm));
+    if ((sm->sm_msg = clicon_msg_encode(0, "%s", cbuf_get(cb))) == NULL){
+	free(sm);
+	sm = NULL;
+	goto done;
+    }
+    sm->sm_refcnt = 1;
+    if (xevent == _NOTIFY_XEV){ /* Keep a reference for next subscriber */
+	_NOTIFY_MSG = sm;
+	sm->sm_refcnt++;
+    }
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return sm;
+}
+
+/*! Release reference of a shared notification message, free it if it was the last
+ * @param[in]  sm   Shared message
+ * @see stream_notify_msg
+ */
+int
+stream_msg_free(struct stream_msg *sm)
+{
+    if (--sm->sm_refcnt > 0)
+	return 0;
+    if (sm->sm_msg)
+	free(sm->sm_msg);
+    free(sm);
+    return 0;
+}
+
+/*! End distribution of a notification, release its shared message
+ */
+static void
+stream_notify_msg_reset(void)
+{
+    if (_NOTIFY_MSG){
+	stream_msg_free(_NOTIFY_MSG);
+	_NOTIFY_MSG = NULL;
+    }
+    _NOTIFY_XEV = NULL;
+}
+
 /*! Stream notify event and distribute to all registered callbacks
  * @param[in]  h       Clicon handle
  * @param[in]  stream  Name of event stream. CLICON is predefined as LOG stream
@@ -489,6 +741,7 @@ stream_ss_delete(clicon_handle     h,
  * @param[in]  event   Notification as xml tree
  * @retval  0  OK
  * @retval -1  Error with clicon_err called
+ * @note Caller should call stream_notify_msg_reset when done with the notification
  * @see stream_notify
  * @see stream_ss_timeout where subscriptions are removed if stoptime<now
  */
@@ -500,8 +753,11 @@ stream_notify1(clicon_handle   h,
 {
     int                         retval = -1;
     struct stream_subscription *ss;
+    int                         ret = 0;
     
     clicon_debug(2, "%s", __FUNCTION__);
+    es->es_notify++; /* Invalidate filter results of previous notification */
+    _NOTIFY_XEV = xevent;
     /* Go thru all subscriptions and find matches */
     if ((ss = es->es_subscription) != NULL)
 	do {
@@ -515,9 +771,16 @@ stream_notify1(clicon_handle   h,
 		ss = ss1;
 	    }
 	    else{  /* xpath match */
-		if (ss->ss_xpath == NULL ||
-		    strlen(ss->ss_xpath)==0 ||
-		    xpath_first(xevent, NULL, "%s", ss->ss_xpath) != NULL)
+		ret = 1;
+		if (ss->ss_filter != NULL &&
+		    (ret = stream_filter_match(es, ss->ss_filter, xevent)) < 0){
+		    /* A failing filter is a non-match for this subscription only */
+		    clicon_debug(1, "%s stream %s filter %s: %s",
+				 __FUNCTION__, es->es_name, ss->ss_xpath, clicon_err_reason);
+		    clicon_err_reset();
+		    ret = 0;
+		}
+		if (ret == 1)
 		    if ((*ss->ss_fn)(h, 0, xevent, ss->ss_arg) < 0)
 			goto done;
 		ss = NEXTQ(struct stream_subscription *, ss);
@@ -595,11 +858,11 @@ stream_notify(clicon_handle h,
     if (es->es_replay_enabled){
 	if (stream_replay_add(es, &tv, xev) < 0)
 	    goto done;
-	xev = NULL; /* xml stored in replay_add and should not be freed */
     }
  ok:
     retval = 0;
   done:
+    stream_notify_msg_reset();
     if (cb)
 	cbuf_free(cb);
     if (xev)
@@ -664,11 +927,11 @@ stream_notify_xml(clicon_handle h,
     if (es->es_replay_enabled){
 	if (stream_replay_add(es, &tv, xev) < 0)
 	    goto done;
-	xev = NULL; /* xml stored in replay_add and should not be freed */
     }
  ok:
     retval = 0;
   done:
+    stream_notify_msg_reset();
     if (cb)
 	cbuf_free(cb);
     if (xev)
@@ -711,42 +974,53 @@ stream_replay_notify(clicon_handle               h,
 {
     int                   retval = -1;
     struct stream_replay *r;
+    size_t                i;
+    cxobj                *xt = NULL;
+    cxobj                *xev;
 
     /* If <startTime> is not present, this is not a replay */
     if (!timerisset(&ss->ss_starttime))
 	goto ok;
     if (!es->es_replay_enabled)
 	goto ok;
-    /* Get replay linked list */
-    if ((r = es->es_replay) == NULL)
-	goto ok;
-    /* First loop to skip until start */
-    do {
-	if (timercmp(&r->r_tv, &ss->ss_starttime, >=))
-	    break;
-	r = NEXTQ(struct stream_replay *, r);
-    } while (r && r!=es->es_replay);
-    if (r == NULL)
-	goto ok; /* No samples to replay */
-    /* Then notify until stop */
-    do {
+    /* Seek start, then notify until stop */
+    for (i = stream_replay_seek(es, &ss->ss_starttime); i < es->es_replay_len; i++){
+	r = stream_replay_i(es, i);
 	if (timerisset(&ss->ss_stoptime) &&
 	    timercmp(&r->r_tv, &ss->ss_stoptime, >))
 	    break;
-	if ((*ss->ss_fn)(h, 0, r->r_xml, ss->ss_arg) < 0)
+	/* Callbacks get the event as XML, and its stored encoding via stream_notify_msg */
+	if (clixon_xml_parse_string(r->r_sm->sm_msg->op_body, YB_NONE, NULL, &xt, NULL) < 0)
+	    goto done;
+	if ((xev = xml_child_i_type(xt, 0, CX_ELMNT)) == NULL)
+	    goto next;
+	_NOTIFY_XEV = xev;
+	_NOTIFY_MSG = r->r_sm;
+	_NOTIFY_MSG->sm_refcnt++;
+	if ((*ss->ss_fn)(h, 0, xev, ss->ss_arg) < 0)
 	    goto done;
-	r = NEXTQ(struct stream_replay *, r);
-    } while (r && r!=es->es_replay);
+	stream_notify_msg_reset();
+    next:
+	xml_free(xt);
+	xt = NULL;
+    }
  ok:
     retval = 0;
  done:
+    stream_notify_msg_reset();
+    if (xt)
+	xml_free(xt);
     return retval;
 }
 
 /*! Add replay sample to stream with timestamp
+ *
+ * The sample is stored encoded in a ring buffer ordered by time, sharing the encoding
+ * sent to subscribers, see stream_notify_msg. The oldest samples are dropped when
+ * the buffer has more than es_replay_max entries or es_replay_maxbytes bytes.
  * @param[in] es   Stream
- * @param[in] tv   Timestamp
- * @param[in] xv   XML
+ * @param[in] tv   Timestamp, not older than previous sample
+ * @param[in] xv   XML, not consumed
  */
 int
 stream_replay_add(event_stream_t *es,
@@ -754,16 +1028,45 @@ stream_replay_add(event_stream_t *es,
 		  cxobj          *xv)
 {
     int                   retval = -1;
-    struct stream_replay *new;
+    struct stream_replay *vec;
+    struct stream_replay *r;
+    struct stream_msg    *sm;
+    size_t                size;
+    size_t                i;
 
-    if ((new = malloc(sizeof *new)) == NULL){
-	clicon_err(OE_UNIX, errno, "malloc");
+    if ((sm = stream_notify_msg(xv)) == NULL)
 	goto done;
+    if (es->es_replay_max && es->es_replay_len >= es->es_replay_max)
+	stream_replay_pop(es);
+    /* Grow ring buffer and make it start at 0 */
+    if (es->es_replay_len == es->es_replay_size){
+	size = es->es_replay_size ? 2*es->es_replay_size : 64;
+	if (es->es_replay_max && size > es->es_replay_max)
+	    size = es->es_replay_max;
+	if ((vec = calloc(size, sizeof(*vec))) == NULL){
+	    clicon_err(OE_UNIX, errno, "calloc");
+	    stream_msg_free(sm);
+	    goto done;
+	}
+	for (i=0; i<es->es_replay_len; i++)
+	    vec[i] = *stream_replay_i(es, i);
+	clixon_mem_add(CLIXON_MEM_STREAM,
+		       (int64_t)((size - es->es_replay_size)*sizeof(*vec)), 0);
+	if (es->es_replay)
+	    free(es->es_replay);
+	es->es_replay = vec;
+	es->es_replay_size = size;
+	es->es_replay_head = 0;
     }
-    memset(new, 0, (sizeof *new));
-    new->r_tv = *tv;
-    new->r_xml = xv;
-    ADDQ(new, es->es_replay);
+    es->es_replay_len++;
+    r = stream_replay_i(es, es->es_replay_len-1);
+    r->r_tv = *tv;
+    r->r_sm = sm;
+    es->es_replay_bytes += ntohl(sm->sm_msg->op_len);
+    clixon_mem_add(CLIXON_MEM_STREAM, ntohl(sm->sm_msg->op_len), 1);
+    while (es->es_replay_maxbytes && es->es_replay_len > 1 &&
+	   es->es_replay_bytes > es->es_replay_maxbytes)
+	stream_replay_pop(es);
     retval = 0;
  done:
     return retval;
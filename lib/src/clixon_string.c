@@ -488,6 +488,8 @@ xml_chardata_encode(char      **escp,
 }
 
 /*! Escape characters according to XML definition and append to cbuf
+ * Runs of characters not needing encoding are copied in one go, only "&<>" are
+ * looked at one by one. CDATA sections are copied unencoded.
  * @param[in]   cb     CLIgen buf
  * @param[in]   str    Not-encoded input string
  * @see xml_chardata_encode for the generic function
@@ -496,48 +498,79 @@ int
 xml_chardata_cbuf_append(cbuf *cb,
 			 char *str)
 {
-    int  retval = -1;
-    int  i;
-    int  cdata; /* when set, skip encoding */
-
-    /* The orignal of this code is in xml_chardata_encode */
-    /* Step: encode and expand str --> enc */
-    /* Same code again, but now actually encode into output buffer */
-    cdata = 0;
-    for (i=0; i<strlen(str); i++){
-	if (cdata){
-	    if (strncmp(&str[i], "]]>", strlen("]]>")) == 0){
-		cdata = 0;
-		cbuf_append(cb, str[i++]);
-		cbuf_append(cb, str[i++]);
+    int     retval = -1;
+    char   *s = str;
+    char   *e;
+    size_t  n;
+
+    while (*s != '\0'){
+	if ((n = strcspn(s, "&<>")) > 0){
+	    if (cbuf_append_buf(cb, s, n) < 0){
+		clicon_err(OE_UNIX, errno, "cbuf_append_buf");
+		goto done;
 	    }
-	    cbuf_append(cb, str[i]);
+	    s += n;
 	}
-	else
-	switch (str[i]){
+	switch (*s){
 	case '&':
 	    cbuf_append_str(cb, "&amp;");
+	    s++;
 	    break;
 	case '<':
-	    if (strncmp(&str[i], "<![CDATA[", strlen("<![CDATA[")) == 0){
-		cbuf_append(cb, str[i]);
-		cdata++;
+	    if (strncmp(s, "<![CDATA[", strlen("<![CDATA[")) == 0){
+		/* Copy until and including "]]>", or rest if not terminated */
+		if ((e = strstr(s+strlen("<![CDATA["), "]]>")) != NULL)
+		    n = e - s + strlen("]]>");
+		else
+		    n = strlen(s);
+		if (cbuf_append_buf(cb, s, n) < 0){
+		    clicon_err(OE_UNIX, errno, "cbuf_append_buf");
+		    goto done;
+		}
+		s += n;
 		break;
 	    }
 	    cbuf_append_str(cb, "&lt;");
+	    s++;
 	    break;
 	case '>':
 	    cbuf_append_str(cb, "&gt;");
+	    s++;
+	    break;
+	default: /* '\0' */
 	    break;
-	default:
-	    cbuf_append(cb, str[i]);
 	}
     }
     retval = 0;
-    // done:
+ done:
     return retval;
 }
 
+/*! Append indentation spaces to a cligen buffer
+ * Same as cprintf(cb, "%*s", n, "") but without format parsing
+ * @param[in]   cb     CLIgen buf
+ * @param[in]   n      Number of spaces
+ * @retval      0      OK
+ * @retval     -1      Error
+ */
+int
+clixon_cbuf_indent(cbuf *cb,
+		   int   n)
+{
+    static char spaces[] = "                                ";
+    int         len;
+
+    while (n > 0){
+	len = n < sizeof(spaces)-1 ? n : sizeof(spaces)-1;
+	if (cbuf_append_buf(cb, spaces, len) < 0){
+	    clicon_err(OE_UNIX, errno, "cbuf_append_buf");
+	    return -1;
+	}
+	n -= len;
+    }
+    return 0;
+}
+
 /*! Split a string into a cligen variable vector using 1st and 2nd delimiter 
  * Split a string first into elements delimited by delim1, then into
  * pairs delimited by delim2.
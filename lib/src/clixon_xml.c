@@ -65,6 +65,7 @@
 #include "clixon_handle.h"
 #include "clixon_log.h"
 #include "clixon_yang.h"
+#include "clixon_memory.h"
 #include "clixon_xml.h"
 #include "clixon_options.h" /* xml_bind_yang */
 #include "clixon_yang_module.h"
@@ -87,6 +88,15 @@
 #define XML_CHILDVEC_SIZE_START_ELMNT 16 
 #define XML_CHILDVEC_SIZE_THRESHOLD 65536
 
+/* Large child vectors are split into chunks so that insert and delete in the middle
+ * do not move all following children, see struct xml_chunkvec.
+ * Convert to chunks when inserting in the middle of a vector of this many children,
+ * and back to a flat vector when the number of children falls below a quarter of it
+ */
+#define XML_CHILDVEC_CHUNK_THRESHOLD 4096
+/* Max number of children in one chunk */
+#define XML_CHILDVEC_CHUNK_SIZE 1024
+
 /* Intention of these macros is to guard against access of type-specific fields 
  * As debug they can contain an assert.
  */
@@ -126,6 +136,34 @@ struct search_index{
 };
 #endif
 
+/* One chunk of children in a chunked child vector */
+struct xml_chunk{
+    int          cc_len;                           /* Number of children in chunk */
+    struct xml  *cc_vec[XML_CHILDVEC_CHUNK_SIZE];  /* Children */
+};
+
+/* Chunked child vector, used instead of x_childvec for large lists
+ * This is a two-level B-tree where the top level is a sorted vector of the
+ * child number of the first child in each chunk:
+ *
+ * cv_start:    0           1024        1536
+ *           +-----------+-----------+-----------+
+ * cv_chunks:|  chunk 0  |  chunk 1  |  chunk 2  |
+ *           +-----------+-----------+-----------+
+ * cc_len:      1024         512          900
+ *
+ * Child i is found by binary search in cv_start. Insert and delete move children
+ * within one chunk and update cv_start of the following chunks, and a full chunk is 
+ * split in two.
+ */
+struct xml_chunkvec{
+    struct xml_chunk **cv_chunks;  /* Vector of chunks */
+    int               *cv_start;   /* Child number of first child in each chunk */
+    int                cv_len;     /* Number of chunks */
+    int                cv_max;     /* Allocated length of cv_chunks and cv_start */
+    int                cv_hint;    /* Last accessed chunk, for sequential access */
+};
+
 /*! xml tree node, with name, type, parent, children, etc 
  * Note that this is a private type not visible from externally, use
  * access functions.
@@ -165,6 +203,8 @@ struct xml{
     char             *x_name;       /* name of node */
     char             *x_prefix;     /* namespace localname N, called prefix */
     uint16_t          x_flags;      /* Flags according to XML_FLAG_* */
+    uint8_t           x_acct;       /* Memory accounting class, see clixon_memory.h */
+    uint32_t          x_msize;      /* Accounted size of this object in bytes */
     struct xml       *x_up;         /* parent node in hierarchy if any */
     int              _x_vector_i;   /* internal use: xml_child_each */
     int              _x_i;          /* internal use for sorting: 
@@ -176,6 +216,7 @@ struct xml{
     struct xml      **x_childvec;   /* vector of children nodes (XXX: use clixon_vec ) */
     int               x_childvec_len;/* Number of children */
     int               x_childvec_max;/* Length of allocated vector */
+    struct xml_chunkvec *x_chunkvec;/* Chunked children, if set x_childvec is not used */
 
 
     cvec             *x_ns_cache;   /* Cached vector of namespaces (set by bind-yang) */
@@ -195,6 +236,8 @@ struct xmlbody{
     char             *xb_name;       /* name of node */
     char             *xb_prefix;     /* namespace localname N, called prefix */
     uint16_t          xb_flags;      /* Flags according to XML_FLAG_* */
+    uint8_t           xb_acct;       /* Memory accounting class, see clixon_memory.h */
+    uint32_t          xb_msize;      /* Accounted size of this object in bytes */
     struct xml       *xb_up;         /* parent node in hierarchy if any */
     int              _xb_vector_i;   /* internal use: xml_child_each */
     int              _xb_i;          /* internal use for sorting: 
@@ -227,6 +270,7 @@ xml_type2str(enum cxobj_type type)
 
 /* Stats */
 uint64_t _stats_nr = 0;
+uint64_t _stats_alloc = 0; /* Total number of created XML objects, never decreases */
 
 /*! Get global statistics about XML objects
  */
@@ -238,16 +282,27 @@ xml_stats_global(uint64_t *nr)
     return 0;
 }
 
+/*! Get total number of XML objects created
+ * The difference of two readings is the number of objects created in between,
+ * regardless of how many were freed.
+ * @param[out] nr  Number of XML objects created since start
+ */
+int
+xml_stats_alloc(uint64_t *nr)
+{
+    if (nr)
+	*nr = _stats_alloc;
+    return 0;
+}
+
 
-/*! Return the alloced memory of a single XML obj 
+/*! Compute the alloced memory of a single XML obj 
  * @param[in]   x    XML object
- * @param[out]  szp  Size of this XML obj
- * @retval      0    OK
+ * @retval      sz   Size of this XML obj
  * (baseline: 96 bytes per object on x86-64)
  */
-static int
-xml_stats_one(cxobj    *x,
-	      size_t   *szp)
+static size_t
+xml_size_one(cxobj *x)
 {
     size_t sz = 0;
 
@@ -259,6 +314,10 @@ xml_stats_one(cxobj    *x,
     case CX_ELMNT:
 	sz += sizeof(struct xml);
 	sz += x->x_childvec_max*sizeof(struct xml*);
+	if (x->x_chunkvec)
+	    sz += sizeof(struct xml_chunkvec) +
+		x->x_chunkvec->cv_max*(sizeof(struct xml_chunk*) + sizeof(int)) +
+		x->x_chunkvec->cv_len*sizeof(struct xml_chunk);
 	if (x->x_ns_cache)
 	    sz += cvec_size(x->x_ns_cache);
 	if (x->x_cv)
@@ -283,12 +342,45 @@ xml_stats_one(cxobj    *x,
     default:
 	break;
     }
+    return sz;
+}
+
+/*! Return the alloced memory of a single XML obj 
+ * @param[in]   x    XML object
+ * @param[out]  szp  Size of this XML obj
+ * @retval      0    OK
+ */
+static int
+xml_stats_one(cxobj    *x,
+	      size_t   *szp)
+{
+    size_t sz;
+
+    sz = xml_size_one(x);
     if (szp)
 	*szp = sz;
     clicon_debug(1, "%s %zu", __FUNCTION__, sz);
     return 0;
 }
 
+/*! Update memory accounting of a single XML obj after it has changed size
+ * Only the difference to the previously accounted size is added to the
+ * accounting class of the object.
+ * @param[in]   x    XML object
+ * @see clixon_mem_add
+ */
+static void
+xml_mem_update(cxobj *x)
+{
+    size_t sz;
+
+    sz = xml_size_one(x);
+    if (sz != x->x_msize){
+	clixon_mem_add(x->x_acct, (int64_t)sz - (int64_t)x->x_msize, 0);
+	x->x_msize = sz;
+    }
+}
+
 #if 0
 /*! Print memory stats of a single object
  */
@@ -401,6 +493,7 @@ xml_name_set(cxobj *xn,
 	    return -1;
 	}
     }
+    xml_mem_update(xn);
     return 0;
 }
 
@@ -434,6 +527,7 @@ xml_prefix_set(cxobj *xn,
 	    return -1;
 	}
     }
+    xml_mem_update(xn);
     return 0;
 }
 
@@ -509,8 +603,9 @@ nscache_set(cxobj *x,
 	if ((x->x_ns_cache = xml_nsctx_init(prefix, namespace)) == NULL)
 	    goto done;
     }
-    else 
-	return xml_nsctx_add(x->x_ns_cache, prefix, namespace);
+    else if (xml_nsctx_add(x->x_ns_cache, prefix, namespace) < 0)
+	goto done;
+    xml_mem_update(x);
     retval = 0;
  done:
     return retval;
@@ -536,6 +631,7 @@ nscache_replace(cxobj *x,
 	x->x_ns_cache = NULL;
     }
     x->x_ns_cache = nsc;
+    xml_mem_update(x);
     retval = 0;
     // done:
     return retval;
@@ -557,6 +653,7 @@ nscache_clear(cxobj *x)
     if (x->x_ns_cache != NULL){
 	xml_nsctx_free(x->x_ns_cache);
 	x->x_ns_cache = NULL;
+	xml_mem_update(x);
     }
     return 0;
 }
@@ -663,6 +760,7 @@ xml_value_set(cxobj *xn,
     else
 	cbuf_reset(xn->x_value_cb);
     cbuf_append_str(xn->x_value_cb, val);
+    xml_mem_update(xn);
     retval = 0;
  done:
     return retval;
@@ -698,6 +796,7 @@ xml_value_append(cxobj *xn,
 	clicon_err(OE_XML, errno, "cprintf");
 	goto done;
     }
+    xml_mem_update(xn);
     retval = 0;
  done:
     return retval;
@@ -731,6 +830,304 @@ xml_type_set(cxobj          *xn,
     return old;
 }
 
+/*! Find chunk of child number i in chunked child vector
+ * @param[in]  cv  Chunked child vector
+ * @param[in]  i   Child number, must be less than number of children
+ * @retval     k   Chunk number
+ */
+static int
+chunkvec_find(struct xml_chunkvec *cv,
+	      int                  i)
+{
+    int k;
+    int low;
+    int upper;
+    int mid;
+
+    /* Sequential access: try last and next chunk first */
+    k = cv->cv_hint;
+    if (k < cv->cv_len && cv->cv_start[k] <= i){
+	if (i < cv->cv_start[k] + cv->cv_chunks[k]->cc_len)
+	    return k;
+	if (k+1 < cv->cv_len &&
+	    i < cv->cv_start[k+1] + cv->cv_chunks[k+1]->cc_len){
+	    cv->cv_hint = k+1;
+	    return k+1;
+	}
+    }
+    low = 0;
+    upper = cv->cv_len - 1;
+    while (low < upper){
+	mid = (low + upper + 1) / 2;
+	if (cv->cv_start[mid] <= i)
+	    low = mid;
+	else
+	    upper = mid - 1;
+    }
+    cv->cv_hint = low;
+    return low;
+}
+
+/*! Insert a new empty chunk at position k in chunked child vector
+ * @param[in]  cv  Chunked child vector
+ * @param[in]  k   Position of new chunk
+ * @param[in]  start Child number of first child of new chunk
+ * @retval     cc  New chunk
+ * @retval     NULL Error
+ */
+static struct xml_chunk *
+chunkvec_chunk_add(struct xml_chunkvec *cv,
+		   int                  k,
+		   int                  start)
+{
+    struct xml_chunk *cc;
+
+    if (cv->cv_len == cv->cv_max){
+	cv->cv_max = cv->cv_max?2*cv->cv_max:16;
+	if ((cv->cv_chunks = realloc(cv->cv_chunks, cv->cv_max*sizeof(struct xml_chunk*))) == NULL ||
+	    (cv->cv_start = realloc(cv->cv_start, cv->cv_max*sizeof(int))) == NULL){
+	    clicon_err(OE_XML, errno, "realloc");
+	    return NULL;
+	}
+    }
+    if ((cc = malloc(sizeof(struct xml_chunk))) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	return NULL;
+    }
+    cc->cc_len = 0;
+    memmove(&cv->cv_chunks[k+1], &cv->cv_chunks[k], (cv->cv_len-k)*sizeof(struct xml_chunk*));
+    memmove(&cv->cv_start[k+1], &cv->cv_start[k], (cv->cv_len-k)*sizeof(int));
+    cv->cv_chunks[k] = cc;
+    cv->cv_start[k] = start;
+    cv->cv_len++;
+    return cc;
+}
+
+/*! Remove chunk k from chunked child vector, children must have been moved
+ */
+static void
+chunkvec_chunk_rm(struct xml_chunkvec *cv,
+		  int                  k)
+{
+    free(cv->cv_chunks[k]);
+    cv->cv_len--;
+    memmove(&cv->cv_chunks[k], &cv->cv_chunks[k+1], (cv->cv_len-k)*sizeof(struct xml_chunk*));
+    memmove(&cv->cv_start[k], &cv->cv_start[k+1], (cv->cv_len-k)*sizeof(int));
+    if (cv->cv_hint >= cv->cv_len)
+	cv->cv_hint = 0;
+}
+
+/*! Free chunked child vector, not the children
+ */
+static void
+chunkvec_free(struct xml_chunkvec *cv)
+{
+    int k;
+
+    for (k=0; k<cv->cv_len; k++)
+	free(cv->cv_chunks[k]);
+    if (cv->cv_chunks)
+	free(cv->cv_chunks);
+    if (cv->cv_start)
+	free(cv->cv_start);
+    free(cv);
+}
+
+/*! Get child i of a chunked or flat child vector, no checks
+ */
+static inline struct xml *
+childvec_i(cxobj *x,
+	   int    i)
+{
+    struct xml_chunkvec *cv;
+    int                  k;
+
+    if ((cv = x->x_chunkvec) == NULL)
+	return x->x_childvec[i];
+    k = chunkvec_find(cv, i);
+    return cv->cv_chunks[k]->cc_vec[i - cv->cv_start[k]];
+}
+
+/*! Convert flat child vector to chunked
+ * Chunks are filled to half so that there is room for inserts
+ * @param[in]  x   XML node
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+childvec_chunk(cxobj *x)
+{
+    int                  retval = -1;
+    struct xml_chunkvec *cv;
+    struct xml_chunk    *cc;
+    int                  i;
+    int                  n;
+
+    if ((cv = calloc(1, sizeof(struct xml_chunkvec))) == NULL){
+	clicon_err(OE_XML, errno, "calloc");
+	goto done;
+    }
+    for (i=0; i<x->x_childvec_len; i+=n){
+	if ((cc = chunkvec_chunk_add(cv, cv->cv_len, i)) == NULL){
+	    chunkvec_free(cv);
+	    goto done;
+	}
+	n = x->x_childvec_len - i;
+	if (n > XML_CHILDVEC_CHUNK_SIZE/2)
+	    n = XML_CHILDVEC_CHUNK_SIZE/2;
+	memcpy(cc->cc_vec, &x->x_childvec[i], n*sizeof(cxobj*));
+	cc->cc_len = n;
+    }
+    if (x->x_childvec)
+	free(x->x_childvec);
+    x->x_childvec = NULL;
+    x->x_childvec_max = 0;
+    x->x_chunkvec = cv;
+    xml_mem_update(x);
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Convert chunked child vector to flat
+ * @param[in]  x   XML node
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+childvec_flat(cxobj *x)
+{
+    struct xml_chunkvec *cv = x->x_chunkvec;
+    struct xml_chunk    *cc;
+    int                  k;
+    int                  i = 0;
+
+    if ((x->x_childvec = malloc((x->x_childvec_len+1)*sizeof(cxobj*))) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	return -1;
+    }
+    x->x_childvec_max = x->x_childvec_len+1;
+    for (k=0; k<cv->cv_len; k++){
+	cc = cv->cv_chunks[k];
+	memcpy(&x->x_childvec[i], cc->cc_vec, cc->cc_len*sizeof(cxobj*));
+	i += cc->cc_len;
+    }
+    chunkvec_free(cv);
+    x->x_chunkvec = NULL;
+    xml_mem_update(x);
+    return 0;
+}
+
+/*! Insert child xc at position i in chunked child vector, before x_childvec_len is incremented
+ * If the chunk is full it is split in two
+ */
+static int
+chunkvec_insert(cxobj *x,
+		cxobj *xc,
+		int    i)
+{
+    struct xml_chunkvec *cv = x->x_chunkvec;
+    struct xml_chunk    *cc;
+    struct xml_chunk    *cn;
+    int                  k;
+    int                  j;
+    int                  half;
+
+    if (i == x->x_childvec_len) /* append */
+	k = cv->cv_len - 1;
+    else
+	k = chunkvec_find(cv, i);
+    cc = cv->cv_chunks[k];
+    if (cc->cc_len == XML_CHILDVEC_CHUNK_SIZE){
+	/* Split: move upper half to new chunk after k */
+	half = XML_CHILDVEC_CHUNK_SIZE/2;
+	if ((cn = chunkvec_chunk_add(cv, k+1, cv->cv_start[k] + half)) == NULL)
+	    return -1;
+	memcpy(cn->cc_vec, &cc->cc_vec[half], (cc->cc_len-half)*sizeof(cxobj*));
+	cn->cc_len = cc->cc_len - half;
+	cc->cc_len = half;
+	if (i > cv->cv_start[k] + half){
+	    k++;
+	    cc = cn;
+	}
+	xml_mem_update(x);
+    }
+    j = i - cv->cv_start[k];
+    memmove(&cc->cc_vec[j+1], &cc->cc_vec[j], (cc->cc_len-j)*sizeof(cxobj*));
+    cc->cc_vec[j] = xc;
+    cc->cc_len++;
+    for (k++; k<cv->cv_len; k++)
+	cv->cv_start[k]++;
+    return 0;
+}
+
+/*! Remove child at position i from chunked child vector, before x_childvec_len is decremented
+ * Empty chunks are removed and small neighbour chunks merged
+ */
+static void
+chunkvec_rm(cxobj *x,
+	    int    i)
+{
+    struct xml_chunkvec *cv = x->x_chunkvec;
+    struct xml_chunk    *cc;
+    struct xml_chunk    *cn;
+    int                  k;
+    int                  m;
+    int                  j;
+
+    k = chunkvec_find(cv, i);
+    cc = cv->cv_chunks[k];
+    j = i - cv->cv_start[k];
+    cc->cc_len--;
+    memmove(&cc->cc_vec[j], &cc->cc_vec[j+1], (cc->cc_len-j)*sizeof(cxobj*));
+    for (m=k+1; m<cv->cv_len; m++)
+	cv->cv_start[m]--;
+    if (cc->cc_len == 0 && cv->cv_len > 1){
+	chunkvec_chunk_rm(cv, k);
+	if (k == 0)
+	    cv->cv_start[0] = 0;
+	xml_mem_update(x);
+    }
+    else if (k+1 < cv->cv_len &&
+	     cc->cc_len + (cn = cv->cv_chunks[k+1])->cc_len <= XML_CHILDVEC_CHUNK_SIZE/2){
+	memcpy(&cc->cc_vec[cc->cc_len], cn->cc_vec, cn->cc_len*sizeof(cxobj*));
+	cc->cc_len += cn->cc_len;
+	chunkvec_chunk_rm(cv, k+1);
+	xml_mem_update(x);
+    }
+}
+
+/*! Find position of child in parent, using the last known position as hint
+ * The position is searched outwards from the last position the child had in
+ * xml_child_each or when inserted, so that nearby shifts are found fast.
+ * @param[in]  xp   Parent
+ * @param[in]  xc   Child
+ * @retval     i    Position of xc in xp
+ * @retval    -1    Not found
+ */
+static int
+xml_child_pos(cxobj *xp,
+	      cxobj *xc)
+{
+    int n;
+    int h;
+    int d;
+
+    if (!is_element(xp))
+	return -1;
+    n = xp->x_childvec_len;
+    h = xc->_x_vector_i;
+    if (h < 0 || h >= n)
+	h = 0;
+    for (d=0; h-d >= 0 || h+d < n; d++){
+	if (h+d < n && childvec_i(xp, h+d) == xc)
+	    return h+d;
+	if (d && h-d >= 0 && childvec_i(xp, h-d) == xc)
+	    return h-d;
+    }
+    return -1;
+}
+
 /*! Get number of children
  * @param[in]  xn    xml node
  * @retval     number of children in XML tree
@@ -810,7 +1207,7 @@ xml_child_i(cxobj *xn,
     if (!is_element(xn))
 	return NULL;
     if (i < xn->x_childvec_len)
-	return xn->x_childvec[i];
+	return childvec_i(xn, i);
     return NULL;
 }
 
@@ -851,8 +1248,14 @@ xml_child_i_set(cxobj *xt,
 {
     if (!is_element(xt))
 	return NULL;
-    if (i < xt->x_childvec_len)
-	xt->x_childvec[i] = xc;
+    if (i < xt->x_childvec_len){
+	if (xt->x_chunkvec){
+	    int k = chunkvec_find(xt->x_chunkvec, i);
+	    xt->x_chunkvec->cv_chunks[k]->cc_vec[i - xt->x_chunkvec->cv_start[k]] = xc;
+	}
+	else
+	    xt->x_childvec[i] = xc;
+    }
     return 0;
 }
 
@@ -927,7 +1330,7 @@ xml_child_each(cxobj           *xparent,
     if (!is_element(xparent))
 	return NULL;
     for (i=xprev?xprev->_x_vector_i+1:0; i<xparent->x_childvec_len; i++){
-	xn = xparent->x_childvec[i];
+	xn = childvec_i(xparent, i);
 	if (xn == NULL)
 	    continue;
 	if (type != CX_ERROR && xml_type(xn) != type)
@@ -961,6 +1364,13 @@ xml_child_append(cxobj *xp,
      */
     if (xml_type(xc) == CX_ELMNT)
 	start = XML_CHILDVEC_SIZE_START_ELMNT;
+    xc->_x_vector_i = xp->x_childvec_len;
+    if (xp->x_chunkvec){
+	if (chunkvec_insert(xp, xc, xp->x_childvec_len) < 0)
+	    return -1;
+	xp->x_childvec_len++;
+	return 0;
+    }
     xp->x_childvec_len++;
     if (xp->x_childvec_len > xp->x_childvec_max){
 	if (xp->x_childvec_len < XML_CHILDVEC_SIZE_THRESHOLD)
@@ -972,6 +1382,7 @@ xml_child_append(cxobj *xp,
 	    clicon_err(OE_XML, errno, "realloc");
 	    return -1;
 	}
+	xml_mem_update(xp);
     }
     xp->x_childvec[xp->x_childvec_len-1] = xc;
     return 0;
@@ -991,6 +1402,19 @@ xml_child_insert_pos(cxobj *xp,
    
     if (!is_element(xp))
 	return 0;
+    xc->_x_vector_i = i;
+    /* Insert in the middle of large vector: use chunks */
+    if (xp->x_chunkvec == NULL &&
+	xp->x_childvec_len >= XML_CHILDVEC_CHUNK_THRESHOLD &&
+	i < xp->x_childvec_len &&
+	childvec_chunk(xp) < 0)
+	return -1;
+    if (xp->x_chunkvec){
+	if (chunkvec_insert(xp, xc, i) < 0)
+	    return -1;
+	xp->x_childvec_len++;
+	return 0;
+    }
     xp->x_childvec_len++;
     if (xp->x_childvec_len > xp->x_childvec_max){
 	if (xp->x_childvec_len < XML_CHILDVEC_SIZE_THRESHOLD)
@@ -1002,6 +1426,7 @@ xml_child_insert_pos(cxobj *xp,
 	    clicon_err(OE_XML, errno, "realloc");
 	    return -1;
 	}
+	xml_mem_update(xp);
     }
     size = (xml_child_nr(xp) - i - 1)*sizeof(cxobj *);
     memmove(&xp->x_childvec[i+1], &xp->x_childvec[i], size);
@@ -1022,6 +1447,10 @@ xml_childvec_set(cxobj *x,
 {
     if (!is_element(x))
 	return 0;
+    if (x->x_chunkvec){
+	chunkvec_free(x->x_chunkvec);
+	x->x_chunkvec = NULL;
+    }
     x->x_childvec_len = len;
     x->x_childvec_max = len;
     if (x->x_childvec)
@@ -1030,16 +1459,20 @@ xml_childvec_set(cxobj *x,
 	clicon_err(OE_XML, errno, "calloc");
 	return -1;
     }
+    xml_mem_update(x);
     return 0;
 }
 
 /*! Get the children of an XML node as an XML vector
+ * @note If the children are chunked, they are first copied to a flat vector
  */
 cxobj **
 xml_childvec_get(cxobj *x)
 {
     if (!is_element(x))
 	return NULL;
+    if (x->x_chunkvec && childvec_flat(x) < 0)
+	return NULL;
     return x->x_childvec;
 }
 
@@ -1087,8 +1520,12 @@ xml_new(char           *name,
     }
     memset(x, 0, sz);
     xml_type_set(x, type);
+    x->x_acct = clixon_mem_acct_get();
+    clixon_mem_add(x->x_acct, 0, 1);
     if (name && (xml_name_set(x, name)) < 0)
 	return NULL;
+    if (name == NULL)
+	xml_mem_update(x);
     if (xp){
 	xml_parent_set(x, xp);
 	if (xml_child_append(xp, x) < 0) 
@@ -1096,6 +1533,7 @@ xml_new(char           *name,
 	x->_x_i = xml_child_nr(xp)-1;
     }
     _stats_nr++;
+    _stats_alloc++;
     return x;
 }
 
@@ -1190,6 +1628,7 @@ xml_cv_set(cxobj  *x,
     if (x->x_cv)
 	cv_free(x->x_cv);
     x->x_cv = cv;
+    xml_mem_update(x);
     return 0;
 }
 
@@ -1249,12 +1688,8 @@ xml_addsub(cxobj *xp,
     cxobj *xa;
 
     if ((oldp = xml_parent(xc)) != NULL){
-	/* Find child order i in old parent*/
-	for (i=0; i<xml_child_nr(oldp); i++)
-	    if (xml_child_i(oldp, i) == xc)
-		break;
-	/* Remove xc from old parent */
-	if (i < xml_child_nr(oldp))
+	/* Find child order i in old parent and remove xc from old parent */
+	if ((i = xml_child_pos(oldp, xc)) >= 0)
 	    xml_child_rm(oldp, i);
     }
     /* Add xc to new parent */
@@ -1361,12 +1796,8 @@ xml_purge(cxobj *xc)
     cxobj    *xp;
 
     if ((xp = xml_parent(xc)) != NULL){
-	/* Find child order i in parent*/
-	for (i=0; i<xml_child_nr(xp); i++)
-	    if (xml_child_i(xp, i) == xc)
-		break;
-	/* Remove xc from parent */
-	if (i < xml_child_nr(xp))
+	/* Find child order i in parent and remove xc from parent */
+	if ((i = xml_child_pos(xp, xc)) >= 0)
 	    if (xml_child_rm(xp, i) < 0)
 		goto done;
     }
@@ -1400,10 +1831,19 @@ xml_child_rm(cxobj *xp,
 	goto done;
     }
     xml_parent_set(xc, NULL);
-    xp->x_childvec[i] = NULL;
-    xp->x_childvec_len--;
-    if (i<xp->x_childvec_len)
-	memmove(&xp->x_childvec[i], &xp->x_childvec[i+1], (xp->x_childvec_len-i)*sizeof(cxobj*));
+    if (xp->x_chunkvec){
+	chunkvec_rm(xp, i);
+	xp->x_childvec_len--;
+	if (xp->x_childvec_len < XML_CHILDVEC_CHUNK_THRESHOLD/4 &&
+	    childvec_flat(xp) < 0)
+	    goto done;
+    }
+    else {
+	xp->x_childvec[i] = NULL;
+	xp->x_childvec_len--;
+	if (i<xp->x_childvec_len)
+	    memmove(&xp->x_childvec[i], &xp->x_childvec[i+1], (xp->x_childvec_len-i)*sizeof(cxobj*));
+    }
 #ifdef XML_EXPLICIT_INDEX
     if (xml_type(xc) == CX_ELMNT){
 	if (xml_search_index_p(xc))
@@ -1429,19 +1869,12 @@ xml_rm(cxobj *xc)
 {
     int    retval = -1;
     cxobj *xp;
-    cxobj *x;
     int    i;
 
     if ((xp = xml_parent(xc)) == NULL)
 	goto ok;
-    /* Find child in parent XXX: search? */
-    x = NULL; i = 0;
-    while ((x = xml_child_each(xp, x, -1)) != NULL) {
-	if (x == xc)
-	    break;
-	i++;
-    }
-    if (x != NULL)
+    /* Find child in parent */
+    if ((i = xml_child_pos(xp, xc)) >= 0)
 	if (xml_child_rm(xp, i) < 0)
 	    goto done;
  ok:
@@ -1841,7 +2274,13 @@ xml_free(cxobj *x)
 	free(x->x_prefix);
     switch (xml_type(x)){
     case CX_ELMNT:
-	for (i=0; i<x->x_childvec_len; i++){
+	if (x->x_chunkvec){
+	    for (i=0; i<x->x_childvec_len; i++)
+		if ((xc = childvec_i(x, i)) != NULL)
+		    xml_free(xc);
+	    chunkvec_free(x->x_chunkvec);
+	}
+	for (i=0; i<x->x_childvec_len && x->x_childvec; i++){
 	    if ((xc = x->x_childvec[i]) != NULL){
 		xml_free(xc);
 		x->x_childvec[i] = NULL;
@@ -1865,6 +2304,7 @@ xml_free(cxobj *x)
     default:
 	break;
     }
+    clixon_mem_add(x->x_acct, -(int64_t)x->x_msize, -1);
     free(x);
     _stats_nr--;
     return 0;
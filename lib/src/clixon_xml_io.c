@@ -82,6 +82,8 @@
 #define BUFLEN 1024  
 /* Indentation for xml pretty-print. Consider option? */
 #define XML_INDENT 3
+/* Output buffer size before flushing when printing xml to file */
+#define XML_OUTPUT_CHUNK 65536
 /* Name of xml top object created by xml parse functions */
 #define XML_TOP_SYMBOL "top" 
 
@@ -90,34 +92,40 @@
  * XML printing functions. Output a parse tree to file, string cligen buf
  *------------------------------------------------------------------------*/
 
-/*! Print an XML tree structure to an output stream and encode chars "<>&"
+/*! Serialize an XML tree into a cligen buffer and encode chars "<>&"
  *
- * @param[in]   f           UNIX output stream
- * @param[in]   xn          clicon xml tree
- * @param[in]   level       how many spaces to insert before each line
- * @param[in]   prettyprint insert \n and spaces tomake the xml more readable.
- * @param[in]   fn          Callback to make print function
+ * Common code of printing XML to file and to cligen buffer. All output is appended
+ * to one growing buffer, bodies are encoded in place without intermediate strings.
+ * If fn is given, the buffer is flushed to f whenever it exceeds XML_OUTPUT_CHUNK,
+ * so that output of large trees, eg datastores, is written in chunks.
+ * @param[in,out] cb          Cligen buffer to write to
+ * @param[in]     x           Clicon xml tree
+ * @param[in]     level       Indentation level for prettyprint
+ * @param[in]     prettyprint insert \n and spaces tomake the xml more readable.
+ * @param[in]     depth       Limit levels of child resources: -1 is all, 0 is none
+ * @param[in]     f           UNIX output stream, or NULL
+ * @param[in]     fn          Callback to flush cb to f, or NULL for no flushing
  * @see clicon_xml2cbuf
- * One can use clicon_xml2cbuf to get common code, but using fprintf is
- * much faster than using cbuf and then printing that,...
+ * @see clicon_xml2file
  */
-int
-xml2file_recurse(FILE             *f, 
-		 cxobj            *x, 
-		 int               level, 
+static int
+xml2cbuf_recurse(cbuf             *cb,
+		 cxobj            *x,
+		 int               level,
 		 int               prettyprint,
+		 int32_t           depth,
+		 FILE             *f,
 		 clicon_output_cb *fn)
 {
     int    retval = -1;
-    char  *name;
-    char  *namespace;
     cxobj *xc;
+    char  *name;
     int    hasbody;
     int    haselement;
+    char  *namespace;
     char  *val;
-    char  *encstr = NULL; /* xml encoded string */
-    
-    if (x == NULL)
+
+    if (x == NULL || depth == 0)
 	goto ok;
     name = xml_name(x);
     namespace = xml_prefix(x);
@@ -125,29 +133,38 @@ xml2file_recurse(FILE             *f,
     case CX_BODY:
 	if ((val = xml_value(x)) == NULL) /* incomplete tree */
 	    break;
-	if (xml_chardata_encode(&encstr, "%s", val) < 0)
+	if (xml_chardata_cbuf_append(cb, val) < 0)
 	    goto done;
-	(*fn)(f, "%s", encstr);
 	break;
     case CX_ATTR:
-	(*fn)(f, " ");
-	if (namespace)
-	    (*fn)(f, "%s:", namespace);
-	(*fn)(f, "%s=\"%s\"", name, xml_value(x));
+	cbuf_append_str(cb, " ");
+	if (namespace){
+	    cbuf_append_str(cb, namespace);
+	    cbuf_append_str(cb, ":");
+	}
+	cbuf_append_str(cb, name);
+	cbuf_append_str(cb, "=\"");
+	if ((val = xml_value(x)) != NULL)
+	    cbuf_append_str(cb, val);
+	cbuf_append_str(cb, "\"");
 	break;
     case CX_ELMNT:
-	(*fn)(f, "%*s<", prettyprint?(level*XML_INDENT):0, "");
-	if (namespace)
-	    (*fn)(f, "%s:", namespace);
-	(*fn)(f, "%s", name);
+	if (prettyprint && clixon_cbuf_indent(cb, level*XML_INDENT) < 0)
+	    goto done;
+	cbuf_append_str(cb, "<");
+	if (namespace){
+	    cbuf_append_str(cb, namespace);
+	    cbuf_append_str(cb, ":");
+	}
+	cbuf_append_str(cb, name);
 	hasbody = 0;
 	haselement = 0;
 	xc = NULL;
 	/* print attributes only */
-	while ((xc = xml_child_each(x, xc, -1)) != NULL) {
+	while ((xc = xml_child_each(x, xc, -1)) != NULL)
 	    switch (xml_type(xc)){
 	    case CX_ATTR:
-		if (xml2file_recurse(f, xc, level+1, prettyprint, fn) <0)
+		if (xml2cbuf_recurse(cb, xc, level+1, prettyprint, -1, f, fn) < 0)
 		    goto done;
 		break;
 	    case CX_BODY:
@@ -159,31 +176,35 @@ xml2file_recurse(FILE             *f,
 	    default:
 		break;
 	    }
-	}
-	/* Check for special case <a/> instead of <a></a>:
-	 * Ie, no CX_BODY or CX_ELMNT child.
-	 */
-	if (hasbody==0 && haselement==0) 
-	    (*fn)(f, "/>");
+	/* Check for special case <a/> instead of <a></a> */
+	if (hasbody==0 && haselement==0)
+	    cbuf_append_str(cb, "/>");
 	else{
-	    (*fn)(f, ">");
+	    cbuf_append_str(cb, ">");
 	    if (prettyprint && hasbody == 0)
-		    (*fn)(f, "\n");
+		cbuf_append_str(cb, "\n");
 	    xc = NULL;
-	    while ((xc = xml_child_each(x, xc, -1)) != NULL) {
+	    while ((xc = xml_child_each(x, xc, -1)) != NULL)
 		if (xml_type(xc) != CX_ATTR)
-		    if (xml2file_recurse(f, xc, level+1, prettyprint, fn) <0)
+		    if (xml2cbuf_recurse(cb, xc, level+1, prettyprint, depth-1, f, fn) < 0)
 			goto done;
+	    if (prettyprint && hasbody == 0 &&
+		clixon_cbuf_indent(cb, level*XML_INDENT) < 0)
+		goto done;
+	    cbuf_append_str(cb, "</");
+	    if (namespace){
+		cbuf_append_str(cb, namespace);
+		cbuf_append_str(cb, ":");
 	    }
-	    if (prettyprint && hasbody==0)
-		(*fn)(f, "%*s", level*XML_INDENT, "");
-	    (*fn)(f, "</");
-	    if (namespace)
-		(*fn)(f, "%s:", namespace);
-	    (*fn)(f, "%s>", name);
+	    cbuf_append_str(cb, name);
+	    cbuf_append_str(cb, ">");
 	}
 	if (prettyprint)
-	    (*fn)(f, "\n");
+	    cbuf_append_str(cb, "\n");
+	if (fn && cbuf_len(cb) >= XML_OUTPUT_CHUNK){
+	    (*fn)(f, "%s", cbuf_get(cb));
+	    cbuf_reset(cb);
+	}
 	break;
     default:
 	break;
@@ -191,8 +212,42 @@ xml2file_recurse(FILE             *f,
  ok:
     retval = 0;
  done:
-    if (encstr)
-	free(encstr);
+    return retval;
+}
+
+/*! Print an XML tree structure to an output stream and encode chars "<>&"
+ *
+ * @param[in]   f           UNIX output stream
+ * @param[in]   xn          clicon xml tree
+ * @param[in]   level       how many spaces to insert before each line
+ * @param[in]   prettyprint insert \n and spaces tomake the xml more readable.
+ * @param[in]   fn          Callback to make print function
+ * @see clicon_xml2cbuf
+ * The tree is serialized into a buffer which is written to f in chunks of
+ * XML_OUTPUT_CHUNK bytes, which is much faster than one print call per token.
+ */
+static int
+xml2file_recurse(FILE             *f,
+		 cxobj            *x,
+		 int               level,
+		 int               prettyprint,
+		 clicon_output_cb *fn)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new_alloc(XML_OUTPUT_CHUNK + BUFLEN)) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new_alloc");
+	goto done;
+    }
+    if (xml2cbuf_recurse(cb, x, level, prettyprint, -1, f, fn) < 0)
+	goto done;
+    if (cbuf_len(cb))
+	(*fn)(f, "%s", cbuf_get(cb));
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
     return retval;
 }
 
@@ -264,6 +319,7 @@ xml_print(FILE  *f,
  * fprintf(stderr, "%s", cbuf_get(cb));
  * cbuf_free(cb);
  * @endcode
+ * @note The buffer may be reused between calls with cbuf_reset() to avoid reallocation
  * @see  clicon_xml2file
  */
 int
@@ -273,94 +329,7 @@ clicon_xml2cbuf(cbuf   *cb,
 		int     prettyprint,
 		int32_t depth)
 {
-    int    retval = -1;
-    cxobj *xc;
-    char  *name;
-    int    hasbody;
-    int    haselement;
-    char  *namespace;
-    char  *val;
-    
-    if (depth == 0)
-	goto ok;
-    name = xml_name(x);
-    namespace = xml_prefix(x);
-    switch(xml_type(x)){
-    case CX_BODY:
-	if ((val = xml_value(x)) == NULL) /* incomplete tree */
-	    break;
-	if (xml_chardata_cbuf_append(cb, val) < 0)
-	    goto done;
-	break;
-    case CX_ATTR:
-	cbuf_append_str(cb, " ");
-	if (namespace){
-	    cbuf_append_str(cb, namespace);
-	    cbuf_append_str(cb, ":");
-	}
-	cprintf(cb, "%s=\"%s\"", name, xml_value(x));
-	break;
-    case CX_ELMNT:
-	if (prettyprint)
-	    cprintf(cb, "%*s<", level*XML_INDENT, "");
-	else
-	    cbuf_append_str(cb, "<");
-	if (namespace){
-	    cbuf_append_str(cb, namespace);
-	    cbuf_append_str(cb, ":");
-	}
-	cbuf_append_str(cb, name);
-	hasbody = 0;
-	haselement = 0;
-	xc = NULL;
-	/* print attributes only */
-	while ((xc = xml_child_each(x, xc, -1)) != NULL) 
-	    switch (xml_type(xc)){
-	    case CX_ATTR:
-		if (clicon_xml2cbuf(cb, xc, level+1, prettyprint, -1) < 0)
-		    goto done;
-		break;
-	    case CX_BODY:
-		hasbody=1;
-		break;
-	    case CX_ELMNT:
-		haselement=1;
-		break;
-	    default:
-		break;
-	    }
-	/* Check for special case <a/> instead of <a></a> */
-	if (hasbody==0 && haselement==0) 
-	    cbuf_append_str(cb, "/>");
-	else{
-	    cbuf_append_str(cb, ">");
-	    if (prettyprint && hasbody == 0)
-		cbuf_append_str(cb, "\n");
-	    xc = NULL;
-	    while ((xc = xml_child_each(x, xc, -1)) != NULL) 
-		if (xml_type(xc) != CX_ATTR)
-		    if (clicon_xml2cbuf(cb, xc, level+1, prettyprint, depth-1) < 0)
-			goto done;
-	    if (prettyprint && hasbody == 0)
-		cprintf(cb, "%*s", level*XML_INDENT, "");
-	    cbuf_append_str(cb, "</");
-	    if (namespace){
-		cbuf_append_str(cb, namespace);
-		cbuf_append_str(cb, ":");
-	    }
-	    cbuf_append_str(cb, name);
-	    cbuf_append_str(cb, ">");
-	}
-	if (prettyprint)
-	    cbuf_append_str(cb, "\n");
-	break;
-    default:
-	break;
-    }/* switch */
- ok:
-    retval = 0;
- done:
-    return retval;
+    return xml2cbuf_recurse(cb, x, level, prettyprint, depth, NULL, NULL);
 }
 
 /*! Return an xml tree as a pretty-printed malloced string.
@@ -421,6 +421,68 @@ xml_sort(cxobj *x)
     return 0;
 }
 
+/*! Sort children of an XML node where a prefix of the children is already sorted
+ *
+ * Typical use is after appending many new children with xml_addsub() to a sorted
+ * node: the unsorted tail is sorted and then merged with the sorted prefix in one
+ * linear pass. This is O(n + k log k) instead of O(n * k) for inserting k children
+ * one by one with xml_insert() among n.
+ * Equal children keep their order, existing children before appended.
+ * @param[in] x    XML node
+ * @retval   -1    Error
+ * @retval    0    OK
+ * @note Only for children ordered-by system, ordered-by user must use xml_insert
+ * @see xml_sort
+ */
+int
+xml_sort_merge(cxobj *x)
+{
+    int     retval = -1;
+    cxobj **vec;
+    cxobj **pvec = NULL; /* copy of sorted prefix */
+    int     n;
+    int     p;
+    int     i;
+    int     j;
+    int     k;
+
+    if ((n = xml_child_nr(x)) < 2)
+	goto ok;
+    if ((vec = xml_childvec_get(x)) == NULL)
+	goto done;
+    /* Find sorted prefix */
+    for (p=1; p<n; p++)
+	if (xml_cmp(vec[p-1], vec[p], 0, 0, NULL) > 0)
+	    break;
+    if (p == n)
+	goto ok;
+    xml_enumerate_children(x);
+    qsort(&vec[p], n-p, sizeof(cxobj *), xml_cmp_qsort);
+    if (xml_cmp(vec[p-1], vec[p], 0, 0, NULL) <= 0)
+	goto ok;
+    /* Merge prefix and tail, filling vec from the start: k <= j always */
+    if ((pvec = malloc(p*sizeof(cxobj *))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memcpy(pvec, vec, p*sizeof(cxobj *));
+    i = 0; j = p; k = 0;
+    while (i < p && j < n){
+	if (xml_cmp(vec[j], pvec[i], 0, 0, NULL) < 0)
+	    vec[k++] = vec[j++];
+	else
+	    vec[k++] = pvec[i++];
+    }
+    while (i < p)
+	vec[k++] = pvec[i++];
+ ok:
+    retval = 0;
+ done:
+    if (pvec)
+	free(pvec);
+    return retval;
+}
+
 /*! Recursively sort a tree 
  * Alt to use xml_apply
  */
@@ -506,8 +568,7 @@ xml_find_keys_notsorted(cxobj   *xp,
 }
 
 /*! Find more equal objects in a vector up and down in the array of the present
- * @param[in]  childvec  Vector of children of parent
- * @param[in]  childlen  Length of child vector
+ * @param[in]  xp        Parent
  * @param[in]  x1        XML node to match
  * @param[in]  yangi     Yang order number (according to spec)
  * @param[in]  mid       Where to start from (may be in middle of interval)
@@ -516,8 +577,7 @@ xml_find_keys_notsorted(cxobj   *xp,
  * @retval    -1         Error
  */
 static int
-search_multi_equals(cxobj  **childvec,
-		    size_t   childlen,
+search_multi_equals(cxobj   *xp,
 		    cxobj   *x1,
 		    int      yangi,
 		    int      mid,
@@ -530,7 +590,7 @@ search_multi_equals(cxobj  **childvec,
     yang_stmt *yc;
     
     for (i=mid-1; i>=0; i--){ /* First decrement */
-	xc = childvec[i];
+	xc = xml_child_i(xp, i);
 	yc = xml_spec(xc);
 	if (yangi != yang_order(yc)) /* wrong yang */
 	    break;
@@ -539,8 +599,8 @@ search_multi_equals(cxobj  **childvec,
 	if (clixon_xvec_prepend(xvec, xc) < 0)
 	    goto done;
     }
-    for (i=mid+1; i<childlen; i++){ /* Then increment */
-	xc = childvec[i];
+    for (i=mid+1; i<xml_child_nr(xp); i++){ /* Then increment */
+	xc = xml_child_i(xp, i);
 	yc = xml_spec(xc);
 	if (yangi != yang_order(yc)) /* wrong yang */
 	    break;
@@ -764,8 +824,7 @@ xml_search_binary(cxobj   *xp,
 	if (clixon_xvec_append(xvec, xc) < 0)
 	    goto done;
 	/* there may be more? */
-	if (search_multi_equals(xml_childvec_get(xp), xml_child_nr(xp),
-				x1, yangi, mid,	skip1, xvec) < 0)
+	if (search_multi_equals(xp, x1, yangi, mid, skip1, xvec) < 0)
 	    goto done;
     }
     else if (cmp < 0)
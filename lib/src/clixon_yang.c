@@ -74,6 +74,7 @@
 #include "clixon_file.h"
 #include "clixon_yang.h"
 #include "clixon_hash.h"
+#include "clixon_memory.h"
 #include "clixon_xml.h"
 #include "clixon_xml_nsctx.h"
 #include "clixon_yang_module.h"
@@ -235,14 +236,21 @@ yang_argument_get(yang_stmt *ys)
  */
 /*! Set yang argument, not not copied
  * @param[in] ys   Yang statement node
- * @param[in] arg  Argument
+ * @param[in] arg  Argument, malloced, freed by ys_free
  * Typically only done at parsing / initiation
  */
 int
 yang_argument_set(yang_stmt *ys,
 		  char      *arg)
 {
+    int64_t sz = 0;
+
+    if (ys->ys_argument)
+	sz -= strlen(ys->ys_argument) + 1;
     ys->ys_argument = arg; /* not strdup/copied */
+    if (arg)
+	sz += strlen(arg) + 1;
+    clixon_mem_add(CLIXON_MEM_YANG, sz, 0);
     return 0;
 }
 
@@ -414,6 +422,7 @@ yspec_new(void)
     }
     memset(yspec, 0, sizeof(*yspec));
     yspec->ys_keyword = Y_SPEC;
+    clixon_mem_add(CLIXON_MEM_YANG, sizeof(*yspec), 1);
     return yspec;
 }
 
@@ -433,6 +442,7 @@ ys_new(enum rfc_6020 keyw)
     }
     memset(ys, 0, sizeof(*ys));
     ys->ys_keyword    = keyw;
+    clixon_mem_add(CLIXON_MEM_YANG, sizeof(*ys), 1);
     /* The cvec contains stmt-specific variables. Only few stmts need variables so the
        cvec could be lazily created to save some heap and cycles. */
     if ((cvv = cvec_new(0)) == NULL){ 
@@ -456,6 +466,7 @@ ys_free1(yang_stmt *ys,
 	 int        self)
 {
     if (ys->ys_argument){
+	clixon_mem_add(CLIXON_MEM_YANG, -(int64_t)(strlen(ys->ys_argument) + 1), 0);
 	free(ys->ys_argument);
 	ys->ys_argument = NULL;
     }
@@ -475,8 +486,10 @@ ys_free1(yang_stmt *ys,
 	free(ys->ys_when_xpath);
     if (ys->ys_when_nsc)
 	cvec_free(ys->ys_when_nsc);
-    if (self)
+    if (self){
+	clixon_mem_add(CLIXON_MEM_YANG, -(int64_t)sizeof(*ys), -1);
 	free(ys);
+    }
     return 0;
 }
 
@@ -503,6 +516,7 @@ ys_prune(yang_stmt *yp,
 	    &yp->ys_stmt[i+1],
 	    size);
     yp->ys_stmt[yp->ys_len--] = NULL;
+    clixon_mem_add(CLIXON_MEM_YANG, -(int64_t)sizeof(yang_stmt *), 0);
  done:
     return yc;
 }
@@ -522,8 +536,10 @@ ys_free(yang_stmt *ys)
 	if ((yc = ys->ys_stmt[i]) != NULL)
 	    ys_free(yc);
     }
-    if (ys->ys_stmt)
+    if (ys->ys_stmt){
+	clixon_mem_add(CLIXON_MEM_YANG, -(int64_t)(ys->ys_len*sizeof(yang_stmt *)), 0);
 	free(ys->ys_stmt);
+    }
     ys_free1(ys, 1);
     return 0;
 }
@@ -540,8 +556,11 @@ yspec_free(yang_stmt *yspec)
 	if ((ys = yspec->ys_stmt[i]) != NULL)
 	    ys_free(ys);
     }
-    if (yspec->ys_stmt)
+    if (yspec->ys_stmt){
+	clixon_mem_add(CLIXON_MEM_YANG, -(int64_t)(yspec->ys_len*sizeof(yang_stmt *)), 0);
 	free(yspec->ys_stmt);
+    }
+    clixon_mem_add(CLIXON_MEM_YANG, -(int64_t)sizeof(*yspec), -1);
     free(yspec);
     return 0;
 }
@@ -557,6 +576,7 @@ yn_realloc(yang_stmt *yn)
 	return -1;
     }
     yn->ys_stmt[yn->ys_len - 1] = NULL; /* init field */
+    clixon_mem_add(CLIXON_MEM_YANG, sizeof(yang_stmt *), 0);
     return 0;
 }
 
@@ -583,16 +603,20 @@ ys_cp(yang_stmt *ynew,
 
     memcpy(ynew, yold, sizeof(*yold)); 
     ynew->ys_parent = NULL;
-    if (yold->ys_stmt)
+    if (yold->ys_stmt){
 	if ((ynew->ys_stmt = calloc(yold->ys_len, sizeof(yang_stmt *))) == NULL){
 	    clicon_err(OE_YANG, errno, "calloc");
 	    goto done;
 	}
-    if (yold->ys_argument)
+	clixon_mem_add(CLIXON_MEM_YANG, yold->ys_len*sizeof(yang_stmt *), 0);
+    }
+    if (yold->ys_argument){
 	if ((ynew->ys_argument = strdup(yold->ys_argument)) == NULL){
 	    clicon_err(OE_YANG, errno, "strdup");
 	    goto done;
 	}
+	clixon_mem_add(CLIXON_MEM_YANG, strlen(ynew->ys_argument) + 1, 0);
+    }
     if (yold->ys_cv)
 	if ((ynew->ys_cv = cv_dup(yold->ys_cv)) == NULL){
 	    clicon_err(OE_YANG, errno, "cv_dup");
@@ -687,6 +711,7 @@ ys_replace(yang_stmt *yorig,
     while ((yc = yn_each(yorig, yc)) != NULL) 
 	ys_free(yc);
     if (yorig->ys_stmt){
+	clixon_mem_add(CLIXON_MEM_YANG, -(int64_t)(yorig->ys_len*sizeof(yang_stmt *)), 0);
 	free(yorig->ys_stmt);
 	yorig->ys_stmt = NULL;
 	yorig->ys_len = 0;
@@ -2433,6 +2458,7 @@ yang_features(clicon_handle h,
 		    yt->ys_stmt[j-1] = yt->ys_stmt[j];
 		yt->ys_len--;
 		yt->ys_stmt[yt->ys_len] = NULL;
+		clixon_mem_add(CLIXON_MEM_YANG, -(int64_t)sizeof(yang_stmt *), 0);
 		ys_free(ys);
 		continue; /* Don't increment i */
 		break;
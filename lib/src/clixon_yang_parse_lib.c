@@ -88,6 +88,7 @@
 #include "clixon_yang.h"
 #include "clixon_yang_internal.h"
 #include "clixon_hash.h"
+#include "clixon_memory.h"
 #include "clixon_xml.h"
 #include "clixon_xml_nsctx.h"
 #include "clixon_xpath_ctx.h"
@@ -546,6 +547,7 @@ yang_expand_grouping(yang_stmt *yn)
 	    if (glen != 1){
 		size = (yang_len_get(yn) - i - 1)*sizeof(struct yang_stmt *);
 		yn->ys_len += glen - 1;
+		clixon_mem_add(CLIXON_MEM_YANG, ((int64_t)glen - 1)*(int64_t)sizeof(yang_stmt *), 0);
 		if (glen && (yn->ys_stmt = realloc(yn->ys_stmt, (yang_len_get(yn))*sizeof(yang_stmt *))) == 0){
 		    clicon_err(OE_YANG, errno, "realloc");
 		    goto done;
@@ -595,6 +597,7 @@ yang_expand_grouping(yang_stmt *yn)
 	    /* Remove 'uses' node */
 	    ys_free(ys); 
 	    /* Remove the grouping copy */
+	    clixon_mem_add(CLIXON_MEM_YANG, -(int64_t)(ygrouping2->ys_len*sizeof(yang_stmt *)), 0);
 	    ygrouping2->ys_len = 0; /* Cant do with get access function */
 	    ys_free(ygrouping2);
 	    break; /* Note same child is re-iterated since it may be changed */
@@ -789,7 +792,7 @@ filename2revision(const char *filename,
  * @retval    -1        Error 
  * @note for bootstrapping, dir may have to be set.
 */
-static int
+int
 yang_parse_find_match(clicon_handle h, 
 		      const char   *module,
 		      const char   *revision,
@@ -0,0 +1,1139 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Pre-resolved YANG spec snapshots
+ *
+ * Parsing YANG, expanding groupings, augmenting and resolving types dominates the
+ * startup time of short-lived clients such as a netconf subsystem started by sshd.
+ * A snapshot is a binary image of a YANG spec as it is after all post-parse steps
+ * (see yang_parse_post), which is loaded instead of the YANG sources.
+ *
+ * A snapshot is stored in CLICON_YANG_SNAPSHOT_DIR as <name>.yspec where name
+ * identifies the set of modules loaded (eg "backend" or "netconf").
+ * It is valid if:
+ *  - It has the same key: a hash of clixon version, name, options and config file
+ *  - None of its sources have changed: the YANG files of all loaded (sub)modules,
+ *    the YANG directories and plugin files, compared by mtime and size.
+ * Otherwise, YANG is parsed as usual and a new snapshot is written.
+ *
+ * File layout (native byte order, strings are length-prefixed, with a special length
+ * for NULL):
+ *   magic, format version, byte-order mark, key
+ *   nr of sources, <path, mtime, size>*
+ *   nr of nodes, nr of modules, <node>*   (pre-order)
+ * Each node contains keyword, flags, nr of children, argument, cv, cvec, type
+ * cache, when-xpath and when-nsc. Pointers to other nodes (ys_mymodule and the
+ * resolved type of type caches) are stored as pre-order node indexes.
+ * Compiled regexps are not stored, they are computed lazily on validation.
+ * @note Plugin yang extension callbacks are not called when a snapshot is loaded, the
+ *       modifications they made of the YANG spec are stored in the snapshot.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+#include <dirent.h>
+#include <syslog.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/param.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include "clixon_log.h"
+#include "clixon_err.h"
+#include "clixon_string.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_file.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_xml_io.h"
+#include "clixon_options.h"
+#include "clixon_data.h"
+#include "clixon_yang_module.h"
+#include "clixon_plugin.h"
+#include "clixon_sha1.h"
+#include "clixon_yang_parse_lib.h"
+#include "clixon_yang_internal.h" /* internal included by this file only, not API*/
+#include "clixon_yang_snapshot.h"
+
+/*
+ * Constants
+ */
+#define YANG_SNAPSHOT_MAGIC   "CLIXON-YANG-SNAPSHOT"
+#define YANG_SNAPSHOT_VERSION 1
+#define YANG_SNAPSHOT_BOM     0x01020304 /* Byte-order mark */
+#define YANG_SNAPSHOT_NULL    0xffffffff /* Length of NULL string or cvec */
+
+/*
+ * Types
+ */
+/* Map from yang node pointer to pre-order index, sorted on pointer */
+struct snap_ptr{
+    yang_stmt *sp_ys;
+    uint32_t   sp_i;
+};
+
+/* Snapshot file contents and read position */
+struct snap_rd{
+    char      *sr_buf;
+    size_t     sr_len;
+    size_t     sr_i;
+};
+
+/* Nodes read from snapshot and their unresolved pointers as indexes */
+struct snap_nodes{
+    yang_stmt **sn_vec;    /* Pre-order vector of nodes */
+    uint32_t   *sn_mod;    /* ys_mymodule index, or YANG_SNAPSHOT_NULL */
+    uint32_t   *sn_res;    /* yc_resolved index, or YANG_SNAPSHOT_NULL */
+    uint32_t    sn_len;    /* Nr of nodes according to header */
+    uint32_t    sn_i;      /* Nr of nodes read */
+};
+
+/*! Qsort function for option names
+ */
+static int
+snap_strcmp(const void *a,
+	    const void *b)
+{
+    return strcmp(*(char**)a, *(char**)b);
+}
+
+/*! Compute snapshot key from clixon version, snapshot name and config
+ * @param[in]  h    Clicon handle
+ * @param[in]  name Snapshot name
+ * @param[out] key  Sha1 hex string, free with free()
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+snap_key(clicon_handle h,
+	 const char   *name,
+	 char        **key)
+{
+    int            retval = -1;
+    cbuf          *cb = NULL;
+    clicon_hash_t *copt;
+    char         **keys = NULL;
+    size_t         klen;
+    size_t         i;
+    cxobj         *xconf;
+    char          *val;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "%s %s %d\n", CLIXON_VERSION_STRING, name, YANG_SNAPSHOT_VERSION);
+    /* Options may be modified on the command-line, features are only in config tree */
+    copt = clicon_options(h);
+    if (clicon_hash_keys(copt, &keys, &klen) < 0)
+	goto done;
+    if (klen)
+	qsort(keys, klen, sizeof(char*), snap_strcmp);
+    for (i=0; i<klen; i++){
+	val = clicon_option_str(h, keys[i]);
+	cprintf(cb, "%s=%s\n", keys[i], val?val:"");
+    }
+    if ((xconf = clicon_conf_xml(h)) != NULL &&
+	clicon_xml2cbuf(cb, xconf, 0, 0, -1) < 0)
+	goto done;
+    if ((*key = clicon_sha1hex(cbuf_get(cb))) == NULL)
+	goto done;
+    retval = 0;
+ done:
+    if (keys)
+	free(keys);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Add a file or directory to the sources of a snapshot, if it exists
+ * @param[in]  srcs  Sources, path is cv name, duplicates are ignored
+ * @param[in]  path  File or directory
+ */
+static int
+snap_source_add(cvec       *srcs,
+		const char *path)
+{
+    struct stat st;
+
+    if (path == NULL || cvec_find(srcs, (char*)path) != NULL)
+	return 0;
+    if (stat(path, &st) < 0)
+	return 0;
+    if (cvec_add_string(srcs, (char*)path, NULL) < 0){
+	clicon_err(OE_UNIX, errno, "cvec_add_string");
+	return -1;
+    }
+    return 0;
+}
+
+/*! Collect the sources a YANG spec was made from
+ * The sources are the files of all loaded (sub)modules, the main YANG file,
+ * all YANG files in the main directory, the YANG directories themselves (to detect
+ * added or removed files), and plugin files (which may contain extension callbacks)
+ * @param[in]  h     Clicon handle
+ * @param[in]  yspec Yang spec
+ * @param[out] srcs  Sources as cv names
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+snap_sources(clicon_handle h,
+	     yang_stmt    *yspec,
+	     cvec         *srcs)
+{
+    int            retval = -1;
+    cxobj         *x;
+    cxobj         *xc = NULL;
+    char          *dir;
+    struct dirent *dp = NULL;
+    int            ndp;
+    int            i;
+    cbuf          *cb = NULL;
+    yang_stmt     *ym;
+    yang_stmt     *yrev;
+    clixon_plugin *cp = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if ((x = clicon_conf_xml(h)) != NULL)
+	while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+	    if (strcmp(xml_name(xc), "CLICON_YANG_DIR") == 0 &&
+		snap_source_add(srcs, xml_body(xc)) < 0)
+		goto done;
+    if (snap_source_add(srcs, clicon_yang_main_file(h)) < 0)
+	goto done;
+    if ((dir = clicon_yang_main_dir(h)) != NULL){
+	if (snap_source_add(srcs, dir) < 0)
+	    goto done;
+	if ((ndp = clicon_file_dirent(dir, &dp, "(.yang)$", S_IFREG)) < 0)
+	    goto done;
+	for (i=0; i<ndp; i++){
+	    cbuf_reset(cb);
+	    cprintf(cb, "%s/%s", dir, dp[i].d_name);
+	    if (snap_source_add(srcs, cbuf_get(cb)) < 0)
+		goto done;
+	}
+    }
+    /* Same lookup as when the module was loaded, with and without revision */
+    ym = NULL;
+    while ((ym = yn_each(yspec, ym)) != NULL){
+	if ((yrev = yang_find(ym, Y_REVISION, NULL)) != NULL){
+	    cbuf_reset(cb);
+	    if ((i = yang_parse_find_match(h, yang_argument_get(ym), yang_argument_get(yrev),
+					   NULL, cb)) < 0)
+		goto done;
+	    if (i == 1 && snap_source_add(srcs, cbuf_get(cb)) < 0)
+		goto done;
+	}
+	cbuf_reset(cb);
+	if ((i = yang_parse_find_match(h, yang_argument_get(ym), NULL, NULL, cb)) < 0)
+	    goto done;
+	if (i == 1 && snap_source_add(srcs, cbuf_get(cb)) < 0)
+	    goto done;
+    }
+    while ((cp = clixon_plugin_each(h, cp)) != NULL)
+	if (snap_source_add(srcs, cp->cp_name) < 0)
+	    goto done;
+    retval = 0;
+ done:
+    if (dp)
+	free(dp);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Write 32-bit unsigned integer to snapshot file */
+static void
+snap_put_u32(FILE    *f,
+	     uint32_t u)
+{
+    fwrite(&u, sizeof(u), 1, f);
+}
+
+/*! Write 64-bit signed integer to snapshot file */
+static void
+snap_put_i64(FILE   *f,
+	     int64_t i)
+{
+    fwrite(&i, sizeof(i), 1, f);
+}
+
+/*! Write string (or NULL) to snapshot file */
+static void
+snap_put_str(FILE       *f,
+	     const char *str)
+{
+    uint32_t len;
+
+    if (str == NULL)
+	snap_put_u32(f, YANG_SNAPSHOT_NULL);
+    else{
+	len = strlen(str);
+	snap_put_u32(f, len);
+	fwrite(str, 1, len, f);
+    }
+}
+
+/*! Write a cligen variable to snapshot file
+ * The value is written as a string and parsed on load.
+ * @retval     0    OK
+ * @retval    -1    Error, variable cannot be represented
+ */
+static int
+snap_put_cv(FILE   *f,
+	    cg_var *cv)
+{
+    int          retval = -1;
+    enum cv_type type;
+    char        *str = NULL;
+
+    type = cv_type_get(cv);
+    snap_put_u32(f, type);
+    snap_put_str(f, cv_name_get(cv));
+    snap_put_u32(f, cv_flag(cv, (char)0xff));
+    snap_put_u32(f, cv_dec64_n_get(cv));
+    if (type == CGV_VOID && cv_void_get(cv) != NULL){
+	clicon_err(OE_YANG, EINVAL, "Yang snapshot: cannot store void variable %s",
+		   cv_name_get(cv));
+	goto done;
+    }
+    if (type == CGV_VOID || type == CGV_EMPTY || cv_flag(cv, V_UNSET) ||
+	(cv_isstring(type) && cv_string_get(cv) == NULL))
+	snap_put_str(f, NULL);
+    else {
+	if ((str = cv2str_dup(cv)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cv2str_dup");
+	    goto done;
+	}
+	snap_put_str(f, str);
+    }
+    retval = 0;
+ done:
+    if (str)
+	free(str);
+    return retval;
+}
+
+/*! Write a cligen variable vector (or NULL) to snapshot file */
+static int
+snap_put_cvec(FILE *f,
+	      cvec *cvv)
+{
+    cg_var *cv = NULL;
+
+    if (cvv == NULL){
+	snap_put_u32(f, YANG_SNAPSHOT_NULL);
+	return 0;
+    }
+    snap_put_u32(f, cvec_len(cvv));
+    while ((cv = cvec_each(cvv, cv)) != NULL)
+	if (snap_put_cv(f, cv) < 0)
+	    return -1;
+    return 0;
+}
+
+/*! Qsort and bsearch function for node pointer map
+ */
+static int
+snap_ptr_cmp(const void *a,
+	     const void *b)
+{
+    uintptr_t pa = (uintptr_t)((struct snap_ptr*)a)->sp_ys;
+    uintptr_t pb = (uintptr_t)((struct snap_ptr*)b)->sp_ys;
+
+    return pa < pb ? -1 : (pa > pb ? 1 : 0);
+}
+
+/*! Build pointer map of all nodes under (but not including) ys in pre-order
+ * @param[in]     ys   Yang node
+ * @param[in,out] pv   Pointer map, allocated by caller, or NULL to only count
+ * @param[in,out] n    Nr of nodes so far
+ */
+static void
+snap_ptr_build(yang_stmt       *ys,
+	       struct snap_ptr *pv,
+	       uint32_t        *n)
+{
+    int i;
+
+    for (i=0; i<ys->ys_len; i++){
+	if (pv){
+	    pv[*n].sp_ys = ys->ys_stmt[i];
+	    pv[*n].sp_i = *n;
+	}
+	(*n)++;
+	snap_ptr_build(ys->ys_stmt[i], pv, n);
+    }
+}
+
+/*! Write pointer to another node as pre-order index
+ * @retval     0    OK
+ * @retval    -1    Error, node is not in the spec
+ */
+static int
+snap_put_ptr(FILE            *f,
+	     yang_stmt       *ys,
+	     struct snap_ptr *pv,
+	     uint32_t         n)
+{
+    struct snap_ptr  key;
+    struct snap_ptr *sp;
+
+    if (ys == NULL){
+	snap_put_u32(f, YANG_SNAPSHOT_NULL);
+	return 0;
+    }
+    key.sp_ys = ys;
+    if ((sp = bsearch(&key, pv, n, sizeof(*pv), snap_ptr_cmp)) == NULL){
+	clicon_err(OE_YANG, ENOENT, "Yang snapshot: %s %s references node outside spec",
+		   yang_key2str(ys->ys_keyword), ys->ys_argument);
+	return -1;
+    }
+    snap_put_u32(f, sp->sp_i);
+    return 0;
+}
+
+/*! Write a yang node and its children recursively in pre-order to snapshot file
+ */
+static int
+snap_put_node(FILE            *f,
+	      yang_stmt       *ys,
+	      struct snap_ptr *pv,
+	      uint32_t         n)
+{
+    yang_type_cache *yc;
+    int              i;
+
+    snap_put_u32(f, ys->ys_keyword);
+    snap_put_u32(f, ys->ys_flags);
+    snap_put_u32(f, ys->ys_len);
+    snap_put_str(f, ys->ys_argument);
+    if (snap_put_ptr(f, ys->ys_mymodule, pv, n) < 0)
+	return -1;
+    if (ys->ys_cv == NULL)
+	snap_put_u32(f, 0);
+    else{
+	snap_put_u32(f, 1);
+	if (snap_put_cv(f, ys->ys_cv) < 0)
+	    return -1;
+    }
+    if (snap_put_cvec(f, ys->ys_cvec) < 0)
+	return -1;
+    if ((yc = ys->ys_typecache) == NULL)
+	snap_put_u32(f, 0);
+    else{
+	snap_put_u32(f, 1);
+	snap_put_u32(f, yc->yc_options);
+	if (snap_put_ptr(f, yc->yc_resolved, pv, n) < 0)
+	    return -1;
+	snap_put_u32(f, yc->yc_fraction);
+	if (snap_put_cvec(f, yc->yc_cvv) < 0)
+	    return -1;
+	if (snap_put_cvec(f, yc->yc_patterns) < 0)
+	    return -1;
+    }
+    snap_put_str(f, ys->ys_when_xpath);
+    if (snap_put_cvec(f, ys->ys_when_nsc) < 0)
+	return -1;
+    for (i=0; i<ys->ys_len; i++)
+	if (snap_put_node(f, ys->ys_stmt[i], pv, n) < 0)
+	    return -1;
+    return 0;
+}
+
+/*! Write snapshot of yang spec to file
+ * The snapshot is written to a temporary file and then renamed so that concurrently
+ * starting processes never read a partially written file.
+ * @param[in]  h        Clicon handle
+ * @param[in]  filename Snapshot filename
+ * @param[in]  key      Snapshot key
+ * @param[in]  yspec    Yang spec
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+snap_write(clicon_handle h,
+	   const char   *filename,
+	   const char   *key,
+	   yang_stmt    *yspec)
+{
+    int              retval = -1;
+    char             tmpfile[MAXPATHLEN];
+    FILE            *f = NULL;
+    cvec            *srcs = NULL;
+    cg_var          *cv = NULL;
+    struct stat      st;
+    struct snap_ptr *pv = NULL;
+    uint32_t         n = 0;
+    int              i;
+
+    snprintf(tmpfile, MAXPATHLEN-1, "%s.%d", filename, getpid());
+    if ((srcs = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto done;
+    }
+    if (snap_sources(h, yspec, srcs) < 0)
+	goto done;
+    snap_ptr_build(yspec, NULL, &n);
+    if ((pv = calloc(n?n:1, sizeof(*pv))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    n = 0;
+    snap_ptr_build(yspec, pv, &n);
+    qsort(pv, n, sizeof(*pv), snap_ptr_cmp);
+    if ((f = fopen(tmpfile, "w")) == NULL){
+	clicon_err(OE_UNIX, errno, "fopen(%s)", tmpfile);
+	goto done;
+    }
+    /* Header */
+    snap_put_str(f, YANG_SNAPSHOT_MAGIC);
+    snap_put_u32(f, YANG_SNAPSHOT_VERSION);
+    snap_put_u32(f, YANG_SNAPSHOT_BOM);
+    snap_put_str(f, key);
+    /* Sources */
+    snap_put_u32(f, cvec_len(srcs));
+    while ((cv = cvec_each(srcs, cv)) != NULL){
+	if (stat(cv_name_get(cv), &st) < 0){
+	    clicon_err(OE_UNIX, errno, "stat(%s)", cv_name_get(cv));
+	    goto done;
+	}
+	snap_put_str(f, cv_name_get(cv));
+	snap_put_i64(f, st.st_mtime);
+	snap_put_i64(f, st.st_size);
+    }
+    /* Nodes */
+    snap_put_u32(f, n);
+    snap_put_u32(f, yspec->ys_len);
+    for (i=0; i<yspec->ys_len; i++)
+	if (snap_put_node(f, yspec->ys_stmt[i], pv, n) < 0)
+	    goto done;
+    if (ferror(f)){
+	clicon_err(OE_UNIX, errno, "fwrite(%s)", tmpfile);
+	goto done;
+    }
+    if (fclose(f) < 0){
+	f = NULL;
+	clicon_err(OE_UNIX, errno, "fclose(%s)", tmpfile);
+	goto done;
+    }
+    f = NULL;
+    if (rename(tmpfile, filename) < 0){
+	clicon_err(OE_UNIX, errno, "rename(%s)", filename);
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (f)
+	fclose(f);
+    if (retval < 0)
+	unlink(tmpfile);
+    if (pv)
+	free(pv);
+    if (srcs)
+	cvec_free(srcs);
+    return retval;
+}
+
+/*! Read 32-bit unsigned integer from snapshot
+ * @retval     1    OK
+ * @retval     0    Truncated snapshot
+ */
+static int
+snap_get_u32(struct snap_rd *sr,
+	     uint32_t       *u)
+{
+    if (sr->sr_len - sr->sr_i < sizeof(*u))
+	return 0;
+    memcpy(u, sr->sr_buf + sr->sr_i, sizeof(*u));
+    sr->sr_i += sizeof(*u);
+    return 1;
+}
+
+/*! Read 64-bit signed integer from snapshot
+ * @retval     1    OK
+ * @retval     0    Truncated snapshot
+ */
+static int
+snap_get_i64(struct snap_rd *sr,
+	     int64_t        *i)
+{
+    if (sr->sr_len - sr->sr_i < sizeof(*i))
+	return 0;
+    memcpy(i, sr->sr_buf + sr->sr_i, sizeof(*i));
+    sr->sr_i += sizeof(*i);
+    return 1;
+}
+
+/*! Read string from snapshot
+ * @param[out] str  Malloced string or NULL, free with free()
+ * @retval     1    OK
+ * @retval     0    Truncated snapshot
+ * @retval    -1    Error
+ */
+static int
+snap_get_str(struct snap_rd *sr,
+	     char          **str)
+{
+    uint32_t len;
+
+    *str = NULL;
+    if (snap_get_u32(sr, &len) == 0)
+	return 0;
+    if (len == YANG_SNAPSHOT_NULL)
+	return 1;
+    if (sr->sr_len - sr->sr_i < len)
+	return 0;
+    if ((*str = malloc(len+1)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return -1;
+    }
+    memcpy(*str, sr->sr_buf + sr->sr_i, len);
+    (*str)[len] = '\0';
+    sr->sr_i += len;
+    return 1;
+}
+
+/*! Read cligen variable from snapshot
+ * @param[in]  sr   Snapshot
+ * @param[in]  cvv  Add variable to this vector, or NULL
+ * @param[out] cvp  Variable if cvv is NULL, free with cv_free()
+ * @retval     1    OK
+ * @retval     0    Invalid snapshot
+ * @retval    -1    Error
+ */
+static int
+snap_get_cv(struct snap_rd *sr,
+	    cvec           *cvv,
+	    cg_var        **cvp)
+{
+    int      retval = -1;
+    uint32_t type;
+    uint32_t flags;
+    uint32_t n;
+    char    *name = NULL;
+    char    *str = NULL;
+    char    *reason = NULL;
+    cg_var  *cv = NULL;
+    int      ret;
+
+    if (snap_get_u32(sr, &type) == 0)
+	goto fail;
+    if ((ret = snap_get_str(sr, &name)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+    if (snap_get_u32(sr, &flags) == 0 ||
+	snap_get_u32(sr, &n) == 0)
+	goto fail;
+    if ((ret = snap_get_str(sr, &str)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+    if ((cv = cvv ? cvec_add(cvv, type) : cv_new(type)) == NULL){
+	clicon_err(OE_UNIX, errno, "cv_new");
+	goto done;
+    }
+    if (name && cv_name_set(cv, name) == NULL){
+	clicon_err(OE_UNIX, errno, "cv_name_set");
+	goto done;
+    }
+    cv_dec64_n_set(cv, n);
+    if (str){
+	if ((ret = cv_parse1(str, cv, &reason)) < 0){
+	    clicon_err(OE_YANG, errno, "cv_parse1");
+	    goto done;
+	}
+	if (ret == 0){
+	    clicon_debug(1, "%s: %s", __FUNCTION__, reason);
+	    goto fail;
+	}
+    }
+    cv_flag_set(cv, flags);
+    if (cvp){
+	*cvp = cv;
+	cv = NULL;
+    }
+    retval = 1;
+ done:
+    if (cv && cvv == NULL && retval != 1)
+	cv_free(cv);
+    if (name)
+	free(name);
+    if (str)
+	free(str);
+    if (reason)
+	free(reason);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Read cligen variable vector (or NULL) from snapshot
+ * @param[out] cvvp Vector or NULL, free with cvec_free()
+ * @retval     1    OK
+ * @retval     0    Invalid snapshot
+ * @retval    -1    Error
+ */
+static int
+snap_get_cvec(struct snap_rd *sr,
+	      cvec          **cvvp)
+{
+    int      retval = -1;
+    cvec    *cvv = NULL;
+    uint32_t len;
+    uint32_t i;
+    int      ret;
+
+    *cvvp = NULL;
+    if (snap_get_u32(sr, &len) == 0)
+	goto fail;
+    if (len == YANG_SNAPSHOT_NULL)
+	goto ok;
+    if (len > sr->sr_len - sr->sr_i)
+	goto fail;
+    if ((cvv = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto done;
+    }
+    for (i=0; i<len; i++){
+	if ((ret = snap_get_cv(sr, cvv, NULL)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+    }
+    *cvvp = cvv;
+    cvv = NULL;
+ ok:
+    retval = 1;
+ done:
+    if (cvv)
+	cvec_free(cvv);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Read a yang node and its children recursively from snapshot
+ * Pointers to other nodes are stored as indexes in sn and resolved when all
+ * nodes are read.
+ * @param[in]  sr   Snapshot
+ * @param[in]  yp   Parent yang node, node is added as last child
+ * @param[in]  sn   Nodes read so far
+ * @retval     1    OK
+ * @retval     0    Invalid snapshot
+ * @retval    -1    Error
+ */
+static int
+snap_get_node(struct snap_rd    *sr,
+	      yang_stmt         *yp,
+	      struct snap_nodes *sn)
+{
+    int        retval = -1;
+    yang_stmt *ys = NULL;
+    uint32_t   keyword;
+    uint32_t   flags;
+    uint32_t   len;
+    uint32_t   has;
+    uint32_t   options;
+    uint32_t   fraction;
+    uint32_t   idx;
+    uint32_t   i;
+    cvec      *cvv = NULL;
+    cvec      *patterns = NULL;
+    char      *arg = NULL;
+    int        ret;
+
+    if (sn->sn_i >= sn->sn_len)
+	goto fail;
+    if (snap_get_u32(sr, &keyword) == 0 ||
+	snap_get_u32(sr, &flags) == 0 ||
+	snap_get_u32(sr, &len) == 0)
+	goto fail;
+    if ((ys = ys_new(keyword)) == NULL)
+	goto done;
+    if (yn_insert(yp, ys) < 0){
+	ys_free(ys);
+	goto done;
+    }
+    idx = sn->sn_i++;
+    sn->sn_vec[idx] = ys;
+    ys->ys_flags = flags;
+    if ((ret = snap_get_str(sr, &arg)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+    yang_argument_set(ys, arg);
+    if (snap_get_u32(sr, &sn->sn_mod[idx]) == 0)
+	goto fail;
+    if (snap_get_u32(sr, &has) == 0)
+	goto fail;
+    if (has){
+	if ((ret = snap_get_cv(sr, NULL, &ys->ys_cv)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+    }
+    if ((ret = snap_get_cvec(sr, &cvv)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+    yang_cvec_set(ys, cvv);
+    cvv = NULL;
+    if (snap_get_u32(sr, &has) == 0)
+	goto fail;
+    if (has){
+	if (snap_get_u32(sr, &options) == 0 ||
+	    snap_get_u32(sr, &sn->sn_res[idx]) == 0 ||
+	    snap_get_u32(sr, &fraction) == 0)
+	    goto fail;
+	if ((ret = snap_get_cvec(sr, &cvv)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+	if ((ret = snap_get_cvec(sr, &patterns)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+	/* Resolved type is set when all nodes are read */
+	if (yang_type_cache_set(ys, NULL, options, cvv, patterns, fraction) < 0)
+	    goto done;
+    }
+    if ((ret = snap_get_str(sr, &ys->ys_when_xpath)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+    if ((ret = snap_get_cvec(sr, &ys->ys_when_nsc)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+    for (i=0; i<len; i++){
+	if ((ret = snap_get_node(sr, ys, sn)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+    }
+    retval = 1;
+ done:
+    if (cvv)
+	cvec_free(cvv);
+    if (patterns)
+	cvec_free(patterns);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Read snapshot file into memory
+ * @param[in]  filename Snapshot filename
+ * @param[out] sr       Snapshot contents
+ * @retval     1        OK
+ * @retval     0        No snapshot file
+ * @retval    -1        Error
+ */
+static int
+snap_read_file(const char     *filename,
+	       struct snap_rd *sr)
+{
+    int         retval = -1;
+    FILE       *f = NULL;
+    struct stat st;
+
+    if ((f = fopen(filename, "r")) == NULL){
+	retval = 0;
+	goto done;
+    }
+    if (fstat(fileno(f), &st) < 0){
+	clicon_err(OE_UNIX, errno, "fstat(%s)", filename);
+	goto done;
+    }
+    if ((sr->sr_buf = malloc(st.st_size)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    if (fread(sr->sr_buf, 1, st.st_size, f) != st.st_size){
+	clicon_err(OE_UNIX, errno, "fread(%s)", filename);
+	goto done;
+    }
+    sr->sr_len = st.st_size;
+    sr->sr_i = 0;
+    retval = 1;
+ done:
+    if (f)
+	fclose(f);
+    return retval;
+}
+
+/*! Check snapshot header and sources
+ * @param[in]  h    Clicon handle
+ * @param[in]  name Snapshot name
+ * @param[in]  sr   Snapshot
+ * @retval     1    Snapshot is valid, sr points to nodes
+ * @retval     0    Snapshot is invalid or stale
+ * @retval    -1    Error
+ */
+static int
+snap_check(clicon_handle   h,
+	   const char     *name,
+	   struct snap_rd *sr)
+{
+    int         retval = -1;
+    char       *str = NULL;
+    char       *key = NULL;
+    uint32_t    u;
+    uint32_t    nsrc;
+    uint32_t    i;
+    int64_t     mtime;
+    int64_t     size;
+    struct stat st;
+    int         ret;
+
+    if ((ret = snap_get_str(sr, &str)) < 0)
+	goto done;
+    if (ret == 0 || str == NULL || strcmp(str, YANG_SNAPSHOT_MAGIC) != 0)
+	goto fail;
+    if (snap_get_u32(sr, &u) == 0 || u != YANG_SNAPSHOT_VERSION)
+	goto fail;
+    if (snap_get_u32(sr, &u) == 0 || u != YANG_SNAPSHOT_BOM)
+	goto fail;
+    free(str);
+    if ((ret = snap_get_str(sr, &str)) < 0)
+	goto done;
+    if (ret == 0 || str == NULL)
+	goto fail;
+    if (snap_key(h, name, &key) < 0)
+	goto done;
+    if (strcmp(str, key) != 0){
+	clicon_debug(1, "%s: key mismatch", __FUNCTION__);
+	goto fail;
+    }
+    if (snap_get_u32(sr, &nsrc) == 0)
+	goto fail;
+    for (i=0; i<nsrc; i++){
+	free(str);
+	if ((ret = snap_get_str(sr, &str)) < 0)
+	    goto done;
+	if (ret == 0 || str == NULL)
+	    goto fail;
+	if (snap_get_i64(sr, &mtime) == 0 ||
+	    snap_get_i64(sr, &size) == 0)
+	    goto fail;
+	if (stat(str, &st) < 0 ||
+	    st.st_mtime != mtime ||
+	    st.st_size != size){
+	    clicon_debug(1, "%s: %s changed", __FUNCTION__, str);
+	    goto fail;
+	}
+    }
+    retval = 1;
+ done:
+    if (str)
+	free(str);
+    if (key)
+	free(key);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Load yang spec from snapshot, if enabled and valid
+ *
+ * @param[in]  h     Clicon handle
+ * @param[in]  name  Snapshot name, identifies the set of modules loaded, eg "backend"
+ * @param[in]  yspec Yang spec, must be empty
+ * @retval     1     Snapshot loaded into yspec
+ * @retval     0     No valid snapshot, or CLICON_YANG_SNAPSHOT_DIR not set. Load YANG as usual.
+ * @retval    -1    Error
+ * @code
+ *   if ((ret = yang_snapshot_load(h, "backend", yspec)) < 0)
+ *      err;
+ *   if (ret == 0){
+ *      yang_spec_parse_module(h, "example", NULL, yspec);
+ *      yang_snapshot_save(h, "backend", yspec);
+ *   }
+ * @endcode
+ * @see yang_snapshot_save
+ */
+int
+yang_snapshot_load(clicon_handle h,
+		   const char   *name,
+		   yang_stmt    *yspec)
+{
+    int               retval = -1;
+    char             *dir;
+    char              filename[MAXPATHLEN];
+    struct snap_rd    sr = {NULL, 0, 0};
+    struct snap_nodes sn = {NULL, NULL, NULL, 0, 0};
+    yang_stmt        *ysnap = NULL;
+    yang_stmt        *ys;
+    uint32_t          nmod;
+    uint32_t          i;
+    int               ret;
+
+    if ((dir = clicon_option_str(h, "CLICON_YANG_SNAPSHOT_DIR")) == NULL)
+	goto fail;
+    /* A snapshot is a complete spec, it is not merged with loaded modules */
+    if (yang_len_get(yspec) != 0)
+	goto fail;
+    snprintf(filename, MAXPATHLEN-1, "%s/%s.yspec", dir, name);
+    if ((ret = snap_read_file(filename, &sr)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+    if ((ret = snap_check(h, name, &sr)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+    if (snap_get_u32(&sr, &sn.sn_len) == 0 ||
+	snap_get_u32(&sr, &nmod) == 0)
+	goto fail;
+    if (sn.sn_len > sr.sr_len - sr.sr_i)
+	goto fail;
+    if ((sn.sn_vec = calloc(sn.sn_len+1, sizeof(yang_stmt *))) == NULL ||
+	(sn.sn_mod = calloc(sn.sn_len+1, sizeof(uint32_t))) == NULL ||
+	(sn.sn_res = calloc(sn.sn_len+1, sizeof(uint32_t))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    memset(sn.sn_mod, 0xff, (sn.sn_len+1)*sizeof(uint32_t));
+    memset(sn.sn_res, 0xff, (sn.sn_len+1)*sizeof(uint32_t));
+    if ((ysnap = yspec_new()) == NULL)
+	goto done;
+    for (i=0; i<nmod; i++){
+	if ((ret = snap_get_node(&sr, ysnap, &sn)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+    }
+    if (sn.sn_i != sn.sn_len || sr.sr_i != sr.sr_len)
+	goto fail;
+    /* Resolve node indexes to pointers */
+    for (i=0; i<sn.sn_len; i++){
+	ys = sn.sn_vec[i];
+	if (sn.sn_mod[i] != YANG_SNAPSHOT_NULL){
+	    if (sn.sn_mod[i] >= sn.sn_len)
+		goto fail;
+	    ys->ys_mymodule = sn.sn_vec[sn.sn_mod[i]];
+	}
+	if (sn.sn_res[i] != YANG_SNAPSHOT_NULL){
+	    if (sn.sn_res[i] >= sn.sn_len || ys->ys_typecache == NULL)
+		goto fail;
+	    ys->ys_typecache->yc_resolved = sn.sn_vec[sn.sn_res[i]];
+	}
+    }
+    /* Move modules from snapshot spec to yspec */
+    yspec->ys_stmt = ysnap->ys_stmt;
+    yspec->ys_len = ysnap->ys_len;
+    for (i=0; i<yspec->ys_len; i++)
+	yspec->ys_stmt[i]->ys_parent = yspec;
+    ysnap->ys_stmt = NULL;
+    ysnap->ys_len = 0;
+    clicon_debug(1, "%s: loaded %s", __FUNCTION__, filename);
+    retval = 1;
+ done:
+    if (ysnap)
+	yspec_free(ysnap);
+    if (sn.sn_vec)
+	free(sn.sn_vec);
+    if (sn.sn_mod)
+	free(sn.sn_mod);
+    if (sn.sn_res)
+	free(sn.sn_res);
+    if (sr.sr_buf)
+	free(sr.sr_buf);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Save yang spec as snapshot, if enabled
+ *
+ * Call after all YANG modules are loaded. Failure to write the snapshot is not fatal,
+ * it is logged and YANG is parsed again at next startup.
+ * @param[in]  h     Clicon handle
+ * @param[in]  name  Snapshot name, identifies the set of modules loaded, eg "backend"
+ * @param[in]  yspec Yang spec
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see yang_snapshot_load
+ */
+int
+yang_snapshot_save(clicon_handle h,
+		   const char   *name,
+		   yang_stmt    *yspec)
+{
+    int   retval = -1;
+    char *dir;
+    char  filename[MAXPATHLEN];
+    char *key = NULL;
+
+    if ((dir = clicon_option_str(h, "CLICON_YANG_SNAPSHOT_DIR")) == NULL)
+	goto ok;
+    if (snap_key(h, name, &key) < 0)
+	goto done;
+    snprintf(filename, MAXPATHLEN-1, "%s/%s.yspec", dir, name);
+    if (snap_write(h, filename, key, yspec) < 0)
+	clicon_log(LOG_WARNING, "%s: %s: %s", __FUNCTION__, filename, clicon_err_reason);
+    else
+	clicon_debug(1, "%s: wrote %s", __FUNCTION__, filename);
+ ok:
+    retval = 0;
+ done:
+    if (key)
+	free(key);
+    return retval;
+}
@@ -0,0 +1,35 @@
+#!/usr/bin/env bash
+# Library micro-benchmarks, see util/clixon_util_bench.c
+# Run all benchmarks on a small tree and check the CSV output
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+: ${clixon_util_bench:=clixon_util_bench}
+
+# Number of list entries
+: ${perfnr:=100}
+
+new "bench $perfnr entries"
+ret=$($clixon_util_bench -n $perfnr -i 10 -t 100 -Y $IETFRFC)
+r=$?
+if [ $r -ne 0 ]; then
+    err "0" "$r"
+fi
+
+new "bench header"
+expectpart "$ret" 0 "^name,entries,nodes,ops,ns_per_op,xml_allocs_per_op"
+
+for b in xml_parse xml_bind_yang xml_sort xml_insert clixon_xml_find_index xpath_vec xml_diff xml2json_cbuf clicon_xml2cbuf nacm_datanode_read xml_yang_validate_all; do
+    new "bench $b"
+    expectpart "$ret" 0 "$b,$perfnr,[1-9][0-9]*,[1-9][0-9]*,[0-9]*,[0-9.]*"
+done
+
+new "bench single benchmark without header"
+ret=$($clixon_util_bench -n $perfnr -i 1 -H -b xpath_vec)
+if [ "$(echo "$ret" | wc -l)" -ne 1 ]; then
+    err "one line" "$ret"
+fi
+expectpart "$ret" 0 "^xpath_vec,$perfnr,"
+
+rm -rf $dir
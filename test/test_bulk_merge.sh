@@ -0,0 +1,154 @@
+#!/usr/bin/env bash
+# Bulk merge of large edit-config into datastore (XMLDB_BULK_MERGE)
+# Many new list and leaf-list entries are appended and sorted once. Check that:
+# 1. New entries in reverse order interleaved with existing entries end up sorted
+# 2. Key lookups (binary search) work after bulk merge
+# 3. An error in the middle of a bulk merge leaves the datastore sorted
+# 4. copy-config (replace) of a large list
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/bulk.yang
+
+# Number of entries, must be larger than XMLDB_BULK_MERGE
+: ${perfnr:=200}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module bulk{
+   yang-version 1.1;
+   namespace "urn:example:bulk";
+   prefix b;
+   container c {
+      list x {
+         key k;
+         leaf k {
+            type int32;
+         }
+         leaf v {
+            type string;
+         }
+      }
+      leaf-list y {
+         type int32;
+      }
+   }
+}
+EOF
+
+# Expected sorted content of list x and leaf-list y for keys 1..$1
+expected(){
+    n=$1
+    for (( i=1; i<=$n; i++ )); do
+	echo -n "<x><k>$i</k><v>v$i</v></x>"
+    done
+    for (( i=1; i<=$n; i++ )); do
+	echo -n "<y>$i</y>"
+    done
+}
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+# Existing entries: odd keys
+rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:bulk\">"
+for (( i=1; i<=$perfnr; i+=2 )); do
+    rpc+="<x><k>$i</k><v>v$i</v></x><y>$i</y>"
+done
+rpc+="</c></config></edit-config></rpc>]]>]]>"
+
+new "edit-config odd entries"
+expecteof "$clixon_netconf -qf $cfg" 0 "$rpc" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+# New entries: even keys in reverse order, leaf-list and list interleaved
+rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:bulk\">"
+for (( i=$perfnr; i>=1; i-- )); do
+    if [ $((i % 2)) -eq 0 ]; then
+	rpc+="<y>$i</y><x><k>$i</k><v>v$i</v></x>"
+    fi
+done
+rpc+="</c></config></edit-config></rpc>]]>]]>"
+
+new "edit-config even entries in reverse order"
+expecteof "$clixon_netconf -qf $cfg" 0 "$rpc" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "get-config sorted"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:bulk\">$(expected $perfnr)</c></data></rpc-reply>]]>]]>$"
+
+new "get-config key lookup of new entry"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/b:c/b:x[b:k='42']\" xmlns:b=\"urn:example:bulk\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:bulk\"><x><k>42</k><v>v42</v></x></c></data></rpc-reply>]]>]]>$"
+
+new "validate"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+# Error in the middle: new entries with an existing entry created
+rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:bulk\">"
+for (( i=$perfnr+$perfnr; i>$perfnr; i-- )); do
+    rpc+="<x><k>$i</k><v>v$i</v></x>"
+done
+rpc+="<x nc:operation=\"create\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><k>1</k><v>v1</v></x>"
+rpc+="</c></config></edit-config></rpc>]]>]]>"
+
+new "edit-config bulk with error"
+expecteof "$clixon_netconf -qf $cfg" 0 "$rpc" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>data-exists</error-tag>"
+
+new "discard-changes"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+# copy-config of all entries in reverse order
+rpc="<rpc $DEFAULTNS><copy-config><target><candidate/></target><source><config><c xmlns=\"urn:example:bulk\">"
+for (( i=$perfnr; i>=1; i-- )); do
+    rpc+="<x><k>$i</k><v>v$i</v></x><y>$i</y>"
+done
+rpc+="</c></config></source></copy-config></rpc>]]>]]>"
+
+new "copy-config all entries in reverse order"
+expecteof "$clixon_netconf -qf $cfg" 0 "$rpc" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "get-config sorted after copy-config"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:bulk\">$(expected $perfnr)</c></data></rpc-reply>]]>]]>$"
+
+new "commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
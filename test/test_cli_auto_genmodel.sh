@@ -4,6 +4,7 @@
 # Tests:
 # Make a config in CLI. Show output as CLI, save it and ensure it is the same
 # Try the different GENMODEL settings
+# Check the autocli cache (CLICON_CLI_GENMODEL_CACHE_DIR)
 # NOTE this uses the "Old" autocli (eg cli_set()), see test_cli_auto.sh for "new" autocli using the cli_auto_*() API
 
 # Magic line must be first in script (see README.md)
@@ -205,6 +206,35 @@ expectpart "$($clixon_cli -1 -f $cfg show state)" 0 "exstate sender x" "table pa
 new "show state exstate"
 expectpart "$($clixon_cli -1 -f $cfg show state exstate)" 0 "state sender x" --not--  "table parameter a" "table parameter a value x"
 
+# autocli cache
+cachedir=$dir/autocli
+mkdir -p $cachedir
+
+new "show state with empty autocli cache"
+expectpart "$($clixon_cli -1 -o CLICON_CLI_GENMODEL_CACHE_DIR=$cachedir -f $cfg show state)" 0 "exstate sender x" "table parameter a" "table parameter a value x"
+
+new "autocli cache files created"
+nr=$(ls $cachedir/*.cli | wc -l)
+if [ $nr -ne 3 ]; then
+    err 3 "$nr"
+fi
+
+new "show state with populated autocli cache"
+expectpart "$($clixon_cli -1 -o CLICON_CLI_GENMODEL_CACHE_DIR=$cachedir -f $cfg show state)" 0 "exstate sender x" "table parameter a" "table parameter a value x"
+
+new "set b with populated autocli cache"
+expectpart "$($clixon_cli -1 -o CLICON_CLI_GENMODEL_CACHE_DIR=$cachedir -f $cfg set$table parameter b value y)" 0 ""
+
+new "show b"
+expectpart "$($clixon_cli -1 -f $cfg show conf cli)" 0 "table parameter b value y"
+
+new "Other autocli options use other cache files"
+expectpart "$($clixon_cli -1 -o CLICON_CLI_GENMODEL_CACHE_DIR=$cachedir -o CLICON_CLI_GENMODEL_TYPE=ALL -f $cfg show version)" 0 "$version."
+nr=$(ls $cachedir/*.cli | wc -l)
+if [ $nr -ne 6 ]; then
+    err 6 "$nr"
+fi
+
 new "Kill backend"
 # Check if premature kill
 pid=$(pgrep -u root -f clixon_backend)
@@ -0,0 +1,113 @@
+#!/usr/bin/env bash
+# CLI completion cache of datastore content (CLICON_CLI_EXPAND_CACHE) and the
+# datastore-generation RPC used to invalidate it.
+# 1. Check that datastore-generation changes on edit and commit, but not on read
+# 2. Check that cli set/show/delete work with the completion cache enabled
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MODULE_MAIN>clixon-example</CLICON_YANG_MODULE_MAIN>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLISPEC_DIR>/usr/local/lib/$APPNAME/clispec</CLICON_CLISPEC_DIR>
+  <CLICON_CLI_EXPAND_CACHE>true</CLICON_CLI_EXPAND_CACHE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+# Get generation of datastore
+# 1: datastore
+getgen(){
+    db=$1
+    echo "<rpc $DEFAULTNS><datastore-generation xmlns=\"http://clicon.org/lib\"><datastore>$db</datastore></datastore-generation></rpc>]]>]]>" | $clixon_netconf -qf $cfg | sed -n 's/.*<generation xmlns="http:\/\/clicon.org\/lib">\([0-9]*\)<\/generation>.*/\1/p'
+}
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+new "datastore-generation of candidate"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><datastore-generation xmlns=\"http://clicon.org/lib\"><datastore>candidate</datastore></datastore-generation></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><generation xmlns=\"http://clicon.org/lib\">[0-9]*</generation><last-modified xmlns=\"http://clicon.org/lib\">[0-9]*</last-modified></rpc-reply>]]>]]>$"
+
+new "datastore-generation of non-existing datastore"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><datastore-generation xmlns=\"http://clicon.org/lib\"><datastore>xxx</datastore></datastore-generation></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>invalid-value</error-tag><error-severity>error</error-severity><error-message>No such database</error-message></rpc-error></rpc-reply>]]>]]>$"
+
+gen0=$(getgen candidate)
+
+new "get-config does not change generation"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data/></rpc-reply>]]>]]>$"
+gen1=$(getgen candidate)
+if [ "$gen0" != "$gen1" ]; then
+    err "$gen0" "$gen1"
+fi
+
+new "cli set interface"
+expectpart "$($clixon_cli -1 -f $cfg set interfaces interface eth0 type ianaift:ethernetCsmacd)" 0 "^$"
+
+new "edit-config changes candidate generation"
+gen2=$(getgen candidate)
+if [ "$gen1" = "$gen2" ]; then
+    err "not $gen1" "$gen2"
+fi
+
+gen0=$(getgen running)
+
+new "cli commit"
+expectpart "$($clixon_cli -1 -f $cfg commit)" 0 "^$"
+
+new "commit changes running generation"
+gen1=$(getgen running)
+if [ "$gen0" = "$gen1" ]; then
+    err "not $gen0" "$gen1"
+fi
+
+new "cli set second interface"
+expectpart "$($clixon_cli -1 -f $cfg set interfaces interface eth1 type ianaift:ethernetCsmacd)" 0 "^$"
+
+new "cli show configuration"
+expectpart "$($clixon_cli -1 -f $cfg show conf cli)" 0 "^set interfaces interface eth0" "^set interfaces interface eth1"
+
+new "cli delete interface"
+expectpart "$($clixon_cli -1 -f $cfg delete interfaces interface eth1)" 0 "^$"
+
+new "cli show configuration after delete"
+expectpart "$($clixon_cli -1 -f $cfg show conf cli)" 0 "^set interfaces interface eth0" --not-- "eth1"
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
@@ -0,0 +1,113 @@
+#!/usr/bin/env bash
+# Datastore cache eviction, see CLICON_XMLDB_CACHE_MAX and xmldb_cache_evict
+# With a small budget, datastores other than running and candidate are evicted
+# from memory after startup and after each message, and read from file on access.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/evict.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_DATASTORE_CACHE>cache</CLICON_DATASTORE_CACHE>
+  <CLICON_XMLDB_CACHE_MAX>1</CLICON_XMLDB_CACHE_MAX>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module evict{
+   yang-version 1.1;
+   namespace "urn:example:evict";
+   prefix e;
+   container c{
+      leaf a{
+         type string;
+      }
+   }
+}
+EOF
+
+sdb="<c xmlns=\"urn:example:evict\"><a>startup</a></c>"
+echo "<config>$sdb</config>" > $dir/startup_db
+
+# Check memory of a datastore in stats rpc
+# 1: name
+# 2: bytes (regexp)
+checkmem(){
+    new "stats $1 bytes $2"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"/></rpc>]]>]]>" "<memory><name>$1</name><bytes>$2</bytes>"
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+checkmem running "[1-9][0-9]*"
+checkmem candidate "[1-9][0-9]*"
+checkmem startup 0
+checkmem datastore 0
+
+new "get startup generation"
+gen=$(echo "<rpc $DEFAULTNS><datastore-generation xmlns=\"http://clicon.org/lib\"><datastore>startup</datastore></datastore-generation></rpc>]]>]]>" | $clixon_netconf -qf $cfg | sed -n 's/.*<generation[^>]*>\([0-9]*\)<\/generation>.*/\1/p')
+if [ -z "$gen" ]; then
+    err "generation" "$gen"
+fi
+
+new "get-config startup is read from file"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><startup/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$sdb</data></rpc-reply>]]>]]>$"
+
+checkmem startup 0
+
+new "startup generation is kept after reload"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><datastore-generation xmlns=\"http://clicon.org/lib\"><datastore>startup</datastore></datastore-generation></rpc>]]>]]>" "<generation xmlns=\"http://clicon.org/lib\">$gen</generation>"
+
+new "copy-config candidate to startup"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:evict\"><a>new</a></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><copy-config><source><candidate/></source><target><startup/></target></copy-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+checkmem startup 0
+
+new "get-config startup after copy"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><startup/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:evict\"><a>new</a></c></data></rpc-reply>]]>]]>$"
+
+new "candidate is kept"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:evict\"><a>new</a></c></data></rpc-reply>]]>]]>$"
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
@@ -0,0 +1,134 @@
+#!/usr/bin/env bash
+# Lazy read of datastore subtrees, see CLICON_XMLDB_LAZY and xmldb_lazy_load
+# Running is indexed on first access and each top-level subtree is read when an
+# xpath selects it. Writes read the whole datastore.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/lazy.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_DATASTORE_CACHE>cache</CLICON_DATASTORE_CACHE>
+  <CLICON_XMLDB_FORMAT>xml</CLICON_XMLDB_FORMAT>
+  <CLICON_XMLDB_LAZY>true</CLICON_XMLDB_LAZY>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module lazy{
+   yang-version 1.1;
+   namespace "urn:example:lazy";
+   prefix ex;
+   container a{
+      leaf x{
+         type string;
+      }
+   }
+   container b{
+      leaf x{
+         type string;
+      }
+   }
+   list c{
+      key k;
+      leaf k{
+         type string;
+      }
+   }
+}
+EOF
+
+A="<a xmlns=\"urn:example:lazy\"><x>a&gt;1</x></a>"
+B="<b xmlns=\"urn:example:lazy\"><x>b</x></b>"
+C1="<c xmlns=\"urn:example:lazy\"><k>1</k></c>"
+C2="<c xmlns=\"urn:example:lazy\"><k>2</k></c>"
+
+# Top-level elements with comments and > in text, not sorted
+cat <<EOF > $dir/running_db
+<config>
+   <!-- <a> is not here -->
+   $C2
+   $B
+   <c xmlns="urn:example:lazy"><k>1</k></c>
+   <a xmlns='urn:example:lazy'><x>a&gt;1</x></a>
+</config>
+EOF
+
+# Get number of XML objects in running cache from stats rpc
+runningnr(){
+    echo "<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"/></rpc>]]>]]>" | $clixon_netconf -qf $cfg | sed -n 's/.*<datastore><name>running<\/name><nr>\([0-9]*\)<\/nr>.*/\1/p'
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s none -f $cfg"
+    start_backend -s none -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+new "get-config a"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:a\" xmlns:ex=\"urn:example:lazy\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$A</data></rpc-reply>]]>]]>$"
+nr1=$(runningnr)
+
+new "get-config b or c"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:b | /ex:c[ex:k='2']\" xmlns:ex=\"urn:example:lazy\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$B$C2</data></rpc-reply>]]>]]>$"
+nr2=$(runningnr)
+
+new "more subtrees read: $nr1 < $nr2"
+if [ -z "$nr1" ] || [ -z "$nr2" ] || [ $nr1 -ge $nr2 ]; then
+    err "$nr1 < $nr2" "$nr2"
+fi
+
+new "get-config all"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$A$B$C1$C2</data></rpc-reply>]]>]]>$"
+
+new "get-config all again, all subtrees read"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$A$B$C1$C2</data></rpc-reply>]]>]]>$"
+
+new "edit-config candidate"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><a xmlns=\"urn:example:lazy\"><x>new</x></a></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "get-config running after commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:lazy\"><x>new</x></a>$B$C1$C2</data></rpc-reply>]]>]]>$"
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+new "running file has all subtrees"
+expectpart "$(cat $dir/running_db)" 0 "<x>new</x>" "<k>1</k>" "<k>2</k>" "<x>b</x>"
+
+rm -rf $dir
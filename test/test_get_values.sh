@@ -0,0 +1,114 @@
+#!/usr/bin/env bash
+# Server-side value lookups, see the clixon-lib get-values rpc and clixon_client_get_vals
+# 1. Count and body of first match of several xpaths in one request
+# 2. No match gives count 0 and no body
+# 3. Generation in reply changes when running changes
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/values.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module values{
+   yang-version 1.1;
+   namespace "urn:example:values";
+   prefix v;
+   container table{
+      list parameter{
+         key name;
+         leaf name{
+            type string;
+         }
+         leaf value{
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+# Get-values rpc of xpaths in urn:example:values namespace
+# 1..n: xpaths
+getvalues(){
+    rpc="<rpc $DEFAULTNS><get-values xmlns=\"http://clicon.org/lib\"><namespace>urn:example:values</namespace>"
+    for x in "$@"; do
+	rpc+="<xpath>$x</xpath>"
+    done
+    rpc+="</get-values></rpc>]]>]]>"
+    echo "$rpc"
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+new "add parameters"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:values\"><parameter><name>a</name><value>x&lt;y</value></parameter><parameter><name>b</name><value>42</value></parameter></table></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "get-values of several xpaths"
+ret=$(echo "$(getvalues "/table/parameter[name='a']/value" "/table/parameter[name='b']/value" "/table/parameter" "/table/parameter[name='c']/value")" | $clixon_netconf -qf $cfg)
+expectpart "$ret" 0 "<rpc-reply $DEFAULTNS><generation xmlns=\"http://clicon.org/lib\">[0-9]*</generation><value xmlns=\"http://clicon.org/lib\"><count>1</count><body>x&lt;y</body></value><value xmlns=\"http://clicon.org/lib\"><count>1</count><body>42</body></value><value xmlns=\"http://clicon.org/lib\"><count>2</count></value><value xmlns=\"http://clicon.org/lib\"><count>0</count></value></rpc-reply>"
+gen=$(echo "$ret" | sed -n 's/.*<generation[^>]*>\([0-9]*\)<\/generation>.*/\1/p')
+
+new "get-values of unknown datastore"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-values xmlns=\"http://clicon.org/lib\"><datastore>xxx</datastore><xpath>/table</xpath></get-values></rpc>]]>]]>" "<rpc-error><error-type>application</error-type><error-tag>invalid-value</error-tag>"
+
+new "change parameter"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:values\"><parameter><name>b</name><value>43</value></parameter></table></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "get-values changed value and generation"
+ret=$(echo "$(getvalues "/table/parameter[name='b']/value")" | $clixon_netconf -qf $cfg)
+expectpart "$ret" 0 "<value xmlns=\"http://clicon.org/lib\"><count>1</count><body>43</body></value>"
+gen2=$(echo "$ret" | sed -n 's/.*<generation[^>]*>\([0-9]*\)<\/generation>.*/\1/p')
+if [ -z "$gen2" -o "$gen2" = "$gen" ]; then
+    err "generation not $gen" "$gen2"
+fi
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
@@ -0,0 +1,142 @@
+#!/usr/bin/env bash
+# Large lists stored in chunked child vectors (XML_CHILDVEC_CHUNK_THRESHOLD in clixon_xml.c)
+# 1. Create a list larger than the chunk threshold
+# 2. Insert and delete single entries in the middle, which converts to chunks
+# 3. Check order and key lookups
+# 4. Delete most entries, which converts back to a flat vector
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/large.yang
+
+# Number of entries, must be larger than XML_CHILDVEC_CHUNK_THRESHOLD (4096)
+: ${perfnr:=5000}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module large{
+   yang-version 1.1;
+   namespace "urn:example:large";
+   prefix l;
+   container c {
+      list x {
+         key k;
+         leaf k {
+            type int32;
+         }
+      }
+   }
+}
+EOF
+
+# Get a list entry using key lookup
+# 1: key
+getkey(){
+    k=$1
+    new "get-config key $k"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/l:c/l:x[l:k='$k']\" xmlns:l=\"urn:example:large\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:large\"><x><k>$k</k></x></c></data></rpc-reply>]]>]]>$"
+}
+
+# Edit a single list entry
+# 1: key
+# 2: operation
+editkey(){
+    k=$1
+    op=$2
+    new "edit-config $op key $k"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:large\"><x nc:operation=\"$op\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><k>$k</k></x></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+}
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+# Even keys only, so that odd keys can be inserted in the middle
+rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:large\">"
+for (( i=0; i<$perfnr; i++ )); do
+    rpc+="<x><k>$((i*2))</k></x>"
+done
+rpc+="</c></config></edit-config></rpc>]]>]]>"
+
+new "edit-config $perfnr entries"
+expecteof "$clixon_netconf -qf $cfg" 0 "$rpc" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+for k in 1 4001 9999 5001 4003; do
+    editkey $k create
+done
+
+for k in 0 4000 4002 9998; do
+    editkey $k delete
+done
+
+for k in 2 1 4001 4003 5001 9996 9999; do
+    getkey $k
+done
+
+new "get-config deleted key"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/l:c/l:x[l:k='4002']\" xmlns:l=\"urn:example:large\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data/></rpc-reply>]]>]]>$"
+
+new "get-config order around inserted entries"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/l:c/l:x[l:k&gt;3996 and l:k&lt;4008]\" xmlns:l=\"urn:example:large\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:large\"><x><k>3998</k></x><x><k>4001</k></x><x><k>4003</k></x><x><k>4004</k></x><x><k>4006</k></x></c></data></rpc-reply>]]>]]>$"
+
+new "validate"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+# Delete all but a few entries
+rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:large\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\">"
+for (( i=2; i<$perfnr; i++ )); do
+    if [ $((i*2)) -ne 4004 ]; then
+	rpc+="<x nc:operation=\"remove\"><k>$((i*2))</k></x>"
+    fi
+done
+rpc+="</c></config></edit-config></rpc>]]>]]>"
+
+new "edit-config remove most entries"
+expecteof "$clixon_netconf -qf $cfg" 0 "$rpc" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "get-config remaining entries"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:large\"><x><k>1</k></x><x><k>2</k></x><x><k>4001</k></x><x><k>4003</k></x><x><k>4004</k></x><x><k>5001</k></x><x><k>9999</k></x></c></data></rpc-reply>]]>]]>$"
+
+new "commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
@@ -0,0 +1,110 @@
+#!/usr/bin/env bash
+# Backend socket load generator, see util/clixon_util_load.c
+# Several connections send a mix of get, get-config, edit-config, commit and lock
+# and throughput and latency percentiles are reported
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+: ${clixon_util_load:=clixon_util_load}
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/load.yang
+sock=$dir/sock
+
+# Number of requests
+: ${perfreq:=500}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>$sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module load{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+         leaf name{
+            type string;
+         }
+         leaf value{
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+new "load $perfreq requests on 4 connections"
+ret=$($clixon_util_load -s $sock -c 4 -n $perfreq -d 0 -p 64 -k 100)
+r=$?
+if [ $r -ne 0 ]; then
+    err "0" "$r"
+fi
+
+new "load header"
+expectpart "$ret" 0 "^op,count,errors,rps,avg_us,p50_us,p90_us,p99_us,max_us"
+
+for op in get get-config edit-config commit lock unlock; do
+    new "load $op"
+    expectpart "$ret" 0 "$op,[1-9][0-9]*,[0-9]*,[0-9.]*,[0-9]*,[0-9]*,[0-9]*,[0-9]*,[0-9]*"
+done
+
+new "load total includes unlocks"
+count=$(echo "$ret" | sed -n 's/^total,\([0-9]*\),.*/\1/p')
+if [ -z "$count" ] || [ $count -lt $perfreq ]; then
+    err "at least $perfreq" "$count"
+fi
+
+new "load edit-config only, no errors"
+expectpart "$($clixon_util_load -s $sock -c 2 -n 100 -d 0 -m edit-config=1 -H)" 0 "^edit-config,100,0," "total,100,0,"
+
+new "get-config after load"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='0']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>"
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
+
+# unset conditional parameters
+unset clixon_util_load
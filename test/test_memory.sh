@@ -0,0 +1,109 @@
+#!/usr/bin/env bash
+# Memory accounting per subsystem, see clixon_memory.c
+# 1. The stats rpc returns current and peak bytes and objects of each subsystem
+# 2. An edit-config exceeding CLICON_XMLDB_MEMORY_MAX is rejected
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/memory.yang
+
+# Number of list entries in oversized edit
+: ${perfnr:=2000}
+
+# Soft memory limit of a datastore in bytes
+memmax=100000
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_XMLDB_MEMORY_MAX>$memmax</CLICON_XMLDB_MEMORY_MAX>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module memory{
+   yang-version 1.1;
+   namespace "urn:example:memory";
+   prefix m;
+   container c{
+      leaf a{
+         type string;
+      }
+      list x{
+         key k;
+         leaf k{
+            type int32;
+         }
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+ret=$(echo "<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"/></rpc>]]>]]>" | $clixon_netconf -qf $cfg)
+
+for name in other yang running candidate startup datastore nacm stream client; do
+    new "stats has memory of $name"
+    expectpart "$ret" 0 "<memory><name>$name</name><bytes>[0-9]*</bytes><peak-bytes>[0-9]*</peak-bytes><objects>[0-9]*</objects><peak-objects>[0-9]*</peak-objects></memory>"
+done
+
+new "yang memory is accounted"
+expectpart "$ret" 0 "<memory><name>yang</name><bytes>[1-9][0-9]*</bytes><peak-bytes>[1-9][0-9]*</peak-bytes><objects>[1-9][0-9]*</objects>"
+
+new "edit-config within limit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:memory\"><a>small</a></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "candidate memory is accounted"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"/></rpc>]]>]]>" "<memory><name>candidate</name><bytes>[1-9][0-9]*</bytes><peak-bytes>[1-9][0-9]*</peak-bytes><objects>[1-9][0-9]*</objects>"
+
+rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:memory\">"
+for (( i=0; i<$perfnr; i++ )); do
+    rpc+="<x><k>$i</k></x>"
+done
+rpc+="</c></config></edit-config></rpc>]]>]]>"
+
+new "edit-config $perfnr entries exceeds limit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$rpc" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>resource-denied</error-tag><error-severity>error</error-severity><error-message>Datastore candidate memory limit exceeded"
+
+new "candidate unchanged"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:memory\"><a>small</a></c></data></rpc-reply>]]>]]>$"
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
@@ -0,0 +1,168 @@
+#!/usr/bin/env bash
+# Compiled NACM policy cache, see nacm_access_pre
+# The NACM config is compiled once per user and only recompiled when the nacm
+# tree of running changes. Check that:
+# 1. Rules are applied per user (read, write and exec)
+# 2. Commits not changing NACM keep the rules
+# 3. Commits changing NACM rules and groups take effect in the next request
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+# Common NACM scripts
+. ./nacm.sh
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/nacm-example.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_NACM_MODE>internal</CLICON_NACM_MODE>
+  <CLICON_NACM_CREDENTIALS>none</CLICON_NACM_CREDENTIALS>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module nacm-example{
+  yang-version 1.1;
+  namespace "urn:example:nacm";
+  prefix nex;
+  import ietf-netconf-acm {
+	prefix nacm;
+  }
+  leaf x{
+    type int32;
+  }
+}
+EOF
+
+# Limited group: deny read of x
+RULES=$(cat <<EOF
+   <nacm xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-acm">
+     <enable-nacm>true</enable-nacm>
+     <read-default>permit</read-default>
+     <write-default>permit</write-default>
+     <exec-default>permit</exec-default>
+
+     $NGROUPS
+
+     <rule-list>
+       <name>limited-acl</name>
+       <group>limited</group>
+       <rule>
+         <name>x</name>
+         <module-name>nacm-example</module-name>
+         <path xmlns:nex="urn:example:nacm">
+           /nex:x
+         </path>
+         <access-operations>read</access-operations>
+         <action>deny</action>
+       </rule>
+     </rule-list>
+
+     $NADMIN
+
+   </nacm>
+   <x xmlns="urn:example:nacm">0</x>
+EOF
+)
+
+# Get x as user
+# 1: user
+# 2: expected data
+getx(){
+    user=$1
+    data=$2
+    new "get-config x as $user"
+    expecteof "$clixon_netconf -qf $cfg -U $user" 0 "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/nex:x\" xmlns:nex=\"urn:example:nacm\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS>$data</rpc-reply>]]>]]>$"
+}
+
+# Edit and commit as admin
+# 1: config
+editcommit(){
+    config=$1
+    new "edit-config as andy"
+    expecteof "$clixon_netconf -qf $cfg -U andy" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$config</config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+    new "commit as andy"
+    expecteof "$clixon_netconf -qf $cfg -U andy" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+}
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+editcommit "$RULES"
+
+getx andy '<data><x xmlns="urn:example:nacm">0</x></data>'
+getx wilma '<data/>'
+getx guest '<data><x xmlns="urn:example:nacm">0</x></data>'
+
+# Commit not changing nacm
+editcommit '<x xmlns="urn:example:nacm">1</x>'
+
+getx andy '<data><x xmlns="urn:example:nacm">1</x></data>'
+getx wilma '<data/>'
+
+# Change rule action
+editcommit '<nacm xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-acm"><rule-list><name>limited-acl</name><rule><name>x</name><action>permit</action></rule></rule-list></nacm>'
+
+getx wilma '<data><x xmlns="urn:example:nacm">1</x></data>'
+
+# Move guest to limited group
+editcommit '<nacm xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-acm"><rule-list><name>limited-acl</name><rule><name>x</name><action>deny</action></rule></rule-list><groups><group><name>limited</name><user-name>guest</user-name></group></groups></nacm>'
+
+getx wilma '<data/>'
+getx guest '<data/>'
+
+# Exec rule: deny edit-config for limited group
+editcommit '<nacm xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-acm"><rule-list><name>limited-acl</name><rule><name>edit</name><module-name>ietf-netconf</module-name><rpc-name>edit-config</rpc-name><access-operations>exec</access-operations><action>deny</action></rule></rule-list></nacm>'
+
+new "edit-config as wilma denied"
+expecteof "$clixon_netconf -qf $cfg -U wilma" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:nacm\">2</x></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>access-denied</error-tag><error-severity>error</error-severity><error-message>access denied</error-message></rpc-error></rpc-reply>]]>]]>$"
+
+new "edit-config as andy permitted"
+expecteof "$clixon_netconf -qf $cfg -U andy" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:nacm\">2</x></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "discard-changes"
+expecteof "$clixon_netconf -qf $cfg -U andy" 0 "<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+# Disable nacm
+editcommit '<nacm xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-acm"><enable-nacm>false</enable-nacm></nacm>'
+
+getx wilma '<data><x xmlns="urn:example:nacm">1</x></data>'
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
@@ -0,0 +1,200 @@
+#!/usr/bin/env bash
+# NACM read pruning of subtrees, see nacm_datanode_read_recurse
+# Subtrees without path targets in one YANG module are kept or removed as a unit,
+# augmented nodes from another module and path targets are checked per node.
+# 1. read-default deny, permit augmenting module: only augmented nodes and list keys kept
+# 2. Path rule on list entry before module rule
+# 3. read-default permit, deny one list entry
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+# Common NACM scripts
+. ./nacm.sh
+
+cfg=$dir/conf_yang.xml
+fyanga=$dir/a.yang
+fyangb=$dir/b.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_MODULE_MAIN>b</CLICON_YANG_MODULE_MAIN>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_NACM_MODE>internal</CLICON_NACM_MODE>
+  <CLICON_NACM_CREDENTIALS>none</CLICON_NACM_CREDENTIALS>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyanga
+module a{
+  yang-version 1.1;
+  namespace "urn:example:a";
+  prefix a;
+  import ietf-netconf-acm {
+	prefix nacm;
+  }
+  container c{
+    list x{
+      key k;
+      leaf k{
+        type int32;
+      }
+      leaf v{
+        type string;
+      }
+    }
+    leaf y{
+      type string;
+    }
+  }
+}
+EOF
+
+cat <<EOF > $fyangb
+module b{
+  yang-version 1.1;
+  namespace "urn:example:b";
+  prefix b;
+  import a {
+	prefix a;
+  }
+  augment "/a:c" {
+    leaf z{
+      type string;
+    }
+  }
+  augment "/a:c/a:x" {
+    leaf w{
+      type string;
+    }
+  }
+}
+EOF
+
+# Limited: permit augmented nodes of module b, but not in entry 3
+# Guest: deny entry 2
+RULES=$(cat <<EOF
+   <nacm xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-acm">
+     <enable-nacm>true</enable-nacm>
+     <read-default>deny</read-default>
+     <write-default>permit</write-default>
+     <exec-default>permit</exec-default>
+
+     $NGROUPS
+
+     <rule-list>
+       <name>limited-acl</name>
+       <group>limited</group>
+       <rule>
+         <name>deny-x3</name>
+         <module-name>*</module-name>
+         <path xmlns:a="urn:example:a">/a:c/a:x[a:k='3']</path>
+         <access-operations>read</access-operations>
+         <action>deny</action>
+       </rule>
+       <rule>
+         <name>permit-b</name>
+         <module-name>b</module-name>
+         <access-operations>read</access-operations>
+         <action>permit</action>
+       </rule>
+     </rule-list>
+     <rule-list>
+       <name>guest-acl</name>
+       <group>guest</group>
+       <rule>
+         <name>deny-x2</name>
+         <module-name>a</module-name>
+         <path xmlns:a="urn:example:a">/a:c/a:x[a:k='2']</path>
+         <access-operations>read</access-operations>
+         <action>deny</action>
+       </rule>
+       <rule>
+         <name>permit-all</name>
+         <module-name>*</module-name>
+         <access-operations>read</access-operations>
+         <action>permit</action>
+       </rule>
+     </rule-list>
+
+     $NADMIN
+
+   </nacm>
+EOF
+)
+
+CONFIG='<c xmlns="urn:example:a"><x><k>1</k><v>v1</v><w xmlns="urn:example:b">w1</w></x><x><k>2</k><v>v2</v><w xmlns="urn:example:b">w2</w></x><x><k>3</k><v>v3</v><w xmlns="urn:example:b">w3</w></x><y>y</y><z xmlns="urn:example:b">z</z></c>'
+
+# Get c as user
+# 1: user
+# 2: expected data
+getc(){
+    user=$1
+    data=$2
+    new "get-config c as $user"
+    expecteof "$clixon_netconf -qf $cfg -U $user" 0 "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/a:c\" xmlns:a=\"urn:example:a\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS>$data</rpc-reply>]]>]]>$"
+}
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+new "edit-config nacm and c"
+expecteof "$clixon_netconf -qf $cfg -U andy" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$RULES$CONFIG</config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "commit"
+expecteof "$clixon_netconf -qf $cfg -U andy" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+getc andy "<data>$CONFIG</data>"
+
+getc wilma '<data><c xmlns="urn:example:a"><x><k>1</k><w xmlns="urn:example:b">w1</w></x><x><k>2</k><w xmlns="urn:example:b">w2</w></x><z xmlns="urn:example:b">z</z></c></data>'
+
+getc guest '<data><c xmlns="urn:example:a"><x><k>1</k><v>v1</v><w xmlns="urn:example:b">w1</w></x><x><k>3</k><v>v3</v><w xmlns="urn:example:b">w3</w></x><y>y</y><z xmlns="urn:example:b">z</z></c></data>'
+
+getc bob '<data/>'
+
+# read-default permit: wilma sees all but entry 3
+new "edit-config read-default permit"
+expecteof "$clixon_netconf -qf $cfg -U andy" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><nacm xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-acm\"><read-default>permit</read-default></nacm></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "commit"
+expecteof "$clixon_netconf -qf $cfg -U andy" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+getc wilma '<data><c xmlns="urn:example:a"><x><k>1</k><v>v1</v><w xmlns="urn:example:b">w1</w></x><x><k>2</k><v>v2</v><w xmlns="urn:example:b">w2</w></x><y>y</y><z xmlns="urn:example:b">z</z></c></data>'
+
+getc bob "<data>$CONFIG</data>"
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
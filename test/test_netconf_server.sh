@@ -0,0 +1,97 @@
+#!/usr/bin/env bash
+# Persistent netconf server (clixon_netconf -S) and shim (clixon_netconf -C)
+# 1. Start netconf server with a pool of session workers on CLICON_NETCONF_SOCK
+# 2. Run several sessions via the shim, including more sessions than pool size
+# 3. Check that the server terminates and removes its socket
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+sock=$dir/netconf.sock
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MODULE_MAIN>clixon-example</CLICON_YANG_MODULE_MAIN>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_NETCONF_DIR>/usr/local/lib/$APPNAME/netconf</CLICON_NETCONF_DIR>
+  <CLICON_NETCONF_SOCK>$sock</CLICON_NETCONF_SOCK>
+  <CLICON_NETCONF_POOL_SIZE>2</CLICON_NETCONF_POOL_SIZE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+new "start netconf server"
+$clixon_netconf -q -S -f $cfg &
+srvpid=$!
+for i in $(seq 1 10); do
+    if [ -S $sock ]; then
+	break
+    fi
+    sleep 1
+done
+if [ ! -S $sock ]; then
+    err "$sock" "no socket"
+fi
+
+new "shim: netconf hello from server"
+expecteof "$clixon_netconf -C $sock" 0 "<hello $DEFAULTONLY><capabilities><capability>urn:ietf:params:netconf:base:1.0</capability></capabilities></hello>]]>]]><rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data/></rpc-reply>]]>]]>$"
+
+new "shim: edit-config"
+expecteof "$clixon_netconf -C $sock" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>x</name><value>42</value></parameter></table></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+# More sessions than pool size, each in its own worker
+for i in $(seq 1 5); do
+    new "shim: get-config session $i"
+    expecteof "$clixon_netconf -C $sock" 0 "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>x</name><value>42</value></parameter></table></data></rpc-reply>]]>]]>$"
+done
+
+new "shim: discard-changes"
+expecteof "$clixon_netconf -C $sock" 0 "<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "shim: non-existing socket"
+expectpart "$($clixon_netconf -C $dir/xxx.sock 2> /dev/null < /dev/null)" 255 '^$'
+
+new "stop netconf server"
+kill $srvpid
+wait $srvpid 2> /dev/null
+if [ -S $sock ]; then
+    err "no socket" "$sock"
+fi
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
@@ -0,0 +1,177 @@
+#!/usr/bin/env bash
+# Restconf GET entity-tags and reply cache, see CLICON_RESTCONF_CACHE
+# 1. GET of config gets ETag and Last-Modified from running datastore generation
+# 2. If-None-Match with the ETag gets 304, until running changes
+# 3. Different media type gets different ETag
+# 4. GET of node with state data (config false) gets no ETag
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/etag.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_RESTCONF_PRETTY>false</CLICON_RESTCONF_PRETTY>
+  <CLICON_RESTCONF_CACHE>16</CLICON_RESTCONF_CACHE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>$dir/restconf.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module etag{
+   yang-version 1.1;
+   namespace "urn:example:etag";
+   prefix e;
+   container c{
+      list x{
+         key k;
+         leaf k{
+            type int32;
+         }
+         leaf v{
+            type string;
+         }
+      }
+   }
+   container s{
+      leaf a{
+         type string;
+      }
+      leaf b{
+         config false;
+         type string;
+      }
+   }
+}
+EOF
+
+# Get ETag of a GET reply
+# 1: Accept media
+# 2: api-path
+getetag(){
+    curl $CURLOPTS -X GET -H "Accept: $1" $RCPROTO://localhost/restconf/data/$2 | sed -n 's/^[Ee][Tt][Aa][Gg]: *\("[^"]*"\).*/\1/p'
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+
+    new "waiting"
+    wait_restconf
+fi
+
+new "restconf PUT list entry"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data/etag:c/x=1 -d '{"etag:x":{"k":1,"v":"a"}}')" 0 "HTTP/1.1 201 Created"
+
+new "restconf GET with ETag and Last-Modified"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/etag:c/x=1)" 0 "HTTP/1.1 200 OK" "ETag: \"" "Last-Modified: " '{"etag:x":\[{"k":1,"v":"a"}\]}'
+
+etag=$(getetag application/yang-data+json etag:c/x=1)
+if [ -z "$etag" ]; then
+    err "ETag" "$etag"
+fi
+
+new "restconf GET cached reply same ETag"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/etag:c/x=1)" 0 "HTTP/1.1 200 OK" "ETag: $etag" '{"etag:x":\[{"k":1,"v":"a"}\]}'
+
+new "restconf GET If-None-Match not modified"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" -H "If-None-Match: $etag" $RCPROTO://localhost/restconf/data/etag:c/x=1)" 0 "HTTP/1.1 304 Not Modified" "ETag: $etag"
+
+new "restconf GET xml other ETag"
+etagx=$(getetag application/yang-data+xml etag:c/x=1)
+if [ "$etagx" = "$etag" ]; then
+    err "ETag not $etag" "$etagx"
+fi
+
+new "restconf GET xml If-None-Match with json ETag is modified"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+xml" -H "If-None-Match: $etag" $RCPROTO://localhost/restconf/data/etag:c/x=1)" 0 "HTTP/1.1 200 OK" '<x xmlns="urn:example:etag"><k>1</k><v>a</v></x>'
+
+new "restconf PUT change list entry"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data/etag:c/x=1 -d '{"etag:x":{"k":1,"v":"b"}}')" 0 "HTTP/1.1 204 No Content"
+
+new "restconf GET If-None-Match modified"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" -H "If-None-Match: $etag" $RCPROTO://localhost/restconf/data/etag:c/x=1)" 0 "HTTP/1.1 200 OK" '{"etag:x":\[{"k":1,"v":"b"}\]}'
+
+etag2=$(getetag application/yang-data+json etag:c/x=1)
+if [ "$etag2" = "$etag" ]; then
+    err "ETag not $etag" "$etag2"
+fi
+
+new "restconf GET If-None-Match * existing"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" -H "If-None-Match: *" $RCPROTO://localhost/restconf/data/etag:c/x=1)" 0 "HTTP/1.1 304 Not Modified"
+
+new "restconf GET If-None-Match * not exists"
+ret=$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" -H "If-None-Match: *" $RCPROTO://localhost/restconf/data/etag:c/x=99)
+expectpart "$ret" 0 "HTTP/1.1 404 Not Found" "Instance does not exist"
+match=$(echo "$ret" | grep -i "^ETag:\|^Last-Modified:")
+if [ -n "$match" ]; then
+    err "No ETag" "$match"
+fi
+
+new "restconf HEAD not exists"
+expectpart "$(curl $CURLOPTS -I -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/etag:c/x=99)" 0 "HTTP/1.1 404 Not Found"
+
+new "restconf PUT container with state"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data/etag:s -d '{"etag:s":{"a":"x"}}')" 0 "HTTP/1.1 201 Created"
+
+new "restconf GET container with state no ETag"
+ret=$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/etag:s)
+expectpart "$ret" 0 "HTTP/1.1 200 OK" '{"etag:s":{"a":"x"}}'
+match=$(echo "$ret" | grep -i "^ETag:")
+if [ -n "$match" ]; then
+    err "No ETag" "$match"
+fi
+
+new "restconf GET container with state content=config with ETag"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/etag:s?content=config)" 0 "HTTP/1.1 200 OK" "ETag: \"" '{"etag:s":{"a":"x"}}'
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
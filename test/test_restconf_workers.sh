@@ -0,0 +1,152 @@
+#!/usr/bin/env bash
+# Restconf worker processes, see CLICON_RESTCONF_WORKERS and restconf_workers_start
+# 1. The restconf daemon forks workers that share the restconf socket
+# 2. Concurrent requests are served, and writes in one worker are seen by all
+# 3. A worker that exits is restarted
+# 4. All workers terminate when restconf is stopped
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Only evhtp has workers
+if [ "${WITH_RESTCONF}" != "evhtp" ]; then
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi # skip
+fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/workers.yang
+
+# Number of restconf processes
+: ${nworkers:=4}
+
+# Number of concurrent requests
+: ${nreq:=20}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_RESTCONF_PRETTY>false</CLICON_RESTCONF_PRETTY>
+  <CLICON_RESTCONF_WORKERS>$nworkers</CLICON_RESTCONF_WORKERS>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>$dir/restconf.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module workers{
+   yang-version 1.1;
+   namespace "urn:example:workers";
+   prefix w;
+   container c{
+      list x{
+         key k;
+         leaf k{
+            type int32;
+         }
+         leaf v{
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+
+    new "waiting"
+    wait_restconf
+
+    new "check $nworkers restconf processes"
+    n=$(pgrep -f clixon_restconf | wc -l)
+    if [ $n -lt $nworkers ]; then
+	err "$nworkers restconf processes" "$n"
+    fi
+fi
+
+new "restconf PUT $nreq list entries concurrently"
+for (( i=0; i<$nreq; i++ )); do
+    curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data/workers:c/x=$i -d "{\"workers:x\":{\"k\":$i,\"v\":\"v$i\"}}" > $dir/put$i &
+done
+wait
+for (( i=0; i<$nreq; i++ )); do
+    expectpart "$(cat $dir/put$i)" 0 "HTTP/1.1 201 Created"
+done
+
+new "restconf GET $nreq list entries concurrently"
+for (( i=0; i<$nreq; i++ )); do
+    curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/workers:c/x=$i > $dir/get$i &
+done
+wait
+for (( i=0; i<$nreq; i++ )); do
+    expectpart "$(cat $dir/get$i)" 0 "HTTP/1.1 200 OK" "{\"workers:x\":\[{\"k\":$i,\"v\":\"v$i\"}\]}"
+done
+
+if [ $RC -ne 0 ]; then
+    new "kill one restconf worker"
+    n0=$(pgrep -f clixon_restconf | wc -l)
+    sudo kill $(pgrep -n -f clixon_restconf)
+    sleep 2
+
+    new "restconf worker restarted"
+    n=$(pgrep -f clixon_restconf | wc -l)
+    if [ $n -ne $n0 ]; then
+	err "$n0 restconf processes" "$n"
+    fi
+
+    new "restconf GET after restart"
+    expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/workers:c/x=0)" 0 "HTTP/1.1 200 OK" "{\"workers:x\":\[{\"k\":0,\"v\":\"v0\"}\]}"
+
+    new "Kill restconf daemon"
+    stop_restconf
+
+    new "check no restconf processes"
+    sleep 1
+    n=$(pgrep -f clixon_restconf | wc -l)
+    if [ $n -ne 0 ]; then
+	err "0 restconf processes" "$n"
+    fi
+fi
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
@@ -0,0 +1,141 @@
+#!/usr/bin/env bash
+# XML and JSON serialization of datastores and replies, see xml2cbuf_recurse
+# Datastores larger than the output chunk (XML_OUTPUT_CHUNK) are written to file in
+# several chunks. Check for both xml and json datastore format:
+# 1. Bodies with characters needing encoding are written and read back
+# 2. A large datastore is written at commit and read back at restart
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/serialize.yang
+
+# Number of entries, datastore must be larger than XML_OUTPUT_CHUNK (64K)
+: ${perfnr:=3000}
+
+cat <<EOF > $fyang
+module serialize{
+   yang-version 1.1;
+   namespace "urn:example:serialize";
+   prefix s;
+   container c {
+      list x {
+         key k;
+         leaf k {
+            type int32;
+         }
+         leaf v {
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+# Value with characters needing encoding, as written in XML
+VAL="a&lt;b&amp;c&gt;d e"
+
+# Get one list entry
+# 1: key
+# 2: expected value
+getkey(){
+    k=$1
+    v=$2
+    new "get-config key $k"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/s:c/s:x[s:k='$k']\" xmlns:s=\"urn:example:serialize\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:serialize\"><x><k>$k</k><v>$v</v></x></c></data></rpc-reply>]]>]]>$"
+}
+
+# Run tests for one datastore format
+# 1: xml or json
+testrun(){
+    format=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_FORMAT>$format</CLICON_XMLDB_FORMAT>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg format $format"
+    if [ $BE -ne 0 ]; then
+	new "kill old backend"
+	sudo clixon_backend -z -f $cfg
+	if [ $? -ne 0 ]; then
+	    err
+	fi
+	new "start backend -s init -f $cfg"
+	start_backend -s init -f $cfg
+
+	new "waiting"
+	wait_backend
+    fi
+
+    rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:serialize\">"
+    for (( i=0; i<$perfnr; i++ )); do
+	rpc+="<x><k>$i</k><v>value-$i-$VAL</v></x>"
+    done
+    rpc+="</c></config></edit-config></rpc>]]>]]>"
+
+    new "edit-config $perfnr entries"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$rpc" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "commit"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    for k in 0 1500 $((perfnr-1)); do
+	getkey $k "value-$k-$VAL"
+    done
+
+    new "running datastore larger than output chunk"
+    sz=$(sudo stat -c %s /usr/local/var/$APPNAME/running_db)
+    if [ $sz -le 65536 ]; then
+	err "size > 65536" "$sz"
+    fi
+
+    if [ $BE -eq 0 ]; then
+	return
+    fi
+
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    stop_backend -f $cfg
+
+    new "start backend -s running -f $cfg"
+    start_backend -s running -f $cfg
+
+    new "waiting"
+    wait_backend
+
+    for k in 0 1500 $((perfnr-1)); do
+	getkey $k "value-$k-$VAL"
+    done
+
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    stop_backend -f $cfg
+}
+
+for format in xml json; do
+    testrun $format
+done
+
+rm -rf $dir
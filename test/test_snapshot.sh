@@ -0,0 +1,148 @@
+#!/usr/bin/env bash
+# Read-only backend socket, see CLICON_SOCK_READONLY and backend_snapshot.c
+# Sessions on the read-only socket may read but not write. During a commit they are
+# served from a snapshot of the configuration before the commit.
+# Commits are made slow by the example backend plugin (-- -w) to read during a commit.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/snapshot.yang
+rosock=$dir/ro.sock
+
+# Seconds the example backend plugin sleeps in every commit
+: ${slow:=3}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_SOCK_READONLY>$rosock</CLICON_SOCK_READONLY>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module snapshot{
+   yang-version 1.1;
+   namespace "urn:example:snapshot";
+   prefix s;
+   container c{
+      leaf a{
+         type string;
+      }
+   }
+}
+EOF
+
+X1="<c xmlns=\"urn:example:snapshot\"><a>1</a></c>"
+X2="<c xmlns=\"urn:example:snapshot\"><a>2</a></c>"
+X3="<c xmlns=\"urn:example:snapshot\"><a>3</a></c>"
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg -- -w $slow"
+    start_backend -s init -f $cfg -- -w $slow
+
+    new "waiting"
+    wait_backend
+fi
+
+new "edit-config and commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$X1</config></edit-config></rpc>]]>]]><rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "read-only get-config"
+expecteof "$clixon_netconf -qf $cfg -o CLICON_SOCK=$rosock" 0 "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$X1</data></rpc-reply>]]>]]>$"
+
+new "read-only get"
+expecteof "$clixon_netconf -qf $cfg -o CLICON_SOCK=$rosock" 0 "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/s:c\" xmlns:s=\"urn:example:snapshot\"/></get></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$X1</data></rpc-reply>]]>]]>$"
+
+new "read-only edit-config denied"
+expecteof "$clixon_netconf -qf $cfg -o CLICON_SOCK=$rosock" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$X2</config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>protocol</error-type><error-tag>access-denied</error-tag><error-severity>error</error-severity><error-message>Operation not allowed on read-only session</error-message></rpc-error></rpc-reply>]]>]]>$"
+
+new "read-only commit denied"
+expecteof "$clixon_netconf -qf $cfg -o CLICON_SOCK=$rosock" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "<error-tag>access-denied</error-tag>"
+
+new "read-only lock denied"
+expecteof "$clixon_netconf -qf $cfg -o CLICON_SOCK=$rosock" 0 "<rpc $DEFAULTNS><lock><target><candidate/></target></lock></rpc>]]>]]>" "<error-tag>access-denied</error-tag>"
+
+new "candidate unchanged"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$X1</data></rpc-reply>]]>]]>$"
+
+new "edit-config and commit on main socket"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$X2</config></edit-config></rpc>]]>]]><rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "read-only get-config after commit"
+expecteof "$clixon_netconf -qf $cfg -o CLICON_SOCK=$rosock" 0 "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$X2</data></rpc-reply>]]>]]>$"
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+# Backend pid, not snapshot processes
+bpid=$(cat /usr/local/var/$APPNAME/$APPNAME.pidfile)
+
+new "edit-config on main socket"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$X3</config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "start slow commit in background"
+echo "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" | $clixon_netconf -qf $cfg > $dir/commit.out &
+cpid=$!
+sleep 1
+
+new "read-only get-config during commit returns old running"
+expecteof "$clixon_netconf -qf $cfg -o CLICON_SOCK=$rosock" 0 "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$X2</data></rpc-reply>]]>]]>$"
+
+new "read-only get-config returned before commit ends"
+if ! kill -0 $cpid 2> /dev/null; then
+    err "commit in progress" "commit done"
+fi
+
+new "wait for commit"
+wait $cpid
+ret=$(cat $dir/commit.out)
+match=$(echo "$ret" | grep -o "<rpc-reply $DEFAULTNS><ok/></rpc-reply>")
+if [ -z "$match" ]; then
+    err "<ok/>" "$ret"
+fi
+
+new "read-only get-config after slow commit returns new running"
+expecteof "$clixon_netconf -qf $cfg -o CLICON_SOCK=$rosock" 0 "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$X3</data></rpc-reply>]]>]]>$"
+
+new "no snapshot process left"
+ret=$(pgrep -P $bpid)
+if [ -n "$ret" ]; then
+    err "no child of backend $bpid" "$ret"
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+new "read-only socket removed"
+if [ -e $rosock ]; then
+    err "no $rosock" "$rosock"
+fi
+
+rm -rf $dir
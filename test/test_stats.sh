@@ -0,0 +1,96 @@
+#!/usr/bin/env bash
+# Backend per-RPC and commit phase statistics, see CLICON_BACKEND_STATS and clixon-stats.yang
+# 1. RPCs are counted per type with latency, bytes and xml nodes
+# 2. Errors are counted
+# 3. Commit phases have their own timers
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/stats.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_BACKEND_STATS>true</CLICON_BACKEND_STATS>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module stats{
+   yang-version 1.1;
+   namespace "urn:example:stats";
+   prefix s;
+   container c{
+      leaf a{
+         type string;
+      }
+   }
+}
+EOF
+
+# Regexp of one timer
+TIMER="<count>[0-9]*</count><total>[0-9]*</total><max>[0-9]*</max><p50>[0-9]*</p50><p99>[0-9]*</p99>"
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+new "edit-config"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:stats\"><a>x</a></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "edit-config error"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:stats\"><xxx>x</xxx></c></config></edit-config></rpc>]]>]]>" "<rpc-error>"
+
+new "commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "get stats"
+ret=$(echo "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/cs:stats\" xmlns:cs=\"http://clicon.org/stats\"/></get></rpc>]]>]]>" | $clixon_netconf -qf $cfg)
+
+new "edit-config stats"
+expectpart "$ret" 0 "<rpc><name>edit-config</name><count>2</count><total>[0-9]*</total><max>[0-9]*</max><p50>[0-9]*</p50><p99>[0-9]*</p99><errors>1</errors><bytes-in>[1-9][0-9]*</bytes-in><bytes-out>[1-9][0-9]*</bytes-out><xml-nodes>[1-9][0-9]*</xml-nodes></rpc>"
+
+new "commit stats"
+expectpart "$ret" 0 "<rpc><name>commit</name><count>1</count>"
+
+for phase in load diff plugin-begin validate plugin-validate plugin-complete plugin-commit datastore-write plugin-end; do
+    new "commit phase $phase"
+    expectpart "$ret" 0 "<phase><name>$phase</name>$TIMER</phase>"
+done
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
@@ -23,8 +23,8 @@
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
 
-# Skip it other than fcgi and http
-if [ "${WITH_RESTCONF}" != "fcgi" -o "$RCPROTO" = https ]; then
+# Skip it other than fcgi or evhtp, and http
+if [ "${WITH_RESTCONF}" != "fcgi" -a "${WITH_RESTCONF}" != "evhtp" -o "$RCPROTO" = https ]; then
     if [ "$s" = $0 ]; then exit 0; else return 0; fi # skip
 fi
 
@@ -0,0 +1,148 @@
+#!/usr/bin/env bash
+# Notification fan-out to many subscribers of one stream, see stream_notify1 and ce_notify_send
+# Each notification is encoded once and filters are evaluated once per distinct xpath.
+# 1. Many netconf subscribers with the same filter all get the notifications
+# 2. A subscriber with another, non-matching filter gets none
+# 3. A subscriber without filter gets all
+# 4. A subscriber whose filter fails to evaluate gets none, but does not stop the others
+# Relies on the example backend plugin sending an EXAMPLE notification every 5s
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/stream.yang
+
+# Number of subscribers with same filter
+: ${nsub:=10}
+
+# How long subscribers listen [s]
+: ${wait:=12}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_BACKEND_PIDFILE>$dir/restconf.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_STREAM_DISCOVERY_RFC5277>true</CLICON_STREAM_DISCOVERY_RFC5277>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example {
+   namespace "urn:example:clixon";
+   prefix ex;
+   notification event {
+      leaf event-class {
+         type string;
+      }
+      container reportingEntity {
+         leaf card {
+            type string;
+         }
+      }
+      leaf severity {
+         type string;
+      }
+   }
+   container state {
+      config false;
+      leaf-list op {
+         type string;
+      }
+   }
+}
+EOF
+
+# Start a netconf subscriber in background writing to a file
+# 1: output file
+# 2: filter element, or empty
+subscribe(){
+    f=$1
+    filter=$2
+    (echo "<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>EXAMPLE</stream>$filter</create-subscription></rpc>]]>]]>"; sleep $wait) | $clixon_netconf -qf $cfg > $f &
+}
+
+NOTIFY="<notification xmlns=\"urn:ietf:params:xml:ns:netconf:notification:1.0\"><eventTime>[0-9TZ:.-]*</eventTime><event xmlns=\"urn:example:clixon\"><event-class>fault</event-class>"
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "start $nsub subscribers with same filter, one with other filter, one with failing filter, one without filter"
+for (( i=0; i<$nsub; i++ )); do
+    subscribe $dir/sub$i "<filter type=\"xpath\" select=\"event[event-class='fault']\"/>"
+done
+subscribe $dir/other "<filter type=\"xpath\" select=\"event[event-class='none']\"/>"
+# Comparing a string with a number is an xpath evaluation error
+subscribe $dir/fail "<filter type=\"xpath\" select=\"event['fault'=1]\"/>"
+subscribe $dir/all ""
+wait
+
+for (( i=0; i<$nsub; i++ )); do
+    new "subscriber $i got notifications"
+    ret=$(cat $dir/sub$i)
+    match=$(echo "$ret" | grep -Eo "$NOTIFY")
+    if [ -z "$match" ]; then
+	err "$NOTIFY" "$ret"
+    fi
+done
+
+new "subscriber with other filter got no notifications"
+ret=$(cat $dir/other)
+match=$(echo "$ret" | grep -o "<notification")
+if [ -n "$match" ]; then
+    err "no notification" "$ret"
+fi
+
+new "subscriber with failing filter got no notifications"
+ret=$(cat $dir/fail)
+match=$(echo "$ret" | grep -o "<notification")
+if [ -n "$match" ]; then
+    err "no notification" "$ret"
+fi
+
+new "subscriber without filter got notifications"
+ret=$(cat $dir/all)
+match=$(echo "$ret" | grep -Eo "$NOTIFY")
+if [ -z "$match" ]; then
+    err "$NOTIFY" "$ret"
+fi
+
+new "netconf get after subscribers leave"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data/></rpc-reply>]]>]]>$"
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
@@ -0,0 +1,104 @@
+#!/usr/bin/env bash
+# Bounded notification replay buffer, see stream_replay_add and CLICON_STREAM_REPLAY_MAX
+# 1. Notifications are stored encoded in the replay buffer
+# 2. Only the CLICON_STREAM_REPLAY_MAX latest are replayed, older are dropped
+# Relies on the example backend plugin sending an EXAMPLE notification every 5s
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/stream.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_BACKEND_PIDFILE>$dir/restconf.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_STREAM_RETENTION>60</CLICON_STREAM_RETENTION>
+  <CLICON_STREAM_REPLAY_MAX>2</CLICON_STREAM_REPLAY_MAX>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example {
+   namespace "urn:example:clixon";
+   prefix ex;
+   notification event {
+      leaf event-class {
+         type string;
+      }
+      container reportingEntity {
+         leaf card {
+            type string;
+         }
+      }
+      leaf severity {
+         type string;
+      }
+   }
+   container state {
+      config false;
+      leaf-list op {
+         type string;
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+START=$(date -u -d "-60 seconds" +"%Y-%m-%dT%H:%M:%SZ")
+
+new "wait for more notifications than replay buffer holds"
+sleep 16
+
+STOP=$(date -u +"%Y-%m-%dT%H:%M:%SZ")
+
+new "netconf replay subscription gets 2 latest notifications"
+ret=$( (echo "<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>EXAMPLE</stream><startTime>$START</startTime><stopTime>$STOP</stopTime></create-subscription></rpc>]]>]]>"; sleep 3) | $clixon_netconf -qf $cfg)
+match=$(echo "$ret" | grep -o "<rpc-reply $DEFAULTNS><ok/></rpc-reply>")
+if [ -z "$match" ]; then
+    err "<ok/>" "$ret"
+fi
+nr=$(echo "$ret" | grep -o "<notification" | wc -l)
+if [ $nr -ne 2 ]; then
+    err 2 "$nr"
+fi
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
@@ -0,0 +1,151 @@
+#!/usr/bin/env bash
+# Backend commit tracing, see CLICON_BACKEND_TRACE_SPANS and backend_trace.c
+# 1. Commit phases and plugin callbacks are recorded as spans
+# 2. trace-export rpc writes them as Chrome trace JSON
+# 3. A commit slower than CLICON_BACKEND_TRACE_SLOW writes the trace file
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/trace.yang
+ftrace=$dir/trace.json
+
+# Number of list entries in slow commit
+: ${perfnr:=5000}
+
+# 1: slow commit threshold in ms
+testconf(){
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_BACKEND_TRACE_SPANS>100</CLICON_BACKEND_TRACE_SPANS>
+  <CLICON_BACKEND_TRACE_FILE>$ftrace</CLICON_BACKEND_TRACE_FILE>
+  <CLICON_BACKEND_TRACE_SLOW>$1</CLICON_BACKEND_TRACE_SLOW>
+</clixon-config>
+EOF
+}
+
+cat <<EOF > $fyang
+module trace{
+   yang-version 1.1;
+   namespace "urn:example:trace";
+   prefix t;
+   container c{
+      leaf a{
+         type string;
+      }
+      list x{
+         key k;
+         leaf k{
+            type int32;
+         }
+      }
+   }
+}
+EOF
+
+# Start backend
+startbe(){
+    if [ $BE -ne 0 ]; then
+	new "kill old backend"
+	sudo clixon_backend -zf $cfg
+	if [ $? -ne 0 ]; then
+	    err
+	fi
+	new "start backend -s init -f $cfg"
+	start_backend -s init -f $cfg
+
+	new "waiting"
+	wait_backend
+    fi
+}
+
+# Stop backend
+stopbe(){
+    if [ $BE -ne 0 ]; then
+	new "Kill backend"
+	# Check if premature kill
+	pid=$(pgrep -u root -f clixon_backend)
+	if [ -z "$pid" ]; then
+	    err "backend already dead"
+	fi
+	stop_backend -f $cfg
+    fi
+}
+
+# Edit and commit
+# 1: value
+commit(){
+    new "edit-config $1"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:trace\"><a>$1</a></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "commit"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+}
+
+new "test params: -f $cfg"
+testconf 0
+startbe
+
+commit x
+
+new "no trace file without export"
+if [ -f $ftrace ]; then
+    err "no $ftrace" "$(cat $ftrace)"
+fi
+
+new "trace-export"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><trace-export xmlns=\"http://clicon.org/lib\"/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><spans xmlns=\"http://clicon.org/lib\">[1-9][0-9]*</spans></rpc-reply>]]>]]>$"
+
+ret=$(sudo cat $ftrace)
+
+new "trace file is chrome trace"
+expectpart "$ret" 0 '^{"displayTimeUnit":"ms","traceEvents":\['
+
+for phase in load diff validate datastore-write commit; do
+    new "trace has phase $phase"
+    expectpart "$ret" 0 "{\"name\":\"$phase\",\"cat\":\"commit\",\"ph\":\"X\",\"ts\":[0-9.]*,\"dur\":[0-9.]*,\"pid\":[0-9]*,\"tid\":[0-9]*}"
+done
+
+for cb in begin validate complete commit commit-done end; do
+    new "trace has plugin callback $cb"
+    expectpart "$ret" 0 "{\"name\":\"$cb\",\"cat\":\"plugin\",\"ph\":\"X\",\"ts\":[0-9.]*,\"dur\":[0-9.]*,\"pid\":[0-9]*,\"tid\":[0-9]*,\"args\":{\"plugin\":\"example_backend.so\"}}"
+done
+
+stopbe
+sudo rm -f $ftrace
+
+new "slow commit threshold 1ms"
+testconf 1
+startbe
+
+rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:trace\">"
+for (( i=0; i<$perfnr; i++ )); do
+    rpc+="<x><k>$i</k></x>"
+done
+rpc+="</c></config></edit-config></rpc>]]>]]>"
+
+new "edit-config $perfnr entries"
+expecteof "$clixon_netconf -qf $cfg" 0 "$rpc" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "slow commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "slow commit trace file"
+expectpart "$(sudo cat $ftrace)" 0 '"name":"datastore-write","cat":"commit"' '"name":"commit","cat":"commit"'
+
+stopbe
+
+rm -rf $dir
@@ -0,0 +1,199 @@
+#!/usr/bin/env bash
+# Pre-resolved YANG spec snapshots (CLICON_YANG_SNAPSHOT_DIR)
+# 1. Check that backend and netconf write snapshots on first start
+# 2. Check that types, ranges, patterns, groupings and augments work when loaded
+#    from snapshot and that an unchanged snapshot is not rewritten
+# 3. Check that a snapshot is rebuilt when a YANG file changes
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/$APPNAME.yang
+snapdir=$dir/snapshot
+
+test -d $snapdir || mkdir $snapdir
+chmod 777 $snapdir
+rm -f $snapdir/*
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_YANG_SNAPSHOT_DIR>$snapdir</CLICON_YANG_SNAPSHOT_DIR>
+  <CLICON_CLISPEC_DIR>/usr/local/lib/$APPNAME/clispec</CLICON_CLISPEC_DIR>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_NETCONF_DIR>/usr/local/lib/$APPNAME/netconf</CLICON_NETCONF_DIR>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+# Yang with typedefs resolved in groupings, augment, ranges and patterns
+# 1: extra statement in container c
+yangfile(){
+    extra=$1
+    cat <<EOF > $fyang
+module $APPNAME{
+   yang-version 1.1;
+   prefix ex;
+   namespace "urn:example:clixon";
+   typedef percent {
+      type decimal64 {
+         fraction-digits 2;
+         range "0 .. 100";
+      }
+   }
+   grouping gr {
+      typedef word {
+         type string {
+            pattern '[a-z]+';
+         }
+      }
+      leaf name {
+         type word;
+      }
+      leaf load {
+         type percent;
+         default 50.00;
+      }
+   }
+   container c {
+      list x {
+         key name;
+         uses gr;
+      }
+      $extra
+   }
+   augment "/ex:c" {
+      leaf y {
+         type uint8 {
+            range "1 .. 10";
+         }
+      }
+   }
+}
+EOF
+}
+
+# Snapshot file inode, changes when the snapshot is rewritten
+# 1: snapshot name
+snapinode(){
+    stat -c %i $snapdir/$1.yspec 2> /dev/null
+}
+
+yangfile ""
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+
+    new "backend snapshot written"
+    if [ ! -f $snapdir/backend.yspec ]; then
+	err "$snapdir/backend.yspec" "no file"
+    fi
+fi
+
+new "netconf hello, write snapshot"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data/></rpc-reply>]]>]]>$"
+
+new "netconf snapshot written"
+ino0=$(snapinode netconf)
+if [ -z "$ino0" ]; then
+    err "$snapdir/netconf.yspec" "no file"
+fi
+
+new "netconf edit-config from snapshot"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><x><name>abc</name><load>42.50</load></x><y>3</y></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf validate ok"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf snapshot not rewritten"
+ino1=$(snapinode netconf)
+if [ "$ino0" != "$ino1" ]; then
+    err "$ino0" "$ino1"
+fi
+
+new "netconf get-config"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><x><name>abc</name><load>42.50</load></x><y>3</y></c></data></rpc-reply>]]>]]>$"
+
+new "netconf edit-config percent out of range (typedef)"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><x><name>abc</name><load>142.50</load></x></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf validate percent out of range"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>bad-element</error-tag><error-info><bad-element>load</bad-element></error-info><error-severity>error</error-severity><error-message>Number 142.50 out of range: 0.00 - 100.00</error-message></rpc-error></rpc-reply>]]>]]>$"
+
+new "netconf discard-changes"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf edit-config name not matching pattern (typedef in grouping)"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><x><name>a9</name></x></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf validate pattern"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>bad-element</error-tag><error-info><bad-element>name</bad-element></error-info><error-severity>error</error-severity><error-message>regexp match fail:"
+
+new "netconf discard-changes"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf edit-config unknown leaf z"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><z>foo</z></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>unknown-element</error-tag><error-info><bad-element>z</bad-element></error-info>"
+
+# Change YANG file: add leaf z, snapshots must be rebuilt
+sleep 1
+yangfile "leaf z { type string; }"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    stop_backend -f $cfg
+
+    new "start backend -s running -f $cfg"
+    start_backend -s running -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+new "netconf edit-config new leaf z"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><z>foo</z></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf validate"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf snapshot rewritten"
+ino2=$(snapinode netconf)
+if [ "$ino0" = "$ino2" ]; then
+    err "not $ino0" "$ino2"
+fi
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
@@ -0,0 +1,664 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Micro-benchmarks of core library hot paths.
+ * A tree with a list of <entries> entries is generated, each entry has a key and
+ * a value leaf, ie five XML nodes per entry. Each benchmark then times one library
+ * call on that tree repeatedly until the time budget or iteration limit is reached.
+ * Setup and cleanup of each operation is not timed.
+ * Output is one CSV line per benchmark:
+ *   name,entries,nodes,ops,ns_per_op,xml_allocs_per_op
+ * where xml_allocs_per_op is the number of XML objects created per operation,
+ * see xml_stats_alloc().
+ * Example, run all benchmarks on trees of 1k, 10k, 100k and 1M XML nodes:
+ *   for n in 200 2000 20000 200000; do clixon_util_bench -n $n -H; done
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <syslog.h>
+#include <time.h>
+#include <sys/stat.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon/clixon.h"
+
+/* Command line options passed to getopt(3) */
+#define UTIL_BENCH_OPTS "hD:n:i:t:b:HY:"
+
+#define BENCH_NS     "urn:example:bench"
+#define BENCH_PREFIX "b"
+
+/* Built-in YANG of the generated tree */
+static const char *BENCH_YANG =
+    "module bench{\n"
+    "  yang-version 1.1;\n"
+    "  namespace \"" BENCH_NS "\";\n"
+    "  prefix " BENCH_PREFIX ";\n"
+    "  container c{\n"
+    "    list x{\n"
+    "      key k;\n"
+    "      leaf k{\n"
+    "        type int32;\n"
+    "      }\n"
+    "      leaf v{\n"
+    "        type string;\n"
+    "      }\n"
+    "    }\n"
+    "  }\n"
+    "}\n";
+
+/* NACM config of nacm_datanode_read benchmark: user bench may not read any value leaf */
+static const char *BENCH_NACM =
+    "<nacm xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-acm\">"
+    "<enable-nacm>true</enable-nacm>"
+    "<read-default>permit</read-default>"
+    "<write-default>deny</write-default>"
+    "<exec-default>permit</exec-default>"
+    "<groups><group><name>bench</name><user-name>bench</user-name></group></groups>"
+    "<rule-list><name>bench</name><group>bench</group>"
+    "<rule><name>value</name><module-name>bench</module-name>"
+    "<path xmlns:" BENCH_PREFIX "=\"" BENCH_NS "\">/" BENCH_PREFIX ":c/" BENCH_PREFIX ":x/" BENCH_PREFIX ":v</path>"
+    "<access-operations>read</access-operations><action>deny</action></rule>"
+    "</rule-list></nacm>";
+
+/*! Benchmark state shared by all benchmarks
+ * The base tree bc_xt is not modified by any benchmark
+ */
+struct bench_ctx{
+    clicon_handle bc_h;
+    yang_stmt    *bc_yspec;
+    cvec         *bc_nsc;     /* bench namespace context */
+    int           bc_n;       /* Number of list entries */
+    cbuf         *bc_xmlstr;  /* Generated tree as XML string */
+    cxobj        *bc_xt;      /* Generated tree, parsed, bound and sorted */
+    cxobj        *bc_xc;      /* Container c of bc_xt */
+    cxobj        *bc_x1;      /* Copy of bc_xt with every 100th value changed */
+    cxobj        *bc_xnacm;   /* NACM tree, or NULL if ietf-netconf-acm is not loaded */
+    cbuf         *bc_cb;      /* Output buffer */
+    int           bc_key;     /* Random key of this operation */
+    /* Per operation state, set by prepare and cleared by cleanup */
+    cxobj        *bc_xs;      /* Scratch tree */
+    cxobj        *bc_xi;      /* Scratch node */
+    cxobj        *bc_xerr;
+    cvec         *bc_cvk;
+    clixon_xvec  *bc_xv;
+    cxobj       **bc_vec;
+    size_t        bc_veclen;
+    cxobj       **bc_dvec[4]; /* xml_diff result vectors */
+};
+
+/*! Benchmark callback, return -1 on error */
+typedef int (bench_cb)(struct bench_ctx *bc);
+
+/*! A benchmark: prepare and cleanup are not timed, op is */
+struct bench{
+    char     *b_name;
+    bench_cb *b_prepare;
+    bench_cb *b_op;
+    bench_cb *b_cleanup;
+};
+
+/*! Free scratch state of one operation */
+static int
+bench_cleanup(struct bench_ctx *bc)
+{
+    int i;
+
+    if (bc->bc_xs){
+	xml_free(bc->bc_xs);
+	bc->bc_xs = NULL;
+    }
+    if (bc->bc_xi){
+	xml_free(bc->bc_xi);
+	bc->bc_xi = NULL;
+    }
+    if (bc->bc_xerr){
+	xml_free(bc->bc_xerr);
+	bc->bc_xerr = NULL;
+    }
+    if (bc->bc_cvk){
+	cvec_free(bc->bc_cvk);
+	bc->bc_cvk = NULL;
+    }
+    if (bc->bc_xv){
+	clixon_xvec_free(bc->bc_xv);
+	bc->bc_xv = NULL;
+    }
+    if (bc->bc_vec){
+	free(bc->bc_vec);
+	bc->bc_vec = NULL;
+    }
+    for (i=0; i<4; i++)
+	if (bc->bc_dvec[i]){
+	    free(bc->bc_dvec[i]);
+	    bc->bc_dvec[i] = NULL;
+	}
+    return 0;
+}
+
+/*! Parse xml string without yang */
+static int
+bench_xml_parse(struct bench_ctx *bc)
+{
+    return clixon_xml_parse_string(cbuf_get(bc->bc_xmlstr), YB_NONE, NULL, &bc->bc_xs, NULL);
+}
+
+/*! Prepare unbound tree */
+static int
+bench_xml_bind_yang_prepare(struct bench_ctx *bc)
+{
+    return clixon_xml_parse_string(cbuf_get(bc->bc_xmlstr), YB_NONE, NULL, &bc->bc_xs, NULL);
+}
+
+static int
+bench_xml_bind_yang(struct bench_ctx *bc)
+{
+    return xml_bind_yang(bc->bc_xs, YB_MODULE, bc->bc_yspec, &bc->bc_xerr);
+}
+
+/*! Prepare copy of tree where list entries are in reverse order */
+static int
+bench_xml_sort_prepare(struct bench_ctx *bc)
+{
+    cxobj **vec;
+    cxobj  *x;
+    int     len;
+    int     i;
+
+    if ((bc->bc_xs = xml_dup(bc->bc_xc)) == NULL)
+	return -1;
+    vec = xml_childvec_get(bc->bc_xs);
+    len = xml_child_nr(bc->bc_xs);
+    for (i=0; i<len/2; i++){
+	x = vec[i];
+	vec[i] = vec[len-1-i];
+	vec[len-1-i] = x;
+    }
+    return 0;
+}
+
+static int
+bench_xml_sort(struct bench_ctx *bc)
+{
+    return xml_sort(bc->bc_xs);
+}
+
+/*! Prepare new bound list entry with a key not in the tree */
+static int
+bench_xml_insert_prepare(struct bench_ctx *bc)
+{
+    cbuf *cb;
+    int   retval = -1;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "<c xmlns=\"%s\"><x><k>%d</k><v>new</v></x></c>", BENCH_NS, 2*bc->bc_key+1);
+    if (clixon_xml_parse_string(cbuf_get(cb), YB_MODULE, bc->bc_yspec, &bc->bc_xs, NULL) < 1)
+	goto done;
+    if ((bc->bc_xi = xpath_first(bc->bc_xs, bc->bc_nsc, "/b:c/b:x")) == NULL){
+	clicon_err(OE_XML, 0, "x not found");
+	goto done;
+    }
+    /* xml_insert requires a node without parent */
+    if (xml_rm(bc->bc_xi) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Insert into base tree */
+static int
+bench_xml_insert(struct bench_ctx *bc)
+{
+    return xml_insert(bc->bc_xc, bc->bc_xi, INS_LAST, NULL, NULL);
+}
+
+/*! Remove inserted entry from base tree */
+static int
+bench_xml_insert_cleanup(struct bench_ctx *bc)
+{
+    if (bc->bc_xi && xml_purge(bc->bc_xi) < 0)
+	return -1;
+    bc->bc_xi = NULL;
+    return bench_cleanup(bc);
+}
+
+static int
+bench_find_index_prepare(struct bench_ctx *bc)
+{
+    char key[16];
+
+    snprintf(key, sizeof(key), "%d", 2*bc->bc_key);
+    if ((bc->bc_cvk = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	return -1;
+    }
+    if (cvec_add_string(bc->bc_cvk, "k", key) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_add_string");
+	return -1;
+    }
+    if ((bc->bc_xv = clixon_xvec_new()) == NULL)
+	return -1;
+    return 0;
+}
+
+static int
+bench_find_index(struct bench_ctx *bc)
+{
+    return clixon_xml_find_index(bc->bc_xc, NULL, NULL, "x", bc->bc_cvk, bc->bc_xv);
+}
+
+/*! Xpath lookup of one value leaf by list key */
+static int
+bench_xpath_vec(struct bench_ctx *bc)
+{
+    return xpath_vec(bc->bc_xt, bc->bc_nsc, "/b:c/b:x[b:k='%d']/b:v",
+		     &bc->bc_vec, &bc->bc_veclen, 2*bc->bc_key);
+}
+
+static int
+bench_xml_diff(struct bench_ctx *bc)
+{
+    int len0;
+    int len1;
+    int len2;
+
+    return xml_diff(bc->bc_yspec, bc->bc_xt, bc->bc_x1,
+		    &bc->bc_dvec[0], &len0,
+		    &bc->bc_dvec[1], &len1,
+		    &bc->bc_dvec[2], &bc->bc_dvec[3], &len2);
+}
+
+static int
+bench_xml2json_cbuf(struct bench_ctx *bc)
+{
+    cbuf_reset(bc->bc_cb);
+    return xml2json_cbuf(bc->bc_cb, bc->bc_xc, 0);
+}
+
+static int
+bench_clicon_xml2cbuf(struct bench_ctx *bc)
+{
+    cbuf_reset(bc->bc_cb);
+    return clicon_xml2cbuf(bc->bc_cb, bc->bc_xc, 0, 0, -1);
+}
+
+/*! Prepare copy of base tree since NACM read removes denied nodes */
+static int
+bench_nacm_read_prepare(struct bench_ctx *bc)
+{
+    if ((bc->bc_xs = xml_dup(bc->bc_xt)) == NULL)
+	return -1;
+    return 0;
+}
+
+/*! NACM read of whole tree
+ * The policy is compiled in each call since it is not cached by nacm_access_pre, which is
+ * small compared to the tree traversal
+ */
+static int
+bench_nacm_read(struct bench_ctx *bc)
+{
+    return nacm_datanode_read(bc->bc_h, bc->bc_xs, &bc->bc_xs, 1, "bench", bc->bc_xnacm);
+}
+
+static int
+bench_validate_all(struct bench_ctx *bc)
+{
+    int ret;
+
+    if ((ret = xml_yang_validate_all_top(bc->bc_h, bc->bc_xt, &bc->bc_xerr)) < 0)
+	return -1;
+    if (ret == 0){
+	clicon_err(OE_YANG, 0, "validation failed");
+	return -1;
+    }
+    return 0;
+}
+
+/* All benchmarks in run order */
+static struct bench BENCHMARKS[] = {
+    {"xml_parse",              NULL,                        bench_xml_parse,       NULL},
+    {"xml_bind_yang",          bench_xml_bind_yang_prepare, bench_xml_bind_yang,   NULL},
+    {"xml_sort",               bench_xml_sort_prepare,      bench_xml_sort,        NULL},
+    {"xml_insert",             bench_xml_insert_prepare,    bench_xml_insert,      bench_xml_insert_cleanup},
+    {"clixon_xml_find_index",  bench_find_index_prepare,    bench_find_index,      NULL},
+    {"xpath_vec",              NULL,                        bench_xpath_vec,       NULL},
+    {"xml_diff",               NULL,                        bench_xml_diff,        NULL},
+    {"xml2json_cbuf",          NULL,                        bench_xml2json_cbuf,   NULL},
+    {"clicon_xml2cbuf",        NULL,                        bench_clicon_xml2cbuf, NULL},
+    {"nacm_datanode_read",     bench_nacm_read_prepare,     bench_nacm_read,       NULL},
+    {"xml_yang_validate_all",  NULL,                        bench_validate_all,    NULL},
+    {NULL,                     NULL,                        NULL,                  NULL}
+};
+
+/*! Return nanoseconds between two timestamps */
+static uint64_t
+bench_ns(struct timespec *t0,
+	 struct timespec *t1)
+{
+    return (t1->tv_sec - t0->tv_sec)*1000000000LL + t1->tv_nsec - t0->tv_nsec;
+}
+
+/*! Run one benchmark and print its result line
+ * @param[in]  bc       Benchmark state
+ * @param[in]  b        Benchmark
+ * @param[in]  nodes    Number of XML nodes in tree
+ * @param[in]  maxiter  Max number of operations, 0 means no limit
+ * @param[in]  budget   Time budget in ms, at least one operation is run
+ */
+static int
+bench_run(struct bench_ctx *bc,
+	  struct bench     *b,
+	  uint64_t          nodes,
+	  uint64_t          maxiter,
+	  uint64_t          budget)
+{
+    int             retval = -1;
+    uint64_t        ops = 0;
+    uint64_t        ns = 0;
+    uint64_t        allocs = 0;
+    uint64_t        a0;
+    uint64_t        a1;
+    struct timespec t0;
+    struct timespec t1;
+
+    do {
+	bc->bc_key = random() % bc->bc_n;
+	if (b->b_prepare && b->b_prepare(bc) < 0)
+	    goto done;
+	xml_stats_alloc(&a0);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	if (b->b_op(bc) < 0)
+	    goto done;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	xml_stats_alloc(&a1);
+	ns += bench_ns(&t0, &t1);
+	allocs += a1 - a0;
+	ops++;
+	if ((b->b_cleanup?b->b_cleanup:bench_cleanup)(bc) < 0)
+	    goto done;
+    } while ((maxiter == 0 || ops < maxiter) && ns < budget*1000000);
+    fprintf(stdout, "%s,%d,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%.1f\n",
+	    b->b_name, bc->bc_n, nodes, ops, ns/ops, (double)allocs/ops);
+    fflush(stdout);
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Generate XML string with n list entries, keys are even numbers 0..2(n-1) */
+static int
+bench_generate(struct bench_ctx *bc)
+{
+    int i;
+
+    if ((bc->bc_xmlstr = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	return -1;
+    }
+    cprintf(bc->bc_xmlstr, "<c xmlns=\"%s\">", BENCH_NS);
+    for (i=0; i<bc->bc_n; i++)
+	cprintf(bc->bc_xmlstr, "<x><k>%d</k><v>v%d</v></x>", 2*i, i);
+    cprintf(bc->bc_xmlstr, "</c>");
+    return 0;
+}
+
+/*! Parse built-in bench YANG via a temporary file */
+static int
+bench_yang(clicon_handle h,
+	   yang_stmt    *yspec)
+{
+    int   retval = -1;
+    char  dir[] = "/tmp/clixon_bench_XXXXXX";
+    char  file[64];
+    FILE *f = NULL;
+
+    if (mkdtemp(dir) == NULL){
+	clicon_err(OE_UNIX, errno, "mkdtemp");
+	goto done;
+    }
+    snprintf(file, sizeof(file), "%s/bench.yang", dir);
+    if ((f = fopen(file, "w")) == NULL){
+	clicon_err(OE_UNIX, errno, "fopen(%s)", file);
+	goto done;
+    }
+    fprintf(f, "%s", BENCH_YANG);
+    fclose(f);
+    f = NULL;
+    if (yang_spec_parse_file(h, file, yspec) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (f)
+	fclose(f);
+    unlink(file);
+    rmdir(dir);
+    return retval;
+}
+
+static int
+usage(char *argv0)
+{
+    fprintf(stderr, "usage:%s [options]\n"
+	    "where options are\n"
+            "\t-h \t\tHelp\n"
+    	    "\t-D <level> \tDebug\n"
+	    "\t-n <entries>\tNumber of list entries in tree, five XML nodes each (default 1000)\n"
+	    "\t-i <nr>\t\tMax operations per benchmark, 0 is no limit (default 0)\n"
+	    "\t-t <ms>\t\tTime budget per benchmark in ms (default 1000)\n"
+	    "\t-b <name>\tRun only this benchmark\n"
+	    "\t-H \t\tDo not print CSV header\n"
+    	    "\t-Y <dir> \tYang dirs (can be several), needed for nacm_datanode_read\n",
+	    argv0);
+    exit(0);
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    int              retval = -1;
+    clicon_handle    h;
+    cxobj           *xcfg = NULL;
+    struct bench_ctx bc = {0,};
+    struct bench    *b;
+    cxobj           *xn = NULL;
+    cxobj           *x;
+    cxobj           *xb;
+    char            *name = NULL;
+    int              c;
+    int              i;
+    int              dbg = 0;
+    int              header = 1;
+    int              nacm = 0;
+    uint64_t         maxiter = 0;
+    uint64_t         budget = 1000;
+    uint64_t         a0;
+    uint64_t         a1;
+
+    /* In the startup, logs to stderr & debug flag set later */
+    clicon_log_init(__FILE__, LOG_INFO, CLICON_LOG_STDERR);
+    /* Initialize clixon handle */
+    if ((h = clicon_handle_init()) == NULL)
+	goto done;
+    if ((xcfg = xml_new("clixon-config", NULL, CX_ELMNT)) == NULL)
+	goto done;
+    if (clicon_conf_xml_set(h, xcfg) < 0)
+	goto done;
+    bc.bc_h = h;
+    bc.bc_n = 1000;
+    optind = 1;
+    opterr = 0;
+    while ((c = getopt(argc, argv, UTIL_BENCH_OPTS)) != -1)
+	switch (c) {
+	case 'h':
+	    usage(argv[0]);
+	    break;
+    	case 'D':
+	    if (sscanf(optarg, "%d", &dbg) != 1)
+		usage(argv[0]);
+	    break;
+	case 'n':
+	    if ((bc.bc_n = atoi(optarg)) <= 0)
+		usage(argv[0]);
+	    break;
+	case 'i':
+	    maxiter = strtoull(optarg, NULL, 10);
+	    break;
+	case 't':
+	    budget = strtoull(optarg, NULL, 10);
+	    break;
+	case 'b':
+	    name = optarg;
+	    break;
+	case 'H':
+	    header = 0;
+	    break;
+	case 'Y':
+	    if (clicon_option_add(h, "CLICON_YANG_DIR", optarg) < 0)
+		goto done;
+	    nacm++;
+	    break;
+	default:
+	    usage(argv[0]);
+	    break;
+	}
+    clicon_log_init(__FILE__, dbg?LOG_DEBUG:LOG_INFO, CLICON_LOG_STDERR);
+    clicon_debug_init(dbg, NULL);
+    if (name){
+	for (b = BENCHMARKS; b->b_name; b++)
+	    if (strcmp(b->b_name, name) == 0)
+		break;
+	if (b->b_name == NULL){
+	    fprintf(stderr, "No such benchmark: %s\n", name);
+	    usage(argv[0]);
+	}
+    }
+    srandom(1); /* Same keys in every run */
+    /* Yang */
+    if ((bc.bc_yspec = yspec_new()) == NULL)
+	goto done;
+    clicon_dbspec_yang_set(h, bc.bc_yspec);
+    if (bench_yang(h, bc.bc_yspec) < 0)
+	goto done;
+    if (nacm && yang_spec_parse_module(h, "ietf-netconf-acm", NULL, bc.bc_yspec) < 0)
+	goto done;
+    if ((bc.bc_nsc = xml_nsctx_init(BENCH_PREFIX, BENCH_NS)) == NULL)
+	goto done;
+    /* Base trees */
+    if (bench_generate(&bc) < 0)
+	goto done;
+    xml_stats_alloc(&a0);
+    if (clixon_xml_parse_string(cbuf_get(bc.bc_xmlstr), YB_MODULE, bc.bc_yspec, &bc.bc_xt, NULL) < 1)
+	goto done;
+    xml_stats_alloc(&a1);
+    if ((bc.bc_xc = xpath_first(bc.bc_xt, bc.bc_nsc, "/b:c")) == NULL){
+	clicon_err(OE_XML, 0, "c not found");
+	goto done;
+    }
+    if ((bc.bc_x1 = xml_dup(bc.bc_xt)) == NULL)
+	goto done;
+    i = 0;
+    x = NULL;
+    while ((x = xml_child_each(xml_find_type(bc.bc_x1, NULL, "c", CX_ELMNT), x, CX_ELMNT)) != NULL)
+	if (i++ % 100 == 0 &&
+	    (xb = xml_body_get(xml_find_type(x, NULL, "v", CX_ELMNT))) != NULL &&
+	    xml_value_set(xb, "changed") < 0)
+	    goto done;
+    if (nacm){
+	if (clixon_xml_parse_string(BENCH_NACM, YB_MODULE, bc.bc_yspec, &xn, NULL) < 1)
+	    goto done;
+	bc.bc_xnacm = xml_find_type(xn, NULL, "nacm", CX_ELMNT);
+    }
+    if ((bc.bc_cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    /* Run benchmarks */
+    if (header)
+	fprintf(stdout, "name,entries,nodes,ops,ns_per_op,xml_allocs_per_op\n");
+    for (b = BENCHMARKS; b->b_name; b++){
+	if (name && strcmp(b->b_name, name) != 0)
+	    continue;
+	if (b->b_op == bench_nacm_read && bc.bc_xnacm == NULL){
+	    fprintf(stderr, "%s: skipped, needs ietf-netconf-acm, see -Y\n", b->b_name);
+	    continue;
+	}
+	if (bench_run(&bc, b, a1 - a0, maxiter, budget) < 0)
+	    goto done;
+    }
+    retval = 0;
+ done:
+    bench_cleanup(&bc);
+    if (bc.bc_cb)
+	cbuf_free(bc.bc_cb);
+    if (xn)
+	xml_free(xn);
+    if (bc.bc_x1)
+	xml_free(bc.bc_x1);
+    if (bc.bc_xt)
+	xml_free(bc.bc_xt);
+    if (bc.bc_xmlstr)
+	cbuf_free(bc.bc_xmlstr);
+    if (bc.bc_nsc)
+	cvec_free(bc.bc_nsc);
+    if (bc.bc_yspec)
+	ys_free(bc.bc_yspec);
+    if (xcfg)
+	xml_free(xcfg);
+    if (h)
+	clicon_handle_exit(h);
+    return retval;
+}
@@ -0,0 +1,721 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Load generator for the backend socket.
+ * Several client connections send a weighted mix of get, get-config, edit-config,
+ * commit and lock requests using the internal clicon_msg protocol. Each connection has
+ * at most one outstanding request. All connections are driven by one poll loop
+ * with non-blocking sockets, so that a slow reply on one connection does not block
+ * requests on the others.
+ * The data model is assumed to have the following form in namespace -N:
+ *   container table{ list parameter{ key name; leaf name{type string;} leaf value{type string;} } }
+ * A lock request is always followed by an unlock on the same connection. While a
+ * connection holds the lock, edit-config and commit of other connections fail with
+ * lock-denied and are counted as errors.
+ * Output is one CSV line per request type and a total line:
+ *   op,count,errors,rps,avg_us,p50_us,p90_us,p99_us,max_us
+ * Precondition: the backend must have been started using socket path given as -s
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <syslog.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pwd.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <sys/stat.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon/clixon.h"
+
+/* Command line options passed to getopt(3) */
+#define UTIL_LOAD_OPTS "hD:a:s:c:d:n:r:p:k:m:N:H"
+
+/* Request types, LOAD_UNLOCK is not part of the mix, it follows each lock */
+enum load_op_type{
+    LOAD_GET,
+    LOAD_GET_CONFIG,
+    LOAD_EDIT_CONFIG,
+    LOAD_COMMIT,
+    LOAD_LOCK,
+    LOAD_UNLOCK,
+    LOAD_NR
+};
+
+/*! Statistics of one request type */
+struct load_op{
+    char     *lo_name;
+    int       lo_weight;  /* Relative weight in mix */
+    uint64_t  lo_count;
+    uint64_t  lo_errors;  /* Replies with rpc-error */
+    uint64_t *lo_lat;     /* Latency in ns of each request */
+    size_t    lo_latlen;
+    size_t    lo_latmax;
+};
+
+/*! One client connection with at most one outstanding request */
+struct load_conn{
+    int                lc_s;      /* Socket, -1 if closed */
+    uint32_t           lc_id;     /* Session id from hello */
+    int                lc_op;     /* Outstanding request type, -1 if idle */
+    int                lc_unlock; /* Send unlock as next request */
+    struct clicon_msg *lc_msg;    /* Request being sent */
+    size_t             lc_msgoff; /* Bytes of lc_msg sent */
+    struct clicon_msg  lc_hdr;    /* Reply header */
+    char              *lc_body;   /* Reply body */
+    size_t             lc_inoff;  /* Bytes of reply header+body read */
+    struct timespec    lc_t0;     /* Request start time */
+};
+
+static struct load_op LOAD_OPS[LOAD_NR] = {
+    {"get",         40, 0, 0, NULL, 0, 0},
+    {"get-config",  30, 0, 0, NULL, 0, 0},
+    {"edit-config", 20, 0, 0, NULL, 0, 0},
+    {"commit",       5, 0, 0, NULL, 0, 0},
+    {"lock",         5, 0, 0, NULL, 0, 0},
+    {"unlock",       0, 0, 0, NULL, 0, 0},
+};
+
+static char    *_USERNAME = NULL;
+static char    *_NAMESPACE = "urn:example:clixon";
+static char    *_PAYLOAD = NULL;  /* Value of edit-config */
+static int      _KEYS = 1000;     /* Number of list entries in edit-config and get-config */
+
+static uint64_t
+load_ns(struct timespec *t0,
+	struct timespec *t1)
+{
+    return (t1->tv_sec - t0->tv_sec)*1000000000LL + t1->tv_nsec - t0->tv_nsec;
+}
+
+/*! Parse request mix on the form <op>=<weight>[,<op>=<weight>]*
+ * Request types not given get weight 0
+ */
+static int
+load_mix_parse(char *mixstr)
+{
+    int    retval = -1;
+    char **vec = NULL;
+    int    nvec;
+    char  *w;
+    int    i;
+    int    j;
+
+    for (j=0; j<LOAD_NR; j++)
+	LOAD_OPS[j].lo_weight = 0;
+    if ((vec = clicon_strsep(mixstr, ",", &nvec)) == NULL)
+	goto done;
+    for (i=0; i<nvec; i++){
+	if ((w = strchr(vec[i], '=')) == NULL){
+	    clicon_err(OE_CFG, EINVAL, "Expected <op>=<weight>: %s", vec[i]);
+	    goto done;
+	}
+	*w++ = '\0';
+	for (j=0; j<LOAD_UNLOCK; j++)
+	    if (strcmp(LOAD_OPS[j].lo_name, vec[i]) == 0)
+		break;
+	if (j == LOAD_UNLOCK){
+	    clicon_err(OE_CFG, EINVAL, "Unknown request type: %s", vec[i]);
+	    goto done;
+	}
+	LOAD_OPS[j].lo_weight = atoi(w);
+    }
+    retval = 0;
+ done:
+    if (vec)
+	free(vec);
+    return retval;
+}
+
+/*! Select a request type from the mix */
+static int
+load_mix_select(int total)
+{
+    int r;
+    int j;
+
+    r = random() % total;
+    for (j=0; j<LOAD_UNLOCK; j++){
+	if (r < LOAD_OPS[j].lo_weight)
+	    break;
+	r -= LOAD_OPS[j].lo_weight;
+    }
+    return j;
+}
+
+/*! Encode request message of a type */
+static struct clicon_msg *
+load_msg(struct load_conn *lc,
+	 int               op)
+{
+    struct clicon_msg *msg = NULL;
+    int                key = random() % _KEYS;
+
+    switch (op){
+    case LOAD_GET:
+	msg = clicon_msg_encode(lc->lc_id, "<rpc xmlns=\"%s\" username=\"%s\"><get><filter type=\"xpath\" select=\"/ex:table\" xmlns:ex=\"%s\"/></get></rpc>",
+				NETCONF_BASE_NAMESPACE, _USERNAME, _NAMESPACE);
+	break;
+    case LOAD_GET_CONFIG:
+	msg = clicon_msg_encode(lc->lc_id, "<rpc xmlns=\"%s\" username=\"%s\"><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='%d']\" xmlns:ex=\"%s\"/></get-config></rpc>",
+				NETCONF_BASE_NAMESPACE, _USERNAME, key, _NAMESPACE);
+	break;
+    case LOAD_EDIT_CONFIG:
+	msg = clicon_msg_encode(lc->lc_id, "<rpc xmlns=\"%s\" username=\"%s\"><edit-config><target><candidate/></target><config><table xmlns=\"%s\"><parameter><name>%d</name><value>%s</value></parameter></table></config></edit-config></rpc>",
+				NETCONF_BASE_NAMESPACE, _USERNAME, _NAMESPACE, key, _PAYLOAD);
+	break;
+    case LOAD_COMMIT:
+	msg = clicon_msg_encode(lc->lc_id, "<rpc xmlns=\"%s\" username=\"%s\"><commit/></rpc>",
+				NETCONF_BASE_NAMESPACE, _USERNAME);
+	break;
+    case LOAD_LOCK:
+	msg = clicon_msg_encode(lc->lc_id, "<rpc xmlns=\"%s\" username=\"%s\"><lock><target><candidate/></target></lock></rpc>",
+				NETCONF_BASE_NAMESPACE, _USERNAME);
+	break;
+    case LOAD_UNLOCK:
+	msg = clicon_msg_encode(lc->lc_id, "<rpc xmlns=\"%s\" username=\"%s\"><unlock><target><candidate/></target></unlock></rpc>",
+				NETCONF_BASE_NAMESPACE, _USERNAME);
+	break;
+    default:
+	clicon_err(OE_UNIX, EINVAL, "op %d", op);
+	break;
+    }
+    return msg;
+}
+
+/*! Open connection and get session id by hello
+ * The socket is non-blocking after the hello
+ */
+static int
+load_conn_open(clicon_handle     h,
+	       char             *family,
+	       char             *sockpath,
+	       struct load_conn *lc)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    char              *retdata = NULL;
+    char              *p;
+    int                flags;
+
+    if (strcmp(family, "UNIX")==0){
+	if (clicon_rpc_connect_unix(h, sockpath, &lc->lc_s) < 0)
+	    goto done;
+    }
+    else
+	if (clicon_rpc_connect_inet(h, sockpath, 4535, &lc->lc_s) < 0)
+	    goto done;
+    if ((msg = clicon_msg_encode(0, "<hello username=\"%s\" xmlns=\"%s\"><capabilities><capability>urn:ietf:params:netconf:base:1.0</capability></capabilities></hello>",
+				 _USERNAME, NETCONF_BASE_NAMESPACE)) == NULL)
+	goto done;
+    if (clicon_rpc(lc->lc_s, msg, &retdata) < 0)
+	goto done;
+    if (retdata == NULL ||
+	(p = strstr(retdata, "<session-id>")) == NULL ||
+	sscanf(p, "<session-id>%u", &lc->lc_id) != 1){
+	clicon_err(OE_PROTO, 0, "No session-id in hello reply: %s", retdata?retdata:"");
+	goto done;
+    }
+    if ((flags = fcntl(lc->lc_s, F_GETFL, 0)) < 0 ||
+	fcntl(lc->lc_s, F_SETFL, flags | O_NONBLOCK) < 0){
+	clicon_err(OE_UNIX, errno, "fcntl");
+	goto done;
+    }
+    lc->lc_op = -1;
+    retval = 0;
+ done:
+    if (retdata)
+	free(retdata);
+    if (msg)
+	free(msg);
+    return retval;
+}
+
+/*! Start a request on an idle connection */
+static int
+load_conn_request(struct load_conn *lc,
+		  int               op)
+{
+    if ((lc->lc_msg = load_msg(lc, op)) == NULL)
+	return -1;
+    lc->lc_msgoff = 0;
+    lc->lc_inoff = 0;
+    lc->lc_op = op;
+    clock_gettime(CLOCK_MONOTONIC, &lc->lc_t0);
+    return 0;
+}
+
+/*! Write as much as possible of outstanding request */
+static int
+load_conn_write(struct load_conn *lc)
+{
+    size_t  len = ntohl(lc->lc_msg->op_len);
+    ssize_t n;
+
+    if ((n = write(lc->lc_s, (char*)lc->lc_msg + lc->lc_msgoff, len - lc->lc_msgoff)) < 0){
+	if (errno == EAGAIN || errno == EINTR)
+	    return 0;
+	clicon_err(OE_UNIX, errno, "write");
+	return -1;
+    }
+    lc->lc_msgoff += n;
+    if (lc->lc_msgoff == len){
+	free(lc->lc_msg);
+	lc->lc_msg = NULL;
+    }
+    return 0;
+}
+
+/*! Record latency of a completed request */
+static int
+load_op_record(struct load_op *lo,
+	       uint64_t        ns,
+	       int             error)
+{
+    uint64_t *lat;
+
+    if (lo->lo_latlen == lo->lo_latmax){
+	lo->lo_latmax = lo->lo_latmax?2*lo->lo_latmax:1024;
+	if ((lat = realloc(lo->lo_lat, lo->lo_latmax*sizeof(*lat))) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    return -1;
+	}
+	lo->lo_lat = lat;
+    }
+    lo->lo_lat[lo->lo_latlen++] = ns;
+    lo->lo_count++;
+    if (error)
+	lo->lo_errors++;
+    return 0;
+}
+
+/*! Read as much as possible of reply, record request when complete
+ * @retval   1   Reply complete, connection idle
+ * @retval   0   Reply not complete
+ * @retval  -1   Error
+ */
+static int
+load_conn_read(struct load_conn *lc)
+{
+    int             retval = -1;
+    size_t          hlen = sizeof(lc->lc_hdr);
+    size_t          len;
+    ssize_t         n;
+    struct timespec t1;
+    int             lock;
+
+    if (lc->lc_inoff < hlen){
+	if ((n = read(lc->lc_s, (char*)&lc->lc_hdr + lc->lc_inoff, hlen - lc->lc_inoff)) < 0)
+	    goto again;
+	if (n == 0)
+	    goto eof;
+	if ((lc->lc_inoff += n) < hlen)
+	    goto notyet;
+	len = ntohl(lc->lc_hdr.op_len);
+	if (len <= hlen){
+	    clicon_err(OE_PROTO, EINVAL, "Reply length %zu", len);
+	    goto done;
+	}
+	if ((lc->lc_body = malloc(len - hlen)) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    goto done;
+	}
+    }
+    len = ntohl(lc->lc_hdr.op_len);
+    if ((n = read(lc->lc_s, lc->lc_body + lc->lc_inoff - hlen, len - lc->lc_inoff)) < 0)
+	goto again;
+    if (n == 0)
+	goto eof;
+    if ((lc->lc_inoff += n) < len)
+	goto notyet;
+    /* Reply complete */
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    lc->lc_body[len - hlen - 1] = '\0';
+    lock = lc->lc_op == LOAD_LOCK && strstr(lc->lc_body, "<rpc-error>") == NULL;
+    if (load_op_record(&LOAD_OPS[lc->lc_op], load_ns(&lc->lc_t0, &t1),
+		       strstr(lc->lc_body, "<rpc-error>") != NULL) < 0)
+	goto done;
+    free(lc->lc_body);
+    lc->lc_body = NULL;
+    lc->lc_op = -1;
+    lc->lc_unlock = lock;
+    retval = 1;
+ done:
+    return retval;
+ notyet:
+    retval = 0;
+    goto done;
+ again:
+    if (errno == EAGAIN || errno == EINTR)
+	goto notyet;
+    clicon_err(OE_UNIX, errno, "read");
+    goto done;
+ eof:
+    clicon_err(OE_PROTO, ESHUTDOWN, "Socket unexpected close");
+    goto done;
+}
+
+static int
+load_cmp(const void *a,
+	 const void *b)
+{
+    uint64_t x = *(uint64_t*)a;
+    uint64_t y = *(uint64_t*)b;
+
+    return x<y ? -1 : x>y ? 1 : 0;
+}
+
+/*! Print one CSV result line, latencies are sorted */
+static int
+load_print(char     *name,
+	   uint64_t *lat,
+	   size_t    len,
+	   uint64_t  errors,
+	   uint64_t  elapsed)
+{
+    uint64_t sum = 0;
+    size_t   i;
+
+    qsort(lat, len, sizeof(*lat), load_cmp);
+    for (i=0; i<len; i++)
+	sum += lat[i];
+    fprintf(stdout, "%s,%zu,%" PRIu64 ",%.1f,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n",
+	    name, len, errors,
+	    elapsed?len*1e9/elapsed:0.0,
+	    len?sum/len/1000:0,
+	    len?lat[(len-1)*50/100]/1000:0,
+	    len?lat[(len-1)*90/100]/1000:0,
+	    len?lat[(len-1)*99/100]/1000:0,
+	    len?lat[len-1]/1000:0);
+    return 0;
+}
+
+/*! Print results of all request types and total */
+static int
+load_report(uint64_t elapsed,
+	    int      header)
+{
+    int       retval = -1;
+    uint64_t *lat = NULL;
+    size_t    len = 0;
+    uint64_t  errors = 0;
+    int       j;
+
+    for (j=0; j<LOAD_NR; j++)
+	len += LOAD_OPS[j].lo_latlen;
+    if (len && (lat = malloc(len*sizeof(*lat))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    len = 0;
+    if (header)
+	fprintf(stdout, "op,count,errors,rps,avg_us,p50_us,p90_us,p99_us,max_us\n");
+    for (j=0; j<LOAD_NR; j++){
+	struct load_op *lo = &LOAD_OPS[j];
+
+	if (lo->lo_count == 0)
+	    continue;
+	if (lat)
+	    memcpy(&lat[len], lo->lo_lat, lo->lo_latlen*sizeof(*lat));
+	len += lo->lo_latlen;
+	errors += lo->lo_errors;
+	load_print(lo->lo_name, lo->lo_lat, lo->lo_latlen, lo->lo_errors, elapsed);
+    }
+    load_print("total", lat, len, errors, elapsed);
+    retval = 0;
+ done:
+    if (lat)
+	free(lat);
+    return retval;
+}
+
+static int
+usage(char *argv0)
+{
+    fprintf(stderr, "usage:%s [options]\n"
+	    "where options are\n"
+            "\t-h \t\tHelp\n"
+    	    "\t-D <level> \tDebug\n"
+	    "\t-a <family>\tSocket address family (default UNIX)\n"
+	    "\t-s <sockpath> \tPath to unix domain socket (or IP addr)\n"
+	    "\t-c <nr>\t\tNumber of connections (default 10)\n"
+	    "\t-d <s>\t\tDuration in seconds (default 10)\n"
+	    "\t-n <nr>\t\tStop after this number of requests, 0 is no limit (default 0)\n"
+	    "\t-r <rate>\tTotal requests per second, 0 is as fast as possible (default 0)\n"
+	    "\t-p <bytes>\tSize of edit-config value (default 16)\n"
+	    "\t-k <nr>\t\tNumber of list entries in requests (default 1000)\n"
+	    "\t-m <mix>\tRequest weights (default get=40,get-config=30,edit-config=20,commit=5,lock=5)\n"
+	    "\t-N <ns>\t\tNamespace of table/parameter list (default urn:example:clixon)\n"
+	    "\t-H \t\tDo not print CSV header\n",
+	    argv0);
+    exit(0);
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    int               retval = -1;
+    int               c;
+    clicon_handle     h;
+    int               dbg = 0;
+    char             *sockpath = NULL;
+    char             *family = "UNIX";
+    int               nconn = 10;
+    uint64_t          duration = 10;
+    uint64_t          maxreq = 0;
+    uint64_t          rate = 0;
+    int               payload = 16;
+    int               header = 1;
+    int               total = 0;
+    struct load_conn *conns = NULL;
+    struct load_conn *lc;
+    struct pollfd    *fds = NULL;
+    struct passwd    *pw;
+    struct timespec   t0;
+    struct timespec   now;
+    uint64_t          sent = 0;
+    uint64_t          elapsed = 0;
+    uint64_t          next;
+    int               stopping = 0;
+    int               active;
+    int               timeout;
+    int               i;
+    int               j;
+
+    /* In the startup, logs to stderr & debug flag set later */
+    clicon_log_init(__FILE__, LOG_INFO, CLICON_LOG_STDERR);
+    if ((h = clicon_handle_init()) == NULL)
+	goto done;
+    optind = 1;
+    opterr = 0;
+    while ((c = getopt(argc, argv, UTIL_LOAD_OPTS)) != -1)
+	switch (c) {
+	case 'h':
+	    usage(argv[0]);
+	    break;
+    	case 'D':
+	    if (sscanf(optarg, "%d", &dbg) != 1)
+		usage(argv[0]);
+	    break;
+	case 'a':
+	    family = optarg;
+	    break;
+	case 's':
+	    sockpath = optarg;
+	    break;
+	case 'c':
+	    if ((nconn = atoi(optarg)) <= 0)
+		usage(argv[0]);
+	    break;
+	case 'd':
+	    duration = strtoull(optarg, NULL, 10);
+	    break;
+	case 'n':
+	    maxreq = strtoull(optarg, NULL, 10);
+	    break;
+	case 'r':
+	    rate = strtoull(optarg, NULL, 10);
+	    break;
+	case 'p':
+	    if ((payload = atoi(optarg)) < 0)
+		usage(argv[0]);
+	    break;
+	case 'k':
+	    if ((_KEYS = atoi(optarg)) <= 0)
+		usage(argv[0]);
+	    break;
+	case 'm':
+	    if (load_mix_parse(optarg) < 0)
+		goto done;
+	    break;
+	case 'N':
+	    _NAMESPACE = optarg;
+	    break;
+	case 'H':
+	    header = 0;
+	    break;
+	default:
+	    usage(argv[0]);
+	    break;
+	}
+    clicon_log_init(__FILE__, dbg?LOG_DEBUG:LOG_INFO, CLICON_LOG_STDERR);
+    clicon_debug_init(dbg, NULL);
+    if (sockpath == NULL){
+	fprintf(stderr, "Mandatory option missing: -s <sockpath>\n");
+	usage(argv[0]);
+    }
+    for (j=0; j<LOAD_UNLOCK; j++)
+	total += LOAD_OPS[j].lo_weight;
+    if (total <= 0){
+	fprintf(stderr, "Empty request mix\n");
+	usage(argv[0]);
+    }
+    if ((pw = getpwuid(getuid())) == NULL){
+	clicon_err(OE_UNIX, errno, "getpwuid");
+	goto done;
+    }
+    if ((_USERNAME = strdup(pw->pw_name)) == NULL ||
+	(_PAYLOAD = malloc(payload+1)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(_PAYLOAD, 'x', payload);
+    _PAYLOAD[payload] = '\0';
+    srandom(getpid());
+    if ((conns = calloc(nconn, sizeof(*conns))) == NULL ||
+	(fds = calloc(nconn, sizeof(*fds))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    for (i=0; i<nconn; i++)
+	conns[i].lc_s = -1;
+    for (i=0; i<nconn; i++)
+	if (load_conn_open(h, family, sockpath, &conns[i]) < 0)
+	    goto done;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    while (1){
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed = load_ns(&t0, &now);
+	if ((duration && elapsed >= duration*1000000000LL) ||
+	    (maxreq && sent >= maxreq))
+	    stopping++;
+	/* Start requests on idle connections, a pending unlock is always sent */
+	timeout = -1;
+	active = 0;
+	for (i=0; i<nconn; i++){
+	    lc = &conns[i];
+	    if (lc->lc_op == -1){
+		if (lc->lc_unlock){
+		    if (load_conn_request(lc, LOAD_UNLOCK) < 0)
+			goto done;
+		    lc->lc_unlock = 0;
+		}
+		else if (!stopping){
+		    next = rate ? sent*1000000000LL/rate : 0;
+		    if (next > elapsed){
+			if (timeout == -1 || (next - elapsed)/1000000 < timeout)
+			    timeout = (next - elapsed)/1000000;
+		    }
+		    else{
+			if (load_conn_request(lc, load_mix_select(total)) < 0)
+			    goto done;
+			sent++;
+		    }
+		}
+	    }
+	    fds[i].fd = lc->lc_s;
+	    fds[i].events = 0;
+	    fds[i].revents = 0;
+	    if (lc->lc_op != -1){
+		active++;
+		fds[i].events = lc->lc_msg ? POLLOUT : POLLIN;
+	    }
+	}
+	if (active == 0){
+	    if (stopping)
+		break;
+	    if (timeout == -1)
+		timeout = 0;
+	}
+	else if (!stopping && duration){
+	    /* Wake up to stop in time */
+	    next = (duration*1000000000LL - elapsed)/1000000;
+	    if (timeout == -1 || next < timeout)
+		timeout = next;
+	}
+	if (poll(fds, nconn, timeout) < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "poll");
+	    goto done;
+	}
+	for (i=0; i<nconn; i++){
+	    lc = &conns[i];
+	    if (fds[i].revents == 0)
+		continue;
+	    if (lc->lc_msg){
+		if (load_conn_write(lc) < 0)
+		    goto done;
+	    }
+	    else if (load_conn_read(lc) < 0)
+		goto done;
+	}
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (load_report(load_ns(&t0, &now), header) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (conns){
+	for (i=0; i<nconn; i++){
+	    lc = &conns[i];
+	    if (lc->lc_s != -1)
+		close(lc->lc_s);
+	    if (lc->lc_msg)
+		free(lc->lc_msg);
+	    if (lc->lc_body)
+		free(lc->lc_body);
+	}
+	free(conns);
+    }
+    if (fds)
+	free(fds);
+    for (j=0; j<LOAD_NR; j++)
+	if (LOAD_OPS[j].lo_lat)
+	    free(LOAD_OPS[j].lo_lat);
+    if (_USERNAME)
+	free(_USERNAME);
+    if (_PAYLOAD)
+	free(_PAYLOAD);
+    if (h)
+	clicon_handle_exit(h);
+    return retval;
+}